@@ -28,6 +28,11 @@ if(NOT WITH_PROFILER)
     add_definitions(-DPADDLE_DISABLE_PROFILER)
 endif(NOT WITH_PROFILER)
 
+if(WITH_EIGEN_THREADPOOL)
+    # CPUDeviceContext runs the Eigen expressions by Eigen::ThreadPoolDevice
+    add_definitions(-DEIGEN_USE_THREADS)
+endif(WITH_EIGEN_THREADPOOL)
+
 if(WITH_AVX AND AVX_FOUND)
     set(SIMD_FLAG ${AVX_FLAG})
     add_definitions(-DPADDLE_WITH_AVX)
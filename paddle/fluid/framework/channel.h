@@ -21,6 +21,7 @@
 
 #include <glog/logging.h>
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>  // NOLINT
 #include <deque>
 #include <limits>
@@ -33,6 +34,15 @@
 namespace paddle {
 namespace framework {
 
+// ChannelObject is a blocking queue of T which can be opened and closed.
+//
+// By default all the data is kept in one deque guarded by one mutex. With
+// SetShardNum(n) the data is spread over n shards with a mutex each, a thread
+// always writes to its own shard and reads from its own shard first, so
+// readers and writers on different threads do not contend with each other.
+// Waiting for data or for space only takes the channel mutex when a thread
+// really has to sleep. The sharded channel is not FIFO across threads, and
+// its capacity is a soft bound, concurrent writers may exceed it slightly.
 template <class T>
 class ChannelObject {
  public:
@@ -44,11 +54,36 @@ class ChannelObject {
   }
 
   void Clear() {
+    if (shard_num_ != 0) {
+      for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard_size_ -= shard->data.size();
+        shard->data.clear();
+        shard->data.shrink_to_fit();
+      }
+      return;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     data_.clear();
     data_.shrink_to_fit();
   }
 
+  size_t ShardNum() { return shard_num_; }
+
+  // shard_num <= 1 means the single locked deque. It can only be set when
+  // the channel is empty and not used by other threads.
+  void SetShardNum(size_t shard_num) {
+    CHECK(Empty()) << "can not set the shard num of a non-empty channel";
+    std::lock_guard<std::mutex> lock(mutex_);
+    shard_num_ = shard_num <= 1 ? 0 : shard_num;
+    CHECK(shard_num_ == 0 || capacity_ > 0)
+        << "a sharded channel can not have zero capacity";
+    shards_.clear();
+    for (size_t i = 0; i < shard_num_; ++i) {
+      shards_.emplace_back(new Shard);
+    }
+  }
+
   size_t Capacity() {
     return capacity_;  // atomic
   }
@@ -71,9 +106,12 @@ class ChannelObject {
 
   template <class U>
   void InheritFrom(const std::shared_ptr<ChannelObject<U>>& other) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    capacity_ = other->Capacity();
-    block_size_ = other->BlockSize();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      capacity_ = other->Capacity();
+      block_size_ = other->BlockSize();
+    }
+    SetShardNum(other->ShardNum());
   }
 
   bool Closed() {
@@ -95,11 +133,17 @@ class ChannelObject {
   }
 
   size_t Size() {
+    if (shard_num_ != 0) {
+      return shard_size_;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return data_.size();
   }
 
   bool Empty() {
+    if (shard_num_ != 0) {
+      return shard_size_ == 0;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return EmptyUnlocked();
   }
@@ -113,6 +157,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (shard_num_ != 0) {
+      return ShardedRead(n, p);
+    }
 
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Read(n, p, lock);
@@ -132,6 +179,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (shard_num_ != 0) {
+      return ShardedWrite(n, p, [](const T& x) -> const T& { return x; });
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Write(n, p, lock);
     Notify();
@@ -143,6 +193,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (shard_num_ != 0) {
+      return ShardedWrite(n, p, [](T& x) -> T&& { return std::move(x); });
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = WriteMove(n, p, lock);
     Notify();
@@ -181,7 +234,7 @@ class ChannelObject {
  private:
   size_t capacity_ = MaxCapacity();
   size_t block_size_ = 1024;
-  bool closed_ = false;
+  std::atomic<bool> closed_{false};
   std::mutex mutex_;
   // use deque to store data
   std::deque<T> data_;
@@ -191,11 +244,27 @@ class ChannelObject {
   std::condition_variable empty_cond_;
   std::condition_variable full_cond_;
 
+  struct Shard {
+    std::mutex mutex;
+    std::deque<T> data;
+  };
+  size_t shard_num_ = 0;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  // the total size of the shards, only changed with a shard locked
+  std::atomic<size_t> shard_size_{0};
+  // the number of threads sleeping on empty_cond_ or full_cond_
+  std::atomic<int> shard_waiters_{0};
+
   static constexpr size_t MaxCapacity() {
     return (std::numeric_limits<size_t>::max)() / 2;
   }
 
   void Notify() {
+    if (shard_num_ != 0) {
+      empty_cond_.notify_all();
+      full_cond_.notify_all();
+      return;
+    }
     if (empty_waiters_ != 0 && (!EmptyUnlocked() || closed_)) {
       empty_cond_.notify_one();
     }
@@ -283,6 +352,88 @@ class ChannelObject {
     }
     return finished;
   }
+
+  // the shard a thread writes to and reads from first
+  size_t HomeShard() {
+    static std::atomic<size_t> thread_count{0};
+    static thread_local size_t thread_index = thread_count++;
+    return thread_index % shard_num_;
+  }
+
+  void WakeUp(std::condition_variable* cond) {
+    if (shard_waiters_ != 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cond->notify_all();
+    }
+  }
+
+  size_t ShardedRead(size_t n, T* p) {
+    size_t finished = 0;
+    size_t home = HomeShard();
+    while (true) {
+      size_t got = 0;
+      for (size_t i = 0; i < shard_num_ && finished < n; ++i) {
+        Shard& shard = *shards_[(home + i) % shard_num_];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size_t m = std::min(n - finished, shard.data.size());
+        for (size_t j = 0; j < m; ++j) {
+          p[finished++] = std::move(shard.data.front());
+          shard.data.pop_front();
+        }
+        shard_size_ -= m;
+        got += m;
+      }
+      if (got != 0) {
+        WakeUp(&full_cond_);
+      }
+      if (finished == n) {
+        break;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      // registering before checking the size pairs with writers, which
+      // change the size before checking the waiters
+      shard_waiters_++;
+      while (shard_size_ == 0 && !closed_) {
+        empty_cond_.wait(lock);
+      }
+      shard_waiters_--;
+      if (shard_size_ == 0) {
+        break;  // closed and empty
+      }
+    }
+    return finished;
+  }
+
+  template <class P, class Forward>
+  size_t ShardedWrite(size_t n, P* p, Forward forward) {
+    size_t finished = 0;
+    Shard& shard = *shards_[HomeShard()];
+    while (finished < n && !closed_) {
+      size_t m = 0;
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size_t size = shard_size_;
+        if (size < capacity_) {
+          m = std::min(n - finished, capacity_ - size);
+          for (size_t i = 0; i < m; ++i) {
+            shard.data.push_back(forward(p[finished++]));
+          }
+          shard_size_ += m;
+        }
+      }
+      if (m != 0) {
+        WakeUp(&empty_cond_);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      shard_waiters_++;
+      while (shard_size_ >= capacity_ && !closed_) {
+        full_cond_.wait(lock);
+      }
+      shard_waiters_--;
+    }
+    return finished;
+  }
 };  // NOLINT
 
 template <class T>
@@ -293,6 +444,16 @@ Channel<T> MakeChannel(size_t capacity = (std::numeric_limits<size_t>::max)()) {
   return std::make_shared<ChannelObject<T>>(capacity);
 }
 
+// a channel spread over shard_num shards, see ChannelObject
+template <class T>
+Channel<T> MakeShardedChannel(
+    size_t shard_num,
+    size_t capacity = (std::numeric_limits<size_t>::max)()) {
+  Channel<T> chan = std::make_shared<ChannelObject<T>>(capacity);
+  chan->SetShardNum(shard_num);
+  return chan;
+}
+
 template <class T, class U>
 Channel<T> MakeChannel(const Channel<U>& other) {
   CHECK(other != nullptr) << "channel can not be NULL";
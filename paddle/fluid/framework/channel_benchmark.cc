@@ -0,0 +1,155 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Compare the locked ChannelObject with the sharded one under the access
+// pattern of DatasetImpl: writers load blocks of instances with
+// ChannelWriter, and readers take instances one by one with Get and put
+// them into a consume channel, like InMemoryDataFeed::Next.
+// Usage:
+//   channel_benchmark --writers=32 --readers=32 --items=2000000 --shard_num=32
+
+#include <atomic>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/channel.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int32(writers, 32, "The number of writer threads.");
+DEFINE_int32(readers, 32, "The number of reader threads.");
+DEFINE_int32(items, 2000000, "The total number of items.");
+DEFINE_int32(block_size, 1024, "The block size of the channels.");
+DEFINE_int32(shard_num, 32, "The shard num of the sharded channels.");
+DEFINE_int32(repeat, 3, "Repeat times of each channel.");
+
+namespace paddle {
+namespace framework {
+
+struct BenchmarkResult {
+  double load_ms = 0;
+  double consume_ms = 0;
+  double mixed_ms = 0;
+};
+
+static void WriteItems(Channel<uint64_t> chan, int writer_id) {
+  ChannelWriter<uint64_t> writer(chan.get());
+  for (int i = writer_id; i < FLAGS_items; i += FLAGS_writers) {
+    writer << static_cast<uint64_t>(i);
+  }
+  writer.Flush();
+}
+
+static void ConsumeItems(Channel<uint64_t> chan, Channel<uint64_t> consume,
+                         std::atomic<uint64_t>* checksum) {
+  uint64_t sum = 0;
+  uint64_t x = 0;
+  while (chan->Get(x)) {
+    sum += x;
+    consume->Put(std::move(x));
+  }
+  *checksum += sum;
+}
+
+template <class Func>
+static double RunThreads(int thread_num, Func func) {
+  platform::Timer timer;
+  timer.Start();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; ++i) {
+    threads.emplace_back(func, i);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  timer.Pause();
+  return timer.ElapsedMS();
+}
+
+static BenchmarkResult RunOnce(size_t shard_num) {
+  BenchmarkResult result;
+  auto make_channel = [shard_num]() {
+    auto chan = MakeShardedChannel<uint64_t>(shard_num);
+    chan->SetBlockSize(FLAGS_block_size);
+    return chan;
+  };
+  std::atomic<uint64_t> checksum{0};
+  uint64_t expect = static_cast<uint64_t>(FLAGS_items) * (FLAGS_items - 1) / 2;
+
+  // LoadIntoMemory: all writers, then all readers
+  auto chan = make_channel();
+  auto consume = make_channel();
+  result.load_ms = RunThreads(FLAGS_writers,
+                              [&](int i) { WriteItems(chan, i); });
+  chan->Close();
+  result.consume_ms = RunThreads(
+      FLAGS_readers, [&](int i) { ConsumeItems(chan, consume, &checksum); });
+  CHECK_EQ(checksum.load(), expect);
+  CHECK_EQ(consume->Size(), static_cast<size_t>(FLAGS_items));
+
+  // readers and writers at the same time
+  chan = make_channel();
+  consume = make_channel();
+  checksum = 0;
+  platform::Timer timer;
+  timer.Start();
+  std::vector<std::thread> writers;
+  for (int i = 0; i < FLAGS_writers; ++i) {
+    writers.emplace_back([&, i] { WriteItems(chan, i); });
+  }
+  std::vector<std::thread> readers;
+  for (int i = 0; i < FLAGS_readers; ++i) {
+    readers.emplace_back([&] { ConsumeItems(chan, consume, &checksum); });
+  }
+  for (auto& t : writers) {
+    t.join();
+  }
+  chan->Close();
+  for (auto& t : readers) {
+    t.join();
+  }
+  timer.Pause();
+  result.mixed_ms = timer.ElapsedMS();
+  CHECK_EQ(checksum.load(), expect);
+  return result;
+}
+
+static void RunBenchmark() {
+  for (size_t shard_num : {0, FLAGS_shard_num}) {
+    BenchmarkResult total;
+    for (int i = 0; i < FLAGS_repeat; ++i) {
+      BenchmarkResult result = RunOnce(shard_num);
+      total.load_ms += result.load_ms;
+      total.consume_ms += result.consume_ms;
+      total.mixed_ms += result.mixed_ms;
+    }
+    LOG(INFO) << (shard_num == 0 ? std::string("locked channel")
+                                 : "sharded channel(" +
+                                       std::to_string(shard_num) + ")")
+              << ": load " << total.load_ms / FLAGS_repeat << " ms, consume "
+              << total.consume_ms / FLAGS_repeat << " ms, mixed "
+              << total.mixed_ms / FLAGS_repeat << " ms";
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::RunBenchmark();
+  return 0;
+}
@@ -0,0 +1,122 @@
+//   Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/channel.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+static Channel<int> MakeTestChannel(size_t shard_num,
+                                    size_t capacity = 1000000) {
+  return MakeShardedChannel<int>(shard_num, capacity);
+}
+
+TEST(Channel, ReadAllAfterClose) {
+  for (size_t shard_num : {0, 4}) {
+    auto chan = MakeTestChannel(shard_num);
+    chan->SetBlockSize(7);
+    std::vector<int> data(100);
+    for (int i = 0; i < 100; ++i) {
+      data[i] = i;
+    }
+    EXPECT_EQ(chan->Write(std::move(data)), 100UL);
+    EXPECT_EQ(chan->Size(), 100UL);
+    chan->Close();
+    EXPECT_EQ(chan->Put(100), false);
+
+    std::vector<int> result;
+    EXPECT_EQ(chan->ReadAll(result), 100UL);
+    std::sort(result.begin(), result.end());
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_EQ(result[i], i);
+    }
+    EXPECT_TRUE(chan->Empty());
+    int x = 0;
+    EXPECT_FALSE(chan->Get(x));
+  }
+}
+
+TEST(Channel, ShardedClear) {
+  auto chan = MakeTestChannel(3);
+  for (int i = 0; i < 10; ++i) {
+    chan->Put(i);
+  }
+  EXPECT_EQ(chan->Size(), 10UL);
+  chan->Clear();
+  EXPECT_EQ(chan->Size(), 0UL);
+  chan->SetShardNum(0);
+  EXPECT_EQ(chan->ShardNum(), 0UL);
+}
+
+// many writers with ChannelWriter and many readers with Get, like
+// DatasetImpl does in LoadIntoMemory and Next
+static void CheckManyReadersManyWriters(size_t shard_num, size_t capacity) {
+  const int writer_num = 8;
+  const int reader_num = 8;
+  const int item_num = 20000;
+  auto chan = MakeTestChannel(shard_num, capacity);
+  chan->SetBlockSize(64);
+  std::atomic<int64_t> sum{0};
+  std::atomic<int> count{0};
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < reader_num; ++i) {
+    readers.emplace_back([&] {
+      int x = 0;
+      while (chan->Get(x)) {
+        sum += x;
+        ++count;
+      }
+    });
+  }
+  std::vector<std::thread> writers;
+  for (int i = 0; i < writer_num; ++i) {
+    writers.emplace_back([&, i] {
+      ChannelWriter<int> writer(chan.get());
+      for (int j = 0; j < item_num; ++j) {
+        writer << i * item_num + j;
+      }
+      writer.Flush();
+    });
+  }
+  for (auto& t : writers) {
+    t.join();
+  }
+  chan->Close();
+  for (auto& t : readers) {
+    t.join();
+  }
+  int64_t total = writer_num * item_num;
+  EXPECT_EQ(count, total);
+  EXPECT_EQ(sum, total * (total - 1) / 2);
+  EXPECT_TRUE(chan->Empty());
+}
+
+TEST(Channel, ManyReadersManyWriters) {
+  CheckManyReadersManyWriters(0, 1000000);
+  CheckManyReadersManyWriters(8, 1000000);
+}
+
+TEST(Channel, ShardedBlockOnCapacity) {
+  // writers have to wait for readers most of the time
+  CheckManyReadersManyWriters(4, 16);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,319 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/columnar_record.h"
+#include <string.h>
+#include <algorithm>
+#include "glog/logging.h"
+#include "paddle/fluid/framework/data_feed_parser.h"
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+static const char kColumnarRecordMagic[8] = {'P', 'D', 'C', 'O',
+                                             'L', 'R', 'E', 'C'};
+static const uint32_t kColumnarRecordVersion = 1;
+
+static_assert(sizeof(ColumnarRecordHeader) % 8 == 0,
+              "ColumnarRecordHeader must be 8 bytes aligned");
+static_assert(sizeof(ColumnarSlotMeta) % 8 == 0,
+              "ColumnarSlotMeta must be 8 bytes aligned");
+
+static uint64_t AlignTo8(uint64_t pos) { return (pos + 7) & ~uint64_t(7); }
+
+ColumnarRecordWriter::ColumnarRecordWriter(
+    const std::vector<std::string>& slot_types, bool with_ins_id,
+    bool with_content)
+    : with_ins_id_(with_ins_id), with_content_(with_content) {
+  slots_.resize(slot_types.size());
+  for (size_t i = 0; i < slot_types.size(); ++i) {
+    PADDLE_ENFORCE((slot_types[i] == "uint64") || (slot_types[i] == "float"),
+                   "There is no this type<%s>.", slot_types[i]);
+    slots_[i].type = slot_types[i][0];
+    slots_[i].offset.push_back(0);
+  }
+  ins_id_offset_.push_back(0);
+  content_offset_.push_back(0);
+}
+
+void ColumnarRecordWriter::Add(const Record& record) {
+  for (auto& item : record.uint64_feasigns_) {
+    PADDLE_ENFORCE_LT(item.slot(), slots_.size(), "Slot %d is out of range.",
+                      item.slot());
+    auto& column = slots_[item.slot()];
+    PADDLE_ENFORCE(column.type == 'u', "Add uint64 feasign to %c slot %d.",
+                   column.type, item.slot());
+    column.uint64_values.push_back(item.sign().uint64_feasign_);
+  }
+  for (auto& item : record.float_feasigns_) {
+    PADDLE_ENFORCE_LT(item.slot(), slots_.size(), "Slot %d is out of range.",
+                      item.slot());
+    auto& column = slots_[item.slot()];
+    PADDLE_ENFORCE(column.type == 'f', "Add float feasign to %c slot %d.",
+                   column.type, item.slot());
+    column.float_values.push_back(item.sign().float_feasign_);
+  }
+  for (auto& column : slots_) {
+    column.offset.push_back(column.type == 'u' ? column.uint64_values.size()
+                                               : column.float_values.size());
+  }
+  if (with_ins_id_) {
+    ins_ids_.append(record.ins_id_);
+    ins_id_offset_.push_back(ins_ids_.size());
+  }
+  if (with_content_) {
+    contents_.append(record.content_);
+    content_offset_.push_back(contents_.size());
+  }
+  ++ins_num_;
+}
+
+void ColumnarRecordWriter::Save(const std::string& path) const {
+  ColumnarRecordHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kColumnarRecordMagic, sizeof(header.magic));
+  header.version = kColumnarRecordVersion;
+  header.slot_num = slots_.size();
+  header.ins_num = ins_num_;
+
+  // lay out the columns
+  const uint64_t offset_bytes = (ins_num_ + 1) * sizeof(uint64_t);
+  std::vector<ColumnarSlotMeta> metas(slots_.size());
+  uint64_t pos = AlignTo8(sizeof(header) + metas.size() * sizeof(metas[0]));
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    auto& column = slots_[i];
+    auto& meta = metas[i];
+    meta.type = column.type;
+    meta.reserved = 0;
+    meta.feasign_num = column.offset.back();
+    meta.offset_pos = pos;
+    pos += offset_bytes;
+    meta.value_pos = pos;
+    pos += AlignTo8(meta.feasign_num * (column.type == 'u' ? sizeof(uint64_t)
+                                                           : sizeof(float)));
+  }
+  if (with_ins_id_) {
+    header.ins_id_offset_pos = pos;
+    pos += offset_bytes;
+    header.ins_id_data_pos = pos;
+    pos += AlignTo8(ins_ids_.size());
+  }
+  if (with_content_) {
+    header.content_offset_pos = pos;
+    pos += offset_bytes;
+    header.content_data_pos = pos;
+    pos += AlignTo8(contents_.size());
+  }
+  header.file_size = pos;
+
+  int err_no = 0;
+  std::shared_ptr<FILE> fp = fs_open_write(path, &err_no, "");
+  CHECK(fp != nullptr) << "open " << path << " failed";
+  uint64_t written = 0;
+  auto write = [&fp, &written](const void* data, size_t size) {
+    CHECK_EQ(fwrite(data, 1, size, &*fp), size) << "write failed";
+    written += size;
+  };
+  auto pad = [&write, &written]() {
+    static const char zeros[8] = {0};
+    write(zeros, AlignTo8(written) - written);
+  };
+  write(&header, sizeof(header));
+  write(metas.data(), metas.size() * sizeof(metas[0]));
+  pad();
+  for (auto& column : slots_) {
+    write(column.offset.data(), offset_bytes);
+    if (column.type == 'u') {
+      write(column.uint64_values.data(),
+            column.uint64_values.size() * sizeof(uint64_t));
+    } else {
+      write(column.float_values.data(),
+            column.float_values.size() * sizeof(float));
+    }
+    pad();
+  }
+  if (with_ins_id_) {
+    write(ins_id_offset_.data(), offset_bytes);
+    write(ins_ids_.data(), ins_ids_.size());
+    pad();
+  }
+  if (with_content_) {
+    write(content_offset_.data(), offset_bytes);
+    write(contents_.data(), contents_.size());
+    pad();
+  }
+  CHECK_EQ(written, header.file_size);
+}
+
+bool ColumnarRecordReader::IsColumnarRecordFile(const char* data,
+                                                size_t size) {
+  if (size < sizeof(ColumnarRecordHeader)) {
+    return false;
+  }
+  auto* header = reinterpret_cast<const ColumnarRecordHeader*>(data);
+  return memcmp(header->magic, kColumnarRecordMagic, sizeof(header->magic)) ==
+             0 &&
+         header->version == kColumnarRecordVersion;
+}
+
+void ColumnarRecordReader::Open(const std::string& path) {
+  data_ = fs_mmap_read(path, &size_);
+  PADDLE_ENFORCE(IsColumnarRecordFile(data_.get(), size_),
+                 "%s is not a columnar record file.", path);
+  header_ = reinterpret_cast<const ColumnarRecordHeader*>(data_.get());
+  PADDLE_ENFORCE_EQ(header_->file_size, size_,
+                    "The columnar record file %s is truncated.", path);
+  PADDLE_ENFORCE_LE(header_->slot_num,
+                    (size_ - sizeof(ColumnarRecordHeader)) /
+                        sizeof(ColumnarSlotMeta),
+                    "The columnar record file %s is broken.", path);
+  PADDLE_ENFORCE_LT(header_->ins_num, size_ / sizeof(uint64_t),
+                    "The columnar record file %s is broken.", path);
+  slots_ = reinterpret_cast<const ColumnarSlotMeta*>(
+      data_.get() + sizeof(ColumnarRecordHeader));
+
+  // The positions and the sizes are read from the file, so the range of a
+  // column is checked as num <= (size_ - pos) / width, which can not
+  // overflow.
+  auto check_column = [this, &path](uint64_t pos, uint64_t num,
+                                    uint64_t width) {
+    PADDLE_ENFORCE(pos % 8 == 0 && pos <= size_ && num <= (size_ - pos) / width,
+                   "The columnar record file %s is broken.", path);
+  };
+  // An offset column starts at 0 and never decreases, return its last value,
+  // i.e. the number of the values of the column.
+  auto check_offset = [this, &path, &check_column](uint64_t pos) {
+    const uint64_t num = header_->ins_num + 1;
+    check_column(pos, num, sizeof(uint64_t));
+    const uint64_t* offset = Column<uint64_t>(pos);
+    PADDLE_ENFORCE(offset[0] == 0 && std::is_sorted(offset, offset + num),
+                   "The columnar record file %s is broken.", path);
+    return offset[num - 1];
+  };
+  for (size_t i = 0; i < header_->slot_num; ++i) {
+    const auto& meta = slots_[i];
+    PADDLE_ENFORCE(meta.type == 'u' || meta.type == 'f',
+                   "Unknown slot type in columnar record file %s.", path);
+    PADDLE_ENFORCE_EQ(check_offset(meta.offset_pos), meta.feasign_num,
+                      "The columnar record file %s is broken.", path);
+    check_column(meta.value_pos, meta.feasign_num,
+                 meta.type == 'u' ? sizeof(uint64_t) : sizeof(float));
+  }
+  if (HasInsId()) {
+    check_column(header_->ins_id_data_pos,
+                 check_offset(header_->ins_id_offset_pos), 1);
+  }
+  if (HasContent()) {
+    check_column(header_->content_data_pos,
+                 check_offset(header_->content_offset_pos), 1);
+  }
+}
+
+void ColumnarRecordReader::GetRecord(size_t i, Record* record) const {
+  size_t uint64_num = 0;
+  size_t float_num = 0;
+  for (size_t s = 0; s < header_->slot_num; ++s) {
+    const uint64_t* offset = Column<uint64_t>(slots_[s].offset_pos);
+    size_t num = offset[i + 1] - offset[i];
+    if (slots_[s].type == 'u') {
+      uint64_num += num;
+    } else {
+      float_num += num;
+    }
+  }
+  record->uint64_feasigns_.resize(uint64_num);
+  record->float_feasigns_.resize(float_num);
+  FeatureItem* uint64_items = record->uint64_feasigns_.data();
+  FeatureItem* float_items = record->float_feasigns_.data();
+  for (size_t s = 0; s < header_->slot_num; ++s) {
+    const auto& meta = slots_[s];
+    const uint64_t* offset = Column<uint64_t>(meta.offset_pos);
+    uint16_t slot = static_cast<uint16_t>(s);
+    if (meta.type == 'u') {
+      const uint64_t* values = Column<uint64_t>(meta.value_pos);
+      for (uint64_t j = offset[i]; j < offset[i + 1]; ++j) {
+        uint64_items->sign().uint64_feasign_ = values[j];
+        uint64_items->slot() = slot;
+        ++uint64_items;
+      }
+    } else {
+      const float* values = Column<float>(meta.value_pos);
+      for (uint64_t j = offset[i]; j < offset[i + 1]; ++j) {
+        float_items->sign().float_feasign_ = values[j];
+        float_items->slot() = slot;
+        ++float_items;
+      }
+    }
+  }
+  if (HasInsId()) {
+    const uint64_t* offset = Column<uint64_t>(header_->ins_id_offset_pos);
+    record->ins_id_.assign(Column<char>(header_->ins_id_data_pos) + offset[i],
+                           offset[i + 1] - offset[i]);
+  }
+  if (HasContent()) {
+    const uint64_t* offset = Column<uint64_t>(header_->content_offset_pos);
+    record->content_.assign(
+        Column<char>(header_->content_data_pos) + offset[i],
+        offset[i + 1] - offset[i]);
+  }
+}
+
+size_t ConvertMultiSlotTextToColumnar(const DataFeedDesc& data_feed_desc,
+                                      bool parse_ins_id, bool parse_content,
+                                      const std::string& text_path,
+                                      const std::string& columnar_path) {
+  PADDLE_ENFORCE(data_feed_desc.has_multi_slot_desc(),
+                 "Multi_slot_desc has not been set.");
+  const auto& multi_slot_desc = data_feed_desc.multi_slot_desc();
+  std::vector<std::string> all_slots_type;
+  std::vector<int> use_slots_index;
+  std::vector<bool> use_slots_is_dense;
+  std::vector<std::string> use_slots_type;
+  for (int i = 0; i < multi_slot_desc.slots_size(); ++i) {
+    const auto& slot = multi_slot_desc.slots(i);
+    all_slots_type.push_back(slot.type());
+    use_slots_index.push_back(
+        slot.is_used() ? static_cast<int>(use_slots_type.size()) : -1);
+    if (slot.is_used()) {
+      use_slots_type.push_back(slot.type());
+      use_slots_is_dense.push_back(slot.is_dense());
+    }
+  }
+
+  MultiSlotBufferParser parser;
+  parser.Init(all_slots_type, use_slots_index, use_slots_is_dense,
+              parse_ins_id, parse_content);
+  ColumnarRecordWriter writer(use_slots_type, parse_ins_id, parse_content);
+  int err_no = 0;
+  std::shared_ptr<FILE> fp =
+      fs_open_read(text_path, &err_no, data_feed_desc.pipe_command());
+  CHECK(fp != nullptr) << "open " << text_path << " failed";
+  Record record;
+  parser.ParseFile(&*fp, [&writer, &record](const RecordBlock& block) {
+    for (size_t i = 0; i < block.Size(); ++i) {
+      block.ToRecord(i, &record);
+      writer.Add(record);
+    }
+  });
+  fp = nullptr;
+  writer.Save(columnar_path);
+  VLOG(3) << "convert " << text_path << " to " << columnar_path << ", "
+          << writer.Size() << " instances";
+  return writer.Size();
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,138 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/data_feed.h"
+
+namespace paddle {
+namespace framework {
+
+// The columnar record file stores the Records of a MultiSlot dataset so that
+// they can be loaded without parsing text. All the integers are in the byte
+// order of the host, and every column starts at a multiple of 8 bytes, so a
+// mapped file is used in place:
+//
+//   ColumnarRecordHeader
+//   ColumnarSlotMeta * slot_num
+//   for every slot:
+//     uint64 offset[ins_num + 1]   // feasigns of ins i: [offset[i], offset[i+1])
+//     uint64 or float value[feasign_num]
+//   uint64 ins_id_offset[ins_num + 1] and ins_id bytes     (optional)
+//   uint64 content_offset[ins_num + 1] and content bytes   (optional)
+//
+// The slots are the used slots of the DataFeedDesc, in the order of
+// FeatureItem::slot().
+struct ColumnarRecordHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t slot_num;
+  uint64_t ins_num;
+  uint64_t ins_id_offset_pos;  // 0 if there is no ins_id
+  uint64_t ins_id_data_pos;
+  uint64_t content_offset_pos;  // 0 if there is no content
+  uint64_t content_data_pos;
+  uint64_t file_size;
+};
+
+struct ColumnarSlotMeta {
+  uint32_t type;  // 'u' for uint64, 'f' for float
+  uint32_t reserved;
+  uint64_t feasign_num;
+  uint64_t offset_pos;
+  uint64_t value_pos;
+};
+
+// Collect Records into columns and save them as a columnar record file.
+class ColumnarRecordWriter {
+ public:
+  // slot_types are the types ("uint64" or "float") of the used slots
+  ColumnarRecordWriter(const std::vector<std::string>& slot_types,
+                       bool with_ins_id, bool with_content);
+
+  void Add(const Record& record);
+
+  size_t Size() const { return ins_num_; }
+
+  void Save(const std::string& path) const;
+
+ private:
+  struct SlotColumn {
+    char type;
+    std::vector<uint64_t> offset;
+    std::vector<uint64_t> uint64_values;
+    std::vector<float> float_values;
+  };
+
+  std::vector<SlotColumn> slots_;
+  bool with_ins_id_;
+  bool with_content_;
+  size_t ins_num_ = 0;
+  std::vector<uint64_t> ins_id_offset_;
+  std::string ins_ids_;
+  std::vector<uint64_t> content_offset_;
+  std::string contents_;
+};
+
+// Read a columnar record file through fs_mmap_read. Local files are mapped
+// and shared with the page cache, hdfs files are read into memory once.
+class ColumnarRecordReader {
+ public:
+  ColumnarRecordReader() {}
+
+  void Open(const std::string& path);
+
+  // Check the header of data, i.e. whether it is a columnar record file
+  static bool IsColumnarRecordFile(const char* data, size_t size);
+
+  size_t Size() const { return header_->ins_num; }
+
+  size_t SlotNum() const { return header_->slot_num; }
+
+  char SlotType(size_t slot) const { return slots_[slot].type; }
+
+  bool HasInsId() const { return header_->ins_id_offset_pos != 0; }
+
+  bool HasContent() const { return header_->content_offset_pos != 0; }
+
+  // Fill the i-th instance into record, every vector of the record is
+  // allocated once with its exact size.
+  void GetRecord(size_t i, Record* record) const;
+
+ private:
+  template <typename T>
+  const T* Column(uint64_t pos) const {
+    return reinterpret_cast<const T*>(data_.get() + pos);
+  }
+
+  std::shared_ptr<const char> data_;
+  size_t size_ = 0;
+  const ColumnarRecordHeader* header_ = nullptr;
+  const ColumnarSlotMeta* slots_ = nullptr;
+};
+
+// Convert a MultiSlot text file to a columnar record file. The text file is
+// read through the pipe_command of data_feed_desc, like DataFeed does.
+// Return the number of converted instances.
+size_t ConvertMultiSlotTextToColumnar(const DataFeedDesc& data_feed_desc,
+                                      bool parse_ins_id, bool parse_content,
+                                      const std::string& text_path,
+                                      const std::string& columnar_path);
+
+}  // namespace framework
+}  // namespace paddle
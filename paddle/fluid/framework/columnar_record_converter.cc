@@ -0,0 +1,62 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Convert MultiSlot text files to columnar record files.
+// Usage:
+//   columnar_record_converter --data_feed_desc=data_feed.prototxt \
+//       --input=part-0,part-1 --output_dir=columnar --parse_ins_id=true
+
+#include <fcntl.h>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/text_format.h"
+#include "paddle/fluid/framework/columnar_record.h"
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/string/string_helper.h"
+
+DEFINE_string(data_feed_desc, "",
+              "The DataFeedDesc of the text files in protobuf text format.");
+DEFINE_string(input, "", "The text files to convert, separated by comma.");
+DEFINE_string(output_dir, "", "The directory of the columnar record files.");
+DEFINE_bool(parse_ins_id, false, "Whether the text files have ins_id.");
+DEFINE_bool(parse_content, false, "Whether the text files have content.");
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  CHECK(!FLAGS_data_feed_desc.empty()) << "--data_feed_desc is required";
+  CHECK(!FLAGS_output_dir.empty()) << "--output_dir is required";
+
+  paddle::framework::DataFeedDesc data_feed_desc;
+  int fd = open(FLAGS_data_feed_desc.c_str(), O_RDONLY);
+  PCHECK(fd >= 0) << "open " << FLAGS_data_feed_desc << " failed";
+  google::protobuf::io::FileInputStream input(fd);
+  CHECK(google::protobuf::TextFormat::Parse(&input, &data_feed_desc))
+      << "parse " << FLAGS_data_feed_desc << " failed";
+  close(fd);
+
+  paddle::framework::fs_mkdir(FLAGS_output_dir);
+  for (auto& path : paddle::string::split_string(FLAGS_input, ",")) {
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    std::string output = FLAGS_output_dir + "/" + name + ".columnar";
+    size_t ins_num = paddle::framework::ConvertMultiSlotTextToColumnar(
+        data_feed_desc, FLAGS_parse_ins_id, FLAGS_parse_content, path, output);
+    LOG(INFO) << "convert " << path << " to " << output << ", " << ins_num
+              << " instances";
+  }
+  return 0;
+}
@@ -0,0 +1,213 @@
+//   Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/columnar_record.h"
+#include <stdio.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/data_feed_parser.h"
+
+namespace paddle {
+namespace framework {
+
+static Record MakeRecord(int i) {
+  Record rec;
+  FeatureKey key;
+  // slot 0: uint64, slot 1: float, slot 2: uint64
+  for (int j = 0; j <= i % 3; ++j) {
+    key.uint64_feasign_ = i * 100 + j;
+    rec.uint64_feasigns_.push_back(FeatureItem(key, 0));
+  }
+  key.float_feasign_ = i * 0.5f;
+  rec.float_feasigns_.push_back(FeatureItem(key, 1));
+  if (i % 2 == 0) {
+    key.uint64_feasign_ = 18446744073709551615ULL - i;
+    rec.uint64_feasigns_.push_back(FeatureItem(key, 2));
+  }
+  rec.ins_id_ = "ins_" + std::to_string(i);
+  rec.content_ = i % 4 == 0 ? "" : "content_" + std::to_string(i);
+  return rec;
+}
+
+static void ExpectSameRecord(const Record& a, const Record& b) {
+  ASSERT_EQ(a.uint64_feasigns_.size(), b.uint64_feasigns_.size());
+  for (size_t i = 0; i < a.uint64_feasigns_.size(); ++i) {
+    EXPECT_EQ(a.uint64_feasigns_[i].slot(), b.uint64_feasigns_[i].slot());
+    EXPECT_EQ(a.uint64_feasigns_[i].sign().uint64_feasign_,
+              b.uint64_feasigns_[i].sign().uint64_feasign_);
+  }
+  ASSERT_EQ(a.float_feasigns_.size(), b.float_feasigns_.size());
+  for (size_t i = 0; i < a.float_feasigns_.size(); ++i) {
+    EXPECT_EQ(a.float_feasigns_[i].slot(), b.float_feasigns_[i].slot());
+    EXPECT_EQ(a.float_feasigns_[i].sign().float_feasign_,
+              b.float_feasigns_[i].sign().float_feasign_);
+  }
+  EXPECT_EQ(a.ins_id_, b.ins_id_);
+  EXPECT_EQ(a.content_, b.content_);
+}
+
+TEST(ColumnarRecord, WriteAndRead) {
+  const std::string path = "test_columnar_record.bin";
+  ColumnarRecordWriter writer({"uint64", "float", "uint64"}, true, true);
+  for (int i = 0; i < 100; ++i) {
+    writer.Add(MakeRecord(i));
+  }
+  writer.Save(path);
+
+  ColumnarRecordReader reader;
+  reader.Open(path);
+  ASSERT_EQ(reader.Size(), 100UL);
+  ASSERT_EQ(reader.SlotNum(), 3UL);
+  EXPECT_EQ(reader.SlotType(0), 'u');
+  EXPECT_EQ(reader.SlotType(1), 'f');
+  EXPECT_TRUE(reader.HasInsId());
+  EXPECT_TRUE(reader.HasContent());
+  for (int i = 0; i < 100; ++i) {
+    Record rec;
+    reader.GetRecord(i, &rec);
+    ExpectSameRecord(MakeRecord(i), rec);
+  }
+  remove(path.c_str());
+}
+
+TEST(ColumnarRecord, WithoutInsId) {
+  const std::string path = "test_columnar_record_no_ins_id.bin";
+  ColumnarRecordWriter writer({"uint64", "float", "uint64"}, false, false);
+  writer.Add(MakeRecord(1));
+  writer.Save(path);
+
+  ColumnarRecordReader reader;
+  reader.Open(path);
+  EXPECT_FALSE(reader.HasInsId());
+  EXPECT_FALSE(reader.HasContent());
+  Record rec;
+  reader.GetRecord(0, &rec);
+  EXPECT_EQ(rec.uint64_feasigns_.size(), 2UL);
+  EXPECT_TRUE(rec.ins_id_.empty());
+  remove(path.c_str());
+}
+
+TEST(ColumnarRecord, RejectTextFile) {
+  const std::string path = "test_columnar_record_text.txt";
+  std::ofstream(path) << "1 1 1 0.5 1 2\n";
+  ColumnarRecordReader reader;
+  EXPECT_THROW(reader.Open(path), paddle::platform::EnforceNotMet);
+  remove(path.c_str());
+}
+
+// Save 10 records, let corrupt modify the bytes of the file, and check that
+// the reader rejects it.
+template <typename Corrupt>
+static void ExpectRejectCorruptFile(Corrupt corrupt) {
+  const std::string path = "test_columnar_record_corrupt.bin";
+  ColumnarRecordWriter writer({"uint64", "float", "uint64"}, true, true);
+  for (int i = 0; i < 10; ++i) {
+    writer.Add(MakeRecord(i));
+  }
+  writer.Save(path);
+  std::string data;
+  {
+    std::ifstream in(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(in),
+                std::istreambuf_iterator<char>());
+  }
+  auto* header = reinterpret_cast<ColumnarRecordHeader*>(&data[0]);
+  auto* slots = reinterpret_cast<ColumnarSlotMeta*>(&data[sizeof(*header)]);
+  corrupt(&data[0], header, slots);
+  std::ofstream(path, std::ios::binary) << data;
+
+  ColumnarRecordReader reader;
+  EXPECT_THROW(reader.Open(path), paddle::platform::EnforceNotMet);
+  remove(path.c_str());
+}
+
+TEST(ColumnarRecord, RejectCorruptFile) {
+  // the values of a slot overflow the file
+  ExpectRejectCorruptFile(
+      [](char* data, ColumnarRecordHeader* header, ColumnarSlotMeta* slots) {
+        slots[0].feasign_num = 1ULL << 62;
+        reinterpret_cast<uint64_t*>(data + slots[0].offset_pos)[10] =
+            slots[0].feasign_num;
+      });
+  // a decreasing offset of a slot
+  ExpectRejectCorruptFile(
+      [](char* data, ColumnarRecordHeader* header, ColumnarSlotMeta* slots) {
+        reinterpret_cast<uint64_t*>(data + slots[1].offset_pos)[5] = 100;
+      });
+  // the ins_id offset does not start at 0
+  ExpectRejectCorruptFile(
+      [](char* data, ColumnarRecordHeader* header, ColumnarSlotMeta* slots) {
+        reinterpret_cast<uint64_t*>(data + header->ins_id_offset_pos)[0] = 1;
+      });
+  // a content offset out of the file
+  ExpectRejectCorruptFile(
+      [](char* data, ColumnarRecordHeader* header, ColumnarSlotMeta* slots) {
+        auto* offset =
+            reinterpret_cast<uint64_t*>(data + header->content_offset_pos);
+        offset[9] = offset[10] = header->file_size;
+      });
+  // too many instances
+  ExpectRejectCorruptFile(
+      [](char* data, ColumnarRecordHeader* header, ColumnarSlotMeta* slots) {
+        header->ins_num = ~0ULL;
+      });
+}
+
+TEST(ColumnarRecord, ConvertText) {
+  const std::string text_path = "test_columnar_record_convert.txt";
+  const std::string columnar_path = "test_columnar_record_convert.bin";
+  std::string data =
+      "1 ins_a 3 1 2 3 1 0.5 1 7 2 4 0\n"
+      "1 ins_b 1 9 2 0.25 0 1 8 1 5\n";
+  std::ofstream(text_path) << data;
+
+  DataFeedDesc desc;
+  desc.set_pipe_command("cat");
+  auto* multi_slot_desc = desc.mutable_multi_slot_desc();
+  const char* types[] = {"uint64", "float", "uint64", "uint64"};
+  for (int i = 0; i < 4; ++i) {
+    auto* slot = multi_slot_desc->add_slots();
+    slot->set_name("slot_" + std::to_string(i));
+    slot->set_type(types[i]);
+    slot->set_is_used(i != 2);
+    slot->set_is_dense(i == 3);
+  }
+  EXPECT_EQ(ConvertMultiSlotTextToColumnar(desc, true, false, text_path,
+                                           columnar_path),
+            2UL);
+
+  MultiSlotBufferParser parser;
+  parser.Init({"uint64", "float", "uint64", "uint64"}, {0, 1, -1, 2},
+              {false, false, true}, true, false);
+  RecordBlock block;
+  parser.Parse(data.c_str(), data.c_str() + data.size(), true, &block);
+
+  ColumnarRecordReader reader;
+  reader.Open(columnar_path);
+  ASSERT_EQ(reader.Size(), block.Size());
+  for (size_t i = 0; i < reader.Size(); ++i) {
+    Record expect, actual;
+    block.ToRecord(i, &expect);
+    reader.GetRecord(i, &actual);
+    ExpectSameRecord(expect, actual);
+  }
+  remove(text_path.c_str());
+  remove(columnar_path.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle
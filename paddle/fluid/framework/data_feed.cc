@@ -31,11 +31,17 @@ limitations under the License. */
 #include "google/protobuf/text_format.h"
 #include "io/fs.h"
 #include "io/shell.h"
+#include "paddle/fluid/framework/columnar_record.h"
+#include "paddle/fluid/framework/data_feed_parser.h"
 #include "paddle/fluid/framework/feed_fetch_method.h"
 #include "paddle/fluid/framework/feed_fetch_type.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
 #include "paddle/fluid/platform/timer.h"
 
+DEFINE_bool(enable_multi_slot_buffer_parser, false,
+            "If set, MultiSlotInMemoryDataFeed parses whole read buffers in "
+            "place with MultiSlotBufferParser instead of one line at a time.");
+
 namespace paddle {
 namespace framework {
 
@@ -350,6 +356,7 @@ void InMemoryDataFeed<T>::LoadIntoMemory() {
 
 // explicit instantiation
 template class InMemoryDataFeed<Record>;
+template class InMemoryDataFeed<ArenaRecord>;
 
 void MultiSlotDataFeed::Init(
     const paddle::framework::DataFeedDesc& data_feed_desc) {
@@ -578,11 +585,9 @@ bool MultiSlotDataFeed::ParseOneInstanceFromPipe(
         }
         pos = endptr - str;
       } else {
+        // skip the count and the feasigns of the unused slot
         for (int j = 0; j <= num; ++j) {
-          // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
-            pos++;
-          }
+          pos = line.find_first_of(' ', pos + 1);
         }
       }
     }
@@ -697,55 +702,286 @@ void MultiSlotDataFeed::PutToFeedVec(
 #endif
 }
 
-void MultiSlotInMemoryDataFeed::Init(
+template <typename T>
+void MultiSlotInMemoryDataFeedBase<T>::Init(
     const paddle::framework::DataFeedDesc& data_feed_desc) {
-  finish_init_ = false;
-  finish_set_filelist_ = false;
-  finish_start_ = false;
+  this->finish_init_ = false;
+  this->finish_set_filelist_ = false;
+  this->finish_start_ = false;
 
   PADDLE_ENFORCE(data_feed_desc.has_multi_slot_desc(),
                  "Multi_slot_desc has not been set.");
   paddle::framework::MultiSlotDesc multi_slot_desc =
       data_feed_desc.multi_slot_desc();
-  SetBatchSize(data_feed_desc.batch_size());
+  this->SetBatchSize(data_feed_desc.batch_size());
   size_t all_slot_num = multi_slot_desc.slots_size();
-  all_slots_.resize(all_slot_num);
-  all_slots_type_.resize(all_slot_num);
-  use_slots_index_.resize(all_slot_num);
-  total_dims_without_inductive_.resize(all_slot_num);
-  inductive_shape_index_.resize(all_slot_num);
-  use_slots_.clear();
-  use_slots_is_dense_.clear();
+  this->all_slots_.resize(all_slot_num);
+  this->all_slots_type_.resize(all_slot_num);
+  this->use_slots_index_.resize(all_slot_num);
+  this->total_dims_without_inductive_.resize(all_slot_num);
+  this->inductive_shape_index_.resize(all_slot_num);
+  this->use_slots_.clear();
+  this->use_slots_is_dense_.clear();
   for (size_t i = 0; i < all_slot_num; ++i) {
     const auto& slot = multi_slot_desc.slots(i);
-    all_slots_[i] = slot.name();
-    all_slots_type_[i] = slot.type();
-    use_slots_index_[i] = slot.is_used() ? use_slots_.size() : -1;
-    total_dims_without_inductive_[i] = 1;
-    inductive_shape_index_[i] = -1;
+    this->all_slots_[i] = slot.name();
+    this->all_slots_type_[i] = slot.type();
+    this->use_slots_index_[i] = slot.is_used() ? this->use_slots_.size() : -1;
+    this->total_dims_without_inductive_[i] = 1;
+    this->inductive_shape_index_[i] = -1;
     if (slot.is_used()) {
-      use_slots_.push_back(all_slots_[i]);
-      use_slots_is_dense_.push_back(slot.is_dense());
+      this->use_slots_.push_back(this->all_slots_[i]);
+      this->use_slots_is_dense_.push_back(slot.is_dense());
       std::vector<int> local_shape;
       if (slot.is_dense()) {
         for (size_t j = 0; j < slot.shape_size(); ++j) {
           if (slot.shape(j) > 0) {
-            total_dims_without_inductive_[i] *= slot.shape(j);
+            this->total_dims_without_inductive_[i] *= slot.shape(j);
           }
           if (slot.shape(j) == -1) {
-            inductive_shape_index_[i] = j;
+            this->inductive_shape_index_[i] = j;
           }
         }
       }
       for (size_t j = 0; j < slot.shape_size(); ++j) {
         local_shape.push_back(slot.shape(j));
       }
-      use_slots_shape_.push_back(local_shape);
+      this->use_slots_shape_.push_back(local_shape);
     }
   }
-  feed_vec_.resize(use_slots_.size());
-  pipe_command_ = data_feed_desc.pipe_command();
-  finish_init_ = true;
+  this->feed_vec_.resize(this->use_slots_.size());
+  this->pipe_command_ = data_feed_desc.pipe_command();
+  this->data_format_ = data_feed_desc.data_format();
+  PADDLE_ENFORCE(
+      this->data_format_ == "text" || this->data_format_ == "columnar",
+      "Unknown data format %s.", this->data_format_);
+  this->finish_init_ = true;
+}
+
+// The feasigns, ins_id and content of an instance, for
+// MultiSlotInMemoryDataFeedBase<T>::PutToFeedVec
+static const std::vector<FeatureItem>& Uint64Feasigns(const Record& r) {
+  return r.uint64_feasigns_;
+}
+
+static FeatureItemRange Uint64Feasigns(const ArenaRecord& r) {
+  return r.uint64_feasigns();
+}
+
+static const std::vector<FeatureItem>& FloatFeasigns(const Record& r) {
+  return r.float_feasigns_;
+}
+
+static FeatureItemRange FloatFeasigns(const ArenaRecord& r) {
+  return r.float_feasigns();
+}
+
+static const std::string& InsId(const Record& r) { return r.ins_id_; }
+
+static std::string InsId(const ArenaRecord& r) { return r.ins_id(); }
+
+static const std::string& Content(const Record& r) { return r.content_; }
+
+static std::string Content(const ArenaRecord& r) { return r.content(); }
+
+template <typename T>
+void MultiSlotInMemoryDataFeedBase<T>::PutToFeedVec(
+    const std::vector<T>& ins_vec) {
+#ifdef _LINUX
+  const size_t use_slot_num = this->use_slots_.size();
+  std::vector<std::vector<float>> batch_float_feasigns(use_slot_num,
+                                                       std::vector<float>());
+  std::vector<std::vector<uint64_t>> batch_uint64_feasigns(
+      use_slot_num, std::vector<uint64_t>());
+  std::vector<std::vector<size_t>> offset(use_slot_num,
+                                          std::vector<size_t>{0});
+  std::vector<bool> visit(use_slot_num, false);
+  this->ins_content_vec_.clear();
+  this->ins_content_vec_.reserve(ins_vec.size());
+  this->ins_id_vec_.clear();
+  this->ins_id_vec_.reserve(ins_vec.size());
+  for (size_t i = 0; i < ins_vec.size(); ++i) {
+    auto& r = ins_vec[i];
+    this->ins_id_vec_.push_back(InsId(r));
+    this->ins_content_vec_.push_back(Content(r));
+    for (auto& item : FloatFeasigns(r)) {
+      batch_float_feasigns[item.slot()].push_back(item.sign().float_feasign_);
+      visit[item.slot()] = true;
+    }
+    for (auto& item : Uint64Feasigns(r)) {
+      batch_uint64_feasigns[item.slot()].push_back(item.sign().uint64_feasign_);
+      visit[item.slot()] = true;
+    }
+    for (size_t j = 0; j < use_slot_num; ++j) {
+      const auto& type = this->all_slots_type_[j];
+      if (visit[j]) {
+        visit[j] = false;
+      } else {
+        // fill slot value with default value 0
+        if (type[0] == 'f') {  // float
+          batch_float_feasigns[j].push_back(0.0);
+        } else if (type[0] == 'u') {  // uint64
+          batch_uint64_feasigns[j].push_back(0);
+        }
+      }
+      // get offset of this ins in this slot
+      if (type[0] == 'f') {  // float
+        offset[j].push_back(batch_float_feasigns[j].size());
+      } else if (type[0] == 'u') {  // uint64
+        offset[j].push_back(batch_uint64_feasigns[j].size());
+      }
+    }
+  }
+
+  for (size_t i = 0; i < use_slot_num; ++i) {
+    LoDTensor* feed = this->feed_vec_[i];
+    if (feed == nullptr) {
+      continue;
+    }
+    int total_instance = offset[i].back();
+    const auto& type = this->all_slots_type_[i];
+    if (type[0] == 'f') {  // float
+      float* feasign = batch_float_feasigns[i].data();
+      float* tensor_ptr =
+          feed->mutable_data<float>({total_instance, 1}, this->place_);
+      this->CopyToFeedTensor(tensor_ptr, feasign,
+                             total_instance * sizeof(float));
+    } else if (type[0] == 'u') {  // uint64
+      // no uint64_t type in paddlepaddle
+      uint64_t* feasign = batch_uint64_feasigns[i].data();
+      int64_t* tensor_ptr =
+          feed->mutable_data<int64_t>({total_instance, 1}, this->place_);
+      this->CopyToFeedTensor(tensor_ptr, feasign,
+                             total_instance * sizeof(int64_t));
+    }
+    auto& slot_offset = offset[i];
+    LoD data_lod{slot_offset};
+    feed->set_lod(data_lod);
+    if (this->use_slots_is_dense_[i]) {
+      if (this->inductive_shape_index_[i] != -1) {
+        this->use_slots_shape_[i][this->inductive_shape_index_[i]] =
+            total_instance / this->total_dims_without_inductive_[i];
+      }
+      feed->Resize(framework::make_ddim(this->use_slots_shape_[i]));
+    }
+  }
+#endif
+}
+
+template <typename T>
+void MultiSlotInMemoryDataFeedBase<T>::LoadIntoMemory() {
+#ifdef _LINUX
+  if (this->data_format_ == "columnar") {
+    LoadColumnarIntoMemory();
+    return;
+  }
+  VLOG(3) << "LoadIntoMemory() begin, thread_id=" << this->thread_id_;
+  MultiSlotBufferParser parser;
+  parser.Init(this->all_slots_type_, this->use_slots_index_,
+              this->use_slots_is_dense_, this->parse_ins_id_,
+              this->parse_content_);
+  std::string filename;
+  while (this->PickOneFile(&filename)) {
+    VLOG(3) << "PickOneFile, filename=" << filename
+            << ", thread_id=" << this->thread_id_;
+    int err_no = 0;
+    this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_);
+    CHECK(this->fp_ != nullptr);
+    __fsetlocking(&*(this->fp_), FSETLOCKING_BYCALLER);
+    paddle::framework::ChannelWriter<T> writer(this->input_channel_);
+    platform::Timer timeline;
+    timeline.Start();
+    size_t ins_num = parser.ParseFile(
+        &*(this->fp_), [this, &writer](const RecordBlock& block) {
+          WriteBlock(block, &writer);
+        });
+    writer.Flush();
+    timeline.Pause();
+    VLOG(3) << "LoadIntoMemory() read " << ins_num
+            << " instances, file=" << filename
+            << ", cost time=" << timeline.ElapsedSec()
+            << " seconds, thread_id=" << this->thread_id_;
+  }
+  VLOG(3) << "LoadIntoMemory() end, thread_id=" << this->thread_id_;
+#endif
+}
+
+template <typename T>
+void MultiSlotInMemoryDataFeedBase<T>::LoadColumnarIntoMemory() {
+#ifdef _LINUX
+  VLOG(3) << "LoadColumnarIntoMemory() begin, thread_id=" << this->thread_id_;
+  std::string filename;
+  while (this->PickOneFile(&filename)) {
+    VLOG(3) << "PickOneFile, filename=" << filename
+            << ", thread_id=" << this->thread_id_;
+    platform::Timer timeline;
+    timeline.Start();
+    ColumnarRecordReader reader;
+    reader.Open(filename);
+    PADDLE_ENFORCE_EQ(reader.SlotNum(), this->use_slots_.size(),
+                      "The slot num of %s does not match the DataFeedDesc.",
+                      filename);
+    for (size_t i = 0, j = 0; i < this->all_slots_type_.size(); ++i) {
+      if (this->use_slots_index_[i] == -1) {
+        continue;
+      }
+      PADDLE_ENFORCE(reader.SlotType(j++) == this->all_slots_type_[i][0],
+                     "The type of slot %s in %s does not match.",
+                     this->all_slots_[i], filename);
+    }
+    PADDLE_ENFORCE(!this->parse_ins_id_ || reader.HasInsId(),
+                   "The ins_id is parsed but %s has no ins_id column.",
+                   filename);
+    PADDLE_ENFORCE(!this->parse_content_ || reader.HasContent(),
+                   "The content is parsed but %s has no content column.",
+                   filename);
+    paddle::framework::ChannelWriter<T> writer(this->input_channel_);
+    WriteColumnarRecords(reader, &writer);
+    writer.Flush();
+    timeline.Pause();
+    VLOG(3) << "LoadColumnarIntoMemory() read " << reader.Size()
+            << " instances, file=" << filename
+            << ", cost time=" << timeline.ElapsedSec()
+            << " seconds, thread_id=" << this->thread_id_;
+  }
+  VLOG(3) << "LoadColumnarIntoMemory() end, thread_id=" << this->thread_id_;
+#endif
+}
+
+// explicit instantiation
+template class MultiSlotInMemoryDataFeedBase<Record>;
+template class MultiSlotInMemoryDataFeedBase<ArenaRecord>;
+
+void MultiSlotInMemoryDataFeed::LoadIntoMemory() {
+  if (!FLAGS_enable_multi_slot_buffer_parser && data_format_ != "columnar") {
+    InMemoryDataFeed<Record>::LoadIntoMemory();
+    return;
+  }
+  MultiSlotInMemoryDataFeedBase<Record>::LoadIntoMemory();
+}
+
+void MultiSlotInMemoryDataFeed::WriteBlock(const RecordBlock& block,
+                                           ChannelWriter<Record>* writer) {
+  for (size_t i = 0; i < block.Size(); ++i) {
+    Record instance;
+    block.ToRecord(i, &instance);
+    *writer << std::move(instance);
+  }
+}
+
+void MultiSlotInMemoryDataFeed::WriteColumnarRecords(
+    const ColumnarRecordReader& reader, ChannelWriter<Record>* writer) {
+  for (size_t i = 0; i < reader.Size(); ++i) {
+    Record instance;
+    reader.GetRecord(i, &instance);
+    if (!parse_ins_id_) {
+      instance.ins_id_.clear();
+    }
+    if (!parse_content_) {
+      instance.content_.clear();
+    }
+    *writer << std::move(instance);
+  }
 }
 
 bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
@@ -800,7 +1036,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
             float feasign = strtof(endptr, &endptr);
             // if float feasign is equal to zero, ignore it
             // except when slot is dense
-            if (fabs(feasign) < 1e-6 && !use_slots_is_dense_[i]) {
+            if (fabs(feasign) < 1e-6 && !use_slots_is_dense_[idx]) {
               continue;
             }
             FeatureKey f;
@@ -812,7 +1048,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
             uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
             // if uint64 feasign is equal to zero, ignore it
             // except when slot is dense
-            if (feasign == 0 && !use_slots_is_dense_[i]) {
+            if (feasign == 0 && !use_slots_is_dense_[idx]) {
               continue;
             }
             FeatureKey f;
@@ -822,11 +1058,9 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
         }
         pos = endptr - str;
       } else {
+        // skip the count and the feasigns of the unused slot
         for (int j = 0; j <= num; ++j) {
-          // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
-            pos++;
-          }
+          pos = line.find_first_of(' ', pos + 1);
         }
       }
     }
@@ -898,83 +1132,43 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
   return false;
 }
 
-void MultiSlotInMemoryDataFeed::PutToFeedVec(
-    const std::vector<Record>& ins_vec) {
-#ifdef _LINUX
-  std::vector<std::vector<float>> batch_float_feasigns(use_slots_.size(),
-                                                       std::vector<float>());
-  std::vector<std::vector<uint64_t>> batch_uint64_feasigns(
-      use_slots_.size(), std::vector<uint64_t>());
-  std::vector<std::vector<size_t>> offset(use_slots_.size(),
-                                          std::vector<size_t>{0});
-  std::vector<bool> visit(use_slots_.size(), false);
-  ins_content_vec_.clear();
-  ins_content_vec_.reserve(ins_vec.size());
-  ins_id_vec_.clear();
-  ins_id_vec_.reserve(ins_vec.size());
-  for (size_t i = 0; i < ins_vec.size(); ++i) {
-    auto& r = ins_vec[i];
-    ins_id_vec_.push_back(r.ins_id_);
-    ins_content_vec_.push_back(r.content_);
-    for (auto& item : r.float_feasigns_) {
-      batch_float_feasigns[item.slot()].push_back(item.sign().float_feasign_);
-      visit[item.slot()] = true;
-    }
-    for (auto& item : r.uint64_feasigns_) {
-      batch_uint64_feasigns[item.slot()].push_back(item.sign().uint64_feasign_);
-      visit[item.slot()] = true;
-    }
-    for (size_t j = 0; j < use_slots_.size(); ++j) {
-      const auto& type = all_slots_type_[j];
-      if (visit[j]) {
-        visit[j] = false;
-      } else {
-        // fill slot value with default value 0
-        if (type[0] == 'f') {  // float
-          batch_float_feasigns[j].push_back(0.0);
-        } else if (type[0] == 'u') {  // uint64
-          batch_uint64_feasigns[j].push_back(0);
-        }
-      }
-      // get offset of this ins in this slot
-      if (type[0] == 'f') {  // float
-        offset[j].push_back(batch_float_feasigns[j].size());
-      } else if (type[0] == 'u') {  // uint64
-        offset[j].push_back(batch_uint64_feasigns[j].size());
-      }
-    }
+void MultiSlotArenaInMemoryDataFeed::WriteBlock(
+    const RecordBlock& block, ChannelWriter<ArenaRecord>* writer) {
+  // the copy drops the capacity the parser reserved
+  std::shared_ptr<const RecordBlock> arena =
+      std::make_shared<RecordBlock>(block);
+  for (size_t i = 0; i < arena->Size(); ++i) {
+    *writer << ArenaRecord(arena, i);
   }
+}
 
-  for (size_t i = 0; i < use_slots_.size(); ++i) {
-    if (feed_vec_[i] == nullptr) {
-      continue;
-    }
-    int total_instance = offset[i].back();
-    const auto& type = all_slots_type_[i];
-    if (type[0] == 'f') {  // float
-      float* feasign = batch_float_feasigns[i].data();
-      float* tensor_ptr =
-          feed_vec_[i]->mutable_data<float>({total_instance, 1}, this->place_);
-      CopyToFeedTensor(tensor_ptr, feasign, total_instance * sizeof(float));
-    } else if (type[0] == 'u') {  // uint64
-      // no uint64_t type in paddlepaddle
-      uint64_t* feasign = batch_uint64_feasigns[i].data();
-      int64_t* tensor_ptr = feed_vec_[i]->mutable_data<int64_t>(
-          {total_instance, 1}, this->place_);
-      CopyToFeedTensor(tensor_ptr, feasign, total_instance * sizeof(int64_t));
-    }
-    auto& slot_offset = offset[i];
-    LoD data_lod{slot_offset};
-    feed_vec_[i]->set_lod(data_lod);
-    if (use_slots_is_dense_[i]) {
-      if (inductive_shape_index_[i] != -1) {
-        use_slots_shape_[i][inductive_shape_index_[i]] =
-            total_instance / total_dims_without_inductive_[i];
-      }
-      feed_vec_[i]->Resize(framework::make_ddim(use_slots_shape_[i]));
+void MultiSlotArenaInMemoryDataFeed::WriteColumnarRecords(
+    const ColumnarRecordReader& reader, ChannelWriter<ArenaRecord>* writer) {
+  // the number of instances sharing one RecordBlock
+  const size_t block_ins_num = 4096;
+  RecordBlock block;
+  Record instance;
+  for (size_t i = 0; i < reader.Size(); ++i) {
+    reader.GetRecord(i, &instance);
+    block.Append(instance, parse_ins_id_, parse_content_);
+    if (block.Size() == block_ins_num || i + 1 == reader.Size()) {
+      WriteBlock(block, writer);
+      block.Clear();
     }
   }
-#endif
+}
+
+bool MultiSlotArenaInMemoryDataFeed::ParseOneInstanceFromPipe(
+    ArenaRecord* instance) {
+  PADDLE_THROW(
+      "MultiSlotArenaInMemoryDataFeed parses whole buffers in "
+      "LoadIntoMemory, ParseOneInstanceFromPipe is not supported.");
+}
+
+bool MultiSlotArenaInMemoryDataFeed::ParseOneInstance(ArenaRecord* instance) {
+  PADDLE_THROW(
+      "MultiSlotArenaInMemoryDataFeed parses whole buffers in "
+      "LoadIntoMemory, ParseOneInstance is not supported.");
 }
 
 #if defined(PADDLE_WITH_CUDA) && !defined(_WIN32)
@@ -172,6 +172,8 @@ class DataFeed {
   bool finish_set_filelist_;
   bool finish_start_;
   std::string pipe_command_;
+  // "text" or "columnar", see DataFeedDesc
+  std::string data_format_;
   std::vector<std::string> ins_id_vec_;
   std::vector<std::string> ins_content_vec_;
   platform::Place place_;
@@ -441,6 +443,145 @@ struct Record {
   std::string content_;
 };
 
+// RecordBlock stores the instances of a block contiguously. The feasigns of
+// all instances live in two arenas, and instance i owns the items in
+// [offset[i], offset[i + 1]) of each arena. ins_id and content are
+// concatenated the same way, their offsets only grow if they are parsed.
+struct RecordBlock {
+  RecordBlock() { Clear(); }
+
+  // Reset the block but keep the capacity of the arenas
+  void Clear() {
+    uint64_feasigns_.clear();
+    float_feasigns_.clear();
+    ins_id_buffer_.clear();
+    content_buffer_.clear();
+    uint64_offset_.assign(1, 0);
+    float_offset_.assign(1, 0);
+    ins_id_offset_.assign(1, 0);
+    content_offset_.assign(1, 0);
+  }
+
+  size_t Size() const { return uint64_offset_.size() - 1; }
+
+  bool HasInsId() const { return ins_id_offset_.size() > 1; }
+
+  bool HasContent() const { return content_offset_.size() > 1; }
+
+  // Copy the i-th instance out of the arenas. Every vector of the record is
+  // allocated with its exact size.
+  void ToRecord(size_t i, Record* record) const {
+    record->uint64_feasigns_.assign(
+        uint64_feasigns_.begin() + uint64_offset_[i],
+        uint64_feasigns_.begin() + uint64_offset_[i + 1]);
+    record->float_feasigns_.assign(
+        float_feasigns_.begin() + float_offset_[i],
+        float_feasigns_.begin() + float_offset_[i + 1]);
+    if (HasInsId()) {
+      record->ins_id_.assign(ins_id_buffer_, ins_id_offset_[i],
+                             ins_id_offset_[i + 1] - ins_id_offset_[i]);
+    }
+    if (HasContent()) {
+      record->content_.assign(content_buffer_, content_offset_[i],
+                              content_offset_[i + 1] - content_offset_[i]);
+    }
+  }
+
+  // Append a copy of record as the last instance. with_ins_id and
+  // with_content must be the same for all the instances of a block.
+  void Append(const Record& record, bool with_ins_id, bool with_content) {
+    uint64_feasigns_.insert(uint64_feasigns_.end(),
+                            record.uint64_feasigns_.begin(),
+                            record.uint64_feasigns_.end());
+    uint64_offset_.push_back(uint64_feasigns_.size());
+    float_feasigns_.insert(float_feasigns_.end(),
+                           record.float_feasigns_.begin(),
+                           record.float_feasigns_.end());
+    float_offset_.push_back(float_feasigns_.size());
+    if (with_ins_id) {
+      ins_id_buffer_.append(record.ins_id_);
+      ins_id_offset_.push_back(ins_id_buffer_.size());
+    }
+    if (with_content) {
+      content_buffer_.append(record.content_);
+      content_offset_.push_back(content_buffer_.size());
+    }
+  }
+
+  std::vector<FeatureItem> uint64_feasigns_;
+  std::vector<FeatureItem> float_feasigns_;
+  std::vector<size_t> uint64_offset_;
+  std::vector<size_t> float_offset_;
+  std::string ins_id_buffer_;
+  std::string content_buffer_;
+  std::vector<size_t> ins_id_offset_;
+  std::vector<size_t> content_offset_;
+};
+
+struct FeatureItemRange {
+  const FeatureItem* begin() const { return begin_; }
+  const FeatureItem* end() const { return end_; }
+  size_t size() const { return end_ - begin_; }
+
+  const FeatureItem* begin_;
+  const FeatureItem* end_;
+};
+
+// ArenaRecord is the i-th instance of a RecordBlock shared by all the
+// instances of the block, so an instance in memory costs no heap allocation
+// of its own. Copying an ArenaRecord only copies a pointer and an index,
+// which makes shuffling and passing instances through channels cheap. The
+// block is immutable once it is shared.
+class ArenaRecord {
+ public:
+  ArenaRecord() : index_(0) {}
+  ArenaRecord(const std::shared_ptr<const RecordBlock>& block, size_t index)
+      : block_(block), index_(index) {}
+
+  FeatureItemRange uint64_feasigns() const {
+    const FeatureItem* data = block_->uint64_feasigns_.data();
+    return {data + block_->uint64_offset_[index_],
+            data + block_->uint64_offset_[index_ + 1]};
+  }
+
+  FeatureItemRange float_feasigns() const {
+    const FeatureItem* data = block_->float_feasigns_.data();
+    return {data + block_->float_offset_[index_],
+            data + block_->float_offset_[index_ + 1]};
+  }
+
+  const char* ins_id_data() const {
+    return block_->HasInsId()
+               ? block_->ins_id_buffer_.data() + block_->ins_id_offset_[index_]
+               : "";
+  }
+
+  size_t ins_id_size() const {
+    return block_->HasInsId() ? block_->ins_id_offset_[index_ + 1] -
+                                    block_->ins_id_offset_[index_]
+                              : 0;
+  }
+
+  std::string ins_id() const {
+    return std::string(ins_id_data(), ins_id_size());
+  }
+
+  std::string content() const {
+    if (!block_->HasContent()) {
+      return std::string();
+    }
+    return block_->content_buffer_.substr(
+        block_->content_offset_[index_],
+        block_->content_offset_[index_ + 1] - block_->content_offset_[index_]);
+  }
+
+  void ToRecord(Record* record) const { block_->ToRecord(index_, record); }
+
+ private:
+  std::shared_ptr<const RecordBlock> block_;
+  size_t index_;
+};
+
 struct RecordCandidate {
   std::string ins_id_;
   std::unordered_multimap<uint16_t, FeatureKey> feas;
@@ -526,6 +667,34 @@ paddle::framework::Archive<AR>& operator>>(paddle::framework::Archive<AR>& ar,
   return ar;
 }
 
+// ArenaRecord is serialized in the format of Record, so instances can be
+// read back as either of them.
+template <class AR>
+paddle::framework::Archive<AR>& operator<<(paddle::framework::Archive<AR>& ar,
+                                           const FeatureItemRange& items) {
+#ifdef _LINUX
+  ar << (size_t)items.size();
+#else
+  ar << (uint64_t)items.size();
+#endif
+  for (const auto& item : items) {
+    ar << item;
+  }
+  return ar;
+}
+
+inline BinaryArchive& operator<<(BinaryArchive& ar, const ArenaRecord& r) {
+  ar << r.uint64_feasigns();
+  ar << r.float_feasigns();
+#ifdef _LINUX
+  ar << (size_t)r.ins_id_size();
+#else
+  ar << (uint64_t)r.ins_id_size();
+#endif
+  ar.Write(r.ins_id_data(), r.ins_id_size());
+  return ar;
+}
+
 // This DataFeed is used to feed multi-slot type data.
 // The format of multi-slot type data:
 //   [n feasign_0 feasign_1 ... feasign_n]*
@@ -547,16 +716,67 @@ class MultiSlotDataFeed
   virtual void PutToFeedVec(const std::vector<MultiSlotType>& ins_vec);
 };
 
-class MultiSlotInMemoryDataFeed : public InMemoryDataFeed<Record> {
+class ColumnarRecordReader;
+
+// MultiSlotInMemoryDataFeedBase sets up the slots from the DataFeedDesc,
+// loads the files, and puts a batch of instances of type T (Record or
+// ArenaRecord) to the feed_vec for the in-memory MultiSlot DataFeeds.
+template <typename T>
+class MultiSlotInMemoryDataFeedBase : public InMemoryDataFeed<T> {
+ public:
+  MultiSlotInMemoryDataFeedBase() {}
+  virtual ~MultiSlotInMemoryDataFeedBase() {}
+  virtual void Init(const DataFeedDesc& data_feed_desc);
+  // Parse the files with MultiSlotBufferParser, or read the columnar record
+  // files without parsing if data_format is "columnar"
+  virtual void LoadIntoMemory();
+
+ protected:
+  virtual void LoadColumnarIntoMemory();
+  // Write the instances of a block parsed to the input channel
+  virtual void WriteBlock(const RecordBlock& block,
+                          ChannelWriter<T>* writer) = 0;
+  // Write the instances of a columnar record file checked to the input
+  // channel
+  virtual void WriteColumnarRecords(const ColumnarRecordReader& reader,
+                                    ChannelWriter<T>* writer) = 0;
+  virtual void PutToFeedVec(const std::vector<T>& ins_vec);
+};
+
+class MultiSlotInMemoryDataFeed
+    : public MultiSlotInMemoryDataFeedBase<Record> {
  public:
   MultiSlotInMemoryDataFeed() {}
   virtual ~MultiSlotInMemoryDataFeed() {}
-  virtual void Init(const DataFeedDesc& data_feed_desc);
+  // Parse the files one line at a time unless
+  // FLAGS_enable_multi_slot_buffer_parser is on or data_format is "columnar"
+  virtual void LoadIntoMemory();
 
  protected:
+  virtual void WriteBlock(const RecordBlock& block,
+                          ChannelWriter<Record>* writer);
+  virtual void WriteColumnarRecords(const ColumnarRecordReader& reader,
+                                    ChannelWriter<Record>* writer);
   virtual bool ParseOneInstance(Record* instance);
   virtual bool ParseOneInstanceFromPipe(Record* instance);
-  virtual void PutToFeedVec(const std::vector<Record>& ins_vec);
+};
+
+// MultiSlotArenaInMemoryDataFeed reads the same data as
+// MultiSlotInMemoryDataFeed, but keeps the instances of every parsed buffer
+// in one RecordBlock and passes ArenaRecords around.
+class MultiSlotArenaInMemoryDataFeed
+    : public MultiSlotInMemoryDataFeedBase<ArenaRecord> {
+ public:
+  MultiSlotArenaInMemoryDataFeed() {}
+  virtual ~MultiSlotArenaInMemoryDataFeed() {}
+
+ protected:
+  virtual void WriteBlock(const RecordBlock& block,
+                          ChannelWriter<ArenaRecord>* writer);
+  virtual void WriteColumnarRecords(const ColumnarRecordReader& reader,
+                                    ChannelWriter<ArenaRecord>* writer);
+  virtual bool ParseOneInstance(ArenaRecord* instance);
+  virtual bool ParseOneInstanceFromPipe(ArenaRecord* instance);
 };
 
 #if defined(PADDLE_WITH_CUDA) && !defined(_WIN32)
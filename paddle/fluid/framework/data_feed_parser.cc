@@ -0,0 +1,347 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/data_feed_parser.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__) && !defined(_WIN32)
+#include <emmintrin.h>
+#define PADDLE_DATA_FEED_PARSER_SSE2
+#endif
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+// A uint64 has at most 20 decimal digits, and every number with at most 19
+// digits fits in it without overflow.
+constexpr size_t kMaxFastDigits = 19;
+
+inline bool IsBlank(char c) { return static_cast<unsigned char>(c) <= ' '; }
+
+inline bool IsDigit(char c) {
+  return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// Skip the blanks in [p, line_end), never beyond the end of the line.
+inline const char* SkipBlank(const char* p, const char* line_end) {
+  while (p < line_end && IsBlank(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+// Return the first blank byte in [p, end), or end if there is none.
+inline const char* FindTokenEnd(const char* p, const char* end) {
+#ifdef PADDLE_DATA_FEED_PARSER_SSE2
+  const __m128i blank = _mm_set1_epi8(' ');
+  for (; p + 16 <= end; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // a byte is blank iff max(byte, ' ') == ' ' in unsigned comparison
+    int mask = _mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_max_epu8(chunk, blank), blank));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+#endif
+  while (p < end && !IsBlank(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+// Count the ' ' and '\n' in [begin, end). It is an upper bound of the number
+// of feasigns in the buffer, and is used to size the arenas before parsing.
+inline size_t CountDelimiters(const char* begin, const char* end) {
+  size_t count = 0;
+  const char* p = begin;
+#ifdef PADDLE_DATA_FEED_PARSER_SSE2
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i newline = _mm_set1_epi8('\n');
+  for (; p + 16 <= end; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                               _mm_cmpeq_epi8(chunk, newline));
+    count += __builtin_popcount(_mm_movemask_epi8(hit));
+  }
+#endif
+  for (; p < end; ++p) {
+    count += (*p == ' ' || *p == '\n');
+  }
+  return count;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PADDLE_DATA_FEED_PARSER_SWAR
+// Check whether all the eight bytes loaded in chunk are in ['0', '9'].
+inline bool IsEightDigits(uint64_t chunk) {
+  return (((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+           (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+          0x3333333333333333ULL);
+}
+
+// Decode eight decimal digits loaded in chunk, the first byte being the most
+// significant digit.
+inline uint64_t ParseEightDigits(uint64_t chunk) {
+  chunk = (chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+  chunk = (chunk & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+  return (chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32;
+}
+#endif
+
+// Parse the unsigned decimal number starting at p, which is not blank. The
+// digits are decoded eight at a time, and everything the fast path can not
+// handle exactly falls back to strtoull.
+inline const char* ParseUint64(const char* p, const char* line_end,
+                               uint64_t* value) {
+  const char* start = p;
+  uint64_t v = 0;
+#ifdef PADDLE_DATA_FEED_PARSER_SWAR
+  while (p + 8 <= line_end) {
+    uint64_t chunk;
+    memcpy(&chunk, p, sizeof(chunk));
+    if (!IsEightDigits(chunk)) {
+      break;
+    }
+    v = v * 100000000ULL + ParseEightDigits(chunk);
+    p += 8;
+  }
+#endif
+  while (p < line_end && IsDigit(*p)) {
+    v = v * 10 + static_cast<uint64_t>(*p - '0');
+    ++p;
+  }
+  size_t digits = p - start;
+  if (digits == 0 || digits > kMaxFastDigits ||
+      (p < line_end && !IsBlank(*p))) {
+    char* endptr = nullptr;
+    *value = static_cast<uint64_t>(strtoull(start, &endptr, 10));
+    return endptr;
+  }
+  *value = v;
+  return p;
+}
+
+// Parse the number of feasigns of a slot.
+inline const char* ParseCount(const char* p, const char* line_end, int* num) {
+  p = SkipBlank(p, line_end);
+  if (p == line_end) {
+    *num = 0;
+    return p;
+  }
+  if (!IsDigit(*p)) {
+    char* endptr = nullptr;
+    *num = static_cast<int>(strtol(p, &endptr, 10));
+    return endptr;
+  }
+  uint64_t v = 0;
+  p = ParseUint64(p, line_end, &v);
+  *num = static_cast<int>(v);
+  return p;
+}
+
+// Parse a "1 <token>" field such as ins_id and content, and append the token
+// to buffer.
+inline const char* ParseStringField(const char* p, const char* line_end,
+                                    const char* line, std::string* buffer,
+                                    std::vector<size_t>* offset) {
+  int num = 0;
+  p = ParseCount(p, line_end, &num);
+  CHECK(num == 1) << "the ins_id and content must have exactly one token: "
+                  << std::string(line, line_end);
+  p = SkipBlank(p, line_end);
+  const char* token_end = FindTokenEnd(p, line_end);
+  buffer->append(p, token_end - p);
+  offset->push_back(buffer->size());
+  return token_end;
+}
+
+}  // namespace
+
+void MultiSlotBufferParser::Init(const std::vector<std::string>& all_slots_type,
+                                 const std::vector<int>& use_slots_index,
+                                 const std::vector<bool>& use_slots_is_dense,
+                                 bool parse_ins_id, bool parse_content) {
+  PADDLE_ENFORCE_EQ(all_slots_type.size(), use_slots_index.size(),
+                    "The size of slot types and slot indices must be equal.");
+  slot_types_.resize(all_slots_type.size());
+  has_float_slot_ = false;
+  has_uint64_slot_ = false;
+  for (size_t i = 0; i < all_slots_type.size(); ++i) {
+    const std::string& type = all_slots_type[i];
+    PADDLE_ENFORCE((type == "uint64") || (type == "float"),
+                   "There is no this type<%s>.", type);
+    slot_types_[i] = type[0];
+    if (use_slots_index[i] != -1) {
+      PADDLE_ENFORCE_LT(static_cast<size_t>(use_slots_index[i]),
+                        use_slots_is_dense.size(),
+                        "The index of used slot is out of range.");
+      has_float_slot_ |= (type[0] == 'f');
+      has_uint64_slot_ |= (type[0] == 'u');
+    }
+  }
+  use_slots_index_ = use_slots_index;
+  use_slots_is_dense_ = use_slots_is_dense;
+  parse_ins_id_ = parse_ins_id;
+  parse_content_ = parse_content;
+}
+
+void MultiSlotBufferParser::SetReadBufferSize(size_t size) {
+  PADDLE_ENFORCE_GT(size, 0, "Illegal read buffer size: %d.", size);
+  read_buffer_size_ = size;
+}
+
+const char* MultiSlotBufferParser::ParseLine(const char* p,
+                                             const char* line_end,
+                                             RecordBlock* block) {
+  const char* line = p;
+  if (parse_ins_id_) {
+    p = ParseStringField(p, line_end, line, &block->ins_id_buffer_,
+                         &block->ins_id_offset_);
+  }
+  if (parse_content_) {
+    p = ParseStringField(p, line_end, line, &block->content_buffer_,
+                         &block->content_offset_);
+  }
+  for (size_t i = 0; i < slot_types_.size(); ++i) {
+    int idx = use_slots_index_[i];
+    int num = 0;
+    p = ParseCount(p, line_end, &num);
+    PADDLE_ENFORCE(
+        num != 0,
+        "The number of ids can not be zero, you need padding "
+        "it in data generator; or if there is something wrong with "
+        "the data, please check if the data contains unresolvable "
+        "characters.\nplease check this error line: %s",
+        std::string(line, line_end));
+    if (idx == -1) {
+      for (int j = 0; j < num; ++j) {
+        p = FindTokenEnd(SkipBlank(p, line_end), line_end);
+      }
+      continue;
+    }
+    bool is_dense = use_slots_is_dense_[idx];
+    uint16_t slot = static_cast<uint16_t>(idx);
+    if (slot_types_[i] == 'f') {  // float
+      for (int j = 0; j < num; ++j) {
+        p = SkipBlank(p, line_end);
+        float feasign = 0;
+        if (p < line_end) {
+          char* endptr = nullptr;
+          feasign = strtof(p, &endptr);
+          p = endptr;
+        }
+        // if float feasign is equal to zero, ignore it
+        // except when slot is dense
+        if (fabs(feasign) < 1e-6 && !is_dense) {
+          continue;
+        }
+        FeatureKey f;
+        f.float_feasign_ = feasign;
+        block->float_feasigns_.emplace_back(f, slot);
+      }
+    } else {  // uint64
+      for (int j = 0; j < num; ++j) {
+        p = SkipBlank(p, line_end);
+        uint64_t feasign = 0;
+        if (p < line_end) {
+          p = ParseUint64(p, line_end, &feasign);
+        }
+        // if uint64 feasign is equal to zero, ignore it
+        // except when slot is dense
+        if (feasign == 0 && !is_dense) {
+          continue;
+        }
+        FeatureKey f;
+        f.uint64_feasign_ = feasign;
+        block->uint64_feasigns_.emplace_back(f, slot);
+      }
+    }
+  }
+  block->uint64_offset_.push_back(block->uint64_feasigns_.size());
+  block->float_offset_.push_back(block->float_feasigns_.size());
+  return p;
+}
+
+const char* MultiSlotBufferParser::Parse(const char* begin, const char* end,
+                                         bool is_last, RecordBlock* block) {
+  size_t max_feasign_num = CountDelimiters(begin, end) + 1;
+  if (has_uint64_slot_) {
+    block->uint64_feasigns_.reserve(block->uint64_feasigns_.size() +
+                                    max_feasign_num);
+  }
+  if (has_float_slot_) {
+    block->float_feasigns_.reserve(block->float_feasigns_.size() +
+                                   max_feasign_num);
+  }
+  const char* p = begin;
+  while (p < end) {
+    const char* line_end =
+        static_cast<const char*>(memchr(p, '\n', end - p));
+    if (line_end == nullptr) {
+      if (!is_last) {
+        break;
+      }
+      line_end = end;
+    }
+    ParseLine(p, line_end, block);
+    p = (line_end == end) ? end : line_end + 1;
+  }
+  return p;
+}
+
+size_t MultiSlotBufferParser::ParseFile(
+    FILE* fp, const std::function<void(const RecordBlock&)>& consumer) {
+  // one more byte for the '\0' terminator required by Parse
+  if (buffer_.size() < read_buffer_size_ + 1) {
+    buffer_.resize(read_buffer_size_ + 1);
+  }
+  size_t data_len = 0;
+  size_t ins_num = 0;
+  bool eof = false;
+  while (!eof) {
+    if (data_len + 1 == buffer_.size()) {
+      // a single line does not fit in the buffer
+      buffer_.resize(buffer_.size() * 2);
+    }
+    size_t len =
+        fread(buffer_.data() + data_len, 1, buffer_.size() - 1 - data_len, fp);
+    if (len == 0) {
+      CHECK(feof(fp));
+      eof = true;
+    }
+    data_len += len;
+    buffer_[data_len] = '\0';
+
+    block_.Clear();
+    const char* begin = buffer_.data();
+    const char* rest = Parse(begin, begin + data_len, eof, &block_);
+    if (block_.Size() > 0) {
+      ins_num += block_.Size();
+      consumer(block_);
+    }
+    // move the incomplete line to the front of the buffer
+    data_len = begin + data_len - rest;
+    memmove(buffer_.data(), rest, data_len);
+  }
+  return ins_num;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,129 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Compare LoadIntoMemory of MultiSlotInMemoryDataFeed with the line-by-line
+// parser and with MultiSlotBufferParser on a generated MultiSlot file.
+// Usage:
+//   data_feed_parser_benchmark --lines=500000 --slots=100 --feasigns=3
+
+#include <stdio.h>
+#include <fstream>
+#include <mutex>  // NOLINT
+#include <random>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/data_feed.h"
+#include "paddle/fluid/framework/data_feed_factory.h"
+#include "paddle/fluid/platform/timer.h"
+
+DECLARE_bool(enable_multi_slot_buffer_parser);
+
+DEFINE_int32(lines, 200000, "The number of instances in the generated file.");
+DEFINE_int32(slots, 100, "The number of uint64 slots of each instance.");
+DEFINE_int32(feasigns, 3, "The max number of feasigns in each slot.");
+DEFINE_int32(repeat, 3, "Repeat times of each parser.");
+DEFINE_string(data_file, "data_feed_parser_benchmark.txt",
+              "The path of the generated file.");
+
+namespace paddle {
+namespace framework {
+
+static void GenerateFile(const std::string& path) {
+  std::mt19937_64 rng(0);
+  std::ofstream os(path);
+  for (int l = 0; l < FLAGS_lines; ++l) {
+    for (int i = 0; i < FLAGS_slots; ++i) {
+      int num = 1 + rng() % FLAGS_feasigns;
+      os << num;
+      for (int j = 0; j < num; ++j) {
+        os << " " << (rng() >> (rng() % 40));
+      }
+      os << (i + 1 == FLAGS_slots ? "\n" : " ");
+    }
+  }
+}
+
+static DataFeedDesc MakeDesc() {
+  DataFeedDesc desc;
+  desc.set_name("MultiSlotInMemoryDataFeed");
+  desc.set_batch_size(32);
+  auto* multi_slot_desc = desc.mutable_multi_slot_desc();
+  for (int i = 0; i < FLAGS_slots; ++i) {
+    auto* slot = multi_slot_desc->add_slots();
+    slot->set_name("slot_" + std::to_string(i));
+    slot->set_type("uint64");
+    slot->set_is_dense(false);
+    slot->set_is_used(true);
+  }
+  return desc;
+}
+
+static double RunLoadIntoMemory(bool use_buffer_parser, size_t* ins_num,
+                                 uint64_t* checksum) {
+  FLAGS_enable_multi_slot_buffer_parser = use_buffer_parser;
+  std::mutex mutex;
+  size_t file_idx = 0;
+  auto channel = MakeChannel<Record>();
+  auto reader = DataFeedFactory::CreateDataFeed("MultiSlotInMemoryDataFeed");
+  reader->Init(MakeDesc());
+  reader->SetFileListMutex(&mutex);
+  reader->SetFileListIndex(&file_idx);
+  reader->SetFileList({FLAGS_data_file});
+  reader->SetInputChannel(channel.get());
+
+  platform::Timer timer;
+  timer.Start();
+  reader->LoadIntoMemory();
+  timer.Pause();
+
+  std::vector<Record> records;
+  channel->ReadAll(records);
+  *ins_num = records.size();
+  *checksum = 0;
+  for (auto& rec : records) {
+    for (auto& item : rec.uint64_feasigns_) {
+      *checksum = *checksum * 31 + item.sign().uint64_feasign_ + item.slot();
+    }
+  }
+  return timer.ElapsedMS();
+}
+
+static void RunBenchmark() {
+  GenerateFile(FLAGS_data_file);
+  for (bool use_buffer_parser : {false, true}) {
+    double total_ms = 0;
+    size_t ins_num = 0;
+    uint64_t checksum = 0;
+    for (int i = 0; i < FLAGS_repeat; ++i) {
+      total_ms += RunLoadIntoMemory(use_buffer_parser, &ins_num, &checksum);
+    }
+    LOG(INFO) << (use_buffer_parser ? "MultiSlotBufferParser" : "line parser")
+              << ": " << ins_num << " instances, checksum " << checksum
+              << ", LoadIntoMemory takes " << total_ms / FLAGS_repeat
+              << " ms on average";
+  }
+  remove(FLAGS_data_file.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::RunBenchmark();
+  return 0;
+}
@@ -0,0 +1,452 @@
+//   Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/data_feed_parser.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/columnar_record.h"
+#include "paddle/fluid/framework/data_feed.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/scope.h"
+
+namespace paddle {
+namespace framework {
+
+struct ParserTestConfig {
+  std::vector<std::string> all_slots_type;
+  std::vector<int> use_slots_index;
+  std::vector<bool> use_slots_is_dense;
+  bool parse_ins_id = false;
+  bool parse_content = false;
+};
+
+static DataFeedDesc MakeDataFeedDesc(const ParserTestConfig& conf) {
+  DataFeedDesc desc;
+  desc.set_batch_size(1);
+  auto* multi_slot_desc = desc.mutable_multi_slot_desc();
+  for (size_t i = 0; i < conf.all_slots_type.size(); ++i) {
+    auto* slot = multi_slot_desc->add_slots();
+    slot->set_name("slot" + std::to_string(i));
+    slot->set_type(conf.all_slots_type[i]);
+    int idx = conf.use_slots_index[i];
+    slot->set_is_used(idx != -1);
+    slot->set_is_dense(idx != -1 && conf.use_slots_is_dense[idx]);
+  }
+  return desc;
+}
+
+// Exposes the line-by-line parsing of MultiSlotInMemoryDataFeed, used as
+// the reference result.
+class LineParserDataFeed : public MultiSlotInMemoryDataFeed {
+ public:
+  explicit LineParserDataFeed(const ParserTestConfig& conf) {
+    Init(MakeDataFeedDesc(conf));
+    SetParseInsId(conf.parse_ins_id);
+    SetParseContent(conf.parse_content);
+  }
+
+  Record Parse(const std::string& line) {
+    std::string text = line + "\n";
+    fp_.reset(fmemopen(&text[0], text.size(), "r"), fclose);
+    Record rec;
+    EXPECT_TRUE(ParseOneInstanceFromPipe(&rec));
+    fp_.reset();
+    return rec;
+  }
+};
+
+static Record ReferenceParse(const ParserTestConfig& conf,
+                             const std::string& line) {
+  LineParserDataFeed data_feed(conf);
+  return data_feed.Parse(line);
+}
+
+static void ExpectSameItems(const std::vector<FeatureItem>& a,
+                            const std::vector<FeatureItem>& b, bool is_float) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(a[i].slot(), b[i].slot());
+    if (is_float) {
+      EXPECT_EQ(a[i].sign().float_feasign_, b[i].sign().float_feasign_);
+    } else {
+      EXPECT_EQ(a[i].sign().uint64_feasign_, b[i].sign().uint64_feasign_);
+    }
+  }
+}
+
+static ParserTestConfig DefaultConfig() {
+  // uint64 sparse, float sparse, unused uint64, uint64 dense, float dense
+  ParserTestConfig conf;
+  conf.all_slots_type = {"uint64", "float", "uint64", "uint64", "float"};
+  conf.use_slots_index = {0, 1, -1, 2, 3};
+  conf.use_slots_is_dense = {false, false, true, true};
+  return conf;
+}
+
+static ParserTestConfig UnusedFirstConfig() {
+  // unused uint64, uint64 dense, unused float, float sparse, uint64 sparse
+  ParserTestConfig conf;
+  conf.all_slots_type = {"uint64", "uint64", "float", "float", "uint64"};
+  conf.use_slots_index = {-1, 0, -1, 1, 2};
+  conf.use_slots_is_dense = {true, false, false};
+  return conf;
+}
+
+static std::string GenerateLines(const ParserTestConfig& conf, int line_num,
+                                 unsigned int seed) {
+  std::mt19937_64 rng(seed);
+  const char* special_tokens[] = {"0",
+                                  "00000000000000000000123",
+                                  "18446744073709551615",
+                                  "18446744073709551616",
+                                  "99999999999999999999999",
+                                  "+42",
+                                  "12345678",
+                                  "1234567890123456789"};
+  std::ostringstream os;
+  for (int l = 0; l < line_num; ++l) {
+    if (conf.parse_ins_id) {
+      os << "1 ins_" << rng() % 100000 << " ";
+    }
+    if (conf.parse_content) {
+      os << "1 content_" << rng() % 100 << " ";
+    }
+    for (size_t i = 0; i < conf.all_slots_type.size(); ++i) {
+      int num = 1 + rng() % 6;
+      os << num;
+      for (int j = 0; j < num; ++j) {
+        os << " ";
+        if (conf.all_slots_type[i][0] == 'f') {
+          if (rng() % 4 == 0) {
+            os << "0.0";
+          } else {
+            os << static_cast<float>(rng() % 100000) / 977.0f;
+          }
+        } else if (rng() % 3 == 0) {
+          os << special_tokens[rng() % 8];
+        } else {
+          os << (rng() >> (rng() % 64));
+        }
+      }
+      os << (i + 1 == conf.all_slots_type.size() ? "" : " ");
+    }
+    os << "\n";
+  }
+  return os.str();
+}
+
+static void CheckParseFile(const ParserTestConfig& conf,
+                           const std::string& data, size_t buffer_size) {
+  MultiSlotBufferParser parser;
+  parser.Init(conf.all_slots_type, conf.use_slots_index,
+              conf.use_slots_is_dense, conf.parse_ins_id, conf.parse_content);
+  parser.SetReadBufferSize(buffer_size);
+
+  FILE* fp = tmpfile();
+  ASSERT_NE(fp, nullptr);
+  fwrite(data.data(), 1, data.size(), fp);
+  rewind(fp);
+  std::vector<Record> records;
+  size_t ins_num =
+      parser.ParseFile(fp, [&records](const RecordBlock& block) {
+        for (size_t i = 0; i < block.Size(); ++i) {
+          Record rec;
+          block.ToRecord(i, &rec);
+          records.push_back(std::move(rec));
+        }
+      });
+  fclose(fp);
+
+  std::istringstream is(data);
+  std::string line;
+  size_t line_num = 0;
+  while (std::getline(is, line)) {
+    ASSERT_LT(line_num, records.size());
+    Record expect = ReferenceParse(conf, line);
+    const Record& actual = records[line_num];
+    ExpectSameItems(expect.uint64_feasigns_, actual.uint64_feasigns_, false);
+    ExpectSameItems(expect.float_feasigns_, actual.float_feasigns_, true);
+    EXPECT_EQ(expect.ins_id_, actual.ins_id_);
+    EXPECT_EQ(expect.content_, actual.content_);
+    ++line_num;
+  }
+  EXPECT_EQ(line_num, records.size());
+  EXPECT_EQ(ins_num, records.size());
+}
+
+TEST(MultiSlotBufferParser, SameAsLineParser) {
+  ParserTestConfig conf = DefaultConfig();
+  std::string data = GenerateLines(conf, 1000, 0);
+  CheckParseFile(conf, data, 1 << 20);
+}
+
+TEST(MultiSlotBufferParser, UnusedSlotBeforeDenseSlot) {
+  ParserTestConfig conf = UnusedFirstConfig();
+  std::string data = GenerateLines(conf, 1000, 6);
+  CheckParseFile(conf, data, 1 << 20);
+  conf.parse_ins_id = true;
+  data = GenerateLines(conf, 200, 7);
+  CheckParseFile(conf, data, 4096);
+}
+
+TEST(MultiSlotBufferParser, LinesAcrossBuffers) {
+  ParserTestConfig conf = DefaultConfig();
+  std::string data = GenerateLines(conf, 200, 1);
+  // buffers smaller than a line force the buffer to grow
+  for (size_t buffer_size : {7, 64, 1000, 4096}) {
+    CheckParseFile(conf, data, buffer_size);
+  }
+}
+
+TEST(MultiSlotBufferParser, InsIdAndContent) {
+  ParserTestConfig conf = DefaultConfig();
+  conf.parse_ins_id = true;
+  conf.parse_content = true;
+  std::string data = GenerateLines(conf, 500, 2);
+  CheckParseFile(conf, data, 1024);
+}
+
+TEST(MultiSlotBufferParser, LastLineWithoutNewline) {
+  ParserTestConfig conf = DefaultConfig();
+  std::string data = GenerateLines(conf, 10, 3);
+  data.pop_back();
+  CheckParseFile(conf, data, 1 << 20);
+}
+
+TEST(MultiSlotBufferParser, ParseBuffer) {
+  ParserTestConfig conf = DefaultConfig();
+  MultiSlotBufferParser parser;
+  parser.Init(conf.all_slots_type, conf.use_slots_index,
+              conf.use_slots_is_dense, false, false);
+  std::string data = "1 5 1 1.5 1 7 2 0 3 1 0\n2 8 0 1 0 1 9 1 2 1 0.5\n3 1";
+  RecordBlock block;
+  const char* begin = data.c_str();
+  const char* rest = parser.Parse(begin, begin + data.size(), false, &block);
+  // the incomplete last line is left to the caller
+  EXPECT_EQ(std::string(rest), "3 1");
+  ASSERT_EQ(block.Size(), 2UL);
+
+  Record rec;
+  block.ToRecord(0, &rec);
+  // the zero in dense slot 2 is kept
+  ASSERT_EQ(rec.uint64_feasigns_.size(), 3UL);
+  EXPECT_EQ(rec.uint64_feasigns_[0].sign().uint64_feasign_, 5UL);
+  EXPECT_EQ(rec.uint64_feasigns_[1].sign().uint64_feasign_, 0UL);
+  EXPECT_EQ(rec.uint64_feasigns_[1].slot(), 2);
+  EXPECT_EQ(rec.uint64_feasigns_[2].sign().uint64_feasign_, 3UL);
+  ASSERT_EQ(rec.float_feasigns_.size(), 2UL);
+  EXPECT_EQ(rec.float_feasigns_[0].sign().float_feasign_, 1.5f);
+  EXPECT_EQ(rec.float_feasigns_[1].sign().float_feasign_, 0.0f);
+
+  block.ToRecord(1, &rec);
+  // the zero in sparse slot 0 is dropped
+  ASSERT_EQ(rec.uint64_feasigns_.size(), 2UL);
+  EXPECT_EQ(rec.uint64_feasigns_[0].sign().uint64_feasign_, 8UL);
+  ASSERT_EQ(rec.float_feasigns_.size(), 1UL);
+  EXPECT_EQ(rec.float_feasigns_[0].sign().float_feasign_, 0.5f);
+}
+
+TEST(MultiSlotBufferParser, ZeroFeasignNum) {
+  ParserTestConfig conf = DefaultConfig();
+  MultiSlotBufferParser parser;
+  parser.Init(conf.all_slots_type, conf.use_slots_index,
+              conf.use_slots_is_dense, false, false);
+  std::string data = "1 5 0 1 7 1 0 1 1.0\n";
+  RecordBlock block;
+  const char* begin = data.c_str();
+  EXPECT_THROW(parser.Parse(begin, begin + data.size(), true, &block),
+               paddle::platform::EnforceNotMet);
+}
+
+TEST(ArenaRecord, SameAsRecord) {
+  ParserTestConfig conf = DefaultConfig();
+  conf.parse_ins_id = true;
+  conf.parse_content = true;
+  std::string data = GenerateLines(conf, 100, 4);
+  MultiSlotBufferParser parser;
+  parser.Init(conf.all_slots_type, conf.use_slots_index,
+              conf.use_slots_is_dense, true, true);
+  RecordBlock block;
+  parser.Parse(data.c_str(), data.c_str() + data.size(), true, &block);
+  std::shared_ptr<const RecordBlock> arena =
+      std::make_shared<RecordBlock>(block);
+  ASSERT_EQ(arena->Size(), 100UL);
+
+  for (size_t i = 0; i < arena->Size(); ++i) {
+    ArenaRecord view(arena, i);
+    Record expect;
+    block.ToRecord(i, &expect);
+    std::vector<FeatureItem> uint64_items(view.uint64_feasigns().begin(),
+                                          view.uint64_feasigns().end());
+    std::vector<FeatureItem> float_items(view.float_feasigns().begin(),
+                                         view.float_feasigns().end());
+    ExpectSameItems(expect.uint64_feasigns_, uint64_items, false);
+    ExpectSameItems(expect.float_feasigns_, float_items, true);
+    EXPECT_EQ(expect.ins_id_, view.ins_id());
+    EXPECT_EQ(expect.content_, view.content());
+  }
+}
+
+TEST(ArenaRecord, SerializeAsRecord) {
+  ParserTestConfig conf = DefaultConfig();
+  conf.parse_ins_id = true;
+  std::string data = GenerateLines(conf, 50, 5);
+  MultiSlotBufferParser parser;
+  parser.Init(conf.all_slots_type, conf.use_slots_index,
+              conf.use_slots_is_dense, true, false);
+  RecordBlock block;
+  parser.Parse(data.c_str(), data.c_str() + data.size(), true, &block);
+  std::shared_ptr<const RecordBlock> arena =
+      std::make_shared<RecordBlock>(block);
+
+  BinaryArchive arena_ar;
+  BinaryArchive record_ar;
+  for (size_t i = 0; i < arena->Size(); ++i) {
+    arena_ar << ArenaRecord(arena, i);
+    Record rec;
+    block.ToRecord(i, &rec);
+    record_ar << rec;
+  }
+  ASSERT_EQ(arena_ar.Length(), record_ar.Length());
+  EXPECT_EQ(std::string(arena_ar.Buffer(), arena_ar.Length()),
+            std::string(record_ar.Buffer(), record_ar.Length()));
+
+  // read back as Records into a new block
+  RecordBlock received;
+  Record rec;
+  while (arena_ar.Cursor() < arena_ar.Finish()) {
+    arena_ar >> rec;
+    received.Append(rec, true, false);
+  }
+  ASSERT_EQ(received.Size(), block.Size());
+  for (size_t i = 0; i < block.Size(); ++i) {
+    Record expect, actual;
+    block.ToRecord(i, &expect);
+    received.ToRecord(i, &actual);
+    ExpectSameItems(expect.uint64_feasigns_, actual.uint64_feasigns_, false);
+    ExpectSameItems(expect.float_feasigns_, actual.float_feasigns_, true);
+    EXPECT_EQ(expect.ins_id_, actual.ins_id_);
+  }
+}
+
+// Exposes PutToFeedVec of the in-memory MultiSlot DataFeeds.
+template <typename Feed>
+class FeedVecDataFeed : public Feed {
+ public:
+  FeedVecDataFeed(const ParserTestConfig& conf, Scope* scope) {
+    this->Init(MakeDataFeedDesc(conf));
+    this->SetPlace(platform::CPUPlace());
+    for (auto& name : this->GetUseSlotAlias()) {
+      this->AddFeedVar(scope->Var(name), name);
+    }
+  }
+
+  template <typename T>
+  void Put(const std::vector<T>& ins_vec) {
+    this->PutToFeedVec(ins_vec);
+  }
+};
+
+TEST(MultiSlotInMemoryDataFeed, ArenaRecordSameFeedVec) {
+  ParserTestConfig conf = DefaultConfig();
+  conf.use_slots_is_dense = {false, false, false, false};
+  conf.parse_ins_id = true;
+  std::string data = GenerateLines(conf, 20, 6);
+  MultiSlotBufferParser parser;
+  parser.Init(conf.all_slots_type, conf.use_slots_index,
+              conf.use_slots_is_dense, true, false);
+  RecordBlock block;
+  parser.Parse(data.c_str(), data.c_str() + data.size(), true, &block);
+  std::shared_ptr<const RecordBlock> arena =
+      std::make_shared<RecordBlock>(block);
+  std::vector<Record> records(block.Size());
+  std::vector<ArenaRecord> arena_records;
+  for (size_t i = 0; i < block.Size(); ++i) {
+    block.ToRecord(i, &records[i]);
+    arena_records.emplace_back(arena, i);
+  }
+
+  Scope record_scope, arena_scope;
+  FeedVecDataFeed<MultiSlotInMemoryDataFeed> record_feed(conf, &record_scope);
+  FeedVecDataFeed<MultiSlotArenaInMemoryDataFeed> arena_feed(conf,
+                                                             &arena_scope);
+  record_feed.Put(records);
+  arena_feed.Put(arena_records);
+  EXPECT_EQ(record_feed.GetInsIdVec(), arena_feed.GetInsIdVec());
+  for (auto& name : record_feed.GetUseSlotAlias()) {
+    auto& expect = record_scope.FindVar(name)->Get<LoDTensor>();
+    auto& actual = arena_scope.FindVar(name)->Get<LoDTensor>();
+    ASSERT_EQ(expect.lod(), actual.lod());
+    ASSERT_EQ(expect.numel(), actual.numel());
+    ASSERT_EQ(expect.type(), actual.type());
+    EXPECT_EQ(memcmp(expect.data<void>(), actual.data<void>(),
+                     expect.numel() * SizeOfType(expect.type())),
+              0);
+  }
+}
+
+// Load a columnar record file with MultiSlotInMemoryDataFeed, which parses
+// the ins_id and the content.
+static void LoadColumnar(const std::string& path) {
+  ParserTestConfig conf;
+  conf.all_slots_type = {"uint64", "float"};
+  conf.use_slots_index = {0, 1};
+  conf.use_slots_is_dense = {false, false};
+  DataFeedDesc desc = MakeDataFeedDesc(conf);
+  desc.set_data_format("columnar");
+  MultiSlotInMemoryDataFeed data_feed;
+  data_feed.Init(desc);
+  data_feed.SetParseInsId(true);
+  data_feed.SetParseContent(true);
+  auto channel = MakeChannel<Record>();
+  data_feed.SetInputChannel(channel.get());
+  std::mutex mutex;
+  size_t file_idx = 0;
+  data_feed.SetFileListMutex(&mutex);
+  data_feed.SetFileListIndex(&file_idx);
+  data_feed.SetFileList({path});
+  data_feed.LoadIntoMemory();
+}
+
+TEST(MultiSlotInMemoryDataFeed, ColumnarWithoutInsId) {
+  const std::string path = "test_data_feed_columnar_no_ins_id.bin";
+  Record rec;
+  FeatureKey key;
+  key.uint64_feasign_ = 1;
+  rec.uint64_feasigns_.push_back(FeatureItem(key, 0));
+  rec.ins_id_ = "ins_1";
+  rec.content_ = "content_1";
+
+  ColumnarRecordWriter writer({"uint64", "float"}, false, false);
+  writer.Add(rec);
+  writer.Save(path);
+  EXPECT_THROW(LoadColumnar(path), platform::EnforceNotMet);
+
+  ColumnarRecordWriter full_writer({"uint64", "float"}, true, true);
+  full_writer.Add(rec);
+  full_writer.Save(path);
+  LoadColumnar(path);
+  remove(path.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -16,6 +16,7 @@
 #include <algorithm>
 #include <random>
 #include <unordered_map>
+#include <utility>
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/text_format.h"
@@ -33,6 +34,38 @@
 namespace paddle {
 namespace framework {
 
+static uint64_t InsIdHash(const Record& rec) {
+  return XXH64(rec.ins_id_.data(), rec.ins_id_.length(), 0);
+}
+
+static uint64_t InsIdHash(const ArenaRecord& rec) {
+  return XXH64(rec.ins_id_data(), rec.ins_id_size(), 0);
+}
+
+static void DeserializeRecords(BinaryArchive* ar, std::vector<Record>* data) {
+  while (ar->Cursor() < ar->Finish()) {
+    data->push_back(ar->Get<Record>());
+  }
+}
+
+// all the instances of a message share one RecordBlock, which keeps the
+// ins_id sent like Record does
+static void DeserializeRecords(BinaryArchive* ar,
+                               std::vector<ArenaRecord>* data) {
+  RecordBlock block;
+  Record rec;
+  while (ar->Cursor() < ar->Finish()) {
+    *ar >> rec;
+    block.Append(rec, true, false);
+  }
+  std::shared_ptr<const RecordBlock> arena =
+      std::make_shared<RecordBlock>(std::move(block));
+  data->reserve(arena->Size());
+  for (size_t i = 0; i < arena->Size(); ++i) {
+    data->emplace_back(arena, i);
+  }
+}
+
 // constructor
 template <typename T>
 DatasetImpl<T>::DatasetImpl() {
@@ -40,6 +73,7 @@ DatasetImpl<T>::DatasetImpl() {
   thread_num_ = 1;
   trainer_num_ = 1;
   channel_num_ = 1;
+  channel_shard_num_ = 0;
   file_idx_ = 0;
   cur_channel_ = 0;
   fleet_send_batch_size_ = 1024;
@@ -107,6 +141,13 @@ void DatasetImpl<T>::SetChannelNum(int channel_num) {
   channel_num_ = channel_num;
 }
 
+template <typename T>
+void DatasetImpl<T>::SetChannelShardNum(int shard_num) {
+  PADDLE_ENFORCE_GE(shard_num, 0, "Illegal channel shard num: %d.",
+                    shard_num);
+  channel_shard_num_ = shard_num;
+}
+
 template <typename T>
 void DatasetImpl<T>::SetParseInsId(bool parse_ins_id) {
   parse_ins_id_ = parse_ins_id;
@@ -150,18 +191,21 @@ std::vector<paddle::framework::DataFeed*> DatasetImpl<T>::GetReaders() {
 template <typename T>
 void DatasetImpl<T>::CreateChannel() {
   if (input_channel_ == nullptr) {
-    input_channel_ = paddle::framework::MakeChannel<T>();
+    input_channel_ =
+        paddle::framework::MakeShardedChannel<T>(channel_shard_num_);
   }
   if (multi_output_channel_.size() == 0) {
     multi_output_channel_.reserve(channel_num_);
     for (int i = 0; i < channel_num_; ++i) {
-      multi_output_channel_.push_back(paddle::framework::MakeChannel<T>());
+      multi_output_channel_.push_back(
+          paddle::framework::MakeShardedChannel<T>(channel_shard_num_));
     }
   }
   if (multi_consume_channel_.size() == 0) {
     multi_consume_channel_.reserve(channel_num_);
     for (int i = 0; i < channel_num_; ++i) {
-      multi_consume_channel_.push_back(paddle::framework::MakeChannel<T>());
+      multi_consume_channel_.push_back(
+          paddle::framework::MakeShardedChannel<T>(channel_shard_num_));
     }
   }
 }
@@ -322,8 +366,7 @@ void DatasetImpl<T>::GlobalShuffle(int thread_num) {
     if (!this->merge_by_insid_) {
       return fleet_ptr->LocalRandomEngine()() % this->trainer_num_;
     } else {
-      return XXH64(data.ins_id_.data(), data.ins_id_.length(), 0) %
-             this->trainer_num_;
+      return InsIdHash(data) % this->trainer_num_;
     }
   };
 
@@ -443,8 +486,10 @@ void DatasetImpl<T>::DynamicAdjustChannelNum(int channel_num) {
   for (int i = 0; i < channel_num; ++i) {
     local_vec.clear();
     total_data_channel->Read(local_vec);
-    new_other_channels.push_back(paddle::framework::MakeChannel<T>());
-    new_channels.push_back(paddle::framework::MakeChannel<T>());
+    new_other_channels.push_back(
+        paddle::framework::MakeShardedChannel<T>(channel_shard_num_));
+    new_channels.push_back(
+        paddle::framework::MakeShardedChannel<T>(channel_shard_num_));
     new_channels[i]->Write(std::move(local_vec));
   }
 
@@ -608,9 +653,7 @@ int DatasetImpl<T>::ReceiveFromClient(int msg_type, int client_id,
     return 0;
   }
   std::vector<T> data;
-  while (ar.Cursor() < ar.Finish()) {
-    data.push_back(ar.Get<T>());
-  }
+  DeserializeRecords(&ar, &data);
   CHECK(ar.Cursor() == ar.Finish());
 
   auto fleet_ptr = FleetWrapper::GetInstance();
@@ -635,6 +678,7 @@ int DatasetImpl<T>::ReceiveFromClient(int msg_type, int client_id,
 
 // explicit instantiation
 template class DatasetImpl<Record>;
+template class DatasetImpl<ArenaRecord>;
 
 void MultiSlotDataset::MergeByInsId() {
   VLOG(3) << "MultiSlotDataset::MergeByInsId begin";
@@ -997,5 +1041,18 @@ void MultiSlotDataset::SlotsShuffle(
           << ", cost time=" << timeline.ElapsedSec() << " seconds";
 }
 
+void MultiSlotArenaDataset::MergeByInsId() {
+  PADDLE_ENFORCE(!merge_by_insid_,
+                 "MultiSlotArenaDataset does not support MergeByInsId, "
+                 "use MultiSlotDataset instead.");
+}
+
+void MultiSlotArenaDataset::SlotsShuffle(
+    const std::set<std::string>& slots_to_replace) {
+  PADDLE_THROW(
+      "MultiSlotArenaDataset does not support SlotsShuffle, "
+      "use MultiSlotDataset instead.");
+}
+
 }  // end namespace framework
 }  // end namespace paddle
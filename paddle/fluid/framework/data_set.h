@@ -58,6 +58,8 @@ class Dataset {
   virtual void SetDataFeedDesc(const std::string& data_feed_desc_str) = 0;
   // set channel num
   virtual void SetChannelNum(int channel_num) = 0;
+  // set the shard num of every channel, <= 1 means unsharded channels
+  virtual void SetChannelShardNum(int shard_num) = 0;
   // set parse ins id
   virtual void SetParseInsId(bool parse_ins_id) = 0;
   virtual void SetParseContent(bool parse_content) = 0;
@@ -147,6 +149,7 @@ class DatasetImpl : public Dataset {
                              const std::string& fs_ugi);
   virtual void SetDataFeedDesc(const std::string& data_feed_desc_str);
   virtual void SetChannelNum(int channel_num);
+  virtual void SetChannelShardNum(int shard_num);
   virtual void SetParseInsId(bool parse_ins_id);
   virtual void SetParseContent(bool parse_content);
   virtual void SetMergeByInsId(const std::vector<std::string>& merge_slot_list,
@@ -197,6 +200,7 @@ class DatasetImpl : public Dataset {
   std::vector<std::shared_ptr<paddle::framework::DataFeed>> preload_readers_;
   paddle::framework::Channel<T> input_channel_;
   int channel_num_;
+  int channel_shard_num_;
   std::vector<paddle::framework::Channel<T>> multi_output_channel_;
   std::vector<paddle::framework::Channel<T>> multi_consume_channel_;
   // when read ins, we put ins from one channel to the other,
@@ -240,5 +244,16 @@ class MultiSlotDataset : public DatasetImpl<Record> {
   virtual ~MultiSlotDataset() {}
 };
 
+// keep the instances in RecordBlocks shared by ArenaRecords, which saves the
+// heap allocations of every instance. MergeByInsId and SlotsShuffle are not
+// supported since they modify the instances.
+class MultiSlotArenaDataset : public DatasetImpl<ArenaRecord> {
+ public:
+  MultiSlotArenaDataset() {}
+  virtual void MergeByInsId();
+  virtual void SlotsShuffle(const std::set<std::string>& slots_to_replace);
+  virtual ~MultiSlotArenaDataset() {}
+};
+
 }  // end namespace framework
 }  // end namespace paddle
@@ -190,7 +190,7 @@ void FastThreadedSSAGraphExecutor::RunOpAsync(
     OpHandleBase *op,
     const std::shared_ptr<BlockingQueue<size_t>> &complete_q) {
   ++remaining_;
-  this->pool_.enqueue([=] {
+  this->pool_.RunAndGetException([=] {
     std::deque<OpHandleBase *> op_queue;
     op_queue.push_front(op);
 
@@ -29,6 +29,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/reader.h"
+#include "paddle/fluid/framework/threadpool.h"
 #include "paddle/fluid/framework/trainer_desc.pb.h"
 #include "paddle/fluid/framework/variable_helper.h"
 #include "paddle/fluid/operators/reader/blocking_queue.h"
@@ -194,8 +195,13 @@ class DownpourWorker : public HogwildWorker {
   void PushGradients();
   void CollectLabelInfo(size_t table_id);
   void AdjustInsWeight();
+  // With pipeline_pull_sparse, return the size of the batch read and pulled
+  // in the background, and start reading and pulling the next one.
+  int NextPipelinedBatch();
+  void ReadAndPullSparse();
 
  private:
+  bool pipeline_pull_sparse_;
   bool need_to_push_dense_;
   bool need_dump_field_;
   bool dump_slot_;
@@ -222,6 +228,14 @@ class DownpourWorker : public HogwildWorker {
   std::map<uint64_t, std::vector<std::vector<float>>> feature_values_;
   // feasign embedding gradient
   std::map<uint64_t, std::vector<std::vector<float>>> feature_grads_;
+  // the feed vars, feasigns and feasign embeddings of the next batch, which
+  // are swapped with those of thread_scope_ when it starts
+  std::unique_ptr<Scope> next_feed_scope_;
+  std::map<uint64_t, std::vector<uint64_t>> next_features_;
+  std::map<uint64_t, std::vector<std::vector<float>>> next_feature_values_;
+  int next_batch_size_;
+  std::future<void> next_batch_ready_;
+  std::unique_ptr<ThreadPool> pull_sparse_pool_;
   // skipped ops
   std::vector<std::string> skip_ops_;
 
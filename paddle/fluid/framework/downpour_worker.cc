@@ -71,6 +71,7 @@ void DownpourWorker::Initialize(const TrainerDesc& desc) {
 
   need_to_push_sparse_ = param_.push_sparse();
   need_to_push_dense_ = param_.push_dense();
+  pipeline_pull_sparse_ = param_.pipeline_pull_sparse();
 
   fleet_ptr_ = FleetWrapper::GetInstance();
   fetch_config_ = desc.fetch_config();
@@ -639,13 +640,81 @@ void DownpourWorker::TrainFilesWithProfiler() {
   }
 }
 
+void DownpourWorker::ReadAndPullSparse() {
+  next_batch_size_ = device_reader_->Next();
+  if (next_batch_size_ <= 0) {
+    return;
+  }
+  for (int i = 0; i < param_.program_config(0).pull_sparse_table_id_size();
+       ++i) {
+    uint64_t tid = static_cast<uint64_t>(
+        param_.program_config(0).pull_sparse_table_id(i));
+    TableParameter table;
+    for (auto j : param_.sparse_table()) {
+      if (j.table_id() == tid) {
+        table = j;
+        break;
+      }
+    }
+    fleet_ptr_->PullSparseVarsSync(
+        *next_feed_scope_, tid, sparse_key_names_[tid], &next_features_[tid],
+        &next_feature_values_[tid], table.fea_dim(), sparse_value_names_[tid]);
+  }
+}
+
+int DownpourWorker::NextPipelinedBatch() {
+  const auto& feed_names = device_reader_->GetUseSlotAlias();
+  if (next_feed_scope_ == nullptr) {
+    // The data feed reads into next_feed_scope_, which holds the embedding
+    // vars of thread_scope_ as well to pull the same slots.
+    next_feed_scope_.reset(new Scope());
+    for (auto& name : feed_names) {
+      next_feed_scope_->Var(name)->GetMutable<LoDTensor>();
+    }
+    for (auto& table : sparse_value_names_) {
+      for (auto& name : table.second) {
+        if (thread_scope_->FindVar(name) != nullptr) {
+          next_feed_scope_->Var(name);
+        }
+      }
+    }
+    if (pull_sparse_pool_ == nullptr) {
+      pull_sparse_pool_.reset(new ThreadPool(1));
+    }
+    device_reader_->AssignFeedVar(*next_feed_scope_);
+    next_batch_ready_ = pull_sparse_pool_->Run([this] { ReadAndPullSparse(); });
+  }
+
+  next_batch_ready_.get();
+  const int cur_batch = next_batch_size_;
+  if (cur_batch <= 0) {
+    device_reader_->AssignFeedVar(*thread_scope_);
+    next_feed_scope_.reset();
+    return cur_batch;
+  }
+  // The tensors of the previous batch are reused to read the next one, as
+  // its gradients have been pushed.
+  for (auto& name : feed_names) {
+    std::swap(*thread_scope_->FindVar(name)->GetMutable<LoDTensor>(),
+              *next_feed_scope_->FindVar(name)->GetMutable<LoDTensor>());
+  }
+  features_.swap(next_features_);
+  feature_values_.swap(next_feature_values_);
+  next_batch_ready_ = pull_sparse_pool_->Run([this] { ReadAndPullSparse(); });
+  return cur_batch;
+}
+
 void DownpourWorker::TrainFiles() {
   VLOG(3) << "Begin to train files";
   platform::SetNumThreads(1);
   device_reader_->Start();
+  // Not pipelined when dumping fields, as the ins ids of the data feed are
+  // those of the batch read last.
+  const bool pipeline = pipeline_pull_sparse_ && !need_dump_field_;
   int batch_cnt = 0;
   int cur_batch;
-  while ((cur_batch = device_reader_->Next()) > 0) {
+  while ((cur_batch = pipeline ? NextPipelinedBatch()
+                               : device_reader_->Next()) > 0) {
     // pull sparse here
     for (int i = 0; i < param_.program_config(0).pull_sparse_table_id_size();
          ++i) {
@@ -658,9 +727,11 @@ void DownpourWorker::TrainFiles() {
           break;
         }
       }
-      fleet_ptr_->PullSparseVarsSync(
-          *thread_scope_, tid, sparse_key_names_[tid], &features_[tid],
-          &feature_values_[tid], table.fea_dim(), sparse_value_names_[tid]);
+      if (!pipeline) {
+        fleet_ptr_->PullSparseVarsSync(
+            *thread_scope_, tid, sparse_key_names_[tid], &features_[tid],
+            &feature_values_[tid], table.fea_dim(), sparse_value_names_[tid]);
+      }
       CollectLabelInfo(i);
       FillSparseValue(i);
       auto nid_iter = std::find(sparse_value_names_[tid].begin(),
@@ -0,0 +1,257 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle/fluid/framework/device_worker.h"
+#include "paddle/fluid/platform/timer.h"
+
+namespace paddle {
+namespace framework {
+
+static const int kBatchNum = 10;
+static const int kBatchSize = 4;
+static const int kEmbDim = 2;
+
+static float FeaValue(uint64_t key, int i) { return key * 10.f + i; }
+
+// Feed the ids 100 * batch + 1 ... of kBatchSize instances, with 0 as the
+// padding of the second one.
+class FakeDataFeed : public DataFeed {
+ public:
+  void Init(const DataFeedDesc& data_feed_desc) override {
+    use_slots_ = {"slot", "click"};
+    feed_vec_.resize(use_slots_.size());
+    finish_init_ = true;
+  }
+
+  bool Start() override {
+    batch_ = 0;
+    return true;
+  }
+
+  int Next() override {
+    if (batch_ == kBatchNum) {
+      return 0;
+    }
+    LoD lod{{0}};
+    std::vector<int64_t> ids;
+    for (int i = 0; i < kBatchSize; ++i) {
+      for (int j = 0; j <= i; ++j) {
+        ids.push_back(i == 1 && j == 0 ? 0 : 100 * batch_ + ids.size() + 1);
+      }
+      lod[0].push_back(ids.size());
+    }
+    int64_t* slot = feed_vec_[0]->mutable_data<int64_t>(
+        {static_cast<int64_t>(ids.size()), 1}, platform::CPUPlace());
+    std::copy(ids.begin(), ids.end(), slot);
+    feed_vec_[0]->set_lod(lod);
+    int64_t* click = feed_vec_[1]->mutable_data<int64_t>({kBatchSize, 1},
+                                                         platform::CPUPlace());
+    for (int i = 0; i < kBatchSize; ++i) {
+      click[i] = (batch_ + i) % 2;
+    }
+    ++batch_;
+    return kBatchSize;
+  }
+
+ private:
+  int batch_ = 0;
+};
+
+// Stand in for the server: a pull takes pull_ms, and a push checks that the
+// batch computed is the one pulled, and takes compute_ms for the ops.
+// If wait_next_pull is set, the push of a batch waits for the pull of the
+// next one, which the pipelined worker issues before it runs the batch, so
+// the overlap is checked without depending on the timings.
+class LocalFleetWrapper : public FleetWrapper {
+ public:
+  LocalFleetWrapper(int pull_ms, int compute_ms, bool wait_next_pull)
+      : pull_ms_(pull_ms),
+        compute_ms_(compute_ms),
+        wait_next_pull_(wait_next_pull) {}
+
+  void PullSparseVarsSync(
+      const Scope& scope, const uint64_t table_id,
+      const std::vector<std::string>& var_names,
+      std::vector<uint64_t>* fea_keys,
+      std::vector<std::vector<float>>* fea_values, int fea_dim,
+      const std::vector<std::string>& var_emb_names) override {
+    *fea_keys = Keys(scope, var_names[0]);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++pulled_;
+    }
+    cond_.notify_all();
+    fea_values->resize(fea_keys->size() + 1);
+    for (size_t i = 0; i < fea_keys->size(); ++i) {
+      (*fea_values)[i].resize(fea_dim);
+      for (int j = 0; j < fea_dim; ++j) {
+        (*fea_values)[i][j] = FeaValue((*fea_keys)[i], j);
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(pull_ms_));
+  }
+
+  void PushSparseVarsWithLabelAsync(
+      const Scope& scope, const uint64_t table_id,
+      const std::vector<uint64_t>& fea_keys,
+      const std::vector<float>& fea_labels,
+      const std::vector<std::string>& sparse_key_names,
+      const std::vector<std::string>& sparse_grad_names, const int emb_dim,
+      std::vector<std::vector<float>>* push_values,
+      std::vector<::std::future<int32_t>>* push_sparse_status,
+      const int batch_size, const bool use_cvm, const bool dump_slot,
+      std::vector<uint64_t>* sparse_push_keys) override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(compute_ms_));
+    EXPECT_EQ(fea_keys, Keys(scope, sparse_key_names[0]));
+    ASSERT_FALSE(fea_keys.empty());
+    const int batch = static_cast<int>(fea_keys[0] / 100);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (wait_next_pull_ && batch + 1 < kBatchNum) {
+        // Only times out if the next pull is never issued.
+        cond_.wait_for(lock, std::chrono::seconds(10),
+                       [this, batch] { return pulled_ > batch + 1; });
+      }
+      if (pulled_ > batch + 1) {
+        ++overlapped_pushes_;
+      }
+    }
+    EXPECT_EQ(fea_labels.size(), fea_keys.size());
+
+    auto& slot = scope.FindVar(sparse_key_names[0])->Get<LoDTensor>();
+    auto& emb = scope.FindVar("emb")->Get<LoDTensor>();
+    ASSERT_EQ(emb.numel(), slot.numel() * emb_dim);
+    for (int64_t i = 0; i < slot.numel(); ++i) {
+      uint64_t key = slot.data<int64_t>()[i];
+      for (int j = 0; j < emb_dim; ++j) {
+        // The values pulled are [show, click, emb...] without cvm.
+        float expected = key == 0 ? 0.f : FeaValue(key, j + 2);
+        EXPECT_EQ(emb.data<float>()[i * emb_dim + j], expected);
+      }
+    }
+    keys_pushed_.insert(keys_pushed_.end(), fea_keys.begin(), fea_keys.end());
+  }
+
+  const std::vector<uint64_t>& keys_pushed() const { return keys_pushed_; }
+  // The pushes issued after the pull of the next batch.
+  int overlapped_pushes() const { return overlapped_pushes_; }
+
+ private:
+  static std::vector<uint64_t> Keys(const Scope& scope,
+                                    const std::string& name) {
+    auto& tensor = scope.FindVar(name)->Get<LoDTensor>();
+    std::vector<uint64_t> keys;
+    for (int64_t i = 0; i < tensor.numel(); ++i) {
+      if (tensor.data<int64_t>()[i] != 0) {
+        keys.push_back(tensor.data<int64_t>()[i]);
+      }
+    }
+    return keys;
+  }
+
+  const int pull_ms_;
+  const int compute_ms_;
+  const bool wait_next_pull_;
+  std::vector<uint64_t> keys_pushed_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  int pulled_{0};
+  int overlapped_pushes_{0};
+};
+
+class LocalDownpourWorker : public DownpourWorker {
+ public:
+  void SetFleet(std::shared_ptr<FleetWrapper> fleet) { fleet_ptr_ = fleet; }
+};
+
+// Train kBatchNum batches and return the seconds taken.
+static double Train(bool pipeline, LocalFleetWrapper* fleet) {
+  TrainerDesc desc;
+  auto* param = desc.mutable_downpour_param();
+  auto* table = param->add_sparse_table();
+  table->set_table_id(0);
+  table->add_sparse_key_name("slot");
+  table->add_sparse_value_name("emb");
+  table->add_sparse_grad_name("emb@GRAD");
+  table->set_label_var_name("click");
+  table->set_emb_dim(kEmbDim);
+  table->set_fea_dim(kEmbDim + 2);
+  auto* program_config = param->add_program_config();
+  program_config->set_program_id("0");
+  program_config->add_pull_sparse_table_id(0);
+  program_config->add_push_sparse_table_id(0);
+  param->set_push_dense(false);
+  param->set_pipeline_pull_sparse(pipeline);
+
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  for (auto name : {"slot", "click", "emb", "emb@GRAD"}) {
+    block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+
+  Scope root_scope;
+  FakeDataFeed data_feed;
+  data_feed.Init(DataFeedDesc());
+  LocalDownpourWorker worker;
+  worker.SetDeviceIndex(0);
+  worker.Initialize(desc);
+  worker.SetNeedDump(false);
+  worker.SetFleet(std::shared_ptr<FleetWrapper>(fleet, [](FleetWrapper*) {}));
+  worker.SetRootScope(&root_scope);
+  worker.CreateDeviceResource(program);
+  worker.SetDataFeed(&data_feed);
+  worker.BindingDataFeedMemory();
+
+  platform::Timer timer;
+  timer.Start();
+  worker.TrainFiles();
+  timer.Pause();
+  return timer.ElapsedSec();
+}
+
+TEST(DownpourWorker, pipeline_pull_sparse) {
+  LocalFleetWrapper sync_fleet(20, 20, false);
+  const double sync_sec = Train(false, &sync_fleet);
+  LocalFleetWrapper pipeline_fleet(20, 20, true);
+  const double pipeline_sec = Train(true, &pipeline_fleet);
+
+  // The same batches are pushed in the same order.
+  EXPECT_EQ(sync_fleet.keys_pushed().size(),
+            static_cast<size_t>(kBatchNum * (kBatchSize * (kBatchSize + 1) /
+                                             2 - 1)));
+  EXPECT_EQ(pipeline_fleet.keys_pushed(), sync_fleet.keys_pushed());
+
+  // The pull of the next batch is issued before the push of every batch but
+  // the last one when pipelined, and after it otherwise.
+  EXPECT_EQ(sync_fleet.overlapped_pushes(), 0);
+  EXPECT_EQ(pipeline_fleet.overlapped_pushes(), kBatchNum - 1);
+
+  // The speedup is only logged, as the timings of a shared machine are
+  // noisy.
+  LOG(INFO) << "train " << kBatchNum << " batches in " << sync_sec
+            << "s, pipelined in " << pipeline_sec << "s";
+}
+
+}  // namespace framework
+}  // namespace paddle
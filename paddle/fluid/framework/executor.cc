@@ -44,6 +44,10 @@ limitations under the License. */
 DECLARE_bool(benchmark);
 DEFINE_bool(use_mkldnn, false, "Use MKLDNN to run");
 DEFINE_bool(use_ngraph, false, "Use NGRAPH to run");
+DEFINE_bool(enable_executor_var_slots, false,
+            "Map the variables of a prepared block to flat slots, so that "
+            "Executor resolves each variable once per run instead of looking "
+            "up the inputs and outputs of every op in the scope by name.");
 
 namespace paddle {
 namespace framework {
@@ -87,6 +91,49 @@ void ExecutorPrepareContext::PrepareUnusedVars(
   unused_vars_ = GetUnusedVars(prog_.Block(block_id_), ops_, keep_vars);
 }
 
+void ExecutorPrepareContext::PrepareVarSlots() {
+  std::unordered_map<std::string, size_t> var_slots;
+  auto get_slot = [&](const std::string& name) {
+    auto it = var_slots.find(name);
+    if (it != var_slots.end()) {
+      return it->second;
+    }
+    size_t slot = slot_var_names_.size();
+    slot_var_names_.push_back(name);
+    var_slots.emplace(name, slot);
+    return slot;
+  };
+  auto bind = [&](const VariableNameMap& names, VariableValueMap* values,
+                  std::vector<std::pair<Variable**, size_t>>* bindings) {
+    for (auto& name_item : names) {
+      // values is not resized after this, so the addresses are stable
+      auto& vars = (*values)[name_item.first];
+      vars.assign(name_item.second.size(), nullptr);
+      for (size_t i = 0; i < vars.size(); ++i) {
+        bindings->emplace_back(&vars[i], get_slot(name_item.second[i]));
+      }
+    }
+  };
+
+  slot_var_names_.clear();
+  slot_runtime_ctxs_.clear();
+  slot_bindings_.clear();
+  slot_runtime_ctxs_.resize(ops_.size());
+  slot_bindings_.resize(ops_.size());
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    auto* op = ops_[i].get();
+    if (dynamic_cast<OperatorWithKernel*>(op) == nullptr) {
+      continue;
+    }
+    slot_runtime_ctxs_[i].reset(
+        new RuntimeContext(VariableValueMap(), VariableValueMap()));
+    bind(op->Inputs(), &slot_runtime_ctxs_[i]->inputs, &slot_bindings_[i]);
+    bind(op->Outputs(), &slot_runtime_ctxs_[i]->outputs, &slot_bindings_[i]);
+  }
+  VLOG(3) << "Map " << slot_var_names_.size() << " variables of block "
+          << block_id_ << " to slots";
+}
+
 ExecutorPrepareContext::~ExecutorPrepareContext() {
   VLOG(5) << "destroy ExecutorPrepareContext";
 }
@@ -383,6 +430,9 @@ std::unique_ptr<ExecutorPrepareContext> Executor::Prepare(
   }
 #endif
   ctx->PrepareUnusedVars(skip_ref_cnt_vars, force_disable_gc);
+  if (FLAGS_enable_executor_var_slots) {
+    ctx->PrepareVarSlots();
+  }
   return ctx;
 }
 
@@ -408,6 +458,9 @@ std::vector<std::shared_ptr<ExecutorPrepareContext>> Executor::Prepare(
     } else {
       ctx->PrepareUnusedVars(skip_ref_cnt_vars[idx], force_disable_gc);
     }
+    if (FLAGS_enable_executor_var_slots) {
+      ctx->PrepareVarSlots();
+    }
     result.push_back(std::shared_ptr<ExecutorPrepareContext>(ctx));
     ++idx;
   }
@@ -448,10 +501,33 @@ void Executor::RunPreparedContext(ExecutorPrepareContext* ctx, Scope* scope,
 #endif
   }
 
-  for (auto& op : ctx->ops_) {
-    op->Run(*local_scope, place_);
-    if (gc) {
-      DeleteUnusedTensors(*local_scope, op.get(), ctx->unused_vars_, gc.get());
+  std::unique_lock<std::mutex> slot_lock(ctx->slot_mutex_, std::defer_lock);
+  if (ctx->slot_bindings_.size() == ctx->ops_.size() && slot_lock.try_lock()) {
+    // The variables are resolved at their first use, so that the variables
+    // created by the former ops of this run are found, too.
+    std::vector<Variable*> slots(ctx->slot_var_names_.size(), nullptr);
+    for (size_t i = 0; i < ctx->ops_.size(); ++i) {
+      auto* op = ctx->ops_[i].get();
+      auto* runtime_ctx = ctx->slot_runtime_ctxs_[i].get();
+      for (auto& binding : ctx->slot_bindings_[i]) {
+        size_t slot = binding.second;
+        if (slots[slot] == nullptr) {
+          slots[slot] = local_scope->FindVar(ctx->slot_var_names_[slot]);
+        }
+        *binding.first = slots[slot];
+      }
+      op->Run(*local_scope, place_, runtime_ctx);
+      if (gc) {
+        DeleteUnusedTensors(*local_scope, op, ctx->unused_vars_, gc.get());
+      }
+    }
+  } else {
+    for (auto& op : ctx->ops_) {
+      op->Run(*local_scope, place_);
+      if (gc) {
+        DeleteUnusedTensors(*local_scope, op.get(), ctx->unused_vars_,
+                            gc.get());
+      }
     }
   }
 
@@ -16,13 +16,16 @@ limitations under the License. */
 
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include "paddle/fluid/framework/data_set.h"
 #include "paddle/fluid/framework/executor_gc_helper.h"
 #include "paddle/fluid/framework/garbage_collector.h"
 #include "paddle/fluid/framework/op_info.h"
+#include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/tensor.h"
@@ -40,6 +43,13 @@ struct ExecutorPrepareContext {
   void PrepareUnusedVars(const std::vector<std::string>& keep_vars,
                          bool force_disable_gc = false);
 
+  // Map every variable used by the kernel operators of ops_ to an integer
+  // slot, and keep a RuntimeContext for each of them. A run then resolves
+  // each variable in the scope once, at its first use, and fills the
+  // RuntimeContexts by slot instead of looking up every input and output of
+  // every op by name.
+  void PrepareVarSlots();
+
   const framework::ProgramDesc& prog_;
   const size_t block_id_;
 
@@ -48,6 +58,17 @@ struct ExecutorPrepareContext {
   std::unordered_map<const OperatorBase*, std::vector<std::string>>
       unused_vars_;
   bool force_disable_gc_{false};
+
+  // The variable name of each slot.
+  std::vector<std::string> slot_var_names_;
+  // The RuntimeContext of ops_[i], nullptr if ops_[i] is not an
+  // OperatorWithKernel.
+  std::vector<std::unique_ptr<RuntimeContext>> slot_runtime_ctxs_;
+  // The (variable address in slot_runtime_ctxs_[i], slot) pairs of ops_[i].
+  std::vector<std::vector<std::pair<Variable**, size_t>>> slot_bindings_;
+  // The slots are used by one run at a time, the others fall back to the
+  // lookup by name.
+  std::mutex slot_mutex_;
 };
 
 class Executor {
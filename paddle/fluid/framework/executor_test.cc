@@ -0,0 +1,103 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/executor.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+DECLARE_bool(enable_executor_var_slots);
+
+namespace paddle {
+namespace framework {
+
+// c = a + b, d = c + b
+static void BuildProgram(ProgramDesc* program) {
+  auto* block = program->MutableBlock(0);
+  for (auto name : {"a", "b", "c", "d"}) {
+    block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  auto* add1 = block->AppendOp();
+  add1->SetType("elementwise_add");
+  add1->SetInput("X", {"a"});
+  add1->SetInput("Y", {"b"});
+  add1->SetOutput("Out", {"c"});
+  auto* add2 = block->AppendOp();
+  add2->SetType("elementwise_add");
+  add2->SetInput("X", {"c"});
+  add2->SetInput("Y", {"b"});
+  add2->SetOutput("Out", {"d"});
+}
+
+static void SetInput(Scope* scope, const std::string& name, float value) {
+  auto* tensor = scope->Var(name)->GetMutable<LoDTensor>();
+  tensor->Resize({1, 4});
+  float* data = tensor->mutable_data<float>(platform::CPUPlace());
+  std::fill_n(data, 4, value);
+}
+
+static void ExpectOutput(const Scope& scope, float value) {
+  auto& tensor = scope.FindVar("d")->Get<LoDTensor>();
+  ASSERT_EQ(tensor.numel(), 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_NEAR(tensor.data<float>()[i], value, 1e-5);
+  }
+}
+
+TEST(Executor, RunWithVarSlots) {
+  FLAGS_enable_executor_var_slots = true;
+  ProgramDesc program;
+  BuildProgram(&program);
+  platform::CPUPlace place;
+  Executor exe(place);
+  auto ctx = exe.Prepare(program, 0, {"a", "b", "d"});
+  EXPECT_EQ(ctx->slot_var_names_.size(), 4UL);
+
+  // The slots are resolved again in every run and in every scope.
+  Scope scope1, scope2;
+  SetInput(&scope1, "a", 1);
+  SetInput(&scope1, "b", 2);
+  SetInput(&scope2, "a", 3);
+  SetInput(&scope2, "b", 4);
+  exe.RunPreparedContext(ctx.get(), &scope1, false);
+  ExpectOutput(scope1, 5);
+  exe.RunPreparedContext(ctx.get(), &scope2, false);
+  ExpectOutput(scope2, 11);
+  SetInput(&scope1, "b", 0);
+  exe.RunPreparedContext(ctx.get(), &scope1, false);
+  ExpectOutput(scope1, 1);
+  FLAGS_enable_executor_var_slots = false;
+}
+
+TEST(Executor, RunWithoutVarSlots) {
+  FLAGS_enable_executor_var_slots = false;
+  ProgramDesc program;
+  BuildProgram(&program);
+  platform::CPUPlace place;
+  Executor exe(place);
+  auto ctx = exe.Prepare(program, 0, {"a", "b", "d"});
+  EXPECT_TRUE(ctx->slot_var_names_.empty());
+
+  Scope scope;
+  SetInput(&scope, "a", 1);
+  SetInput(&scope, "b", 2);
+  exe.RunPreparedContext(ctx.get(), &scope, false);
+  ExpectOutput(scope, 5);
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+USE_OP(elementwise_add);
@@ -73,12 +73,13 @@ class FleetWrapper {
   // Pull sparse variables from server in Sync mode
   // Param<in>: scope, table_id, var_names, fea_keys
   // Param<out>: fea_values
-  void PullSparseVarsSync(const Scope& scope, const uint64_t table_id,
-                          const std::vector<std::string>& var_names,
-                          std::vector<uint64_t>* fea_keys,
-                          std::vector<std::vector<float>>* fea_values,
-                          int fea_dim,
-                          const std::vector<std::string>& var_emb_names);
+  // Virtual to let the tests of the workers stand in for the server
+  virtual void PullSparseVarsSync(
+      const Scope& scope, const uint64_t table_id,
+      const std::vector<std::string>& var_names,
+      std::vector<uint64_t>* fea_keys,
+      std::vector<std::vector<float>>* fea_values, int fea_dim,
+      const std::vector<std::string>& var_emb_names);
 
   void PullDenseVarsSync(const Scope& scope, const uint64_t table_id,
                          const std::vector<std::string>& var_names);
@@ -108,7 +109,7 @@ class FleetWrapper {
   // Param<in>: scope, table_id, var_grad_names,
   //            fea_keys, fea_labels, sparse_grad_names
   // Param<out>: push_values, push_sparse_status
-  void PushSparseVarsWithLabelAsync(
+  virtual void PushSparseVarsWithLabelAsync(
       const Scope& scope, const uint64_t table_id,
       const std::vector<uint64_t>& fea_keys,
       const std::vector<float>& fea_labels,
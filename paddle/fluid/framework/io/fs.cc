@@ -13,6 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/framework/io/fs.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #include <memory>
 
 namespace paddle {
@@ -196,6 +200,48 @@ void localfs_mkdir(const std::string& path) {
   shell_execute(string::format_string("mkdir -p %s", path.c_str()));
 }
 
+std::shared_ptr<const char> localfs_mmap_read(const std::string& path,
+                                              size_t* size) {
+#ifndef _WIN32
+  int fd = open(path.c_str(), O_RDONLY);
+  PCHECK(fd >= 0) << "open " << path << " failed";
+  struct stat buf;
+  PCHECK(0 == fstat(fd, &buf)) << "fstat " << path << " failed";
+  *size = static_cast<size_t>(buf.st_size);
+  if (*size == 0) {
+    close(fd);
+    return std::shared_ptr<const char>(new char[1](),
+                                       std::default_delete<char[]>());
+  }
+  void* data = mmap(nullptr, *size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  PCHECK(data != MAP_FAILED) << "mmap " << path << " failed";
+  size_t length = *size;
+  return std::shared_ptr<const char>(
+      static_cast<const char*>(data), [length](const char* p) {
+        munmap(const_cast<char*>(p), length);
+      });
+#else
+  LOG(FATAL) << "Not supported";
+  return {};
+#endif
+}
+
+static std::shared_ptr<const char> fs_read_all_internal(
+    std::shared_ptr<FILE> fp, size_t* size) {
+  auto buffer = std::make_shared<std::vector<char>>();
+  const size_t block_size = 1 << 20;
+  size_t len = 0;
+  do {
+    buffer->resize(len + block_size);
+    len += fread(buffer->data() + len, 1, block_size, &*fp);
+  } while (!feof(&*fp) && !ferror(&*fp));
+  CHECK(!ferror(&*fp)) << "read file failed";
+  buffer->resize(len);
+  *size = len;
+  return std::shared_ptr<const char>(buffer, buffer->data());
+}
+
 static size_t& hdfs_buffer_size_internal() {
   static size_t x = 0;
   return x;
@@ -314,6 +360,17 @@ void hdfs_mkdir(const std::string& path) {
                                       hdfs_command().c_str(), path.c_str()));
 }
 
+std::shared_ptr<const char> hdfs_read_all(const std::string& path,
+                                          size_t* size) {
+  int err_no = 0;
+  std::shared_ptr<const char> data;
+  do {
+    err_no = 0;
+    data = fs_read_all_internal(hdfs_open_read(path, &err_no, ""), size);
+  } while (err_no == -1);
+  return data;
+}
+
 int fs_select_internal(const std::string& path) {
   if (fs_begin_with_internal(path, "hdfs:")) {
     return 1;
@@ -370,6 +427,22 @@ std::shared_ptr<FILE> fs_open(const std::string& path, const std::string& mode,
   return {};
 }
 
+std::shared_ptr<const char> fs_mmap_read(const std::string& path,
+                                         size_t* size) {
+  switch (fs_select_internal(path)) {
+    case 0:
+      return localfs_mmap_read(path, size);
+
+    case 1:
+      return hdfs_read_all(path, size);
+
+    default:
+      LOG(FATAL) << "Not supported";
+  }
+
+  return {};
+}
+
 int64_t fs_file_size(const std::string& path) {
   switch (fs_select_internal(path)) {
     case 0:
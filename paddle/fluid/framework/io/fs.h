@@ -50,6 +50,11 @@ extern bool localfs_exists(const std::string& path);
 
 extern void localfs_mkdir(const std::string& path);
 
+// map the whole file read-only, the mapping is released with the last
+// reference, and *size is set to the file size
+extern std::shared_ptr<const char> localfs_mmap_read(const std::string& path,
+                                                     size_t* size);
+
 // hdfs
 extern size_t hdfs_buffer_size();
 
@@ -75,6 +80,10 @@ extern bool hdfs_exists(const std::string& path);
 
 extern void hdfs_mkdir(const std::string& path);
 
+// hdfs files can not be mapped, read the whole file into memory instead
+extern std::shared_ptr<const char> hdfs_read_all(const std::string& path,
+                                                 size_t* size);
+
 // aut-detect fs
 extern std::shared_ptr<FILE> fs_open_read(const std::string& path, int* err_no,
                                           const std::string& converter);
@@ -97,5 +106,8 @@ extern std::string fs_tail(const std::string& path);
 extern bool fs_exists(const std::string& path);
 
 extern void fs_mkdir(const std::string& path);
+
+extern std::shared_ptr<const char> fs_mmap_read(const std::string& path,
+                                                size_t* size);
 }  // namespace framework
 }  // namespace paddle
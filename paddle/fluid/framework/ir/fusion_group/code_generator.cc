@@ -21,13 +21,17 @@ namespace paddle {
 namespace framework {
 namespace ir {
 
-CodeGenerator::CodeGenerator(CodeTemplate code_template) {
+CodeGenerator::CodeGenerator(CodeTemplate code_template, bool use_cpu) {
   code_template_ = code_template;
+  use_cpu_ = use_cpu;
 }
 
 // In order to get the right result of expression, we need to calculate and
 // store the expression as suffix Expressions using vector.
 std::string CodeGenerator::GenerateCode(TemplateVariable template_var) {
+  if (use_cpu_) {
+    return cpu_kernel_function + code_template_.Format(template_var);
+  }
   auto cuda_kernel = kernel_function + code_template_.Format(template_var);
   return cuda_kernel;
 }
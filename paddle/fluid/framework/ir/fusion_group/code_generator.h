@@ -23,7 +23,8 @@ namespace ir {
 
 class CodeGenerator {
  public:
-  explicit CodeGenerator(CodeTemplate code_template);
+  // The code is generated for the host if use_cpu, or for CUDA.
+  explicit CodeGenerator(CodeTemplate code_template, bool use_cpu = false);
 
   std::string GenerateCode(TemplateVariable template_var);
 
@@ -32,6 +33,7 @@ class CodeGenerator {
 
  private:
   CodeTemplate code_template_;
+  bool use_cpu_;
 };
 }  // namespace ir
 }  // namespace framework
@@ -239,6 +239,61 @@ extern "C" __global__ void $name($parameter){
 }
 )";
 
+// The host code is compiled into a shared library, and called with the
+// pointers to the arguments like the CUDA kernel.
+static const char cpu_kernel_function[] = R"(
+#include <cmath>
+
+inline float real_exp(float x) { return std::exp(x); }
+
+inline double real_exp(double x) { return std::exp(x); }
+
+inline float real_log(float x) { return std::log(x); }
+
+inline double real_log(double x) { return std::log(x); }
+
+inline float real_min(float x, float y) { return std::fmin(x, y); }
+
+inline double real_min(double x, double y) { return std::fmin(x, y); }
+
+inline float real_max(float x, float y) { return std::fmax(x, y); }
+
+inline double real_max(double x, double y) { return std::fmax(x, y); }
+
+template <int... I>
+struct Indices {};
+
+template <int N, int... I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+
+template <int... I>
+struct MakeIndices<0, I...> {
+  typedef Indices<I...> type;
+};
+
+template <typename... Args, int... I>
+void LaunchKernel(void (*kernel)(Args...), void** args, Indices<I...>) {
+  kernel(*static_cast<Args*>(args[I])...);
+}
+
+template <typename... Args>
+void LaunchKernel(void (*kernel)(Args...), void** args) {
+  LaunchKernel(kernel, args, typename MakeIndices<sizeof...(Args)>::type());
+}
+
+)";
+
+static const char cpu_kernel_elementwise_template[] = R"(
+
+static void $name_kernel($parameter){
+  for(int idx = 0; idx < N; ++idx) {
+      $compute
+}
+}
+
+extern "C" void $name(void** args) { LaunchKernel($name_kernel, args); }
+)";
+
 }  // namespace ir
 }  // namespace framework
 }  // namespace paddle
@@ -23,6 +23,72 @@ limitations under the License. */
 #include "paddle/fluid/platform/device_code.h"
 #include "paddle/fluid/platform/init.h"
 
+TEST(code_generator, cpu) {
+  std::vector<int> mul_input{1, 2};
+  std::vector<int> add_input{3, 4};
+  std::vector<int> sub_input{5, 6};
+  std::vector<int> relu_input{7};
+  std::vector<int> sigmoid_input{8};
+
+  paddle::framework::ir::OperationExpression opexp1(mul_input, 3,
+                                                    "elementwise_mul");
+  paddle::framework::ir::OperationExpression opexp2(add_input, 5,
+                                                    "elementwise_add");
+  paddle::framework::ir::OperationExpression opexp3(sub_input, 7,
+                                                    "elementwise_sub");
+  paddle::framework::ir::OperationExpression opexp4(relu_input, 8, "relu");
+  paddle::framework::ir::OperationExpression opexp5(sigmoid_input, 9,
+                                                    "sigmoid");
+
+  std::vector<paddle::framework::ir::OperationExpression> fused_op = {
+      opexp1, opexp2, opexp3, opexp4, opexp5};
+  paddle::framework::ir::CodeTemplate code_template(
+      paddle::framework::ir::cpu_kernel_elementwise_template);
+  paddle::framework::ir::CodeGenerator codegen(code_template, true);
+  paddle::framework::ir::TemplateVariable template_var;
+  template_var.Add("$name", EmitUniqueName(fused_op));
+  template_var.Add("$parameter", EmitDeclarationCode(fused_op, "float"));
+  template_var.Add("$compute", EmitComputeCode(fused_op));
+  std::string code_str = codegen.GenerateCode(template_var);
+
+  std::cout << code_str << std::endl;
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceCode code(place, EmitUniqueName(fused_op),
+                                       code_str);
+
+  // var1 * var2 + var4 - var6 -> relu -> sigmoid, and the intermediates are
+  // var3, var5, var7 and var8.
+  std::vector<paddle::framework::Tensor> tensors(9);
+  std::vector<float*> data(9);
+  auto dims = paddle::framework::make_ddim(
+      {static_cast<int64_t>(256), static_cast<int64_t>(1024)});
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    data[i] = tensors[i].mutable_data<float>(dims, place);
+  }
+
+  size_t n = tensors[0].numel();
+  for (size_t i = 0; i < n; ++i) {
+    data[0][i] = static_cast<float>(i) - 1000.0;
+    data[1][i] = static_cast<float>(0.01);
+    data[3][i] = static_cast<float>(-0.5);
+    data[5][i] = static_cast<float>(0.0);
+  }
+
+  code.Compile();
+
+  std::vector<void*> args = {&n,       &data[0], &data[1], &data[3], &data[5],
+                             &data[2], &data[4], &data[6], &data[7], &data[8]};
+  code.Launch(n, &args);
+
+  for (size_t i = 0; i < n; i++) {
+    float result = (1.0 / (1.0 + std::exp(-std::max(
+                                     0.0, (static_cast<float>(i) - 1000.0) *
+                                                  0.01 -
+                                              0.5 - 0.0))));
+    EXPECT_NEAR(data[8][i], result, 1e-5);
+  }
+}
+
 #ifdef PADDLE_WITH_CUDA
 TEST(code_generator, cuda) {
   std::vector<int> mul_input{1, 2};
@@ -0,0 +1,291 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/mmap_param_file.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace framework {
+
+constexpr size_t MmapParamFile::kAlignment;
+
+static constexpr char kMagic[8] = {'P', 'D', 'M', 'M', 'A', 'P', 'P', 'M'};
+static constexpr uint32_t kVersion = 0;
+// magic, version, the number of tensors, the offset of the index
+static constexpr size_t kHeaderSize = 8 + 4 + 4 + 8;
+
+// The tensor data in a mapped file, which keeps the mapping alive.
+class MmapParamAllocation : public memory::allocation::Allocation {
+ public:
+  MmapParamAllocation(void* ptr, size_t size,
+                      std::shared_ptr<MmapParamFile> file)
+      : Allocation(ptr, size, platform::CPUPlace()), file_(std::move(file)) {}
+
+ private:
+  std::shared_ptr<MmapParamFile> file_;
+};
+
+// Read the fields of the index with bounds checking.
+class IndexReader {
+ public:
+  IndexReader(const char* begin, const char* end, const std::string& path)
+      : pos_(begin), end_(end), path_(path) {}
+
+  template <typename T>
+  T Read() {
+    T value;
+    std::memcpy(&value, Advance(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  const char* Advance(size_t bytes) {
+    PADDLE_ENFORCE_LE(bytes, static_cast<size_t>(end_ - pos_),
+                      "The parameter file %s is damaged", path_);
+    const char* pos = pos_;
+    pos_ += bytes;
+    return pos;
+  }
+
+ private:
+  const char* pos_;
+  const char* end_;
+  const std::string& path_;
+};
+
+bool MmapParamFile::IsMmapParamFile(const std::string& path) {
+  std::ifstream fin(path, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  return fin.read(magic, sizeof(magic)) &&
+         std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+std::shared_ptr<MmapParamFile> MmapParamFile::Open(const std::string& path) {
+  return std::shared_ptr<MmapParamFile>(new MmapParamFile(path));
+}
+
+MmapParamFile::MmapParamFile(const std::string& path) : path_(path) {
+#ifndef _WIN32
+  int fd = open(path.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_GE(fd, 0, "Cannot open the file %s", path);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    PADDLE_THROW("Cannot stat the file %s", path);
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ >= kHeaderSize) {
+    // The pages are shared with the page cache until they are written.
+    void* data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                      0);
+    close(fd);
+    PADDLE_ENFORCE(data != MAP_FAILED, "Cannot mmap the file %s", path);
+    data_ = static_cast<char*>(data);
+  } else {
+    close(fd);
+  }
+#else
+  // Read the whole file on Windows.
+  std::ifstream fin(path, std::ios::binary | std::ios::ate);
+  PADDLE_ENFORCE(static_cast<bool>(fin), "Cannot open the file %s", path);
+  size_ = static_cast<size_t>(fin.tellg());
+  data_ = new char[size_];
+  fin.seekg(0);
+  fin.read(data_, size_);
+#endif
+  try {
+    ParseIndex();
+  } catch (...) {
+    Unmap();
+    throw;
+  }
+  VLOG(3) << "Map the parameter file " << path << " of " << size_
+          << " bytes, " << entries_.size() << " tensors";
+}
+
+MmapParamFile::~MmapParamFile() { Unmap(); }
+
+void MmapParamFile::Unmap() {
+  if (data_ == nullptr) {
+    return;
+  }
+#ifndef _WIN32
+  munmap(data_, size_);
+#else
+  delete[] data_;
+#endif
+  data_ = nullptr;
+}
+
+void MmapParamFile::ParseIndex() {
+  PADDLE_ENFORCE(data_ != nullptr && size_ >= kHeaderSize,
+                 "The parameter file %s is damaged", path_);
+  IndexReader header(data_, data_ + kHeaderSize, path_);
+  PADDLE_ENFORCE(std::memcmp(header.Advance(sizeof(kMagic)), kMagic,
+                             sizeof(kMagic)) == 0,
+                 "The file %s is not a parameter file of the mmap layout",
+                 path_);
+  auto version = header.Read<uint32_t>();
+  PADDLE_ENFORCE_EQ(version, kVersion,
+                    "Unsupported version %d of the parameter file %s", version,
+                    path_);
+  auto count = header.Read<uint32_t>();
+  auto index_offset = header.Read<uint64_t>();
+  PADDLE_ENFORCE_LE(index_offset, size_, "The parameter file %s is damaged",
+                    path_);
+
+  // The sizes are checked by reading the fields, so a damaged file does not
+  // allocate a lot of memory.
+  IndexReader reader(data_ + index_offset, data_ + size_, path_);
+  for (uint32_t i = 0; i < count; ++i) {
+    entries_.emplace_back();
+    auto& entry = entries_.back();
+    auto name_size = reader.Read<uint64_t>();
+    entry.name.assign(reader.Advance(name_size), name_size);
+
+    auto lod_level = reader.Read<uint64_t>();
+    for (uint64_t level = 0; level < lod_level; ++level) {
+      auto level_size = reader.Read<uint64_t>();
+      entry.lod.emplace_back();
+      for (uint64_t j = 0; j < level_size; ++j) {
+        entry.lod.back().push_back(reader.Read<uint64_t>());
+      }
+    }
+
+    auto desc_size = reader.Read<int32_t>();
+    PADDLE_ENFORCE_GE(desc_size, 0, "The parameter file %s is damaged", path_);
+    proto::VarType::TensorDesc desc;
+    PADDLE_ENFORCE(desc.ParseFromArray(reader.Advance(desc_size), desc_size),
+                   "Cannot parse the tensor desc of %s in %s", entry.name,
+                   path_);
+    entry.type = desc.data_type();
+    std::vector<int64_t> dims(desc.dims().begin(), desc.dims().end());
+    entry.dims = make_ddim(dims);
+
+    entry.offset = reader.Read<uint64_t>();
+    entry.bytes = reader.Read<uint64_t>();
+    PADDLE_ENFORCE_EQ(
+        entry.bytes,
+        static_cast<uint64_t>(product(entry.dims) * SizeOfType(entry.type)),
+        "The data size of %s in %s does not match its shape", entry.name,
+        path_);
+    PADDLE_ENFORCE(entry.offset <= index_offset &&
+                       entry.bytes <= index_offset - entry.offset,
+                   "The data of %s is out of the file %s", entry.name, path_);
+  }
+}
+
+void MmapParamFile::ShareDataTo(size_t idx, LoDTensor* tensor) {
+  PADDLE_ENFORCE_LT(idx, entries_.size(),
+                    "The parameter file %s has only %d tensors", path_,
+                    entries_.size());
+  auto& entry = entries_[idx];
+  // The Allocation of size 0 is not allowed to be used.
+  size_t bytes = std::max<size_t>(entry.bytes, 1);
+  auto holder = std::make_shared<MmapParamAllocation>(
+      data_ + entry.offset, bytes, shared_from_this());
+  tensor->clear();
+  tensor->Resize(entry.dims);
+  tensor->set_lod(entry.lod);
+  tensor->ResetHolderWithType(holder, entry.type);
+}
+
+MmapParamFileWriter::MmapParamFileWriter(const std::string& path)
+    : path_(path), fout_(path, std::ios::binary) {
+  PADDLE_ENFORCE(static_cast<bool>(fout_), "Cannot open %s to write", path);
+  // the index offset is filled in Close
+  char header[kHeaderSize] = {0};
+  std::memcpy(header, kMagic, sizeof(kMagic));
+  std::memcpy(header + sizeof(kMagic), &kVersion, sizeof(kVersion));
+  fout_.write(header, sizeof(header));
+}
+
+template <typename T>
+static void AppendField(std::string* buf, const T& value) {
+  buf->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void MmapParamFileWriter::Append(const std::string& name,
+                                 const LoDTensor& tensor) {
+  PADDLE_ENFORCE(fout_.is_open(), "The file %s is closed", path_);
+  const Tensor* cpu_tensor = &tensor;
+  Tensor copied;
+  if (!platform::is_cpu_place(tensor.place())) {
+    TensorCopySync(tensor, platform::CPUPlace(), &copied);
+    cpu_tensor = &copied;
+  }
+
+  const uint64_t alignment = MmapParamFile::kAlignment;
+  uint64_t offset = static_cast<uint64_t>(fout_.tellp());
+  uint64_t bytes = cpu_tensor->numel() * SizeOfType(cpu_tensor->type());
+  // An empty tensor has neither data nor padding, its data may not be
+  // allocated.
+  if (bytes > 0) {
+    uint64_t padding = (alignment - offset % alignment) % alignment;
+    if (padding > 0) {
+      char zeros[MmapParamFile::kAlignment] = {0};
+      fout_.write(zeros, padding);
+      offset += padding;
+    }
+    fout_.write(static_cast<const char*>(cpu_tensor->data<void>()), bytes);
+    PADDLE_ENFORCE(static_cast<bool>(fout_), "Failed to write %s", path_);
+  }
+
+  AppendField<uint64_t>(&index_, name.size());
+  index_.append(name);
+  AppendField<uint64_t>(&index_, tensor.lod().size());
+  for (auto& level : tensor.lod()) {
+    AppendField<uint64_t>(&index_, level.size());
+    for (size_t offset : level) {
+      AppendField<uint64_t>(&index_, offset);
+    }
+  }
+  proto::VarType::TensorDesc desc;
+  desc.set_data_type(tensor.type());
+  auto dims = vectorize(tensor.dims());
+  for (auto dim : dims) {
+    desc.add_dims(dim);
+  }
+  std::string desc_str = desc.SerializeAsString();
+  AppendField<int32_t>(&index_, static_cast<int32_t>(desc_str.size()));
+  index_.append(desc_str);
+  AppendField<uint64_t>(&index_, offset);
+  AppendField<uint64_t>(&index_, bytes);
+  ++count_;
+}
+
+void MmapParamFileWriter::Close() {
+  PADDLE_ENFORCE(fout_.is_open(), "The file %s is closed", path_);
+  uint64_t index_offset = static_cast<uint64_t>(fout_.tellp());
+  fout_.write(index_.data(), index_.size());
+  fout_.seekp(sizeof(kMagic) + sizeof(kVersion));
+  fout_.write(reinterpret_cast<const char*>(&count_), sizeof(count_));
+  fout_.write(reinterpret_cast<const char*>(&index_offset),
+              sizeof(index_offset));
+  fout_.close();
+  PADDLE_ENFORCE(static_cast<bool>(fout_), "Failed to write %s", path_);
+}
+
+}  // namespace framework
+}  // namespace paddle
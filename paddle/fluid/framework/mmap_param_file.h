@@ -0,0 +1,105 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "paddle/fluid/framework/lod_tensor.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * The mmap layout of a combined parameter file, which can be mapped into the
+ * memory and used by the tensors without copying:
+ *
+ *   header: char[8] magic, uint32_t version, uint32_t the number of tensors,
+ *           uint64_t the offset of the index
+ *   data:   the data of the tensors, every one is aligned to kAlignment
+ *   index:  for every tensor,
+ *           uint64_t the length of the name, the name,
+ *           uint64_t the levels of the LoD, for every level, uint64_t the
+ *           length of the level and the uint64_t offsets,
+ *           int32_t the size of TensorDesc, the TensorDesc protobuf message,
+ *           uint64_t the offset of the data, uint64_t the bytes of the data
+ *
+ * The file is mapped privately, so the predictors loading the same file, in
+ * the same process or not, share the pages in the page cache, and a tensor
+ * written by an op, e.g. by a fuse pass, gets its own copy of the written
+ * pages only.
+ */
+class MmapParamFile : public std::enable_shared_from_this<MmapParamFile> {
+ public:
+  static constexpr size_t kAlignment = 64;
+
+  // Whether the file is in the mmap layout.
+  static bool IsMmapParamFile(const std::string& path);
+
+  // Map the file. Every call maps the file again, so that the tensors written
+  // by a predictor are not seen by the others in the process, while the
+  // pages not written are still shared.
+  static std::shared_ptr<MmapParamFile> Open(const std::string& path);
+
+  ~MmapParamFile();
+
+  size_t size() const { return entries_.size(); }
+
+  const std::string& name(size_t idx) const { return entries_[idx].name; }
+
+  // Make the tensor use the idx-th tensor of the file in CPU, which keeps the
+  // mapping alive.
+  void ShareDataTo(size_t idx, LoDTensor* tensor);
+
+ private:
+  struct Entry {
+    std::string name;
+    LoD lod;
+    proto::VarType::Type type;
+    DDim dims;
+    uint64_t offset;
+    uint64_t bytes;
+  };
+
+  explicit MmapParamFile(const std::string& path);
+  void ParseIndex();
+  void Unmap();
+
+  std::string path_;
+  char* data_{nullptr};
+  size_t size_{0};
+  std::vector<Entry> entries_;
+};
+
+class MmapParamFileWriter {
+ public:
+  explicit MmapParamFileWriter(const std::string& path);
+
+  void Append(const std::string& name, const LoDTensor& tensor);
+
+  // Write the index, the file is not complete until it is closed.
+  void Close();
+
+ private:
+  std::string path_;
+  std::ofstream fout_;
+  std::string index_;
+  uint32_t count_{0};
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,121 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/mmap_param_file.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+static void WriteTestFile(const std::string& path) {
+  platform::CPUPlace place;
+  LoDTensor weight;
+  float* w = weight.mutable_data<float>(make_ddim({3, 5}), place);
+  for (int i = 0; i < 15; ++i) {
+    w[i] = i * 0.5f;
+  }
+  LoDTensor ids;
+  ids.set_lod({{0, 1, 3}});
+  int64_t* id = ids.mutable_data<int64_t>(make_ddim({3, 1}), place);
+  for (int i = 0; i < 3; ++i) {
+    id[i] = i + 100;
+  }
+  LoDTensor empty;
+  empty.mutable_data<float>(make_ddim({0, 4}), place);
+
+  MmapParamFileWriter writer(path);
+  writer.Append("weight", weight);
+  writer.Append("ids", ids);
+  writer.Append("empty", empty);
+  writer.Close();
+}
+
+TEST(MmapParamFile, SaveAndLoad) {
+  std::string path = "mmap_param_file_test.bin";
+  WriteTestFile(path);
+  ASSERT_TRUE(MmapParamFile::IsMmapParamFile(path));
+
+  auto file = MmapParamFile::Open(path);
+  ASSERT_EQ(file->size(), 3UL);
+  EXPECT_EQ(file->name(0), "weight");
+  EXPECT_EQ(file->name(1), "ids");
+  EXPECT_EQ(file->name(2), "empty");
+
+  LoDTensor weight;
+  file->ShareDataTo(0, &weight);
+  EXPECT_EQ(weight.type(), proto::VarType::FP32);
+  EXPECT_EQ(weight.dims(), make_ddim({3, 5}));
+  EXPECT_EQ(
+      reinterpret_cast<uintptr_t>(weight.data<float>()) %
+          MmapParamFile::kAlignment,
+      0UL);
+  for (int i = 0; i < 15; ++i) {
+    EXPECT_EQ(weight.data<float>()[i], i * 0.5f);
+  }
+
+  LoDTensor ids;
+  file->ShareDataTo(1, &ids);
+  EXPECT_EQ(ids.type(), proto::VarType::INT64);
+  EXPECT_EQ(ids.lod(), LoD({{0, 1, 3}}));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(ids.data<int64_t>()[i], i + 100);
+  }
+
+  LoDTensor empty;
+  file->ShareDataTo(2, &empty);
+  EXPECT_EQ(empty.numel(), 0);
+
+  // the tensors keep the mapping alive
+  file.reset();
+  EXPECT_EQ(weight.data<float>()[3], 1.5f);
+
+  // the written pages are private to the mapping
+  weight.mutable_data<float>(platform::CPUPlace())[0] = 42;
+  LoDTensor reloaded;
+  MmapParamFile::Open(path)->ShareDataTo(0, &reloaded);
+  EXPECT_EQ(reloaded.data<float>()[0], 0.0f);
+  std::remove(path.c_str());
+}
+
+TEST(MmapParamFile, DamagedFile) {
+  std::string path = "mmap_param_file_damaged.bin";
+  WriteTestFile(path);
+  std::string content;
+  {
+    std::ifstream fin(path, std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(fin),
+                   std::istreambuf_iterator<char>());
+  }
+  // truncate the index
+  {
+    std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+    fout.write(content.data(), content.size() - 10);
+  }
+  EXPECT_TRUE(MmapParamFile::IsMmapParamFile(path));
+  EXPECT_THROW(MmapParamFile::Open(path), platform::EnforceNotMet);
+
+  {
+    std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+    fout << "not a parameter file";
+  }
+  EXPECT_FALSE(MmapParamFile::IsMmapParamFile(path));
+  std::remove(path.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -49,11 +49,20 @@ void NaiveExecutor::Run() {
                              "setting the cmake flag ON_INFER=ON if you are "
                              "running Paddle Inference";
 #endif  // PADDLE_ON_INFERENCE
+  if (memory_planner_) {
+    memory_planner_->BeginRun();
+  }
   for (auto &op : ops_) {
     VLOG(4) << std::this_thread::get_id() << " run "
             << op->DebugStringEx(scope_) << " on scope " << scope_;
     op->SetIsCalledByExecutor(false);
     op->Run(*scope_, place_);
+    if (memory_planner_) {
+      memory_planner_->RecordOp(*op, *scope_);
+    }
+  }
+  if (memory_planner_) {
+    memory_planner_->EndRun();
   }
 }
 
@@ -112,11 +121,23 @@ void NaiveExecutor::CreateOps(const ProgramDesc &desc, int block_id,
 LoDTensor *NaiveExecutor::FindTensor(const std::string &name) {
   PADDLE_ENFORCE(scope_, "Need to init scope first");
   auto *var = scope_->FindVar(name);
-  PADDLE_ENFORCE(var, "No variable [%s] in the scope");
+  PADDLE_ENFORCE(var, "No variable [%s] in the scope", name);
   auto *tensor = const_cast<LoDTensor *>(&var->Get<LoDTensor>());
   return tensor;
 }
 
+void NaiveExecutor::EnableStaticMemoryPlan() {
+  // The tensors in the sub-blocks are not recorded.
+  for (auto &op : ops_) {
+    if (op->HasAttr("sub_block") || op->HasAttr("sub_blocks")) {
+      LOG(WARNING) << "The static memory plan is not supported by the op "
+                   << op->Type();
+      return;
+    }
+  }
+  memory_planner_.reset(new StaticMemoryPlanner(place_));
+}
+
 void NaiveExecutor::CleanFeedFetchOps() {
   std::vector<std::unique_ptr<OperatorBase>> ops;
   for (auto &op : ops_) {
@@ -14,11 +14,13 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/static_memory_planner.h"
 #include "paddle/fluid/platform/device_context.h"
 
 namespace paddle {
@@ -54,6 +56,13 @@ class NaiveExecutor {
 
   void CleanFeedFetchOps();
 
+  // Lay out the temporary tensors in one arena planned by the first run, see
+  // StaticMemoryPlanner. It should be called after Prepare.
+  void EnableStaticMemoryPlan();
+  const StaticMemoryPlanner* memory_planner() const {
+    return memory_planner_.get();
+  }
+
  protected:
   void CreateOps(const ProgramDesc& desc, int block_id,
                  bool with_feed_fetch_ops);
@@ -63,6 +72,7 @@ class NaiveExecutor {
   // Catch the required resource to avoid recreate.
   std::vector<std::unique_ptr<OperatorBase>> ops_;
   Scope* scope_;
+  std::unique_ptr<StaticMemoryPlanner> memory_planner_;
 };
 
 }  // namespace framework
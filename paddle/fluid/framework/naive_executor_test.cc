@@ -15,9 +15,14 @@
 #include "paddle/fluid/framework/naive_executor.h"
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <string>
+#include <vector>
+#include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/program_desc.h"
 
+DECLARE_bool(enable_op_runtime_cache);
+
 namespace paddle {
 namespace framework {
 
@@ -64,6 +69,124 @@ TEST(NaiveExecutor, Basic) {
   }
 }
 
+template <typename T>
+static void SetTensor(Scope* scope, const std::string& name, T value) {
+  auto* tensor = scope->Var(name)->GetMutable<LoDTensor>();
+  tensor->Resize({1, 4});
+  std::fill_n(tensor->mutable_data<T>(platform::CPUPlace()), 4, value);
+}
+
+template <typename T>
+static void ExpectTensor(const Scope& scope, const std::string& name,
+                         T value) {
+  auto& tensor = scope.FindVar(name)->Get<LoDTensor>();
+  ASSERT_EQ(tensor.type(), DataTypeTrait<T>::DataType());
+  for (int i = 0; i < 4; i++) {
+    EXPECT_NEAR(tensor.data<T>()[i], value, 1e-5);
+  }
+}
+
+TEST(NaiveExecutor, RuntimeCache) {
+  bool enable_op_runtime_cache = FLAGS_enable_op_runtime_cache;
+  FLAGS_enable_op_runtime_cache = true;
+  ProgramDesc program;
+  auto* main_block = program.MutableBlock(0);
+  auto* add = main_block->AppendOp();
+  add->SetType("elementwise_add");
+  add->SetInput("X", {"a"});
+  add->SetInput("Y", {"b"});
+  add->SetOutput("Out", {"c"});
+
+  Scope scope;
+  SetTensor<float>(&scope, "a", 1);
+  SetTensor<float>(&scope, "b", 2);
+  scope.Var("c")->GetMutable<LoDTensor>();
+  auto place = platform::CPUPlace();
+  NaiveExecutor exe(place);
+  exe.Prepare(&scope, program, 0, false);
+  exe.Run();
+  ExpectTensor<float>(scope, "c", 3);
+  SetTensor<float>(&scope, "a", 4);
+  exe.Run();
+  ExpectTensor<float>(scope, "c", 6);
+
+  // The kernel is chosen again when the data type of the inputs changes.
+  SetTensor<double>(&scope, "a", 0.5);
+  SetTensor<double>(&scope, "b", 0.25);
+  exe.Run();
+  ExpectTensor<double>(scope, "c", 0.75);
+
+  // The variables are found again when the scope changes.
+  scope.EraseVars({"c"});
+  scope.Var("c")->GetMutable<LoDTensor>();
+  exe.Run();
+  ExpectTensor<double>(scope, "c", 0.75);
+  FLAGS_enable_op_runtime_cache = enable_op_runtime_cache;
+}
+
+static void SetTensor(Scope* scope, const std::string& name, int64_t numel,
+                      float value) {
+  auto* tensor = scope->Var(name)->GetMutable<LoDTensor>();
+  tensor->Resize({numel});
+  std::fill_n(tensor->mutable_data<float>(platform::CPUPlace()), numel, value);
+}
+
+TEST(NaiveExecutor, StaticMemoryPlan) {
+  // f = x + 4 * w, by a chain of elementwise_add through c, d and e.
+  ProgramDesc program;
+  auto* main_block = program.MutableBlock(0);
+  std::vector<std::string> chain = {"x", "c", "d", "e", "f"};
+  for (size_t i = 0; i + 1 < chain.size(); ++i) {
+    auto* add = main_block->AppendOp();
+    add->SetType("elementwise_add");
+    add->SetInput("X", {chain[i]});
+    add->SetInput("Y", {"w"});
+    add->SetOutput("Out", {chain[i + 1]});
+  }
+
+  Scope scope;
+  SetTensor(&scope, "w", 64, 1);
+  auto* local_scope = &scope.NewScope();
+  SetTensor(local_scope, "x", 64, 2);
+  for (auto& name : {"c", "d", "e", "f"}) {
+    local_scope->Var(name)->GetMutable<LoDTensor>();
+  }
+  auto place = platform::CPUPlace();
+  NaiveExecutor exe(place);
+  exe.Prepare(local_scope, program, 0, false);
+  exe.EnableStaticMemoryPlan();
+  auto* planner = exe.memory_planner();
+  ASSERT_NE(planner, nullptr);
+
+  exe.Run();
+  ASSERT_TRUE(planner->planned());
+  // c and e are not alive at the same time, x and f are used out of the run.
+  EXPECT_LT(planner->arena_size(), planner->planned_size());
+  for (int i = 0; i < 3; ++i) {
+    exe.Run();
+    auto* c = exe.FindTensor("c");
+    auto* d = exe.FindTensor("d");
+    auto* e = exe.FindTensor("e");
+    EXPECT_EQ(c->data<float>(), e->data<float>());
+    EXPECT_NE(c->data<float>(), d->data<float>());
+    EXPECT_EQ(exe.FindTensor("x")->Holder().use_count(), 1);
+    EXPECT_NEAR(exe.FindTensor("f")->data<float>()[63], 6, 1e-5);
+  }
+
+  // A larger input outgrows the plan, which is planned again.
+  SetTensor(&scope, "w", 128, 1);
+  SetTensor(local_scope, "x", 128, 3);
+  exe.Run();
+  EXPECT_NEAR(exe.FindTensor("f")->data<float>()[127], 7, 1e-5);
+  EXPECT_FALSE(planner->planned());
+  exe.Run();
+  EXPECT_TRUE(planner->planned());
+  exe.Run();
+  EXPECT_NEAR(exe.FindTensor("f")->data<float>()[127], 7, 1e-5);
+  EXPECT_EQ(exe.FindTensor("c")->data<float>(),
+            exe.FindTensor("e")->data<float>());
+}
+
 }  // namespace framework
 }  // namespace paddle
 
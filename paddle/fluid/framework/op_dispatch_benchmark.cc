@@ -0,0 +1,107 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Measure the dispatch overhead of the operators run by NaiveExecutor, with
+// and without the runtime cache of OperatorWithKernel, on a chain of
+// elementwise_add ops with tiny inputs:
+//   x_{i+1} = x_i + y
+// Usage:
+//   op_dispatch_benchmark --ops=1000 --numel=4 --repeat=1000
+
+#include <algorithm>
+#include <string>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/platform/timer.h"
+
+DECLARE_bool(enable_op_runtime_cache);
+
+DEFINE_int32(ops, 1000, "The number of elementwise_add ops in the program.");
+DEFINE_int32(numel, 4, "The number of elements of each input.");
+DEFINE_int32(repeat, 1000, "The number of runs of the program.");
+
+namespace paddle {
+namespace framework {
+
+static std::string VarName(int i) { return "x_" + std::to_string(i); }
+
+static void BuildProgram(ProgramDesc* program) {
+  auto* block = program->MutableBlock(0);
+  for (int i = 0; i < FLAGS_ops; ++i) {
+    auto* add = block->AppendOp();
+    add->SetType("elementwise_add");
+    add->SetInput("X", {VarName(i)});
+    add->SetInput("Y", {"y"});
+    add->SetOutput("Out", {VarName(i + 1)});
+  }
+}
+
+static void SetInput(Scope* scope, const std::string& name) {
+  auto* tensor = scope->Var(name)->GetMutable<LoDTensor>();
+  tensor->Resize({1, FLAGS_numel});
+  std::fill_n(tensor->mutable_data<float>(platform::CPUPlace()), FLAGS_numel,
+              1.0f);
+}
+
+static double RunProgram(bool use_runtime_cache, float* result) {
+  FLAGS_enable_op_runtime_cache = use_runtime_cache;
+  ProgramDesc program;
+  BuildProgram(&program);
+  Scope scope;
+  SetInput(&scope, VarName(0));
+  SetInput(&scope, "y");
+  for (int i = 1; i <= FLAGS_ops; ++i) {
+    scope.Var(VarName(i))->GetMutable<LoDTensor>();
+  }
+
+  auto place = platform::CPUPlace();
+  NaiveExecutor exe(place);
+  exe.Prepare(&scope, program, 0, false);
+  // warm up
+  exe.Run();
+
+  platform::Timer timer;
+  timer.Start();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    exe.Run();
+  }
+  timer.Pause();
+  *result = exe.FindTensor(VarName(FLAGS_ops))->data<float>()[0];
+  return timer.ElapsedUS() / FLAGS_repeat / FLAGS_ops;
+}
+
+static void RunBenchmark() {
+  for (bool use_runtime_cache : {false, true}) {
+    float result = 0;
+    double us = RunProgram(use_runtime_cache, &result);
+    LOG(INFO) << (use_runtime_cache ? "with" : "without")
+              << " runtime cache: result " << result << ", " << us
+              << " us per op";
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::RunBenchmark();
+  return 0;
+}
+
+USE_OP(elementwise_add);
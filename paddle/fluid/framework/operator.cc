@@ -29,6 +29,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/shape_inference.h"
 #include "paddle/fluid/framework/transfer_scope_cache.h"
 #include "paddle/fluid/framework/var_type.h"
+#include "paddle/fluid/platform/event_tracer.h"
 #include "paddle/fluid/platform/profiler.h"
 
 DECLARE_bool(benchmark);
@@ -37,6 +38,11 @@ DEFINE_int32(inner_op_parallelism, 0, "number of threads for inner op");
 DEFINE_bool(fast_check_nan_inf, false,
             "Fast checking NAN/INF after each operation. It will be a little"
             "bit slow, much faster than check_nan_inf");
+DEFINE_bool(enable_op_runtime_cache, false,
+            "Cache the RuntimeContext, the kernel and the data transform "
+            "decision of the operators run by NaiveExecutor across runs. They "
+            "are updated when the variables in the scope, or the types, "
+            "places or layouts of the inputs change. Off by default.");
 
 namespace paddle {
 namespace framework {
@@ -148,6 +154,11 @@ RuntimeContext::RuntimeContext(const VariableNameMap& innames,
 }
 
 void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
+  Run(scope, place, nullptr);
+}
+
+void OperatorBase::Run(const Scope& scope, const platform::Place& place,
+                       RuntimeContext* runtime_ctx) {
   try {
     VLOG(4) << place << " " << DebugStringEx(&scope);
     if (platform::is_gpu_place(place)) {
@@ -163,11 +174,19 @@ void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
     // issue
     // in concurrency scenerio. Here use an `if` to fix this issue.
     // Please not remove the `if`, ask @Superjomn if there are any concern.
-    if (platform::IsProfileEnabled()) {
+    if (platform::IsProfileEnabled() || platform::IsEventTracerEnabled()) {
       platform::RecordEvent record_event(Type());
-      RunImpl(scope, place);
+      if (runtime_ctx == nullptr) {
+        RunImpl(scope, place);
+      } else {
+        RunImpl(scope, place, runtime_ctx);
+      }
     } else {
-      RunImpl(scope, place);
+      if (runtime_ctx == nullptr) {
+        RunImpl(scope, place);
+      } else {
+        RunImpl(scope, place, runtime_ctx);
+      }
     }
     VLOG(3) << place << " " << DebugStringEx(&scope);
   } catch (platform::EnforceNotMet& exception) {
@@ -853,13 +872,14 @@ std::vector<KernelConfig>* OperatorWithKernel::GetKernelConfig(
 
 void OperatorWithKernel::RunImpl(const Scope& scope,
                                  const platform::Place& place) const {
+  if (!run_by_executor_ && FLAGS_enable_op_runtime_cache) {
+    RunImplWithCache(scope, place);
+    return;
+  }
   // To reduce the elapsed time of HasAttr, we use bool variable to record the
   // result of HasAttr.
   if (!enable_cache_runtime_context_ && HasAttr(kEnableCacheRuntimeContext))
     enable_cache_runtime_context_ = true;
-  if (!all_kernels_must_compute_runtime_shape_ &&
-      HasAttr(kAllKernelsMustComputeRuntimeShape))
-    all_kernels_must_compute_runtime_shape_ = true;
   if (!enable_cache_runtime_context_) {
     RuntimeContext ctx(Inputs(), Outputs(), scope);
     RunImpl(scope, place, &ctx);
@@ -876,9 +896,103 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   }
 }
 
+void OperatorWithKernel::RunImplWithCache(
+    const Scope& scope, const platform::Place& place) const {
+  if (runtime_cache_ == nullptr) {
+    runtime_cache_.reset(new RuntimeCache);
+  }
+  auto& cache = *runtime_cache_;
+
+  // The variables found in the scope may be dropped once a variable is
+  // created, erased or renamed in the scope or its ancestors.
+  bool scope_changed = cache.runtime_ctx == nullptr;
+  size_t depth = 0;
+  for (auto* s = &scope; s != nullptr; s = s->parent(), ++depth) {
+    uint64_t version = s->VarsVersion();
+    if (depth == cache.scope_versions.size()) {
+      cache.scope_versions.push_back(version);
+      scope_changed = true;
+    } else if (cache.scope_versions[depth] != version) {
+      cache.scope_versions[depth] = version;
+      scope_changed = true;
+    }
+  }
+  if (depth != cache.scope_versions.size()) {
+    cache.scope_versions.resize(depth);
+    scope_changed = true;
+  }
+  if (scope_changed) {
+    cache.runtime_ctx.reset(new RuntimeContext(Inputs(), Outputs(), scope));
+  }
+
+  if (UpdateInputVarSignatures(*cache.runtime_ctx)) {
+    VLOG(3) << "The inputs of " << type_ << " change, choose the kernel again";
+    std::lock_guard<std::mutex> lock(cache_update_mutex_);
+    kernel_type_.reset();
+    kernel_func_.reset();
+    cache.need_prepare_data = true;
+  }
+
+  RunImpl(scope, place, cache.runtime_ctx.get());
+
+  // Some inputs of runtime_ctx are replaced by the transformed variables in
+  // a transfer scope, which does not live across runs.
+  if (cache.need_prepare_data) {
+    cache.runtime_ctx.reset();
+  }
+}
+
+bool OperatorWithKernel::UpdateInputVarSignatures(
+    const RuntimeContext& ctx) const {
+  auto& signatures = runtime_cache_->input_signatures;
+  bool changed = false;
+  size_t idx = 0;
+  for (auto& var_item : ctx.inputs) {
+    for (auto* var : var_item.second) {
+      InputVarSignature sig{var, -1, false, proto::VarType::FP32,
+                            platform::CPUPlace(), DataLayout::kAnyLayout};
+      if (var != nullptr) {
+        sig.var_type = var->Type();
+        if (VarIsTensor(*var)) {
+          auto* tensor = GetLoDTensorOrSelectedRowsValueFromVar(*var);
+          sig.initialized = tensor->IsInitialized();
+          if (sig.initialized) {
+            sig.data_type = tensor->type();
+            sig.place = tensor->place();
+            sig.layout = tensor->layout();
+          }
+        }
+      }
+      if (idx == signatures.size()) {
+        signatures.push_back(sig);
+        changed = true;
+      } else {
+        auto& old = signatures[idx];
+        if (old.var != sig.var || old.var_type != sig.var_type ||
+            old.initialized != sig.initialized ||
+            (sig.initialized &&
+             (old.data_type != sig.data_type || old.layout != sig.layout ||
+              !platform::is_same_place(old.place, sig.place)))) {
+          old = sig;
+          changed = true;
+        }
+      }
+      ++idx;
+    }
+  }
+  if (idx != signatures.size()) {
+    signatures.resize(idx);
+    changed = true;
+  }
+  return changed;
+}
+
 void OperatorWithKernel::RunImpl(const Scope& scope,
                                  const platform::Place& place,
                                  RuntimeContext* runtime_ctx) const {
+  if (!all_kernels_must_compute_runtime_shape_ &&
+      HasAttr(kAllKernelsMustComputeRuntimeShape))
+    all_kernels_must_compute_runtime_shape_ = true;
   platform::DeviceContextPool& pool = platform::DeviceContextPool::Instance();
   auto* dev_ctx = pool.Get(place);
 
@@ -890,8 +1004,18 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
 
   // do data transformScope &transfer_scope;
   std::vector<std::string> transfered_inplace_vars;
-  auto* transfer_scope =
-      PrepareData(scope, *kernel_type_, &transfered_inplace_vars, runtime_ctx);
+  Scope* transfer_scope = nullptr;
+  bool use_runtime_cache = runtime_cache_ != nullptr &&
+                           runtime_cache_->runtime_ctx.get() == runtime_ctx;
+  if (!use_runtime_cache || runtime_cache_->need_prepare_data) {
+    transfer_scope = PrepareData(scope, *kernel_type_, &transfered_inplace_vars,
+                                 runtime_ctx);
+    // No input needs transform for the cached kernel, skip PrepareData until
+    // the inputs change.
+    if (use_runtime_cache) {
+      runtime_cache_->need_prepare_data = transfer_scope != nullptr;
+    }
+  }
 
   // exec scope is the scope that kernel actually executed on.
   const Scope& exec_scope =
@@ -138,6 +138,12 @@ class OperatorBase {
   //  The implementation should be written at RunImpl
   void Run(const Scope& scope, const platform::Place& place);
 
+  /// Run the op with the variables of its inputs and outputs already resolved
+  /// in runtime_ctx. The operators which do not run on a RuntimeContext
+  /// ignore it and look up their variables in scope.
+  void Run(const Scope& scope, const platform::Place& place,
+           RuntimeContext* runtime_ctx);
+
   // FIXME(typhoonzero): this is only used for recv_op to stop event_loop.
   virtual void Stop() {}
 
@@ -212,6 +218,10 @@ class OperatorBase {
   void CheckAllInputOutputSet() const;
   virtual void RunImpl(const Scope& scope,
                        const platform::Place& place) const = 0;
+  virtual void RunImpl(const Scope& scope, const platform::Place& place,
+                       RuntimeContext* runtime_ctx) const {
+    RunImpl(scope, place);
+  }
 };
 
 #ifdef PADDLE_WITH_CUDA
@@ -479,7 +489,7 @@ class OperatorWithKernel : public OperatorBase {
   proto::VarType::Type IndicateDataType(const ExecutionContext& ctx) const;
   void RunImpl(const Scope& scope, const platform::Place& place) const final;
   void RunImpl(const Scope& scope, const platform::Place& place,
-               RuntimeContext* runtime_ctx) const;
+               RuntimeContext* runtime_ctx) const final;
 
   /**
    * Transfer data from scope to a transfered scope. If there is no data need to
@@ -499,7 +509,38 @@ class OperatorWithKernel : public OperatorBase {
   void ChooseKernel(const RuntimeContext& ctx, const Scope& scope,
                     const platform::Place& place) const;
 
+  /**
+   * Run with the RuntimeContext, the kernel and the data transform decision
+   * cached across runs. It is used for the operators which are not run by
+   * Executor, e.g. by NaiveExecutor, whose scope is reused by every run.
+   */
+  void RunImplWithCache(const Scope& scope, const platform::Place& place) const;
+
+  // Update the cached signatures of the input variables in ctx, return true
+  // if any of them changes.
+  bool UpdateInputVarSignatures(const RuntimeContext& ctx) const;
+
  protected:
+  // The cached kernel and data transform decision of an op are reused as long
+  // as the input variables and their types, places and layouts do not change.
+  struct InputVarSignature {
+    const Variable* var;
+    int var_type;
+    bool initialized;
+    proto::VarType::Type data_type;
+    platform::Place place;
+    DataLayout layout;
+  };
+
+  struct RuntimeCache {
+    // The VarsVersion of the scope and its ancestors when runtime_ctx is
+    // created.
+    std::vector<uint64_t> scope_versions;
+    std::unique_ptr<RuntimeContext> runtime_ctx;
+    std::vector<InputVarSignature> input_signatures;
+    bool need_prepare_data{true};
+  };
+
   mutable OpKernelConfigsMap kernel_configs_map_;
   mutable std::unique_ptr<OpKernelType> kernel_type_;
   mutable std::unique_ptr<OpKernelFunc> kernel_func_;
@@ -509,6 +550,7 @@ class OperatorWithKernel : public OperatorBase {
   mutable bool all_kernels_must_compute_runtime_shape_ = false;
   mutable std::mutex cache_update_mutex_;
   mutable bool enable_cache_transfer_scope_ = false;
+  mutable std::unique_ptr<RuntimeCache> runtime_cache_;
 };
 
 extern bool OpSupportGPU(const std::string& op_type);
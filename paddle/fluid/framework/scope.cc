@@ -50,6 +50,11 @@ namespace framework {
 
 Scope::~Scope() { DropKids(); }
 
+uint64_t Scope::NewVarsVersion() {
+  static std::atomic<uint64_t> version{0};
+  return version.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
 Scope& Scope::NewScope() const {
   Scope* child = new Scope(this);
   {
@@ -134,6 +139,7 @@ void Scope::DeleteScope(Scope* scope) const {
 void Scope::EraseVars(const std::vector<std::string>& var_names) {
   std::set<std::string> var_set(var_names.begin(), var_names.end());
   SCOPE_VARS_WRITER_LOCK
+  vars_version_.store(NewVarsVersion(), std::memory_order_relaxed);
   for (auto it = vars_.begin(); it != vars_.end();) {
     if (var_set.find(it->first) != var_set.end()) {
       it = vars_.erase(it);
@@ -161,6 +167,7 @@ Variable* Scope::VarInternal(const std::string& name) {
   if (v != nullptr) return v;
   v = new Variable();
   vars_.emplace(name, std::unique_ptr<Variable>(v));
+  vars_version_.store(NewVarsVersion(), std::memory_order_relaxed);
   VLOG(3) << "Create variable " << name;
   return v;
 }
@@ -184,6 +191,7 @@ void Scope::RenameInternal(const std::string& origin_name,
                  "The variable with name %s is already in the scope", new_name);
   vars_[new_name].reset(origin_it->second.release());
   vars_.erase(origin_it);
+  vars_version_.store(NewVarsVersion(), std::memory_order_relaxed);
 }
 
 Variable* Scope::FindVarInternal(const std::string& name) const {
@@ -202,6 +210,7 @@ Variable* Scope::FindVarLocally(const std::string& name) const {
 
 void Scope::EraseVarsExcept(const std::unordered_set<Variable*>& vars) {
   SCOPE_VARS_WRITER_LOCK
+  vars_version_.store(NewVarsVersion(), std::memory_order_relaxed);
   for (auto iter = vars_.begin(); iter != vars_.end();) {
     if (vars.count(iter->second.get()) != 0) {
       ++iter;
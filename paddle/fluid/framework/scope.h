@@ -18,6 +18,7 @@ extern "C" {
 #include <xxhash.h>
 }
 
+#include <atomic>
 #include <list>
 #include <memory>
 #include <string>
@@ -105,6 +106,14 @@ class Scope {
   // Rename variable to a new name and return the new name
   std::string Rename(const std::string& origin_name) const;
 
+  /// The version of the variable set of this scope. It changes whenever a
+  /// variable is created, erased or renamed in this scope, and is unique
+  /// among all the scopes of the process, so the caches of the variables
+  /// found in a scope can check it to know if they are outdated.
+  uint64_t VarsVersion() const {
+    return vars_version_.load(std::memory_order_relaxed);
+  }
+
  protected:
   struct KeyHasher {
     std::size_t operator()(const std::string& key) const {
@@ -119,6 +128,9 @@ class Scope {
   // Call Scope::NewScope for a sub-scope.
   explicit Scope(Scope const* parent) : parent_(parent) {}
 
+  // Get a new value of vars_version_.
+  static uint64_t NewVarsVersion();
+
   // Called by Var.
   Variable* VarInternal(const std::string& name);
 
@@ -138,6 +150,7 @@ class Scope {
   // Scope in `kids_` are owned by this class.
   mutable std::list<Scope*> kids_;
   const Scope* parent_{nullptr};
+  mutable std::atomic<uint64_t> vars_version_{NewVarsVersion()};
 
   DISABLE_COPY_AND_ASSIGN(Scope);
 
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/framework/selected_rows.h"
+#include <algorithm>
+#include <vector>
 
 namespace paddle {
 namespace framework {
@@ -38,49 +40,43 @@ struct ReAllocateVisitor {
   framework::Tensor* tensor_;
 };
 
-struct TensorCopyVisitor {
-  TensorCopyVisitor(framework::Tensor* dst, int64_t dst_offset,
-                    const framework::Tensor src, int64_t src_offset,
-                    int64_t size)
+// Copy the rows of src to the rows of dst, a negative src row fills zeros.
+struct TensorRowsCopyVisitor {
+  TensorRowsCopyVisitor(framework::Tensor* dst, const int64_t* dst_rows,
+                        const framework::Tensor& src, const int64_t* src_rows,
+                        int64_t row_num, int64_t width)
       : dst_(dst),
-        dst_offset_(dst_offset),
+        dst_rows_(dst_rows),
         src_(src),
-        src_offset_(src_offset),
-        size_(size) {}
+        src_rows_(src_rows),
+        row_num_(row_num),
+        width_(width) {}
 
   template <typename T>
   void apply() const {
     // TODO(Yancey1989): support other place
     platform::CPUPlace cpu;
-    memory::Copy(cpu, dst_->mutable_data<T>(cpu) + dst_offset_, cpu,
-                 src_.data<T>() + src_offset_, size_ * sizeof(T));
-  }
-
-  framework::Tensor* dst_;
-  int64_t dst_offset_;
-  framework::Tensor src_;
-  int64_t src_offset_;
-  int64_t size_;
-};
-
-struct TensorFillVisitor {
-  TensorFillVisitor(framework::Tensor* dst, int64_t dst_offset, int64_t size,
-                    float value)
-      : dst_(dst), dst_offset_(dst_offset), size_(size) {}
-
-  template <typename T>
-  void apply() const {
-    // TODO(qiao): support other place
-    platform::CPUPlace cpu;
-    auto* tensor_data = dst_->mutable_data<T>(cpu);
-    auto* start = tensor_data + dst_offset_;
-    auto* end = start + size_;
-    std::fill(start, end, static_cast<T>(0.0));
+    T* dst_data = dst_->mutable_data<T>(cpu);
+    const T* src_data = src_.data<T>();
+    for (int64_t i = 0; i < row_num_; ++i) {
+      int64_t dst_row = dst_rows_ == nullptr ? i : dst_rows_[i];
+      int64_t src_row = src_rows_ == nullptr ? i : src_rows_[i];
+      T* dst_start = dst_data + dst_row * width_;
+      if (src_row < 0) {
+        std::fill(dst_start, dst_start + width_, static_cast<T>(0.0));
+      } else {
+        memory::Copy(cpu, dst_start, cpu, src_data + src_row * width_,
+                     width_ * sizeof(T));
+      }
+    }
   }
 
   framework::Tensor* dst_;
-  int64_t dst_offset_;
-  int64_t size_;
+  const int64_t* dst_rows_;
+  const framework::Tensor& src_;
+  const int64_t* src_rows_;
+  int64_t row_num_;
+  int64_t width_;
 };
 
 void SerializeToStream(std::ostream& os, const SelectedRows& selected_rows,
@@ -140,65 +136,54 @@ bool SelectedRows::HasKey(int64_t key) const {
                                                                    : true;
 }
 
+int64_t SelectedRows::AppendRow(int64_t key) {
+  AutoWRLock lock(rwlock_.get());
+  int64_t row_num = rows_.size();
+  if (row_num == value_->dims()[0]) {
+    PADDLE_THROW("selected rows is full, then length exceed %d", row_num);
+  }
+  // key logic to put a key into id_to_index_
+  rows_.push_back(key);
+  return row_num;
+}
+
 int64_t SelectedRows::AutoGrownIndex(int64_t key, bool auto_grown,
                                      bool is_test) {
-  if (is_test) {
-    auto iter = id_to_index_.find(key);
-    if (iter == id_to_index_.end()) {
-      return -1;
-    } else {
-      return iter->second;
+  if (is_test || !auto_grown) {
+    int64_t index = id_to_index_->Find(key);
+    if (index < 0 && !is_test) {
+      PADDLE_THROW("key %d not found", key);
     }
+    return index;
   }
+  return id_to_index_->FindOrInsert(
+      key, [this](int64_t id) { return AppendRow(id); });
+}
 
-  rwlock_->RDLock();
-  auto iter = id_to_index_.find(key);
-  if (iter == id_to_index_.end()) {
-    rwlock_->UNLock();
-    if (!auto_grown) {
-      PADDLE_THROW("key %d not found", key);
-    }
-    rwlock_->WRLock();
-    auto map_size = id_to_index_.size();
-    auto vector_size = rows_.size();
-    if (map_size != vector_size) {
-      rwlock_->UNLock();
-      PADDLE_THROW(
-          "id_to_index_ size %d should have the same size with rows_ %d",
-          map_size, vector_size);
-    }
-    auto write_iter = id_to_index_.find(key);
-    if (write_iter == id_to_index_.end()) {
-      int row_num = rows_.size();
-      if (row_num == value_->dims()[0]) {
-        rwlock_->UNLock();
-        PADDLE_THROW("selected rows is full, then length exceed %d", row_num);
+void SelectedRows::AutoGrownIndex(const int64_t* keys, int64_t num,
+                                  bool auto_grown, bool is_test,
+                                  int64_t* indexes) {
+  if (is_test || !auto_grown) {
+    id_to_index_->FindBatch(keys, num, indexes);
+    if (!is_test) {
+      for (int64_t i = 0; i < num; ++i) {
+        if (indexes[i] < 0) {
+          PADDLE_THROW("key %d not found", keys[i]);
+        }
       }
-      // key logic to put a key into id_to_index_
-      rows_.push_back(key);
-      auto index = static_cast<int64_t>(rows_.size() - 1);
-      id_to_index_[key] = index;
-      rwlock_->UNLock();
-      return index;
-    } else {
-      auto index = write_iter->second;
-      rwlock_->UNLock();
-      return index;
     }
-  } else {
-    auto index = iter->second;
-    rwlock_->UNLock();
-    return index;
+    return;
   }
+  id_to_index_->FindBatch(keys, num, indexes,
+                          [this](int64_t id) { return AppendRow(id); });
 }
 
 void SelectedRows::SyncIndex() {
-  rwlock_->WRLock();
-  id_to_index_.clear();
+  AutoWRLock lock(rwlock_.get());
+  id_to_index_->Clear();
   for (size_t i = 0; i < rows_.size(); ++i) {
-    id_to_index_[rows_[i]] = i;
+    id_to_index_->Set(rows_[i], i);
   }
-  rwlock_->UNLock();
 }
 
 void SelectedRows::Get(const framework::Tensor& ids, framework::Tensor* value,
@@ -212,22 +197,45 @@ void SelectedRows::Get(const framework::Tensor& ids, framework::Tensor* value,
     PADDLE_ENFORCE_EQ(value_width, value->numel() / value->dims()[0],
                       "output tensor should have the same shape with table "
                       "except the dims[0].");
-    for (int i = 0; i < ids.numel(); ++i) {
-      auto id = ids.data<int64_t>()[i];
-      int64_t index = AutoGrownIndex(id, auto_grown, is_test);
-      if (index < 0) {
-        VLOG(5) << "id " << id << " not in the table, return 0";
-        framework::VisitDataType(
-            value_->type(),
-            TensorFillVisitor(value, i * value_width, value_width, 0.0));
-      } else {
-        framework::VisitDataType(
-            value_->type(),
-            TensorCopyVisitor(value, i * value_width, *value_.get(),
-                              index * value_width, value_width));
+    std::vector<int64_t> indexes(ids.numel());
+    AutoGrownIndex(ids.data<int64_t>(), ids.numel(), auto_grown, is_test,
+                   indexes.data());
+    if (VLOG_IS_ON(5)) {
+      for (int64_t i = 0; i < ids.numel(); ++i) {
+        if (indexes[i] < 0) {
+          VLOG(5) << "id " << ids.data<int64_t>()[i]
+                  << " not in the table, return 0";
+        }
       }
     }
+    framework::VisitDataType(
+        value_->type(),
+        TensorRowsCopyVisitor(value, nullptr, *value_, indexes.data(),
+                              ids.numel(), value_width));
+  }
+}
+
+void SelectedRows::Set(const framework::Tensor& ids,
+                       const framework::Tensor& value, bool auto_grown) {
+  PADDLE_ENFORCE(value_->IsInitialized(),
+                 "The table value tensor should be initialized.");
+  if (ids.numel() == 0) {
+    VLOG(3) << "keys is empty, please check data!";
+    return;
   }
+  int64_t value_width = value_->numel() / value_->dims()[0];
+  PADDLE_ENFORCE_EQ(value_width, value.numel() / value.dims()[0],
+                    "input tensor should have the same shape with table "
+                    "except the dims[0].");
+  PADDLE_ENFORCE_EQ(ids.numel(), value.dims()[0],
+                    "input tensor should have a row for every id.");
+  std::vector<int64_t> indexes(ids.numel());
+  AutoGrownIndex(ids.data<int64_t>(), ids.numel(), auto_grown, false,
+                 indexes.data());
+  framework::VisitDataType(
+      value_->type(), TensorRowsCopyVisitor(value_.get(), indexes.data(),
+                                            value, nullptr, ids.numel(),
+                                            value_width));
 }
 
 }  // namespace framework
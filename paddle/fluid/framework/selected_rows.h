@@ -17,12 +17,12 @@ limitations under the License. */
 #include <algorithm>
 #include <memory>
 #include <mutex>  // NOLINT
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/rw_lock.h"
+#include "paddle/fluid/framework/sharded_id_index.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/memory/memcpy.h"
 
@@ -49,12 +49,14 @@ class SelectedRows {
   SelectedRows(const std::vector<int64_t>& rows, const int64_t& height)
       : rows_(rows), height_(height) {
     value_.reset(new Tensor());
+    id_to_index_.reset(new ShardedIdIndex);
     rwlock_.reset(new RWLock);
   }
 
   SelectedRows() {
     height_ = 0;
     value_.reset(new Tensor());
+    id_to_index_.reset(new ShardedIdIndex);
     rwlock_.reset(new RWLock);
   }
 
@@ -106,6 +108,17 @@ class SelectedRows {
   void Get(const framework::Tensor& ids, framework::Tensor* value,
            bool auto_grown = false, bool is_test = false);
 
+  /*
+   * @brief Set value by the key list, the i-th row of value is copied to the
+   * row of the i-th key. The keys which do not exist are added if
+   * auto_grown.
+   * Note!!! this interface is only used when selected_rows is used as
+   * parameters
+   * for distribute lookup table.
+   */
+  void Set(const framework::Tensor& ids, const framework::Tensor& value,
+           bool auto_grown = true);
+
   /*
    * @brief Get the index of the key from id_to_index_ map. If the key not
    * exist,
@@ -119,18 +132,27 @@ class SelectedRows {
    */
   int64_t AutoGrownIndex(int64_t key, bool auto_grown, bool is_test = false);
 
+  /*
+   * @brief The batch version of AutoGrownIndex, which gets the indexes of
+   * keys[0, num) with every shard of id_to_index_ locked once. The new keys
+   * are appended to rows_ shard by shard rather than in the order of keys.
+   */
+  void AutoGrownIndex(const int64_t* keys, int64_t num, bool auto_grown,
+                      bool is_test, int64_t* indexes);
+
   /*
    * @brief Get the index of the key from id_to_index_ map.
    */
   inline int64_t GetIndexFromId(int64_t key) {
-    auto iter = id_to_index_.find(key);
-    if (iter == id_to_index_.end()) {
-      return -1;
-    } else {
-      return iter->second;
-    }
+    return id_to_index_->Find(key);
   }
 
+  /*
+   * @brief Rebuild id_to_index_ from rows_ under the write lock.
+   *
+   * NOTE: It should not run together with AutoGrownIndex on the same
+   * SelectedRows, which locks a shard of id_to_index_ before rwlock_.
+   */
   void SyncIndex();
   /*
    * @brief Get complete Dims before
@@ -142,15 +164,19 @@ class SelectedRows {
   }
 
  private:
+  // Append key to rows_ and return its index, called by id_to_index_ when
+  // key is inserted.
+  int64_t AppendRow(int64_t key);
+
   // Notice: rows can be duplicate. We can have {0, 4, 7, 0, 5, 7, 9} here.
   // SelectedRows are simply concated when adding together. Until a
   // SelectedRows add a Tensor, will the duplicate rows be handled.
   Vector<int64_t> rows_;
-  std::unordered_map<int64_t, int64_t>
+  std::unique_ptr<ShardedIdIndex>
       id_to_index_;  // should not be used when rows_ has duplicate member
   std::unique_ptr<Tensor> value_{nullptr};
   int64_t height_;  // height indicates the underline tensor's height
-  std::unique_ptr<RWLock> rwlock_{nullptr};
+  std::unique_ptr<RWLock> rwlock_{nullptr};  // protect the append of rows_
 };
 
 /*
@@ -0,0 +1,156 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Measure the concurrent lookups of a SelectedRows used as a sparse table,
+// against the std::unordered_map behind a single RWLock that it used before.
+// Usage:
+//   selected_rows_benchmark --threads=8 --ids=1000000 --batch=1024
+
+#include <random>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int32(threads, 8, "The number of lookup threads.");
+DEFINE_int64(ids, 1000000, "The number of ids in the table.");
+DEFINE_int32(batch, 1024, "The number of ids of a lookup.");
+DEFINE_int32(repeat, 200, "The number of lookups of each thread.");
+
+namespace paddle {
+namespace framework {
+
+// The index of SelectedRows before it was sharded.
+class LegacyIdIndex {
+ public:
+  int64_t AutoGrownIndex(int64_t key) {
+    rwlock_.RDLock();
+    auto iter = id_to_index_.find(key);
+    if (iter != id_to_index_.end()) {
+      rwlock_.UNLock();
+      return iter->second;
+    }
+    rwlock_.UNLock();
+    AutoWRLock lock(&rwlock_);
+    auto it = id_to_index_.find(key);
+    if (it != id_to_index_.end()) {
+      return it->second;
+    }
+    int64_t index = static_cast<int64_t>(id_to_index_.size());
+    id_to_index_[key] = index;
+    return index;
+  }
+
+  size_t MemorySize() const {
+    // a node holds the pair and the next pointer, rounded up by malloc
+    return id_to_index_.size() * 32 +
+           id_to_index_.bucket_count() * sizeof(void*);
+  }
+
+ private:
+  RWLock rwlock_;
+  std::unordered_map<int64_t, int64_t> id_to_index_;
+};
+
+static std::vector<std::vector<int64_t>> RandomIds() {
+  std::vector<std::vector<int64_t>> ids(FLAGS_threads);
+  for (int t = 0; t < FLAGS_threads; ++t) {
+    std::mt19937_64 engine(t);
+    std::uniform_int_distribution<int64_t> dist(0, FLAGS_ids - 1);
+    ids[t].resize(static_cast<size_t>(FLAGS_batch) * FLAGS_repeat);
+    for (auto& id : ids[t]) {
+      // spread the ids over the whole int64 range
+      id = dist(engine) * 2654435761LL;
+    }
+  }
+  return ids;
+}
+
+template <typename Callback>
+static double RunThreads(Callback callback) {
+  platform::Timer timer;
+  timer.Start();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < FLAGS_threads; ++t) {
+    threads.emplace_back(callback, t);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  timer.Pause();
+  double lookups =
+      static_cast<double>(FLAGS_threads) * FLAGS_batch * FLAGS_repeat;
+  return lookups / timer.ElapsedUS();
+}
+
+static void RunBenchmark() {
+  auto ids = RandomIds();
+
+  LegacyIdIndex legacy;
+  for (int64_t i = 0; i < FLAGS_ids; ++i) {
+    legacy.AutoGrownIndex(i * 2654435761LL);
+  }
+  double legacy_speed = RunThreads([&](int t) {
+    for (auto id : ids[t]) {
+      legacy.AutoGrownIndex(id);
+    }
+  });
+
+  SelectedRows table;
+  table.mutable_value()->mutable_data<float>(make_ddim({FLAGS_ids, 1}),
+                                             platform::CPUPlace());
+  std::vector<int64_t> indexes(FLAGS_ids);
+  std::vector<int64_t> keys(FLAGS_ids);
+  for (int64_t i = 0; i < FLAGS_ids; ++i) {
+    keys[i] = i * 2654435761LL;
+  }
+  table.AutoGrownIndex(keys.data(), FLAGS_ids, true, false, indexes.data());
+  double single_speed = RunThreads([&](int t) {
+    for (auto id : ids[t]) {
+      table.AutoGrownIndex(id, true);
+    }
+  });
+  double batch_speed = RunThreads([&](int t) {
+    std::vector<int64_t> batch_indexes(FLAGS_batch);
+    for (int i = 0; i < FLAGS_repeat; ++i) {
+      table.AutoGrownIndex(ids[t].data() + i * FLAGS_batch, FLAGS_batch, true,
+                           false, batch_indexes.data());
+    }
+  });
+
+  // the same ids in an index alone, to measure its memory
+  ShardedIdIndex sharded;
+  for (int64_t i = 0; i < FLAGS_ids; ++i) {
+    sharded.Set(keys[i], i);
+  }
+
+  LOG(INFO) << "unordered_map: " << legacy_speed << " lookups/us, "
+            << legacy.MemorySize() / FLAGS_ids << " bytes/id";
+  LOG(INFO) << "sharded: " << single_speed << " lookups/us, batched "
+            << batch_speed << " lookups/us, "
+            << sharded.MemorySize() / FLAGS_ids << " bytes/id";
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::RunBenchmark();
+  return 0;
+}
@@ -198,5 +198,53 @@ TEST(SelectedRows, MultiThreadAutoIndex) {
   t4.join();
 }
 
+TEST(SelectedRows, BatchGetAndSet) {
+  platform::CPUPlace cpu;
+  SelectedRows table;
+  int64_t table_size = 10;
+  int64_t embedding_width = 4;
+  table.mutable_value()->mutable_data<float>(
+      framework::make_ddim({table_size, embedding_width}), cpu);
+
+  framework::Tensor ids;
+  auto* ids_data = ids.mutable_data<int64_t>(framework::make_ddim({3}), cpu);
+  ids_data[0] = 42;
+  ids_data[1] = 7;
+  ids_data[2] = 42;
+  framework::Tensor set_value;
+  auto* set_data = set_value.mutable_data<float>(
+      framework::make_ddim({3, embedding_width}), cpu);
+  for (int64_t i = 0; i < 3 * embedding_width; ++i) {
+    set_data[i] = static_cast<float>(i / embedding_width);
+  }
+  // the row of 42 is set twice, the later one wins
+  table.Set(ids, set_value);
+  ASSERT_EQ(table.rows().size(), 2UL);
+  ASSERT_EQ(table.rows()[table.AutoGrownIndex(42, false)], 42);
+  ASSERT_EQ(table.rows()[table.AutoGrownIndex(7, false)], 7);
+
+  ids_data[2] = 3;
+  framework::Tensor get_value;
+  auto* get_data = get_value.mutable_data<float>(
+      framework::make_ddim({3, embedding_width}), cpu);
+  table.Get(ids, &get_value, false, true);
+  for (int64_t j = 0; j < embedding_width; ++j) {
+    ASSERT_EQ(get_data[j], 2);
+    ASSERT_EQ(get_data[embedding_width + j], 1);
+    ASSERT_EQ(get_data[2 * embedding_width + j], 0);
+  }
+  ASSERT_EQ(table.rows().size(), 2UL);
+  ASSERT_THROW(table.Get(ids, &get_value, false, false),
+               paddle::platform::EnforceNotMet);
+
+  std::vector<int64_t> keys{3, 42, 5};
+  std::vector<int64_t> indexes(keys.size());
+  table.AutoGrownIndex(keys.data(), keys.size(), true, false, indexes.data());
+  ASSERT_EQ(table.rows().size(), 4UL);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_EQ(table.rows()[indexes[i]], keys[i]);
+  }
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -0,0 +1,204 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/sharded_id_index.h"
+#include <algorithm>
+
+namespace paddle {
+namespace framework {
+
+static constexpr size_t kInitCapacity = 16;
+
+ShardedIdIndex::ShardedIdIndex(size_t shard_num) {
+  PADDLE_ENFORCE_GT(shard_num, 0, "shard_num should be positive");
+  shard_num_ = 1;
+  while (shard_num_ < shard_num) {
+    shard_num_ <<= 1;
+  }
+  shards_.reset(new Shard[shard_num_]);
+}
+
+int64_t ShardedIdIndex::Shard::Find(int64_t id, uint64_t hash) const {
+  if (size == 0) {
+    return -1;
+  }
+  size_t mask = entries.size() - 1;
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    const Entry& entry = entries[pos];
+    if (entry.index < 0) {
+      return -1;
+    }
+    if (entry.id == id) {
+      return entry.index;
+    }
+  }
+}
+
+ShardedIdIndex::Entry* ShardedIdIndex::Shard::FindOrAdd(int64_t id,
+                                                        uint64_t hash) {
+  if ((size + 1) * 4 > entries.size() * 3) {
+    Grow();
+  }
+  size_t mask = entries.size() - 1;
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    Entry& entry = entries[pos];
+    if (entry.index < 0) {
+      entry.id = id;
+      return &entry;
+    }
+    if (entry.id == id) {
+      return &entry;
+    }
+  }
+}
+
+void ShardedIdIndex::Shard::Grow() {
+  std::vector<Entry> old_entries(
+      std::max(kInitCapacity, entries.size() * 2), Entry{0, -1});
+  old_entries.swap(entries);
+  size_t mask = entries.size() - 1;
+  for (auto& old_entry : old_entries) {
+    if (old_entry.index < 0) {
+      continue;
+    }
+    size_t pos = Hash(old_entry.id) & mask;
+    while (entries[pos].index >= 0) {
+      pos = (pos + 1) & mask;
+    }
+    entries[pos] = old_entry;
+  }
+}
+
+int64_t ShardedIdIndex::Find(int64_t id) const {
+  uint64_t hash = Hash(id);
+  Shard& shard = ShardOf(hash);
+  AutoRDLock lock(&shard.lock);
+  return shard.Find(id, hash);
+}
+
+int64_t ShardedIdIndex::FindOrInsert(int64_t id, const InsertFunc& insert) {
+  uint64_t hash = Hash(id);
+  Shard& shard = ShardOf(hash);
+  {
+    AutoRDLock lock(&shard.lock);
+    int64_t index = shard.Find(id, hash);
+    if (index >= 0) {
+      return index;
+    }
+  }
+  AutoWRLock lock(&shard.lock);
+  Entry* entry = shard.FindOrAdd(id, hash);
+  if (entry->index < 0) {
+    // insert may throw, the entry stays empty then
+    entry->index = insert(id);
+    ++shard.size;
+  }
+  return entry->index;
+}
+
+void ShardedIdIndex::FindBatch(const int64_t* ids, size_t num,
+                               int64_t* indexes, const InsertFunc& insert) {
+  // Group the ids by shard with a counting sort, so that every shard is
+  // locked once for the whole batch.
+  std::vector<uint64_t> hashes(num);
+  std::vector<size_t> offsets(shard_num_ + 1, 0);
+  for (size_t i = 0; i < num; ++i) {
+    hashes[i] = Hash(ids[i]);
+    ++offsets[((hashes[i] >> 40) & (shard_num_ - 1)) + 1];
+  }
+  for (size_t s = 0; s < shard_num_; ++s) {
+    offsets[s + 1] += offsets[s];
+  }
+  std::vector<size_t> order(num);
+  {
+    std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < num; ++i) {
+      order[next[(hashes[i] >> 40) & (shard_num_ - 1)]++] = i;
+    }
+  }
+
+  for (size_t s = 0; s < shard_num_; ++s) {
+    if (offsets[s] == offsets[s + 1]) {
+      continue;
+    }
+    Shard& shard = shards_[s];
+    bool has_missing = false;
+    {
+      AutoRDLock lock(&shard.lock);
+      for (size_t k = offsets[s]; k < offsets[s + 1]; ++k) {
+        size_t i = order[k];
+        indexes[i] = shard.Find(ids[i], hashes[i]);
+        has_missing = has_missing || indexes[i] < 0;
+      }
+    }
+    if (!has_missing || !insert) {
+      continue;
+    }
+    AutoWRLock lock(&shard.lock);
+    for (size_t k = offsets[s]; k < offsets[s + 1]; ++k) {
+      size_t i = order[k];
+      if (indexes[i] >= 0) {
+        continue;
+      }
+      Entry* entry = shard.FindOrAdd(ids[i], hashes[i]);
+      if (entry->index < 0) {
+        entry->index = insert(ids[i]);
+        ++shard.size;
+      }
+      indexes[i] = entry->index;
+    }
+  }
+}
+
+void ShardedIdIndex::Set(int64_t id, int64_t index) {
+  PADDLE_ENFORCE_GE(index, 0, "The index of id %d should not be negative",
+                    id);
+  uint64_t hash = Hash(id);
+  Shard& shard = ShardOf(hash);
+  AutoWRLock lock(&shard.lock);
+  Entry* entry = shard.FindOrAdd(id, hash);
+  if (entry->index < 0) {
+    ++shard.size;
+  }
+  entry->index = index;
+}
+
+void ShardedIdIndex::Clear() {
+  for (size_t s = 0; s < shard_num_; ++s) {
+    AutoWRLock lock(&shards_[s].lock);
+    std::vector<Entry>().swap(shards_[s].entries);
+    shards_[s].size = 0;
+  }
+}
+
+size_t ShardedIdIndex::Size() const {
+  size_t size = 0;
+  for (size_t s = 0; s < shard_num_; ++s) {
+    AutoRDLock lock(&shards_[s].lock);
+    size += shards_[s].size;
+  }
+  return size;
+}
+
+size_t ShardedIdIndex::MemorySize() const {
+  size_t bytes = sizeof(Shard) * shard_num_;
+  for (size_t s = 0; s < shard_num_; ++s) {
+    AutoRDLock lock(&shards_[s].lock);
+    bytes += shards_[s].entries.capacity() * sizeof(Entry);
+  }
+  return bytes;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,108 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "paddle/fluid/framework/rw_lock.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * @brief The id to index map of the SelectedRows used as a sparse table.
+ *
+ *  The ids are spread over shards by their hash. Every shard is an open
+ *  addressing hash table with linear probing behind its own RWLock, so the
+ *  lookups of different threads rarely wait for the same lock. An entry
+ *  takes 16 bytes in a table at most 3/4 full, while a node of
+ *  std::unordered_map<int64_t, int64_t> takes about 40 bytes with its
+ *  bucket.
+ *
+ *  The indexes are non-negative, -1 is returned for the missing ids.
+ */
+class ShardedIdIndex {
+ public:
+  // Return the index of a missing id, it is called under the write lock of
+  // the shard of id, so it is called once for each id.
+  using InsertFunc = std::function<int64_t(int64_t id)>;
+
+  // shard_num is rounded up to a power of 2.
+  explicit ShardedIdIndex(size_t shard_num = 64);
+
+  int64_t Find(int64_t id) const;
+
+  // Find the index of id, insert id with the index returned by insert if it
+  // does not exist.
+  int64_t FindOrInsert(int64_t id, const InsertFunc& insert);
+
+  // Find the indexes of ids[0, num) in batch, which takes the lock of every
+  // shard once. The missing ids are inserted if insert is not null,
+  // otherwise their indexes are -1.
+  void FindBatch(const int64_t* ids, size_t num, int64_t* indexes,
+                 const InsertFunc& insert = nullptr);
+
+  // Insert id, or update its index if it exists.
+  void Set(int64_t id, int64_t index);
+
+  void Clear();
+
+  size_t Size() const;
+
+  // The bytes used by the hash tables.
+  size_t MemorySize() const;
+
+ private:
+  struct Entry {
+    int64_t id;
+    int64_t index;  // -1 if the entry is empty
+  };
+
+  struct Shard {
+    RWLock lock;
+    std::vector<Entry> entries;  // the capacity is 0 or a power of 2
+    size_t size{0};
+    // keep the locks of the shards in different cache lines
+    char padding[64];
+
+    int64_t Find(int64_t id, uint64_t hash) const;
+    // Return the entry of id, insert an empty entry if it does not exist.
+    Entry* FindOrAdd(int64_t id, uint64_t hash);
+    void Grow();
+  };
+
+  static uint64_t Hash(int64_t id) {
+    uint64_t h = static_cast<uint64_t>(id);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  Shard& ShardOf(uint64_t hash) const {
+    return shards_[(hash >> 40) & (shard_num_ - 1)];
+  }
+
+  size_t shard_num_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,111 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/sharded_id_index.h"
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(ShardedIdIndex, FindAndInsert) {
+  ShardedIdIndex index(4);
+  int64_t next = 0;
+  auto insert = [&next](int64_t id) { return next++; };
+  EXPECT_EQ(index.Find(5), -1);
+  EXPECT_EQ(index.FindOrInsert(5, insert), 0);
+  EXPECT_EQ(index.FindOrInsert(-3, insert), 1);
+  EXPECT_EQ(index.FindOrInsert(5, insert), 0);
+  EXPECT_EQ(index.Find(-3), 1);
+  EXPECT_EQ(index.Size(), 2UL);
+
+  // grow the tables
+  for (int64_t id = 1; id <= 10000; ++id) {
+    index.FindOrInsert(id * 7919, insert);
+  }
+  EXPECT_EQ(index.Size(), 10002UL);
+  for (int64_t id = 1; id <= 10000; ++id) {
+    EXPECT_EQ(index.Find(id * 7919), id + 1);
+  }
+  EXPECT_LT(index.MemorySize(), 10002UL * 40);
+
+  index.Set(5, 100);
+  EXPECT_EQ(index.Find(5), 100);
+  index.Clear();
+  EXPECT_EQ(index.Size(), 0UL);
+  EXPECT_EQ(index.Find(5), -1);
+}
+
+TEST(ShardedIdIndex, InsertThrows) {
+  ShardedIdIndex index;
+  EXPECT_THROW(index.FindOrInsert(1,
+                                  [](int64_t id) -> int64_t {
+                                    PADDLE_THROW("full");
+                                  }),
+               paddle::platform::EnforceNotMet);
+  EXPECT_EQ(index.Find(1), -1);
+  EXPECT_EQ(index.Size(), 0UL);
+}
+
+TEST(ShardedIdIndex, FindBatch) {
+  ShardedIdIndex index;
+  int64_t next = 0;
+  auto insert = [&next](int64_t id) { return next++; };
+  std::vector<int64_t> ids{9, 1, 9, 100, 1};
+  std::vector<int64_t> indexes(ids.size());
+  index.FindBatch(ids.data(), ids.size(), indexes.data());
+  EXPECT_EQ(indexes, std::vector<int64_t>(ids.size(), -1));
+
+  index.FindBatch(ids.data(), ids.size(), indexes.data(), insert);
+  EXPECT_EQ(next, 3);
+  EXPECT_EQ(indexes[0], indexes[2]);
+  EXPECT_EQ(indexes[1], indexes[4]);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    EXPECT_EQ(index.Find(ids[i]), indexes[i]);
+  }
+}
+
+TEST(ShardedIdIndex, MultiThreadInsert) {
+  ShardedIdIndex index;
+  std::atomic<int64_t> next{0};
+  auto insert = [&next](int64_t id) { return next++; };
+  const int64_t id_num = 20000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&index, &insert, t, id_num] {
+      std::vector<int64_t> ids;
+      for (int64_t i = 0; i < id_num; ++i) {
+        ids.push_back(t % 2 == 0 ? i : id_num - 1 - i);
+      }
+      std::vector<int64_t> indexes(ids.size());
+      for (size_t i = 0; i < ids.size(); i += 100) {
+        index.FindBatch(ids.data() + i, 100, indexes.data() + i, insert);
+      }
+      for (size_t i = 0; i < ids.size(); ++i) {
+        ASSERT_EQ(index.FindOrInsert(ids[i], insert), indexes[i]);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // every id is inserted once
+  EXPECT_EQ(next.load(), id_num);
+  EXPECT_EQ(index.Size(), static_cast<size_t>(id_num));
+}
+
+}  // namespace framework
+}  // namespace paddle
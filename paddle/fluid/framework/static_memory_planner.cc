@@ -0,0 +1,269 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/static_memory_planner.h"
+#include <algorithm>
+#include <limits>
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/memory/malloc.h"
+
+namespace paddle {
+namespace framework {
+
+// A piece of the arena, which keeps the arena alive.
+class ArenaPieceAllocation : public memory::allocation::Allocation {
+ public:
+  ArenaPieceAllocation(void* ptr, size_t size, const platform::Place& place,
+                       std::shared_ptr<memory::Allocation> arena)
+      : Allocation(ptr, size, place), arena_(std::move(arena)) {}
+
+ private:
+  std::shared_ptr<memory::Allocation> arena_;
+};
+
+size_t PlanMemoryOffsets(std::vector<MemoryPlanBuffer>* buffers,
+                         size_t alignment) {
+  auto aligned_size = [alignment](size_t size) {
+    return (size + alignment - 1) / alignment * alignment;
+  };
+  std::vector<size_t> order(buffers->size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return (*buffers)[a].size > (*buffers)[b].size;
+  });
+
+  size_t arena_size = 0;
+  std::vector<size_t> placed;
+  std::vector<std::pair<size_t, size_t>> used;
+  for (size_t idx : order) {
+    auto& buffer = (*buffers)[idx];
+    size_t size = aligned_size(buffer.size);
+    // The ranges of the placed buffers alive at the same time.
+    used.clear();
+    for (size_t other_idx : placed) {
+      auto& other = (*buffers)[other_idx];
+      if (other.first_use <= buffer.last_use &&
+          buffer.first_use <= other.last_use) {
+        used.emplace_back(other.offset,
+                          other.offset + aligned_size(other.size));
+      }
+    }
+    std::sort(used.begin(), used.end());
+
+    size_t best_offset = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t end = 0;
+    for (auto& range : used) {
+      if (range.first > end) {
+        size_t gap = range.first - end;
+        if (gap >= size && gap < best_gap) {
+          best_offset = end;
+          best_gap = gap;
+        }
+      }
+      end = std::max(end, range.second);
+    }
+    if (best_offset == std::numeric_limits<size_t>::max()) {
+      best_offset = end;
+    }
+    buffer.offset = best_offset;
+    arena_size = std::max(arena_size, best_offset + size);
+    placed.push_back(idx);
+  }
+  return arena_size;
+}
+
+void StaticMemoryPlanner::BeginRun() {
+  if (planned_) {
+    Bind();
+    return;
+  }
+  op_idx_ = 0;
+  records_.clear();
+  unplannable_holders_.clear();
+}
+
+void StaticMemoryPlanner::RecordOp(const OperatorBase& op,
+                                   const Scope& scope) {
+  if (planned_) {
+    return;
+  }
+  bool is_feed = op.Type() == "feed";
+  bool is_fetch = op.Type() == "fetch";
+  // Record the inputs first, so a tensor updated in place is not taken as
+  // written by the op.
+  for (auto& input : op.Inputs()) {
+    for (auto& name : input.second) {
+      RecordVar(name, scope, true, is_feed, is_fetch);
+    }
+  }
+  for (auto& output : op.Outputs()) {
+    for (auto& name : output.second) {
+      RecordVar(name, scope, false, is_feed, is_fetch);
+    }
+  }
+  ++op_idx_;
+}
+
+void StaticMemoryPlanner::RecordVar(const std::string& name,
+                                    const Scope& scope, bool is_input,
+                                    bool is_feed, bool is_fetch) {
+  if (name == kEmptyVarName) {
+    return;
+  }
+  auto* var = scope.FindLocalVar(name);
+  if (var == nullptr) {
+    // The parameters are in the parent scope, the memory shared with them
+    // can't be planned.
+    var = scope.FindVar(name);
+    if (var != nullptr && var->IsType<LoDTensor>() &&
+        var->Get<LoDTensor>().IsInitialized()) {
+      unplannable_holders_.insert(var->Get<LoDTensor>().Holder().get());
+    }
+    return;
+  }
+  if (!var->IsType<LoDTensor>()) {
+    return;
+  }
+
+  auto& holder = var->Get<LoDTensor>().Holder();
+  auto it = records_.find(name);
+  if (it == records_.end()) {
+    // The tensor read before written is an input of the run.
+    VarRecord record{var, holder, op_idx_, op_idx_, !is_input, false};
+    it = records_.emplace(name, record).first;
+  } else {
+    auto& record = it->second;
+    record.last_use = op_idx_;
+    if (is_input && op_idx_ > record.first_use) {
+      record.read_after_write = true;
+    }
+    if (record.holder == nullptr) {
+      record.holder = holder;
+    } else if (holder != record.holder) {
+      record.plannable = false;
+    }
+  }
+  if (is_feed || is_fetch) {
+    it->second.plannable = false;
+  }
+}
+
+void StaticMemoryPlanner::EndRun() {
+  if (!planned_) {
+    Plan();
+    return;
+  }
+  for (auto& binding : bindings_) {
+    if (binding.first->Get<LoDTensor>().Holder() != binding.second) {
+      VLOG(3) << "A tensor outgrows the static memory plan, plan it again";
+      DropPlan();
+      return;
+    }
+  }
+}
+
+void StaticMemoryPlanner::Plan() {
+  // The tensors sharing the memory are planned together.
+  std::unordered_map<memory::Allocation*, size_t> group_of_holder;
+  std::vector<std::vector<VarRecord*>> groups;
+  for (auto& item : records_) {
+    auto& record = item.second;
+    if (record.holder == nullptr) {
+      continue;
+    }
+    auto it = group_of_holder.find(record.holder.get());
+    if (it == group_of_holder.end()) {
+      it = group_of_holder.emplace(record.holder.get(), groups.size()).first;
+      groups.emplace_back();
+    }
+    groups[it->second].push_back(&record);
+  }
+
+  std::vector<MemoryPlanBuffer> buffers;
+  std::vector<size_t> buffer_groups;
+  for (size_t i = 0; i < groups.size(); ++i) {
+    auto& group = groups[i];
+    auto& holder = group.front()->holder;
+    // The memory is held by the tensors and the records only.
+    bool plannable =
+        holder->size() > 0 && unplannable_holders_.count(holder.get()) == 0 &&
+        holder.use_count() <= static_cast<long>(2 * group.size());  // NOLINT
+    MemoryPlanBuffer buffer{holder->size(), std::numeric_limits<int>::max(),
+                            -1, 0};
+    for (auto* record : group) {
+      // The tensor not read after written is an output of the run.
+      plannable = plannable && record->plannable &&
+                  record->read_after_write &&
+                  record->var->Get<LoDTensor>().Holder() == holder;
+      buffer.first_use = std::min(buffer.first_use, record->first_use);
+      buffer.last_use = std::max(buffer.last_use, record->last_use);
+    }
+    if (plannable) {
+      buffers.push_back(buffer);
+      buffer_groups.push_back(i);
+    }
+  }
+
+  planned_ = true;
+  if (!buffers.empty()) {
+    size_t alignment = platform::is_gpu_place(place_) ? 256 : 64;
+    arena_size_ = PlanMemoryOffsets(&buffers, alignment);
+    arena_ = memory::AllocShared(place_, arena_size_);
+    auto* base = static_cast<char*>(arena_->ptr());
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      auto piece = std::make_shared<ArenaPieceAllocation>(
+          base + buffers[i].offset, buffers[i].size, place_, arena_);
+      for (auto* record : groups[buffer_groups[i]]) {
+        bindings_.emplace_back(record->var, piece);
+      }
+      planned_size_ += buffers[i].size;
+    }
+  }
+  VLOG(3) << "Plan " << bindings_.size() << " tensors in an arena of "
+          << arena_size_ << " bytes, which take " << planned_size_
+          << " bytes if allocated one by one";
+  records_.clear();
+  unplannable_holders_.clear();
+  // Release the memory allocated in the recorded run.
+  Bind();
+}
+
+void StaticMemoryPlanner::Bind() {
+  for (auto& binding : bindings_) {
+    auto* tensor = binding.first->GetMutable<LoDTensor>();
+    if (tensor->Holder() != binding.second) {
+      tensor->ResetHolderWithType(binding.second, tensor->type());
+    }
+  }
+}
+
+void StaticMemoryPlanner::DropPlan() {
+  for (auto& binding : bindings_) {
+    auto* tensor = binding.first->GetMutable<LoDTensor>();
+    if (tensor->Holder() == binding.second) {
+      tensor->clear();
+    }
+  }
+  bindings_.clear();
+  arena_.reset();
+  arena_size_ = 0;
+  planned_size_ = 0;
+  planned_ = false;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,106 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace framework {
+
+// A buffer used by the ops from first_use to last_use, both inclusive.
+struct MemoryPlanBuffer {
+  size_t size;
+  int first_use;
+  int last_use;
+  size_t offset;
+};
+
+// Assign the offsets of the buffers in an arena, so that the buffers alive at
+// the same time don't overlap. The buffers are placed from the largest one,
+// each into the smallest gap fitting it. Return the size of the arena.
+size_t PlanMemoryOffsets(std::vector<MemoryPlanBuffer>* buffers,
+                         size_t alignment);
+
+/*
+ * Lay out the temporary tensors of a NaiveExecutor in one arena.
+ *
+ * The first run records the memory of the tensors read and written by every
+ * op. The tensors sharing the same memory are planned as one buffer, alive
+ * from the first op to the last op using it, and the buffers are placed in
+ * the arena by PlanMemoryOffsets. Before the later runs the tensors are bound
+ * to their places in the arena, so the ops reuse the memory instead of
+ * allocating it. If a tensor outgrows its place, e.g. for a larger input
+ * shape, the op allocates the memory as usual, and the next run records and
+ * plans again.
+ *
+ * The tensors used out of the run are not planned: the parameters, the
+ * inputs, the outputs, the tensors fed or fetched, and the ones whose memory
+ * is held by others.
+ */
+class StaticMemoryPlanner {
+ public:
+  explicit StaticMemoryPlanner(const platform::Place& place) : place_(place) {}
+
+  void BeginRun();
+  void RecordOp(const OperatorBase& op, const Scope& scope);
+  void EndRun();
+
+  bool planned() const { return planned_; }
+  // The bytes of the arena.
+  size_t arena_size() const { return arena_size_; }
+  // The bytes of the planned tensors if they were allocated one by one.
+  size_t planned_size() const { return planned_size_; }
+
+ private:
+  struct VarRecord {
+    Variable* var;
+    std::shared_ptr<memory::Allocation> holder;
+    int first_use;
+    int last_use;
+    bool plannable;
+    bool read_after_write;
+  };
+
+  void RecordVar(const std::string& name, const Scope& scope, bool is_input,
+                 bool is_feed, bool is_fetch);
+  void Plan();
+  void Bind();
+  void DropPlan();
+
+  const platform::Place place_;
+
+  // The records of the run without the plan.
+  int op_idx_{0};
+  std::unordered_map<std::string, VarRecord> records_;
+  std::unordered_set<memory::Allocation*> unplannable_holders_;
+
+  bool planned_{false};
+  std::shared_ptr<memory::Allocation> arena_;
+  std::vector<std::pair<Variable*, std::shared_ptr<memory::Allocation>>>
+      bindings_;
+  size_t arena_size_{0};
+  size_t planned_size_{0};
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,82 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/static_memory_planner.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+static bool Overlap(const MemoryPlanBuffer& a, const MemoryPlanBuffer& b) {
+  bool alive = a.first_use <= b.last_use && b.first_use <= a.last_use;
+  bool placed = a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+  return alive && placed;
+}
+
+TEST(PlanMemoryOffsets, Chain) {
+  // a -> b -> c -> d, every buffer is alive with the next one only.
+  std::vector<MemoryPlanBuffer> buffers = {
+      {100, 0, 1, 0}, {200, 1, 2, 0}, {100, 2, 3, 0}, {50, 3, 4, 0}};
+  size_t arena_size = PlanMemoryOffsets(&buffers, 64);
+  // b is at 0, a and c share the memory after b, d reuses the memory of b.
+  EXPECT_EQ(buffers[1].offset, 0UL);
+  EXPECT_EQ(buffers[0].offset, 256UL);
+  EXPECT_EQ(buffers[2].offset, 256UL);
+  EXPECT_EQ(buffers[3].offset, 0UL);
+  EXPECT_EQ(arena_size, 384UL);
+}
+
+TEST(PlanMemoryOffsets, BestFit) {
+  std::vector<MemoryPlanBuffer> buffers = {{512, 0, 0, 0}, {256, 0, 2, 0},
+                                           {128, 0, 0, 0}, {128, 0, 2, 0},
+                                           {128, 1, 1, 0}};
+  size_t arena_size = PlanMemoryOffsets(&buffers, 64);
+  EXPECT_EQ(buffers[0].offset, 0UL);
+  EXPECT_EQ(buffers[1].offset, 512UL);
+  EXPECT_EQ(buffers[2].offset, 768UL);
+  EXPECT_EQ(buffers[3].offset, 896UL);
+  // At op 1 the gaps are 0-512 and 768-896, the last buffer is placed into
+  // the smaller one.
+  EXPECT_EQ(buffers[4].offset, 768UL);
+  EXPECT_EQ(arena_size, 1024UL);
+}
+
+TEST(PlanMemoryOffsets, Random) {
+  std::vector<MemoryPlanBuffer> buffers;
+  unsigned seed = 1;
+  auto rand = [&seed]() {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+  };
+  size_t total_size = 0;
+  for (int i = 0; i < 200; ++i) {
+    int first_use = rand() % 100;
+    int last_use = first_use + rand() % 10;
+    size_t size = rand() % 5000 + 1;
+    buffers.push_back({size, first_use, last_use, 0});
+    total_size += size;
+  }
+  size_t arena_size = PlanMemoryOffsets(&buffers, 64);
+  EXPECT_LT(arena_size, total_size);
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    EXPECT_LE(buffers[i].offset + buffers[i].size, arena_size);
+    for (size_t j = i + 1; j < buffers.size(); ++j) {
+      ASSERT_FALSE(Overlap(buffers[i], buffers[j])) << i << " " << j;
+    }
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
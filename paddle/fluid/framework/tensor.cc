@@ -113,5 +113,14 @@ void Tensor::ResetHolder(std::shared_ptr<memory::Allocation> holder) {
   holder_ = holder;
 }
 
+void Tensor::ResetHolderWithType(std::shared_ptr<memory::Allocation> holder,
+                                 proto::VarType::Type type) {
+  holder_ = nullptr;
+  type_ = type;
+  offset_ = 0;
+  ResetHolder(std::move(holder));
+  check_memory_size();
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -168,6 +168,11 @@ class Tensor {
 
   void ResetHolder(std::shared_ptr<memory::Allocation> holder);
 
+  // Reset the holder and the data type, e.g. to use the memory not allocated
+  // by the memory module.
+  void ResetHolderWithType(std::shared_ptr<memory::Allocation> holder,
+                           proto::VarType::Type type);
+
  private:
   /*! holds the memory block if allocated. */
   std::shared_ptr<memory::Allocation> holder_;
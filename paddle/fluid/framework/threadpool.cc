@@ -21,11 +21,19 @@
 
 DEFINE_int32(io_threadpool_size, 100,
              "number of threads used for doing IO, default 100");
+DEFINE_bool(enable_work_stealing_threadpool, false,
+            "give every thread of ThreadPool its own task queue and let idle "
+            "threads steal tasks, instead of sharing one locked queue");
 
 DECLARE_int32(dist_threadpool_size);
 
 namespace paddle {
 namespace framework {
+
+// the pool and the index of the current thread, if it belongs to a pool
+static thread_local ThreadPool* g_current_pool = nullptr;
+static thread_local size_t g_current_index = 0;
+
 std::unique_ptr<ThreadPool> ThreadPool::threadpool_(nullptr);
 std::once_flag ThreadPool::init_flag_;
 
@@ -47,11 +55,17 @@ void ThreadPool::Init() {
   }
 }
 
-ThreadPool::ThreadPool(int num_threads) : running_(true) {
+ThreadPool::ThreadPool(int num_threads)
+    : next_queue_(0), pending_(0), sleeping_(0), running_(true) {
+  size_t queue_num = FLAGS_enable_work_stealing_threadpool ? num_threads : 1;
+  for (size_t i = 0; i < queue_num; ++i) {
+    queues_.emplace_back(new TaskQueue);
+  }
   threads_.resize(num_threads);
-  for (auto& thread : threads_) {
+  for (size_t i = 0; i < threads_.size(); ++i) {
     // TODO(Yancey1989): binding the thread on the specify CPU number
-    thread.reset(new std::thread(std::bind(&ThreadPool::TaskLoop, this)));
+    threads_[i].reset(
+        new std::thread(std::bind(&ThreadPool::TaskLoop, this, i)));
   }
 }
 
@@ -69,29 +83,85 @@ ThreadPool::~ThreadPool() {
   }
 }
 
-void ThreadPool::TaskLoop() {
-  while (true) {
-    Task task;
-
-    {
-      std::unique_lock<std::mutex> lock(mutex_);
-      scheduled_.wait(
-          lock, [this] { return !this->tasks_.empty() || !this->running_; });
+void ThreadPool::Schedule(Task task) {
+  size_t index = 0;
+  if (queues_.size() > 1) {
+    index = g_current_pool == this ? g_current_index
+                                   : next_queue_++ % queues_.size();
+  }
+  TaskQueue* queue = queues_[index].get();
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (!running_) {
+      PADDLE_THROW("enqueue on stopped ThreadPool");
+    }
+    queue->tasks.push_back(std::move(task));
+    ++pending_;
+  }
+  // pairs with TaskLoop, which counts itself as sleeping before checking
+  // pending_
+  if (sleeping_ != 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    scheduled_.notify_one();
+  }
+}
 
-      if (!running_ && tasks_.empty()) {
-        return;
-      }
+bool ThreadPool::PopTask(size_t index, Task* task) {
+  if (queues_.size() == 1) {
+    TaskQueue* queue = queues_[0].get();
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->tasks.empty()) {
+      return false;
+    }
+    *task = std::move(queue->tasks.front());
+    queue->tasks.pop_front();
+    --pending_;
+    return true;
+  }
+  {
+    // the newest task of its own queue is the most likely to be cache hot
+    TaskQueue* queue = queues_[index].get();
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (!queue->tasks.empty()) {
+      *task = std::move(queue->tasks.back());
+      queue->tasks.pop_back();
+      --pending_;
+      return true;
+    }
+  }
+  for (size_t i = 1; i < queues_.size(); ++i) {
+    TaskQueue* queue = queues_[(index + i) % queues_.size()].get();
+    std::unique_lock<std::mutex> lock(queue->mutex, std::try_to_lock);
+    if (!lock.owns_lock() || queue->tasks.empty()) {
+      continue;
+    }
+    *task = std::move(queue->tasks.front());
+    queue->tasks.pop_front();
+    --pending_;
+    return true;
+  }
+  return false;
+}
 
-      if (tasks_.empty()) {
-        PADDLE_THROW("This thread has no task to Run");
-      }
+void ThreadPool::TaskLoop(size_t index) {
+  g_current_pool = this;
+  g_current_index = index;
+  while (true) {
+    Task task;
+    if (PopTask(index, &task)) {
+      // run the task
+      task();
+      continue;
+    }
 
-      // pop a task from the task queue
-      task = std::move(tasks_.front());
-      tasks_.pop();
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++sleeping_;
+    scheduled_.wait(lock,
+                    [this] { return this->pending_ > 0 || !this->running_; });
+    --sleeping_;
+    if (!running_ && pending_ == 0) {
+      return;
     }
-    // run the task
-    task();
   }
 }
 
@@ -14,12 +14,13 @@ limitations under the License. */
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>  // NOLINT
+#include <deque>
 #include <functional>
 #include <future>  // NOLINT
 #include <memory>
 #include <mutex>  // NOLINT
-#include <queue>
 #include <thread>  // NOLINT
 #include <utility>
 #include <vector>
@@ -48,6 +49,14 @@ struct ExceptionHandler {
 
 // ThreadPool maintains a queue of tasks, and runs them using a fixed
 // number of threads.
+//
+// With FLAGS_enable_work_stealing_threadpool, which is off by default as it
+// changes the order of the tasks, every thread owns a task deque instead of
+// sharing one queue. A task scheduled by a thread of the pool is
+// pushed to the deque of that thread, other tasks are spread over the
+// deques round-robin. A thread runs the newest task of its own deque first,
+// and steals the oldest task of the other deques when its own is empty, so
+// small tasks spawned by running tasks rarely touch a shared lock.
 class ThreadPool {
  public:
   explicit ThreadPool(int num_threads);
@@ -85,23 +94,27 @@ class ThreadPool {
       return nullptr;
     });
     std::future<std::unique_ptr<platform::EnforceNotMet>> f = task.get_future();
-    {
-      std::unique_lock<std::mutex> lock(mutex_);
-      if (!running_) {
-        PADDLE_THROW("enqueue on stopped ThreadPool");
-      }
-      tasks_.push(std::move(task));
-    }
-    scheduled_.notify_one();
+    Schedule(std::move(task));
     return f;
   }
 
  private:
   DISABLE_COPY_AND_ASSIGN(ThreadPool);
 
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  // Push task to a queue and wake up a sleeping thread if there is one.
+  void Schedule(Task task);
+
+  // Take a task for the index-th thread, from its own queue or by stealing.
+  bool PopTask(size_t index, Task* task);
+
   // The constructor starts threads to run TaskLoop, which retrieves
-  // and runs tasks from the queue.
-  void TaskLoop();
+  // and runs tasks from the queues.
+  void TaskLoop(size_t index);
 
   // Init is called by GetInstance.
   static void Init();
@@ -112,9 +125,15 @@ class ThreadPool {
 
   std::vector<std::unique_ptr<std::thread>> threads_;
 
-  std::queue<Task> tasks_;
+  // one queue per thread with work stealing, otherwise one shared queue
+  std::vector<std::unique_ptr<TaskQueue>> queues_;
+  std::atomic<size_t> next_queue_;
+  // the number of tasks in the queues, only changed with a queue locked
+  std::atomic<int64_t> pending_;
+  // the number of threads waiting on scheduled_
+  std::atomic<int> sleeping_;
   std::mutex mutex_;
-  bool running_;
+  std::atomic<bool> running_;
   std::condition_variable scheduled_;
 };
 
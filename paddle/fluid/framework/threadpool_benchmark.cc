@@ -0,0 +1,131 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Measure the scheduling overhead of ThreadPool with the shared queue and
+// with work stealing, on tens of thousands of tiny tasks:
+//   external: all the tasks are scheduled by one thread outside the pool,
+//             like Async() called by the executor.
+//   spawned:  every task schedules its successors from inside the pool,
+//             like the ready ops in FastThreadedSSAGraphExecutor.
+// Usage:
+//   threadpool_benchmark --threads=32 --tasks=100000
+
+#include <atomic>
+#include <future>  // NOLINT
+#include <string>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/threadpool.h"
+#include "paddle/fluid/platform/timer.h"
+
+DECLARE_bool(enable_work_stealing_threadpool);
+
+DEFINE_int32(threads, 16, "The number of threads of the pool.");
+DEFINE_int32(tasks, 100000, "The number of tasks of each round.");
+DEFINE_int32(fanout, 4, "The number of tasks each spawned task schedules.");
+DEFINE_int32(work, 100, "The number of loop iterations in each task.");
+DEFINE_int32(repeat, 5, "Repeat times of each round.");
+
+namespace paddle {
+namespace framework {
+
+static void TinyWork() {
+  volatile int x = 0;
+  for (int i = 0; i < FLAGS_work; ++i) {
+    x = x + i;
+  }
+}
+
+static double RunExternal(ThreadPool* pool) {
+  std::atomic<int> remaining(FLAGS_tasks);
+  std::promise<void> done;
+  platform::Timer timer;
+  timer.Start();
+  for (int i = 0; i < FLAGS_tasks; ++i) {
+    pool->RunAndGetException([&] {
+      TinyWork();
+      if (--remaining == 0) {
+        done.set_value();
+      }
+    });
+  }
+  done.get_future().wait();
+  timer.Pause();
+  return timer.ElapsedMS();
+}
+
+struct SpawnContext {
+  ThreadPool* pool;
+  std::atomic<int> scheduled;
+  std::atomic<int> remaining;
+  std::promise<void> done;
+};
+
+static void SpawnTask(SpawnContext* ctx) {
+  TinyWork();
+  for (int i = 0; i < FLAGS_fanout; ++i) {
+    if (ctx->scheduled.fetch_add(1) >= FLAGS_tasks) {
+      break;
+    }
+    ctx->pool->RunAndGetException([ctx] { SpawnTask(ctx); });
+  }
+  if (--ctx->remaining == 0) {
+    ctx->done.set_value();
+  }
+}
+
+static double RunSpawned(ThreadPool* pool) {
+  SpawnContext ctx;
+  ctx.pool = pool;
+  ctx.scheduled = 1;
+  ctx.remaining = FLAGS_tasks;
+  platform::Timer timer;
+  timer.Start();
+  pool->RunAndGetException([&ctx] { SpawnTask(&ctx); });
+  ctx.done.get_future().wait();
+  timer.Pause();
+  return timer.ElapsedMS();
+}
+
+static void RunBenchmark() {
+  for (bool work_stealing : {false, true}) {
+    FLAGS_enable_work_stealing_threadpool = work_stealing;
+    double external_ms = 0;
+    double spawned_ms = 0;
+    {
+      ThreadPool pool(FLAGS_threads);
+      for (int i = 0; i < FLAGS_repeat; ++i) {
+        external_ms += RunExternal(&pool);
+        spawned_ms += RunSpawned(&pool);
+      }
+    }
+    double tasks = static_cast<double>(FLAGS_tasks) * FLAGS_repeat;
+    LOG(INFO) << (work_stealing ? "work stealing" : "shared queue") << ": "
+              << FLAGS_tasks << " tasks, external "
+              << external_ms / FLAGS_repeat << " ms ("
+              << external_ms * 1e6 / tasks << " ns/task), spawned "
+              << spawned_ms / FLAGS_repeat << " ms ("
+              << spawned_ms * 1e6 / tasks << " ns/task)";
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::RunBenchmark();
+  return 0;
+}
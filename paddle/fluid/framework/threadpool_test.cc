@@ -15,8 +15,11 @@ limitations under the License. */
 #include <gtest/gtest.h>
 #include <atomic>
 
+#include "gflags/gflags.h"
 #include "paddle/fluid/framework/threadpool.h"
 
+DECLARE_bool(enable_work_stealing_threadpool);
+
 namespace framework = paddle::framework;
 
 void do_sum(std::vector<std::future<void>>* fs, std::mutex* mu,
@@ -59,3 +62,45 @@ TEST(ThreadPool, ConcurrentRun) {
   }
   EXPECT_EQ(sum, ((n + 1) * n) / 2);
 }
+
+// every task spawns two children from a pool thread until depth is 0
+static void Spawn(framework::ThreadPool* pool, int depth,
+                  std::atomic<int>* count) {
+  count->fetch_add(1);
+  if (depth == 0) {
+    return;
+  }
+  auto left = pool->Run([=] { Spawn(pool, depth - 1, count); });
+  auto right = pool->Run([=] { Spawn(pool, depth - 1, count); });
+  // the children are in the queue of this thread, and other threads steal
+  // them while this one is blocked
+  left.wait();
+  right.wait();
+}
+
+TEST(ThreadPool, NestedRun) {
+  for (bool work_stealing : {false, true}) {
+    FLAGS_enable_work_stealing_threadpool = work_stealing;
+    std::atomic<int> count(0);
+    {
+      // depth 3 blocks at most 1 + 2 + 4 threads, leaving one for the leaves
+      framework::ThreadPool pool(8);
+      pool.Run([&] { Spawn(&pool, 3, &count); }).wait();
+    }
+    EXPECT_EQ(count, 15);
+  }
+}
+
+TEST(ThreadPool, RunTasksBeforeDestruction) {
+  for (bool work_stealing : {false, true}) {
+    FLAGS_enable_work_stealing_threadpool = work_stealing;
+    std::atomic<int> sum(0);
+    {
+      framework::ThreadPool pool(4);
+      for (int i = 0; i < 1000; ++i) {
+        pool.Run([&sum] { sum.fetch_add(1); });
+      }
+    }
+    EXPECT_EQ(sum, 1000);
+  }
+}
@@ -17,6 +17,8 @@
 //
 #pragma once
 
+#include <cstddef>
+
 namespace paddle {
 namespace imperative {
 namespace detail {
@@ -26,6 +28,9 @@ struct BackwardStrategy {
    * gradient, another is sum gradient once they are created */
   // TODO(jiabin): add more Strategy when we support
   bool sorted_sum_gradient_{false};
+  /* The number of threads to run the independent grad ops concurrently, the
+   * grad ops run one by one in the calling thread if it is 1 */
+  size_t num_threads_{1};
 };
 
 }  // namespace detail
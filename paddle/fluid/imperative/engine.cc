@@ -15,7 +15,10 @@
 #include "paddle/fluid/imperative/engine.h"
 
 #include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <exception>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
@@ -105,6 +108,9 @@ void BasicEngine::SetBackwardOutputs(paddle::imperative::OpBase* op) {
   for (auto& pair : op->GetOutsMap()) {
     for (auto& var : pair.second) {
       if (var) {
+        // Clear the grad ops here instead of in Execute, which may run the
+        // grad ops generating the same var concurrently
+        var->ClearGradOps();
         // Set Backward outputs's generate_grad as true
         var->SetGradGenerated(true);
         VLOG(6) << "Set backward output: " << var->Name()
@@ -177,8 +183,74 @@ void BasicEngine::SumGradient(OpBase* op, std::shared_ptr<VarBase> src,
                     "Cannot find gradient of variable %s", dst->Name());
   iter->second->Add(std::move(src), op->id());
 }
+
+void BasicEngine::RunGradOp(OpBase* op) {
+  // Step 1: Run Backward
+  auto& bwd_ins = op->GetInsMap();
+  auto& bwd_outs = op->GetOutsMap();
+
+  NameVarBaseMap tmp_outs;
+  // A var may be coresponding to several grad var in one op
+  std::unordered_map<VarBase*, std::vector<std::shared_ptr<VarBase>>> var_map;
+  size_t counter = 0;
+  for (auto& bwd_out : bwd_outs) {
+    auto& tmp_var_list = tmp_outs[bwd_out.first];
+    tmp_var_list.reserve(bwd_out.second.size());
+    for (auto& var : bwd_out.second) {
+      auto tmp_var = std::make_shared<VarBase>(
+          false, "Gtmp@" + std::to_string(counter++));  // Do not need grad
+      tmp_var_list.emplace_back(tmp_var);
+      if (var) {
+        var_map[var.get()].emplace_back(std::move(tmp_var));
+      }
+    }
+  }
+
+  VLOG(3) << "Start to execute grad op " << op->Type();
+  RunOp(op, bwd_ins, tmp_outs, op->place());
+  // Step 2: Sum Gradient
+  {
+    platform::RecordEvent record_event("merge_grads");
+    for (auto& var_pair : var_map) {
+      auto* dst_var = var_pair.first;
+      if (dst_var == nullptr) continue;
+      for (auto& src_var : var_pair.second) {
+        VLOG(3) << "Sum gradient of variable " << dst_var->Name()
+                << " after op " << op->Type();
+        SumGradient(op, std::move(src_var), dst_var);
+      }
+    }
+  }
+}
+
+bool BasicEngine::CanRunParallel() const {
+  if (backward_strategy_.num_threads_ <= 1) {
+    return false;
+  }
+  // The device contexts of GPU, e.g. the cuBLAS handles, are not safe to be
+  // used by several threads
+  for (auto& op_dep : op_deps_) {
+    if (!platform::is_cpu_place(op_dep.first->place())) {
+      return false;
+    }
+  }
+  for (auto* init_op : init_ops_) {
+    if (!platform::is_cpu_place(init_op->place())) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void BasicEngine::Execute() {
   PrepareDeps();
+  if (CanRunParallel()) {
+    ExecuteParallel();
+    VLOG(3) << "Clean properties of BasicEngine";
+    CleanEngine();
+    return;
+  }
+
   // Start execute Computation graph
   std::queue<OpBase*> q;
   for (const auto& init_op : init_ops_) {
@@ -188,43 +260,8 @@ void BasicEngine::Execute() {
     OpBase* cur_op = q.front();
     q.pop();
 
-    // Step 1: Run Backward
-    auto& bwd_ins = cur_op->GetInsMap();
-    auto& bwd_outs = cur_op->GetOutsMap();
-
-    NameVarBaseMap tmp_outs;
-    // A var may be coresponding to several grad var in one op
-    std::unordered_map<VarBase*, std::vector<std::shared_ptr<VarBase>>> var_map;
-    size_t counter = 0;
-    for (auto& bwd_out : bwd_outs) {
-      auto& tmp_var_list = tmp_outs[bwd_out.first];
-      tmp_var_list.reserve(bwd_out.second.size());
-      for (auto& var : bwd_out.second) {
-        auto tmp_var = std::make_shared<VarBase>(
-            false, "Gtmp@" + std::to_string(counter++));  // Do not need grad
-        tmp_var_list.emplace_back(tmp_var);
-        if (var) {
-          var_map[var.get()].emplace_back(std::move(tmp_var));
-          var->ClearGradOps();
-        }
-      }
-    }
-
-    VLOG(3) << "Start to execute grad op " << cur_op->Type();
-    RunOp(cur_op, bwd_ins, tmp_outs, cur_op->place());
-    // Step 2: Sum Gradient
-    {
-      platform::RecordEvent record_event("merge_grads");
-      for (auto& var_pair : var_map) {
-        auto* dst_var = var_pair.first;
-        if (dst_var == nullptr) continue;
-        for (auto& src_var : var_pair.second) {
-          VLOG(3) << "Sum gradient of variable " << dst_var->Name()
-                  << " after op " << cur_op->Type();
-          SumGradient(cur_op, std::move(src_var), dst_var);
-        }
-      }
-    }
+    // Step 1 & 2: Run Backward and Sum Gradient
+    RunGradOp(cur_op);
 
     // Step 3: Collect ready ops
     for (auto* grad_pending_op : cur_op->GradPendingOps()) {
@@ -251,5 +288,71 @@ void BasicEngine::Execute() {
   VLOG(3) << "Clean properties of BasicEngine";
   CleanEngine();
 }
+
+void BasicEngine::ExecuteParallel() {
+  size_t num_threads = backward_strategy_.num_threads_;
+  if (pool_ == nullptr || pool_size_ != num_threads) {
+    pool_.reset(new ::ThreadPool(num_threads));
+    pool_size_ = num_threads;
+  }
+  VLOG(3) << "Run the grad ops by " << num_threads << " threads";
+
+  // The ready ops are scheduled by this thread, and op_deps_ is guarded by
+  // mutex.
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::queue<OpBase*> ready_ops;
+  size_t running_ops = 0;
+  std::exception_ptr error;
+  for (const auto& init_op : init_ops_) {
+    ready_ops.push(init_op);
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    while (!ready_ops.empty() && !error) {
+      OpBase* op = ready_ops.front();
+      ready_ops.pop();
+      ++running_ops;
+      pool_->enqueue([&, op] {
+        std::exception_ptr op_error;
+        std::vector<OpBase*> grad_pending_ops;
+        try {
+          RunGradOp(op);
+          grad_pending_ops = op->GradPendingOps();
+          VLOG(3) << "Remove op after op " << op->Type() << " runs";
+          RemoveOp(op);
+        } catch (...) {
+          op_error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> guard(mutex);
+        if (op_error) {
+          if (!error) error = op_error;
+        } else {
+          for (auto* grad_pending_op : grad_pending_ops) {
+            auto iter = op_deps_.find(grad_pending_op);
+            if (iter != op_deps_.end() && --(iter->second) == 0) {
+              ready_ops.push(grad_pending_op);
+            }
+          }
+        }
+        --running_ops;
+        // Notify in the lock, since the locals are gone once the scheduler
+        // sees no running op.
+        cv.notify_one();
+      });
+    }
+    if (running_ops == 0) {
+      break;
+    }
+    cv.wait(lock);
+  }
+  lock.unlock();
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
 }  // namespace imperative
 }  // namespace paddle
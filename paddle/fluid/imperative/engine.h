@@ -17,10 +17,12 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
+#include "ThreadPool.h"
 #include "paddle/fluid/imperative/backward_strategy.h"
 #include "paddle/fluid/imperative/gradient_accumulator.h"
 #include "paddle/fluid/imperative/layer.h"
@@ -40,11 +42,18 @@ class Engine {
   virtual void RunOp(imperative::OpBase* op, const NameVarBaseMap& ins,
                      const NameVarBaseMap& outs, const platform::Place& place);
 
+  // It is thread-safe, and the op is destructed out of the lock.
   virtual void RemoveOp(OpBase* op) {
     PADDLE_ENFORCE_NOT_NULL(op, "Cannot remove null op");
-    auto iter = grad_ops_.find(op);
-    PADDLE_ENFORCE_EQ(iter != grad_ops_.end(), true, "Op is not inside tracer");
-    grad_ops_.erase(iter);
+    std::shared_ptr<OpBase> removed_op;
+    {
+      std::lock_guard<std::mutex> guard(grad_ops_mutex_);
+      auto iter = grad_ops_.find(op);
+      PADDLE_ENFORCE_EQ(iter != grad_ops_.end(), true,
+                        "Op is not inside tracer");
+      removed_op = std::move(iter->second);
+      grad_ops_.erase(iter);
+    }
   }
 
   void InsertOp(OpBase* op, std::shared_ptr<OpBase> op_shared) {
@@ -64,6 +73,7 @@ class Engine {
   std::unordered_map<OpBase*, std::shared_ptr<OpBase>>
       grad_ops_;  // opBase for remove - grad_op
   std::unordered_set<VarBase*> grad_vars_;
+  std::mutex grad_ops_mutex_;
 };
 
 class BasicEngine : public Engine {
@@ -87,6 +97,15 @@ class BasicEngine : public Engine {
 
   void SumGradient(OpBase* op, std::shared_ptr<VarBase> src, VarBase* dst);
 
+  void RunGradOp(OpBase* op);
+
+  // Whether the grad ops can run concurrently, i.e. num_threads_ of the
+  // strategy is larger than 1 and all the grad ops are on CPU.
+  bool CanRunParallel() const;
+
+  // Run every grad op on pool_ once the grad ops it depends on finish.
+  void ExecuteParallel();
+
   // TODO(jiabin): maybe we can optimize the performance of engine by cache the
   // result
   void CleanEngine() {
@@ -101,6 +120,8 @@ class BasicEngine : public Engine {
   std::unordered_map<OpBase*, size_t> op_deps_;
   std::unordered_map<VarBase*, std::unique_ptr<GradientAccumulator>>
       accumulators_;
+  std::unique_ptr<::ThreadPool> pool_;
+  size_t pool_size_{0};
 };
 
 }  // namespace imperative
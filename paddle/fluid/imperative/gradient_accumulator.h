@@ -15,6 +15,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>  // NOLINT
 #include <utility>
 #include <vector>
 #include "paddle/fluid/imperative/layer.h"
@@ -26,6 +27,8 @@ class GradientAccumulator {
  public:
   explicit GradientAccumulator(VarBase* var) : var_(var) {}
 
+  // It is thread-safe, since the grad ops generating the same var may run
+  // concurrently.
   virtual void Add(std::shared_ptr<VarBase> var, size_t trace_id) = 0;
 
   virtual ~GradientAccumulator() = default;
@@ -37,6 +40,7 @@ class GradientAccumulator {
  protected:
   VarBase* var_;
   size_t ref_cnt_{0};
+  std::mutex mutex_;
 };
 
 class EagerGradientAccumulator : public GradientAccumulator {
@@ -187,6 +187,18 @@ std::unique_ptr<framework::ProgramDesc> ProgramDescTracer::CreateProgramDesc()
   return prog;
 }
 
+std::vector<std::shared_ptr<VarBase>> ProgramDescTracer::GetPersistableVars()
+    const {
+  std::vector<std::shared_ptr<VarBase>> persistable_vars;
+  for (auto &pair : vars_) {
+    auto var = pair.first.lock();
+    if (var && var->Persistable()) {
+      persistable_vars.emplace_back(std::move(var));
+    }
+  }
+  return persistable_vars;
+}
+
 void ProgramDescTracer::InsertVarIfNotExist(
     const std::shared_ptr<VarBase> &new_var) {
   PADDLE_ENFORCE_NOT_NULL(new_var);
@@ -49,6 +49,9 @@ class ProgramDescTracer {
 
   std::unique_ptr<framework::ProgramDesc> CreateProgramDesc() const;
 
+  // The alive persistable vars used by the traced ops, e.g. the parameters.
+  std::vector<std::shared_ptr<VarBase>> GetPersistableVars() const;
+
   void Reset();
 
  private:
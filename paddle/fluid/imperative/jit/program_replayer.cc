@@ -0,0 +1,176 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/imperative/jit/program_replayer.h"
+#include <unordered_set>
+#include <utility>
+#include "paddle/fluid/framework/ir/graph.h"
+#include "paddle/fluid/framework/ir/pass.h"
+
+namespace paddle {
+namespace imperative {
+namespace jit {
+
+ProgramReplayer::ProgramReplayer(
+    const framework::ProgramDesc &program,
+    const std::vector<std::shared_ptr<VarBase>> &feed_vars,
+    const std::vector<std::string> &feed_names,
+    const std::vector<std::string> &fetch_names,
+    const std::vector<std::shared_ptr<VarBase>> &persistable_vars,
+    const std::vector<std::string> &passes, const platform::Place &place)
+    : place_(place),
+      feed_names_(feed_names),
+      fetch_names_(fetch_names),
+      persistable_vars_(persistable_vars),
+      program_(new framework::ProgramDesc(program)),
+      executor_(place) {
+  PADDLE_ENFORCE_EQ(feed_vars.size(), feed_names.size(),
+                    "The feeded variable names number must be equal to the "
+                    "feeded variable number");
+  for (auto &var : feed_vars) {
+    PADDLE_ENFORCE_EQ(var->Var().IsType<framework::LoDTensor>(), true,
+                      "Only LoDTensor can be feeded, but %s is not",
+                      var->Name());
+    auto &tensor = var->Var().Get<framework::LoDTensor>();
+    feed_signatures_.push_back({tensor.dims(), tensor.type(), tensor.lod()});
+  }
+
+  Optimize(passes);
+
+  // The feed and fetch vars are created in scope_ instead of the local scope
+  // of a run, and not collected by the garbage collector, as the persistable
+  // vars.
+  auto *block = program_->MutableBlock(0);
+  for (auto &name : feed_names_) {
+    auto *var = block->FindVar(name);
+    if (var != nullptr) {
+      var->SetPersistable(true);
+    }
+  }
+  for (auto &name : fetch_names_) {
+    auto *var = block->FindVar(name);
+    PADDLE_ENFORCE_NOT_NULL(var, "Cannot find the fetched variable %s", name);
+    var->SetPersistable(true);
+  }
+  program_->Flush();
+
+  ctx_ = executor_.Prepare(*program_, 0);
+}
+
+void ProgramReplayer::Optimize(const std::vector<std::string> &passes) {
+  if (passes.empty()) {
+    return;
+  }
+  std::unique_ptr<framework::ir::Graph> graph(
+      new framework::ir::Graph(*program_));
+  for (auto &name : passes) {
+    VLOG(3) << "Apply " << name << " to the traced program";
+    auto pass = framework::ir::PassRegistry::Instance().Get(name);
+    graph.reset(pass->Apply(graph.release()));
+  }
+
+  std::unique_ptr<framework::ProgramDesc> optimized(
+      new framework::ProgramDesc());
+  optimized->CopyFrom(*program_->Proto());
+  auto to_program =
+      framework::ir::PassRegistry::Instance().Get("graph_to_program_pass");
+  to_program->SetNotOwned("program", optimized.get());
+  to_program->Apply(graph.get());
+
+  std::unordered_set<std::string> outputs;
+  for (auto *op : optimized->Block(0).AllOps()) {
+    for (auto &name : op->OutputArgumentNames()) {
+      outputs.insert(name);
+    }
+  }
+  for (auto &name : fetch_names_) {
+    if (outputs.count(name) == 0) {
+      LOG(WARNING) << "The fetched variable " << name
+                   << " is removed by the passes, run the traced program "
+                      "without optimization";
+      return;
+    }
+  }
+  program_ = std::move(optimized);
+}
+
+bool ProgramReplayer::IsMatched(
+    const std::vector<std::shared_ptr<VarBase>> &inputs) const {
+  if (inputs.size() != feed_signatures_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto &var = inputs[i]->Var();
+    if (!var.IsType<framework::LoDTensor>()) {
+      return false;
+    }
+    auto &tensor = var.Get<framework::LoDTensor>();
+    auto &signature = feed_signatures_[i];
+    if (!tensor.IsInitialized() ||
+        !platform::is_same_place(tensor.place(), place_) ||
+        tensor.dims() != signature.dims || tensor.type() != signature.type ||
+        tensor.lod() != signature.lod) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ProgramReplayer::Run(
+    const std::vector<std::shared_ptr<VarBase>> &inputs,
+    const std::vector<std::shared_ptr<VarBase>> &outputs) {
+  PADDLE_ENFORCE_EQ(inputs.size(), feed_names_.size(),
+                    "The traced program has %d inputs, but got %d",
+                    feed_names_.size(), inputs.size());
+  PADDLE_ENFORCE_EQ(outputs.size(), fetch_names_.size(),
+                    "The traced program has %d outputs, but got %d",
+                    fetch_names_.size(), outputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    *scope_.Var(feed_names_[i])->GetMutable<framework::LoDTensor>() =
+        inputs[i]->Var().Get<framework::LoDTensor>();
+  }
+  // Share the persistable vars every run, in case they are assigned new
+  // memory, e.g. by set_value.
+  for (auto &var : persistable_vars_) {
+    *scope_.Var(var->Name())->GetMutable<framework::LoDTensor>() =
+        var->Var().Get<framework::LoDTensor>();
+  }
+
+  executor_.RunPreparedContext(ctx_.get(), &scope_,
+                               /*create_local_scope=*/true,
+                               /*create_vars=*/true, /*keep_kids=*/false);
+
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    auto *var = scope_.FindVar(fetch_names_[i]);
+    PADDLE_ENFORCE_NOT_NULL(var, "Cannot find the fetched variable %s",
+                            fetch_names_[i]);
+    auto &tensor = var->Get<framework::LoDTensor>();
+    *outputs[i]->MutableVar()->GetMutable<framework::LoDTensor>() = tensor;
+    outputs[i]->SetDataType(tensor.type());
+    // The next run writes new memory instead of the output.
+    var->Clear();
+  }
+  for (auto &name : feed_names_) {
+    scope_.FindVar(name)->Clear();
+  }
+}
+
+}  // namespace jit
+}  // namespace imperative
+}  // namespace paddle
+
+USE_PASS(graph_to_program_pass);
+// The default passes of jit.ReplayedLayer.
+USE_PASS(fc_fuse_pass);
+USE_PASS(fuse_elewise_add_act_pass);
@@ -0,0 +1,90 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "paddle/fluid/framework/executor.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/imperative/layer.h"
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace imperative {
+namespace jit {
+
+/*
+ * Run a program traced by ProgramDescTracer with the static graph Executor,
+ * so that the later steps with the same inputs skip the tracing of every op.
+ *
+ * The program is optimized by the IR passes once, and prepared into an
+ * ExecutorPrepareContext. Every run shares the data of the inputs and the
+ * persistable vars, e.g. the parameters, into its scope without copying, and
+ * moves the fetched vars out to the outputs, so the outputs of different runs
+ * never share memory.
+ *
+ * The ops are not traced for backward, so it is only used when no gradient is
+ * required.
+ */
+class ProgramReplayer {
+  DISABLE_COPY_AND_ASSIGN(ProgramReplayer);
+
+ public:
+  // The passes should not write the persistable vars, since they share the
+  // data with the VarBases. The passes failing to keep the fetched vars are
+  // ignored.
+  ProgramReplayer(const framework::ProgramDesc &program,
+                  const std::vector<std::shared_ptr<VarBase>> &feed_vars,
+                  const std::vector<std::string> &feed_names,
+                  const std::vector<std::string> &fetch_names,
+                  const std::vector<std::shared_ptr<VarBase>> &persistable_vars,
+                  const std::vector<std::string> &passes,
+                  const platform::Place &place);
+
+  // Whether the inputs have the same places, shapes, data types and LoDs as
+  // the feed vars traced.
+  bool IsMatched(const std::vector<std::shared_ptr<VarBase>> &inputs) const;
+
+  void Run(const std::vector<std::shared_ptr<VarBase>> &inputs,
+           const std::vector<std::shared_ptr<VarBase>> &outputs);
+
+  const framework::ProgramDesc &Program() const { return *program_; }
+
+ private:
+  struct FeedSignature {
+    framework::DDim dims;
+    framework::proto::VarType::Type type;
+    framework::LoD lod;
+  };
+
+  void Optimize(const std::vector<std::string> &passes);
+
+  platform::Place place_;
+  std::vector<std::string> feed_names_;
+  std::vector<std::string> fetch_names_;
+  std::vector<FeedSignature> feed_signatures_;
+  std::vector<std::shared_ptr<VarBase>> persistable_vars_;
+
+  std::unique_ptr<framework::ProgramDesc> program_;
+  framework::Executor executor_;
+  std::unique_ptr<framework::ExecutorPrepareContext> ctx_;
+  framework::Scope scope_;
+};
+
+}  // namespace jit
+}  // namespace imperative
+}  // namespace paddle
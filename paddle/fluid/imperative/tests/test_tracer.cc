@@ -145,6 +145,93 @@ TEST(test_tracer, test_track_backward_input) {
   mul_attr_map["use_mkldnn"] = false;
   ASSERT_ANY_THROW(tracer.TraceOp("mul", ins, outs, mul_attr_map, place, true));
 }
+// loss = (x * y0 + x * y1) + (x * y2 + x * y3), and return the grad of x.
+static std::vector<float> RunBranchedBackward(
+    const detail::BackwardStrategy& strategy) {
+  imperative::Tracer tracer;
+  platform::CPUPlace place;
+  framework::AttributeMap attrs;
+  attrs["use_mkldnn"] = false;
+
+  std::shared_ptr<imperative::VarBase> x(new imperative::VarBase(true, "x"));
+  x->SetOverridedStopGradient(false);
+  auto* x_tensor = x->MutableVar()->GetMutable<framework::LoDTensor>();
+  float* x_data = x_tensor->mutable_data<float>(framework::make_ddim({2, 5}),
+                                                place);
+  for (int i = 0; i < 10; ++i) {
+    x_data[i] = i * 0.1f;
+  }
+
+  vb_vector products;
+  for (int i = 0; i < 4; ++i) {
+    std::shared_ptr<imperative::VarBase> y(
+        new imperative::VarBase(true, "y" + std::to_string(i)));
+    y->SetOverridedStopGradient(true);
+    auto* y_tensor = y->MutableVar()->GetMutable<framework::LoDTensor>();
+    float* y_data = y_tensor->mutable_data<float>(
+        framework::make_ddim({5, 2}), place);
+    for (int j = 0; j < 10; ++j) {
+      y_data[j] = (i + 1) * 0.3f + j * 0.01f;
+    }
+    std::shared_ptr<imperative::VarBase> out(
+        new imperative::VarBase(true, "mul_out" + std::to_string(i)));
+    tracer.TraceOp("mul", {var_pair("X", vb_vector(1, x)),
+                           var_pair("Y", vb_vector(1, y))},
+                   {var_pair("Out", vb_vector(1, out))}, attrs, place, true);
+    products.push_back(out);
+  }
+
+  auto add = [&](std::shared_ptr<imperative::VarBase> a,
+                 std::shared_ptr<imperative::VarBase> b,
+                 const std::string& name) {
+    std::shared_ptr<imperative::VarBase> out(
+        new imperative::VarBase(true, name));
+    tracer.TraceOp("elementwise_add", {var_pair("X", vb_vector(1, a)),
+                                       var_pair("Y", vb_vector(1, b))},
+                   {var_pair("Out", vb_vector(1, out))}, attrs, place, true);
+    return out;
+  };
+  auto sum0 = add(products[0], products[1], "sum0");
+  auto sum1 = add(products[2], products[3], "sum1");
+  auto loss = add(sum0, sum1, "loss");
+
+  auto* engine = tracer.GetDefaultEngine();
+  engine->Init(loss.get(), strategy);
+  engine->Execute();
+
+  auto& x_grad = x->GradVar().Get<framework::LoDTensor>();
+  return std::vector<float>(x_grad.data<float>(),
+                            x_grad.data<float>() + x_grad.numel());
+}
+
+TEST(test_tracer, test_parallel_backward) {
+  detail::BackwardStrategy strategy;
+  strategy.sorted_sum_gradient_ = true;
+  auto expected = RunBranchedBackward(strategy);
+  ASSERT_EQ(expected.size(), 10UL);
+  // d loss / d x[i][k] = sum of y_j[k][0] + y_j[k][1]
+  for (int k = 0; k < 5; ++k) {
+    float grad = 0;
+    for (int j = 0; j < 4; ++j) {
+      grad += 2 * (j + 1) * 0.3f + (4 * k + 1) * 0.01f;
+    }
+    EXPECT_NEAR(expected[k], grad, 1e-5);
+    EXPECT_NEAR(expected[5 + k], grad, 1e-5);
+  }
+
+  strategy.num_threads_ = 4;
+  for (int i = 0; i < 10; ++i) {
+    // The sorted sum gradient is the same as that of the serial run
+    EXPECT_EQ(RunBranchedBackward(strategy), expected);
+  }
+
+  strategy.sorted_sum_gradient_ = false;
+  auto eager = RunBranchedBackward(strategy);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(eager[i], expected[i], 1e-5);
+  }
+}
+
 #if defined(PADDLE_WITH_CUDA)
 TEST(test_tracer, test_trace_op_with_multi_device_inputs) {
   // Doing an mul
@@ -201,3 +288,4 @@ TEST(test_tracer, test_unique_name_generator) {
 }  // namespace paddle
 
 USE_OP(mul);
+USE_OP(elementwise_add);
@@ -91,6 +91,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
                                   // params_file_ fields.
 
   CP_MEMBER(opt_cache_dir_);
+  CP_MEMBER(use_optim_program_cache_);
+  CP_MEMBER(use_static_memory_plan_);
   prog_file_ = std::move(other.prog_file_);
   params_file_ = std::move(other.params_file_);
 
@@ -141,6 +143,7 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(specify_input_name_);
 
   CP_MEMBER(cpu_math_library_num_threads_);
+  CP_MEMBER(intra_op_threads_);
 
   CP_MEMBER(serialized_info_cache_);
 
@@ -393,8 +396,11 @@ std::string AnalysisConfig::SerializeInfoCache() {
 
   ss << specify_input_name_;
   ss << cpu_math_library_num_threads_;
+  ss << intra_op_threads_;
   ss << use_anakin_;
   ss << anakin_min_subgraph_size_;
+  ss << use_optim_program_cache_;
+  ss << use_static_memory_plan_;
   return ss.str();
 }
 
@@ -405,6 +411,14 @@ void AnalysisConfig::SetCpuMathLibraryNumThreads(
   Update();
 }
 
+void AnalysisConfig::SetIntraOpThreads(int intra_op_threads) {
+  PADDLE_ENFORCE_GE(intra_op_threads, 0,
+                    "The number of intra-op threads should not be negative");
+  intra_op_threads_ = intra_op_threads;
+
+  Update();
+}
+
 float AnalysisConfig::fraction_of_gpu_memory_for_pool() const {
 #ifdef PADDLE_WITH_CUDA
   // Get the GPU memory details and calculate the fraction of memory for the
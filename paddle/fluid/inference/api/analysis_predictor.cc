@@ -14,13 +14,18 @@
 
 #include "paddle/fluid/inference/api/analysis_predictor.h"
 #include <glog/logging.h>
+#include <sys/stat.h>
 #include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <memory>
+#include <random>
 #include <set>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
+#include "paddle/fluid/framework/commit.h"
 #include "paddle/fluid/framework/feed_fetch_method.h"
 #include "paddle/fluid/framework/feed_fetch_type.h"
 #include "paddle/fluid/framework/ir/fuse_pass_base.h"
@@ -37,6 +42,7 @@
 #include "paddle/fluid/inference/utils/singleton.h"
 #include "paddle/fluid/memory/memcpy.h"
 #include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/gpu_info.h"
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler.h"
@@ -73,6 +79,27 @@ bool IsPersistable(const framework::VarDesc *var) {
   }
   return false;
 }
+
+std::vector<std::string> GetPersistableNames(
+    const framework::BlockDesc &block) {
+  std::vector<std::string> names;
+  for (auto *var : block.AllVars()) {
+    if (IsPersistable(var)) {
+      names.push_back(var->Name());
+    }
+  }
+  // sort the names to have consistent ordering
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+// Identify a file by its size and modified time.
+void AppendFileStamp(const std::string &path, std::ostream *os) {
+  struct stat st;
+  if (stat(path.c_str(), &st) == 0) {
+    *os << path << ":" << st.st_size << ":" << st.st_mtime << ";";
+  }
+}
 }  // namespace
 
 bool AnalysisPredictor::Init(
@@ -154,7 +181,13 @@ bool AnalysisPredictor::PrepareProgram(
     // if enable_ir_optim_ is false,
     // the analysis pass(op fuse, graph analysis, trt subgraph, mkldnn etc) will
     // not be executed.
-    OptimizeInferenceProgram();
+    std::string cache_prefix = GetOptimProgramCachePrefix();
+    if (cache_prefix.empty() || !LoadOptimProgramCache(cache_prefix)) {
+      OptimizeInferenceProgram();
+      if (!cache_prefix.empty()) {
+        SaveOptimProgramCache(cache_prefix);
+      }
+    }
   } else {
     // If the program is passed from external, no need to optimize it, this
     // logic is used in the clone scenario.
@@ -178,6 +211,9 @@ bool AnalysisPredictor::CreateExecutor() {
 bool AnalysisPredictor::PrepareExecutor() {
   executor_->Prepare(sub_scope_, *inference_program_, 0,
                      config_.use_feed_fetch_ops_);
+  if (config_.static_memory_plan_enabled()) {
+    executor_->EnableStaticMemoryPlan();
+  }
 
   PADDLE_ENFORCE_NOT_NULL(sub_scope_);
 
@@ -224,6 +260,7 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
                             std::vector<PaddleTensor> *output_data,
                             int batch_size) {
   paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  platform::ScopedIntraOpThreads intra_op_threads(config_.intra_op_threads());
 #ifdef PADDLE_WITH_MKLDNN
   if (config_.use_mkldnn_) MkldnnPreSet(inputs);
 #endif
@@ -635,6 +672,7 @@ std::unique_ptr<ZeroCopyTensor> AnalysisPredictor::GetOutputTensor(
 
 bool AnalysisPredictor::ZeroCopyRun() {
   paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  platform::ScopedIntraOpThreads intra_op_threads(config_.intra_op_threads());
   executor_->Run();
   // Fix TensorArray reuse not cleaned bug.
   tensor_array_batch_cleaner_.CollectTensorArrays(sub_scope_);
@@ -747,6 +785,124 @@ bool AnalysisPredictor::LoadParameters() {
   return true;
 }
 
+std::string AnalysisPredictor::GetOptimProgramCachePrefix() {
+  if (!config_.optim_program_cache_enabled()) {
+    return "";
+  }
+  // The engines of the subgraphs and the quantized program are not in the
+  // optimized program, the model from memory can't be identified cheaply.
+  if (!config_.ir_optim() || config_.model_from_memory() ||
+      config_.tensorrt_engine_enabled() || config_.anakin_engine_enabled() ||
+      config_.mkldnn_quantizer_enabled()) {
+    LOG(WARNING) << "The optimized program cache is not used with ir_optim "
+                    "off, the model from memory, TensorRT, Anakin or the "
+                    "MKLDNN quantizer";
+    return "";
+  }
+
+  std::stringstream key;
+  key << framework::paddle_version() << framework::paddle_commit();
+  key << config_.SerializeInfoCache();
+  for (auto &pass : config_.pass_builder()->AllPasses()) {
+    key << pass << ";";
+  }
+  for (auto &pass : config_.pass_builder()->AnalysisPasses()) {
+    key << pass << ";";
+  }
+  key << GetSerializedProgram();
+  // Hashing the parameters takes as long as loading them, so they are
+  // identified by the files.
+  if (!config_.params_file().empty()) {
+    AppendFileStamp(config_.params_file(), &key);
+  } else {
+    for (auto &name : GetPersistableNames(inference_program_->Block(0))) {
+      AppendFileStamp(config_.model_dir() + "/" + name, &key);
+    }
+  }
+
+  std::string cache_dir = config_.opt_cache_dir_;
+  if (cache_dir.empty()) {
+    std::string model_root =
+        config_.model_dir().empty()
+            ? inference::analysis::GetDirRoot(config_.prog_file())
+            : config_.model_dir();
+    cache_dir = model_root + "/_opt_cache";
+  }
+  if (!inference::analysis::PathExists(cache_dir) &&
+      MKDIR(cache_dir.c_str()) == -1) {
+    LOG(WARNING) << "Can not create the optimize cache directory "
+                 << cache_dir << ", the optimized program is not cached";
+    return "";
+  }
+  return cache_dir + "/optim_program_" +
+         std::to_string(std::hash<std::string>()(key.str()));
+}
+
+bool AnalysisPredictor::LoadOptimProgramCache(const std::string &prefix) {
+  std::string model_path = prefix + ".model";
+  if (!inference::analysis::FileExists(model_path)) {
+    VLOG(3) << "The optimized program cache " << model_path << " is missed";
+    return false;
+  }
+  try {
+    std::shared_ptr<framework::ProgramDesc> program(new framework::ProgramDesc(
+        inference::analysis::LoadProgramDesc(model_path)));
+    executor_->CreateVariables(*program, 0, true, sub_scope_);
+
+    auto params = GetPersistableNames(program->Block(0));
+    if (!params.empty()) {
+      framework::ProgramDesc load_program;
+      auto *op = load_program.MutableBlock(0)->AppendOp();
+      op->SetType("load_combine");
+      op->SetOutput("Out", params);
+      op->SetAttr("file_path", prefix + ".params");
+      op->CheckAttrs();
+
+      framework::NaiveExecutor e(place_);
+      e.Prepare(scope_.get(), load_program, 0, false);
+      e.Run();
+    }
+    inference_program_ = program;
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Failed to load the optimized program cache " << prefix
+                 << ", analyze the program again: " << e.what();
+    return false;
+  }
+  config_.PartiallyRelease();
+  LOG(INFO) << "Load the optimized program from the cache " << model_path;
+  return true;
+}
+
+void AnalysisPredictor::SaveOptimProgramCache(const std::string &prefix) {
+  // Write the temporary files and rename them, the model at last, so the
+  // other processes never see a partial cache. The parameters are in the
+  // mmap layout, which shares the pages among the predictors of the model.
+  std::string suffix = ".tmp" + std::to_string(std::random_device()());
+  std::string model_path = prefix + ".model";
+  std::string params_path = prefix + ".params";
+  try {
+    SaveParameters(params_path + suffix, true);
+    std::ofstream fout(model_path + suffix, std::ios::binary);
+    fout << GetSerializedProgram();
+    fout.close();
+    PADDLE_ENFORCE(static_cast<bool>(fout), "Failed to write %s",
+                   model_path + suffix);
+    PADDLE_ENFORCE_EQ(
+        std::rename((params_path + suffix).c_str(), params_path.c_str()), 0,
+        "Failed to rename the file to %s", params_path);
+    PADDLE_ENFORCE_EQ(
+        std::rename((model_path + suffix).c_str(), model_path.c_str()), 0,
+        "Failed to rename the file to %s", model_path);
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Failed to save the optimized program cache " << prefix
+                 << ": " << e.what();
+    std::remove((params_path + suffix).c_str());
+    std::remove((model_path + suffix).c_str());
+    return;
+  }
+  LOG(INFO) << "Save the optimized program to the cache " << model_path;
+}
+
 #if PADDLE_WITH_TENSORRT
 bool AnalysisPredictor::SaveTrtCalibToDisk() {
   PADDLE_ENFORCE(config_.tensorrt_engine_enabled(),
@@ -877,6 +1033,11 @@ void AnalysisPredictor::SaveOptimModel(const std::string &dir) {
   std::string inference_prog_desc = GetSerializedProgram();
   outfile << inference_prog_desc;
   // save params
+  SaveParameters(dir + "/params", false);
+}
+
+void AnalysisPredictor::SaveParameters(const std::string &path,
+                                       bool mmap_layout) {
   framework::ProgramDesc save_program;
   auto *save_block = save_program.MutableBlock(0);
 
@@ -899,7 +1060,8 @@ void AnalysisPredictor::SaveOptimModel(const std::string &dir) {
   auto *op = save_block->AppendOp();
   op->SetType("save_combine");
   op->SetInput("X", save_var_list);
-  op->SetAttr("file_path", dir + "/params");
+  op->SetAttr("file_path", path);
+  op->SetAttr("mmap_layout", mmap_layout);
   op->CheckAttrs();
 
   platform::CPUPlace place;
@@ -99,6 +99,13 @@ class AnalysisPredictor : public PaddlePredictor {
 
   bool LoadProgramDesc();
   bool LoadParameters();
+  void SaveParameters(const std::string &path, bool mmap_layout);
+
+  // The cache of the optimized program and parameters, the prefix of the
+  // cache files is empty if the cache is not used.
+  std::string GetOptimProgramCachePrefix();
+  bool LoadOptimProgramCache(const std::string &prefix);
+  void SaveOptimProgramCache(const std::string &prefix);
 
   bool SetFeed(const std::vector<PaddleTensor> &input_datas,
                framework::Scope *scope);
@@ -135,6 +142,7 @@ class AnalysisPredictor : public PaddlePredictor {
   FRIEND_TEST(AnalysisPredictor, analysis_off);
   FRIEND_TEST(AnalysisPredictor, analysis_on);
   FRIEND_TEST(AnalysisPredictor, with_gpu);
+  FRIEND_TEST(AnalysisPredictor, static_memory_plan);
 #endif
 
  private:
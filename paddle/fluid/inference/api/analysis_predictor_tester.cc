@@ -193,6 +193,85 @@ TEST(AnalysisPredictor, Clone) {
   }
 }
 
+// The startup time without the cache, on the cache miss and on the cache hit,
+// the outputs should be the same.
+TEST(AnalysisPredictor, optim_program_cache) {
+  std::string cache_dir = "./analysis_predictor_optim_cache";
+  auto create_predictor = [&](bool use_cache, double* startup_ms) {
+    AnalysisConfig config;
+    config.SetModel(FLAGS_dirname);
+    config.SwitchIrOptim(true);
+    config.SetOptimCacheDir(cache_dir);
+    config.EnableOptimProgramCache(use_cache);
+    inference::Timer timer;
+    timer.tic();
+    auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+    *startup_ms = timer.toc();
+    return predictor;
+  };
+
+  double no_cache_ms, miss_ms, hit_ms;
+  auto reference = create_predictor(false, &no_cache_ms);
+  auto miss = create_predictor(true, &miss_ms);
+  auto hit = create_predictor(true, &hit_ms);
+  LOG(INFO) << "startup without the cache: " << no_cache_ms
+            << " ms, on the cache miss: " << miss_ms
+            << " ms, on the cache hit: " << hit_ms << " ms";
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+
+  std::vector<PaddleTensor> ref_outputs;
+  ASSERT_TRUE(reference->Run(inputs, &ref_outputs));
+  for (auto* predictor : {miss.get(), hit.get()}) {
+    std::vector<PaddleTensor> outputs;
+    ASSERT_TRUE(predictor->Run(inputs, &outputs));
+    ASSERT_EQ(outputs.size(), ref_outputs.size());
+    inference::CompareTensor(outputs.front(), ref_outputs.front());
+  }
+  // The cached program is optimized already.
+  auto* hit_predictor = static_cast<AnalysisPredictor*>(hit.get());
+  auto* miss_predictor = static_cast<AnalysisPredictor*>(miss.get());
+  ASSERT_EQ(hit_predictor->GetSerializedProgram(),
+            miss_predictor->GetSerializedProgram());
+}
+
+TEST(AnalysisPredictor, static_memory_plan) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  auto reference = CreatePaddlePredictor<AnalysisConfig>(config);
+  config.EnableStaticMemoryPlan();
+  auto _predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  auto* predictor = static_cast<AnalysisPredictor*>(_predictor.get());
+
+  for (int batch_size : {4, 2, 8, 8}) {
+    std::vector<int64_t> data(batch_size);
+    for (int i = 0; i < batch_size; ++i) {
+      data[i] = i * 10 + batch_size;
+    }
+    PaddleTensor tensor;
+    tensor.shape = std::vector<int>({batch_size, 1});
+    tensor.data.Reset(data.data(), data.size() * sizeof(int64_t));
+    tensor.dtype = PaddleDType::INT64;
+    std::vector<PaddleTensor> inputs(4, tensor);
+
+    std::vector<PaddleTensor> outputs, ref_outputs;
+    ASSERT_TRUE(predictor->Run(inputs, &outputs));
+    ASSERT_TRUE(reference->Run(inputs, &ref_outputs));
+    inference::CompareTensor(outputs.front(), ref_outputs.front());
+  }
+  auto* planner = predictor->executor_->memory_planner();
+  ASSERT_TRUE(planner != nullptr);
+  EXPECT_TRUE(planner->planned());
+  LOG(INFO) << "arena: " << planner->arena_size()
+            << " bytes, the tensors planned: " << planner->planned_size()
+            << " bytes";
+}
+
 // This function is not released yet, will fail on some machine.
 // TODO(Superjomn) Turn on it latter.
 /*
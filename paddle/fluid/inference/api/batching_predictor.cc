@@ -0,0 +1,483 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/string/string_helper.h"
+
+namespace paddle {
+
+using LoD = std::vector<std::vector<size_t>>;
+
+struct BatchingPredictor::Request {
+  // The inputs in the order of the input names of the model.
+  std::vector<const PaddleTensor*> inputs;
+  std::vector<PaddleTensor>* outputs;
+  // The number of the samples, i.e. the sequences of the LoD inputs.
+  size_t batch_size;
+  std::chrono::steady_clock::time_point arrival;
+  bool done{false};
+  bool success{false};
+
+  // Whether the requests can be merged into a batch.
+  bool IsCompatible(const Request& other) const;
+};
+
+class BatchingPredictor::Worker {
+ public:
+  Worker(std::unique_ptr<PaddlePredictor> predictor,
+         const std::vector<std::string>& input_names,
+         const std::vector<std::string>& output_names)
+      : predictor_(std::move(predictor)) {
+    for (auto& name : input_names) {
+      inputs_.emplace_back(predictor_->GetInputTensor(name));
+      PADDLE_ENFORCE_NOT_NULL(inputs_.back(),
+                              "The predictor should support ZeroCopyRun");
+    }
+    for (auto& name : output_names) {
+      outputs_.emplace_back(predictor_->GetOutputTensor(name));
+      PADDLE_ENFORCE_NOT_NULL(outputs_.back(),
+                              "The predictor should support ZeroCopyRun");
+    }
+  }
+
+  // Run the requests by one run of the predictor.
+  void Run(const std::vector<Request*>& batch);
+
+ private:
+  void Feed(size_t idx, const std::vector<Request*>& batch);
+  void Fetch(size_t idx, const std::vector<Request*>& batch);
+
+  std::unique_ptr<PaddlePredictor> predictor_;
+  std::vector<std::unique_ptr<ZeroCopyTensor>> inputs_;
+  std::vector<std::unique_ptr<ZeroCopyTensor>> outputs_;
+  // The copy of the outputs not in CPU.
+  std::vector<char> staging_;
+};
+
+static size_t Rows(const PaddleTensor& tensor) {
+  PADDLE_ENFORCE(!tensor.shape.empty(), "The input %s should not be a scalar",
+                 tensor.name);
+  return static_cast<size_t>(tensor.shape[0]);
+}
+
+static size_t Numel(const std::vector<int>& shape) {
+  size_t numel = 1;
+  for (int dim : shape) {
+    numel *= static_cast<size_t>(dim);
+  }
+  return numel;
+}
+
+static size_t BatchSizeOf(const PaddleTensor& tensor) {
+  return tensor.lod.empty() ? Rows(tensor) : tensor.lod[0].size() - 1;
+}
+
+static void* MutableData(ZeroCopyTensor* tensor, PaddleDType dtype) {
+  switch (dtype) {
+    case PaddleDType::FLOAT32:
+      return tensor->mutable_data<float>(PaddlePlace::kCPU);
+    case PaddleDType::INT64:
+      return tensor->mutable_data<int64_t>(PaddlePlace::kCPU);
+    case PaddleDType::INT32:
+      return tensor->mutable_data<int32_t>(PaddlePlace::kCPU);
+    case PaddleDType::UINT8:
+      return tensor->mutable_data<uint8_t>(PaddlePlace::kCPU);
+    default:
+      PADDLE_THROW("Unsupported data type %d", static_cast<int>(dtype));
+  }
+  return nullptr;
+}
+
+static const void* Data(const ZeroCopyTensor* tensor, PaddleDType dtype,
+                        PaddlePlace* place) {
+  int size = 0;
+  switch (dtype) {
+    case PaddleDType::FLOAT32:
+      return tensor->data<float>(place, &size);
+    case PaddleDType::INT64:
+      return tensor->data<int64_t>(place, &size);
+    case PaddleDType::INT32:
+      return tensor->data<int32_t>(place, &size);
+    case PaddleDType::UINT8:
+      return tensor->data<uint8_t>(place, &size);
+    default:
+      PADDLE_THROW("Unsupported data type %d", static_cast<int>(dtype));
+  }
+  return nullptr;
+}
+
+static void CopyToCpu(ZeroCopyTensor* tensor, PaddleDType dtype, void* dst) {
+  switch (dtype) {
+    case PaddleDType::FLOAT32:
+      return tensor->copy_to_cpu(static_cast<float*>(dst));
+    case PaddleDType::INT64:
+      return tensor->copy_to_cpu(static_cast<int64_t*>(dst));
+    case PaddleDType::INT32:
+      return tensor->copy_to_cpu(static_cast<int32_t*>(dst));
+    case PaddleDType::UINT8:
+      return tensor->copy_to_cpu(static_cast<uint8_t*>(dst));
+    default:
+      PADDLE_THROW("Unsupported data type %d", static_cast<int>(dtype));
+  }
+}
+
+bool BatchingPredictor::Request::IsCompatible(const Request& other) const {
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto& x = *inputs[i];
+    auto& y = *other.inputs[i];
+    if (x.dtype != y.dtype || x.lod.size() != y.lod.size() ||
+        x.shape.size() != y.shape.size() ||
+        !std::equal(x.shape.begin() + 1, x.shape.end(), y.shape.begin() + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Append the LoD of a request to the merged LoD, the offsets of every level
+// are shifted by the end of the merged level.
+static void AppendLoD(const LoD& lod, LoD* merged) {
+  if (merged->empty()) {
+    *merged = lod;
+    return;
+  }
+  for (size_t level = 0; level < lod.size(); ++level) {
+    auto& merged_level = (*merged)[level];
+    size_t shift = merged_level.back();
+    for (size_t i = 1; i < lod[level].size(); ++i) {
+      merged_level.push_back(lod[level][i] + shift);
+    }
+  }
+}
+
+// Slice the sequences [begin, end) of the top level, return the rows, and
+// the LoD rebased to 0.
+static std::pair<size_t, size_t> SliceLoD(const LoD& lod, size_t begin,
+                                          size_t end, LoD* sliced) {
+  sliced->clear();
+  for (auto& level : lod) {
+    std::vector<size_t> sliced_level(level.begin() + begin,
+                                     level.begin() + end + 1);
+    for (auto& offset : sliced_level) {
+      offset -= level[begin];
+    }
+    sliced->emplace_back(std::move(sliced_level));
+    begin = level[begin];
+    end = level[end];
+  }
+  return std::make_pair(begin, end);
+}
+
+void BatchingPredictor::Worker::Feed(size_t idx,
+                                     const std::vector<Request*>& batch) {
+  auto& first = *batch.front()->inputs[idx];
+  auto* tensor = inputs_[idx].get();
+
+  std::vector<int> shape = first.shape;
+  shape[0] = 0;
+  LoD lod;
+  for (auto* request : batch) {
+    auto& input = *request->inputs[idx];
+    shape[0] += input.shape[0];
+    AppendLoD(input.lod, &lod);
+  }
+  tensor->Reshape(shape);
+  tensor->SetLoD(lod);
+  if (Numel(shape) == 0) {
+    return;
+  }
+
+  auto* dst = static_cast<char*>(MutableData(tensor, first.dtype));
+  for (auto* request : batch) {
+    auto& input = *request->inputs[idx];
+    size_t bytes = Numel(input.shape) * PaddleDtypeSize(input.dtype);
+    if (bytes > 0) {
+      std::memcpy(dst, input.data.data(), bytes);
+      dst += bytes;
+    }
+  }
+}
+
+void BatchingPredictor::Worker::Fetch(size_t idx,
+                                      const std::vector<Request*>& batch) {
+  auto* tensor = outputs_[idx].get();
+  std::vector<int> shape = tensor->shape();
+  LoD lod = tensor->lod();
+  PaddleDType dtype = tensor->type();
+  size_t numel = Numel(shape);
+  size_t total_batch = 0;
+  size_t total_rows = 0;
+  for (auto* request : batch) {
+    total_batch += request->batch_size;
+    total_rows += Rows(*request->inputs.front());
+  }
+
+  // How the output is split.
+  enum { kByLoD, kByBatch, kByRows } split;
+  if (!lod.empty() && lod[0].size() == total_batch + 1) {
+    split = kByLoD;
+  } else if (!shape.empty() && static_cast<size_t>(shape[0]) == total_batch) {
+    split = kByBatch;
+  } else if (!shape.empty() && static_cast<size_t>(shape[0]) == total_rows) {
+    split = kByRows;
+  } else {
+    PADDLE_THROW(
+        "Can not split the output %s of shape [%s] to the requests of batch "
+        "size %d",
+        tensor->name(), string::join_strings(shape, ','), total_batch);
+  }
+
+  const char* data = nullptr;
+  if (numel > 0) {
+    PaddlePlace place;
+    data = static_cast<const char*>(Data(tensor, dtype, &place));
+    if (place != PaddlePlace::kCPU) {
+      staging_.resize(numel * PaddleDtypeSize(dtype));
+      CopyToCpu(tensor, dtype, staging_.data());
+      data = staging_.data();
+    }
+  }
+  size_t row_bytes = shape.empty() || shape[0] == 0
+                         ? 0
+                         : numel / shape[0] * PaddleDtypeSize(dtype);
+
+  size_t batch_offset = 0;
+  size_t row_offset = 0;
+  for (auto* request : batch) {
+    PaddleTensor& out = (*request->outputs)[idx];
+    out.name = tensor->name();
+    out.dtype = dtype;
+    out.shape = shape;
+    out.lod.clear();
+    size_t begin = 0;
+    size_t end = 0;
+    if (split == kByLoD) {
+      std::tie(begin, end) = SliceLoD(
+          lod, batch_offset, batch_offset + request->batch_size, &out.lod);
+    } else if (split == kByBatch) {
+      begin = batch_offset;
+      end = batch_offset + request->batch_size;
+    } else {
+      begin = row_offset;
+      end = row_offset + Rows(*request->inputs.front());
+    }
+    batch_offset += request->batch_size;
+    row_offset += Rows(*request->inputs.front());
+
+    out.shape[0] = static_cast<int>(end - begin);
+    size_t bytes = (end - begin) * row_bytes;
+    out.data.Resize(bytes);
+    if (bytes > 0) {
+      std::memcpy(out.data.data(), data + begin * row_bytes, bytes);
+    }
+  }
+}
+
+void BatchingPredictor::Worker::Run(const std::vector<Request*>& batch) {
+  for (size_t i = 0; i < inputs_.size(); ++i) {
+    Feed(i, batch);
+  }
+  PADDLE_ENFORCE(predictor_->ZeroCopyRun(), "Failed to run the predictor");
+  for (auto* request : batch) {
+    request->outputs->resize(outputs_.size());
+  }
+  for (size_t i = 0; i < outputs_.size(); ++i) {
+    Fetch(i, batch);
+  }
+}
+
+BatchingPredictor::BatchingPredictor(std::unique_ptr<PaddlePredictor> predictor,
+                                     const BatchingConfig& config)
+    : config_(config) {
+  PADDLE_ENFORCE_NOT_NULL(predictor);
+  PADDLE_ENFORCE_GT(config.max_batch_size, 0,
+                    "The max batch size should be positive");
+  PADDLE_ENFORCE_GE(config.max_wait_us, 0,
+                    "The max wait time should not be negative");
+  PADDLE_ENFORCE_GT(config.num_workers, 0,
+                    "The number of workers should be positive");
+  input_names_ = predictor->GetInputNames();
+  output_names_ = predictor->GetOutputNames();
+  PADDLE_ENFORCE(!input_names_.empty(), "The model should have inputs");
+
+  for (int i = 1; i < config.num_workers; ++i) {
+    workers_.emplace_back(
+        new Worker(predictor->Clone(), input_names_, output_names_));
+  }
+  workers_.emplace_back(
+      new Worker(std::move(predictor), input_names_, output_names_));
+  for (auto& worker : workers_) {
+    threads_.emplace_back(&BatchingPredictor::WorkerLoop, this, worker.get());
+  }
+}
+
+BatchingPredictor::~BatchingPredictor() {
+  {
+    std::lock_guard<std::mutex> guard(mtx_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+bool BatchingPredictor::Run(const std::vector<PaddleTensor>& inputs,
+                            std::vector<PaddleTensor>* outputs) {
+  PADDLE_ENFORCE_NOT_NULL(outputs);
+  if (inputs.size() != input_names_.size()) {
+    LOG(ERROR) << "The model has " << input_names_.size() << " inputs, but "
+               << inputs.size() << " inputs are fed";
+    return false;
+  }
+
+  Request request;
+  request.inputs.resize(inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    size_t idx = i;
+    if (!inputs[i].name.empty()) {
+      auto it = std::find(input_names_.begin(), input_names_.end(),
+                          inputs[i].name);
+      if (it == input_names_.end()) {
+        LOG(ERROR) << "The model has no input named " << inputs[i].name;
+        return false;
+      }
+      idx = it - input_names_.begin();
+    }
+    if (request.inputs[idx] != nullptr) {
+      LOG(ERROR) << "The input " << input_names_[idx] << " is fed twice";
+      return false;
+    }
+    request.inputs[idx] = &inputs[i];
+  }
+  try {
+    request.batch_size = BatchSizeOf(*request.inputs.front());
+    for (auto* input : request.inputs) {
+      PADDLE_ENFORCE_EQ(BatchSizeOf(*input), request.batch_size,
+                        "The batch size of the input %s differs from the "
+                        "other inputs",
+                        input->name);
+      PADDLE_ENFORCE_GE(input->data.length(),
+                        Numel(input->shape) * PaddleDtypeSize(input->dtype),
+                        "The data of the input %s is less than its shape",
+                        input->name);
+      if (!input->lod.empty()) {
+        PADDLE_ENFORCE_EQ(input->lod.back().back(), Rows(*input),
+                          "The LoD of the input %s does not match its shape",
+                          input->name);
+      }
+    }
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+    return false;
+  }
+  request.outputs = outputs;
+  request.arrival = std::chrono::steady_clock::now();
+
+  std::unique_lock<std::mutex> lock(mtx_);
+  PADDLE_ENFORCE(!stop_, "The BatchingPredictor is destroyed");
+  queue_.push_back(&request);
+  queue_cv_.notify_all();
+  done_cv_.wait(lock, [&request] { return request.done; });
+  return request.success;
+}
+
+bool BatchingPredictor::NextBatch(std::vector<Request*>* batch) {
+  std::unique_lock<std::mutex> lock(mtx_);
+  queue_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+  if (queue_.empty()) {
+    return false;
+  }
+
+  auto* head = queue_.front();
+  queue_.pop_front();
+  batch->push_back(head);
+  size_t batch_size = head->batch_size;
+  const size_t max_batch_size = config_.max_batch_size;
+  auto deadline =
+      head->arrival + std::chrono::microseconds(config_.max_wait_us);
+
+  // The requests not compatible with the head are skipped, and they are run
+  // in the later batches.
+  size_t pos = 0;
+  bool full = batch_size >= max_batch_size;
+  auto collect = [&] {
+    while (!full && pos < queue_.size()) {
+      auto* request = queue_[pos];
+      if (!head->IsCompatible(*request)) {
+        ++pos;
+        continue;
+      }
+      if (batch_size + request->batch_size > max_batch_size) {
+        full = true;
+        break;
+      }
+      batch->push_back(request);
+      batch_size += request->batch_size;
+      queue_.erase(queue_.begin() + pos);
+      full = batch_size >= max_batch_size;
+    }
+  };
+
+  collect();
+  while (!full && !stop_) {
+    bool timeout =
+        queue_cv_.wait_until(lock, deadline) == std::cv_status::timeout;
+    collect();
+    if (timeout) {
+      break;
+    }
+  }
+  return true;
+}
+
+void BatchingPredictor::WorkerLoop(Worker* worker) {
+  std::vector<Request*> batch;
+  while (NextBatch(&batch)) {
+    bool success = true;
+    try {
+      worker->Run(batch);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Failed to run a batch of " << batch.size()
+                 << " requests: " << e.what();
+      success = false;
+    }
+    {
+      std::lock_guard<std::mutex> guard(mtx_);
+      stat_.requests += batch.size();
+      stat_.batches += 1;
+      if (!success) {
+        stat_.failed_requests += batch.size();
+      }
+      for (auto* request : batch) {
+        request->success = success;
+        request->done = true;
+      }
+    }
+    done_cv_.notify_all();
+    batch.clear();
+  }
+}
+
+BatchingStat BatchingPredictor::GetStat() const {
+  std::lock_guard<std::mutex> guard(mtx_);
+  return stat_;
+}
+
+}  // namespace paddle
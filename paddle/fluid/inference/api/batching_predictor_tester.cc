@@ -0,0 +1,184 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+DEFINE_string(dirname, "", "dirname to tests.");
+DEFINE_int32(load_clients, 16, "The number of the clients of the load test.");
+DEFINE_int32(load_requests, 50, "The requests sent by every client.");
+
+namespace paddle {
+
+static std::unique_ptr<PaddlePredictor> CreateZeroCopyPredictor() {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.SwitchUseFeedFetchOps(false);
+  return CreatePaddlePredictor<AnalysisConfig>(config);
+}
+
+// The 4 word inputs of word2vec of the batch size.
+static std::vector<PaddleTensor> PrepareInputs(int batch_size, int seed,
+                                               std::vector<int64_t>* data) {
+  data->resize(4 * batch_size);
+  for (size_t i = 0; i < data->size(); ++i) {
+    (*data)[i] = (seed * 7 + i * 13) % 1000;
+  }
+  std::vector<PaddleTensor> inputs(4);
+  const char* names[] = {"firstw", "secondw", "thirdw", "forthw"};
+  for (int i = 0; i < 4; ++i) {
+    inputs[i].name = names[i];
+    inputs[i].shape = {batch_size, 1};
+    inputs[i].dtype = PaddleDType::INT64;
+    inputs[i].data.Reset(data->data() + i * batch_size,
+                         batch_size * sizeof(int64_t));
+  }
+  return inputs;
+}
+
+// Run the inputs alone by ZeroCopyRun.
+static std::vector<float> RunAlone(PaddlePredictor* predictor,
+                                   const std::vector<PaddleTensor>& inputs) {
+  for (auto& input : inputs) {
+    auto tensor = predictor->GetInputTensor(input.name);
+    tensor->Reshape(input.shape);
+    tensor->copy_from_cpu(static_cast<const int64_t*>(input.data.data()));
+  }
+  EXPECT_TRUE(predictor->ZeroCopyRun());
+  auto output = predictor->GetOutputTensor(predictor->GetOutputNames()[0]);
+  auto shape = output->shape();
+  std::vector<float> result(shape[0] * shape[1]);
+  output->copy_to_cpu(result.data());
+  return result;
+}
+
+TEST(BatchingPredictor, SameAsRunAlone) {
+  auto reference = CreateZeroCopyPredictor();
+  BatchingConfig config;
+  config.max_batch_size = 8;
+  config.max_wait_us = 10000;
+  config.num_workers = 2;
+  BatchingPredictor predictor(reference->Clone(), config);
+
+  const int num_threads = 8;
+  std::vector<std::vector<int64_t>> data(num_threads);
+  std::vector<std::vector<PaddleTensor>> inputs(num_threads);
+  std::vector<std::vector<float>> expected(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    inputs[i] = PrepareInputs(i % 3 + 1, i, &data[i]);
+    expected[i] = RunAlone(reference.get(), inputs[i]);
+  }
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < 10; ++j) {
+        std::vector<PaddleTensor> outputs;
+        ASSERT_TRUE(predictor.Run(inputs[i], &outputs));
+        ASSERT_EQ(outputs.size(), 1UL);
+        ASSERT_EQ(outputs[0].shape[0], i % 3 + 1);
+        auto* out = static_cast<float*>(outputs[0].data.data());
+        for (size_t k = 0; k < expected[i].size(); ++k) {
+          ASSERT_NEAR(out[k], expected[i][k], 1e-5);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto stat = predictor.GetStat();
+  EXPECT_EQ(stat.requests, static_cast<uint64_t>(num_threads * 10));
+  EXPECT_EQ(stat.failed_requests, 0UL);
+  LOG(INFO) << "average batch size: " << stat.AverageBatchSize();
+}
+
+TEST(BatchingPredictor, InvalidInputs) {
+  BatchingPredictor predictor(CreateZeroCopyPredictor(), BatchingConfig());
+  std::vector<int64_t> data;
+  auto inputs = PrepareInputs(2, 0, &data);
+  std::vector<PaddleTensor> outputs;
+
+  auto missing = inputs;
+  missing.pop_back();
+  EXPECT_FALSE(predictor.Run(missing, &outputs));
+
+  auto unknown = inputs;
+  unknown[0].name = "unknown";
+  EXPECT_FALSE(predictor.Run(unknown, &outputs));
+
+  auto mismatched = inputs;
+  mismatched[1].shape = {1, 1};
+  EXPECT_FALSE(predictor.Run(mismatched, &outputs));
+
+  EXPECT_TRUE(predictor.Run(inputs, &outputs));
+}
+
+// The throughput and the latency of the clients sending the requests of
+// batch size 1 without think time, for different max batch sizes.
+TEST(BatchingPredictor, LoadGenerator) {
+  auto reference = CreateZeroCopyPredictor();
+  LOG(INFO) << "clients: " << FLAGS_load_clients
+            << ", requests per client: " << FLAGS_load_requests;
+  for (int max_batch_size : {1, 4, 16, 64}) {
+    BatchingConfig config;
+    config.max_batch_size = max_batch_size;
+    config.max_wait_us = max_batch_size == 1 ? 0 : 1000;
+    BatchingPredictor predictor(reference->Clone(), config);
+
+    std::vector<std::vector<double>> latencies(FLAGS_load_clients);
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FLAGS_load_clients; ++i) {
+      clients.emplace_back([&, i] {
+        std::vector<int64_t> data;
+        std::vector<PaddleTensor> outputs;
+        for (int j = 0; j < FLAGS_load_requests; ++j) {
+          auto inputs = PrepareInputs(1, i * FLAGS_load_requests + j, &data);
+          auto begin = std::chrono::steady_clock::now();
+          ASSERT_TRUE(predictor.Run(inputs, &outputs));
+          latencies[i].push_back(std::chrono::duration<double, std::milli>(
+                                     std::chrono::steady_clock::now() - begin)
+                                     .count());
+        }
+      });
+    }
+    for (auto& client : clients) {
+      client.join();
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    std::vector<double> all;
+    for (auto& latency : latencies) {
+      all.insert(all.end(), latency.begin(), latency.end());
+    }
+    std::sort(all.begin(), all.end());
+    LOG(INFO) << "max_batch_size: " << max_batch_size
+              << ", throughput: " << all.size() / seconds << " requests/s"
+              << ", average batch size: "
+              << predictor.GetStat().AverageBatchSize()
+              << ", p50: " << all[all.size() / 2] << " ms"
+              << ", p99: " << all[all.size() * 99 / 100] << " ms";
+  }
+}
+
+}  // namespace paddle
@@ -67,6 +67,14 @@ struct AnalysisConfig {
   void SetOptimCacheDir(const std::string& opt_cache_dir) {
     opt_cache_dir_ = opt_cache_dir;
   }
+  /** Cache the optimized program and parameters in the opt cache dir, or in
+   *  the _opt_cache directory of the model if it is not set, so that the
+   *  later predictors of the same model and config skip the analysis.
+   */
+  void EnableOptimProgramCache(bool x = true) { use_optim_program_cache_ = x; }
+  /** A boolean state telling whether the optimized program is cached.
+   */
+  bool optim_program_cache_enabled() const { return use_optim_program_cache_; }
   /** Get the model directory path.
    */
   const std::string& model_dir() const { return model_dir_; }
@@ -209,6 +217,13 @@ struct AnalysisConfig {
     return cpu_math_library_num_threads_;
   }
 
+  /** Set and get the number of threads to run an op, e.g. the Eigen based
+   *  elementwise and reduce ops, they are taken from the pool of
+   *  FLAGS_intra_op_threads threads. 0 means all the threads of the pool.
+   */
+  void SetIntraOpThreads(int intra_op_threads);
+  int intra_op_threads() const { return intra_op_threads_; }
+
   /** Transform the AnalysisConfig to NativeConfig.
    */
   NativeConfig ToNativeConfig() const;
@@ -248,6 +263,14 @@ struct AnalysisConfig {
   /** Tell whether the memory optimization is activated. */
   bool enable_memory_optim() const;
 
+  /** Turn on the static memory plan, which lays out the temporary tensors in
+   *  one arena by the memory used in the first run, so the later runs with
+   *  the same or smaller input shapes don't allocate them.
+   */
+  void EnableStaticMemoryPlan(bool x = true) { use_static_memory_plan_ = x; }
+  /** Tell whether the static memory plan is activated. */
+  bool static_memory_plan_enabled() const { return use_static_memory_plan_; }
+
   /** \brief Turn on profiling report.
    *
    * If not turned on, no profiling report will be generateed.
@@ -331,6 +354,7 @@ struct AnalysisConfig {
   bool specify_input_name_{false};
 
   int cpu_math_library_num_threads_{1};
+  int intra_op_threads_{1};
 
   bool with_profile_{false};
 
@@ -361,6 +385,8 @@ struct AnalysisConfig {
   // So we release the memory when the predictor is set up.
   mutable bool is_valid_{true};
   std::string opt_cache_dir_;
+  bool use_optim_program_cache_{false};
+  bool use_static_memory_plan_{false};
 };
 
 }  // namespace paddle
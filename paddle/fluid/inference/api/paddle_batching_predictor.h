@@ -0,0 +1,125 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+/*! \file paddle_batching_predictor.h
+ */
+
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle_api.h"  // NOLINT
+
+namespace paddle {
+
+/** Configuration of the BatchingPredictor.
+ */
+struct BatchingConfig {
+  /** The max batch size of a merged run. A request is never split, so a
+   * request larger than it runs alone.
+   */
+  int max_batch_size{32};
+  /** The max time in microseconds to wait for more requests after the first
+   * request of a batch arrives. 0 means running the requests queued at the
+   * time.
+   */
+  int max_wait_us{1000};
+  /** The number of threads running the batches, each thread runs its own
+   * clone of the predictor.
+   */
+  int num_workers{1};
+};
+
+/** The statistics of the BatchingPredictor.
+ */
+struct BatchingStat {
+  uint64_t requests{0};
+  uint64_t batches{0};
+  uint64_t failed_requests{0};
+  double AverageBatchSize() const {
+    return batches == 0 ? 0 : static_cast<double>(requests) / batches;
+  }
+};
+
+/** \brief Merge the concurrent requests into one run of the predictor.
+ *
+ * The serving threads call Run concurrently with the inputs of a request,
+ * the requests are queued, merged along the batch dimension, run by
+ * ZeroCopyRun once, and the outputs are split back to the requests. This
+ * improves the efficiency of the GEMM based ops, e.g. fc and mul, a lot for
+ * the requests of batch size 1.
+ *
+ * The batch size of a request is the first dimension of its inputs, or the
+ * number of the sequences for the inputs with LoD, whose LoD are merged.
+ * The requests whose inputs differ in the other dimensions are not merged.
+ *
+ * An output is split by its LoD if it has as many sequences as the merged
+ * batch, or by its first dimension if it equals to the merged batch size or
+ * the rows of the first input.
+ *
+ * The predictor should support ZeroCopyRun, e.g. an AnalysisPredictor
+ * created with AnalysisConfig::SwitchUseFeedFetchOps(false).
+ */
+class BatchingPredictor {
+ public:
+  BatchingPredictor(std::unique_ptr<PaddlePredictor> predictor,
+                    const BatchingConfig& config);
+  BatchingPredictor(const BatchingPredictor&) = delete;
+  BatchingPredictor& operator=(const BatchingPredictor&) = delete;
+
+  /** Finish the queued requests and stop the workers.
+   */
+  ~BatchingPredictor();
+
+  /** Run a request, it is thread safe and blocks until the outputs are
+   * ready. The inputs are matched to the inputs of the model by their names,
+   * or by their positions if the names are empty. The outputs are all the
+   * outputs of the model.
+   */
+  bool Run(const std::vector<PaddleTensor>& inputs,
+           std::vector<PaddleTensor>* outputs);
+
+  BatchingStat GetStat() const;
+
+ private:
+  struct Request;
+  class Worker;
+
+  void WorkerLoop(Worker* worker);
+  // Take the requests of the next batch from the queue, return false if the
+  // predictor is stopped and the queue is empty.
+  bool NextBatch(std::vector<Request*>* batch);
+
+  BatchingConfig config_;
+  std::vector<std::string> input_names_;
+  std::vector<std::string> output_names_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  mutable std::mutex mtx_;
+  std::condition_variable queue_cv_;
+  std::condition_variable done_cv_;
+  std::deque<Request*> queue_;
+  bool stop_{false};
+  BatchingStat stat_;
+};
+
+}  // namespace paddle
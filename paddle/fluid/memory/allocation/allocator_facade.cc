@@ -26,6 +26,7 @@
 #include "paddle/fluid/memory/allocation/locked_allocator.h"
 #include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
 #include "paddle/fluid/memory/allocation/retry_allocator.h"
+#include "paddle/fluid/memory/allocation/thread_local_allocator.h"
 #include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/place.h"
@@ -74,6 +75,18 @@ class AllocatorFacadePrivate {
         break;
       }
 
+      case AllocatorStrategy::kThreadLocal: {
+        InitThreadLocalCPUAllocator();
+#ifdef PADDLE_WITH_CUDA
+        for (int dev_id = 0; dev_id < platform::GetCUDADeviceCount();
+             ++dev_id) {
+          InitNaiveBestFitCUDAAllocator(platform::CUDAPlace(dev_id));
+        }
+        InitNaiveBestFitCUDAPinnedAllocator();
+#endif
+        break;
+      }
+
       default: {
         PADDLE_THROW("Unsupported allocator strategy: %d",
                      static_cast<int>(strategy));
@@ -103,6 +116,11 @@ class AllocatorFacadePrivate {
         std::make_shared<NaiveBestFitAllocator>(platform::CPUPlace());
   }
 
+  void InitThreadLocalCPUAllocator() {
+    allocators_[platform::CPUPlace()] = std::make_shared<ThreadLocalAllocator>(
+        std::make_shared<NaiveBestFitAllocator>(platform::CPUPlace()));
+  }
+
 #ifdef PADDLE_WITH_CUDA
   void InitNaiveBestFitCUDAPinnedAllocator() {
     allocators_[platform::CUDAPinnedPlace()] =
@@ -198,6 +216,16 @@ AllocationPtr AllocatorFacade::Alloc(const platform::Place& place,
   return m_->GetAllocator(place, size)->Allocate(size);
 }
 
+std::vector<ThreadCacheStat> AllocatorFacade::GetThreadCacheStats(
+    const platform::Place& place) {
+  auto allocator = std::dynamic_pointer_cast<ThreadLocalAllocator>(
+      m_->GetAllocator(place, 1));
+  if (allocator == nullptr) {
+    return {};
+  }
+  return allocator->GetThreadCacheStats();
+}
+
 }  // namespace allocation
 }  // namespace memory
 }  // namespace paddle
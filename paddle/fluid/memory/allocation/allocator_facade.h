@@ -14,7 +14,9 @@
 
 #pragma once
 #include <memory>
+#include <vector>
 #include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/memory/allocation/thread_local_allocator.h"
 #include "paddle/fluid/platform/place.h"
 
 namespace paddle {
@@ -44,6 +46,11 @@ class AllocatorFacade {
   // Allocate a unique allocation.
   AllocationPtr Alloc(const platform::Place& place, size_t size);
 
+  // The stats of the thread caches of the allocator of place, empty if it is
+  // not a ThreadLocalAllocator.
+  std::vector<ThreadCacheStat> GetThreadCacheStats(
+      const platform::Place& place);
+
   // TODO(yy): Allocate a Copy-On-Write allocation?
  private:
   AllocatorFacade();
@@ -0,0 +1,354 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/thread_local_allocator.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <utility>
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+constexpr size_t ThreadLocalAllocator::kMinClassSize;
+constexpr size_t ThreadLocalAllocator::kMaxClassSize;
+
+// kMinClassSize, and 4 classes in (2^n, 2^(n+1)] for 2^n in
+// [kMinClassSize, kMaxClassSize).
+static constexpr size_t kClassNum = 1 + (20 - 6) * 4;
+// The index of the requests larger than kMaxClassSize.
+static constexpr size_t kLargeIndex = kClassNum;
+
+// The bytes moved between a thread cache and the central pool at a time.
+static constexpr size_t kBatchBytes = 64 << 10;
+static constexpr size_t kMaxBatchNum = 32;
+
+static inline int HighestBit(size_t n) {
+#if defined(__GNUC__)
+  return 63 - __builtin_clzll(static_cast<unsigned long long>(n));  // NOLINT
+#else
+  int bit = -1;
+  while (n != 0) {
+    n >>= 1;
+    ++bit;
+  }
+  return bit;
+#endif
+}
+
+size_t ThreadLocalAllocator::SizeClassIndex(size_t size) {
+  if (size <= kMinClassSize) {
+    return 0;
+  }
+  if (size > kMaxClassSize) {
+    return kLargeIndex;
+  }
+  // 2^n < size <= 2^(n+1)
+  int n = HighestBit(size - 1);
+  size_t step = static_cast<size_t>(1) << (n - 2);
+  size_t k = (size - (static_cast<size_t>(1) << n) + step - 1) / step;
+  return 1 + (n - 6) * 4 + (k - 1);
+}
+
+size_t ThreadLocalAllocator::SizeOfClass(size_t index) {
+  if (index == 0) {
+    return kMinClassSize;
+  }
+  size_t n = 6 + (index - 1) / 4;
+  size_t k = (index - 1) % 4 + 1;
+  return (static_cast<size_t>(1) << n) + k * (static_cast<size_t>(1) << (n - 2));
+}
+
+static size_t BatchNum(size_t index) {
+  return std::min(
+      std::max(kBatchBytes / ThreadLocalAllocator::SizeOfClass(index),
+               static_cast<size_t>(1)),
+      kMaxBatchNum);
+}
+
+// The allocation object is kept with its block in the caches, so it is not
+// created again when the block is reused.
+class SizeClassAllocation : public Allocation {
+ public:
+  SizeClassAllocation(AllocationPtr underlying, size_t size, size_t index)
+      : Allocation(underlying->ptr(), size, underlying->place()),
+        underlying_(std::move(underlying)),
+        index_(index) {}
+
+  size_t index() const { return index_; }
+
+ private:
+  AllocationPtr underlying_;
+  size_t index_;
+};
+
+class ThreadLocalAllocator::CentralPool {
+ public:
+  explicit CentralPool(const std::shared_ptr<Allocator> &underlying_allocator)
+      : underlying_allocator_(underlying_allocator) {}
+
+  ~CentralPool() { ReleaseFreeBlocks(); }
+
+  const std::shared_ptr<Allocator> &underlying_allocator() const {
+    return underlying_allocator_;
+  }
+
+  AllocationPtr AllocateUnderlying(size_t size) {
+    try {
+      return underlying_allocator_->Allocate(size);
+    } catch (BadAlloc &) {
+      VLOG(2) << "Release the free blocks of the central pool and retry to "
+                 "allocate "
+              << size;
+      ReleaseFreeBlocks();
+      return underlying_allocator_->Allocate(size);
+    }
+  }
+
+  // Append at most num blocks of the index-th class to blocks, and at least
+  // one block if no exception is thrown.
+  void Fetch(size_t index, size_t num,
+             std::vector<SizeClassAllocation *> *blocks) {
+    auto &free_list = free_lists_[index];
+    {
+      std::lock_guard<std::mutex> guard(free_list.mtx);
+      size_t fetch_num = std::min(num, free_list.blocks.size());
+      blocks->insert(blocks->end(), free_list.blocks.end() - fetch_num,
+                     free_list.blocks.end());
+      free_list.blocks.resize(free_list.blocks.size() - fetch_num);
+      num -= fetch_num;
+    }
+
+    size_t size = SizeOfClass(index);
+    for (size_t i = 0; i < num; ++i) {
+      try {
+        blocks->emplace_back(
+            new SizeClassAllocation(AllocateUnderlying(size), size, index));
+      } catch (BadAlloc &) {
+        if (i == 0) throw;
+        break;
+      }
+    }
+  }
+
+  void Release(size_t index, SizeClassAllocation *const *blocks, size_t num) {
+    auto &free_list = free_lists_[index];
+    std::lock_guard<std::mutex> guard(free_list.mtx);
+    free_list.blocks.insert(free_list.blocks.end(), blocks, blocks + num);
+  }
+
+  void ReleaseFreeBlocks() {
+    for (auto &free_list : free_lists_) {
+      std::vector<SizeClassAllocation *> blocks;
+      {
+        std::lock_guard<std::mutex> guard(free_list.mtx);
+        blocks.swap(free_list.blocks);
+      }
+      for (auto *block : blocks) {
+        delete block;
+      }
+    }
+  }
+
+  void RegisterThreadCache(const std::shared_ptr<ThreadCache> &cache) {
+    std::lock_guard<std::mutex> guard(caches_mtx_);
+    caches_.emplace_back(cache);
+  }
+
+  std::vector<std::shared_ptr<ThreadCache>> ThreadCaches() {
+    std::vector<std::shared_ptr<ThreadCache>> caches;
+    std::lock_guard<std::mutex> guard(caches_mtx_);
+    for (auto it = caches_.begin(); it != caches_.end();) {
+      auto cache = it->lock();
+      if (cache) {
+        caches.emplace_back(std::move(cache));
+        ++it;
+      } else {
+        it = caches_.erase(it);
+      }
+    }
+    return caches;
+  }
+
+ private:
+  struct FreeList {
+    std::mutex mtx;
+    std::vector<SizeClassAllocation *> blocks;
+  };
+
+  std::shared_ptr<Allocator> underlying_allocator_;
+  FreeList free_lists_[kClassNum];
+
+  std::mutex caches_mtx_;
+  std::vector<std::weak_ptr<ThreadCache>> caches_;
+};
+
+// The cache is only changed by its thread, the counters are atomic so that
+// they can be read by the other threads.
+class ThreadLocalAllocator::ThreadCache {
+ public:
+  explicit ThreadCache(const std::shared_ptr<CentralPool> &central)
+      : central_(central),
+        underlying_allocator_(central->underlying_allocator()),
+        thread_id_(std::this_thread::get_id()) {}
+
+  ~ThreadCache() {
+    auto central = central_.lock();
+    for (size_t index = 0; index < kClassNum; ++index) {
+      auto &blocks = lists_[index];
+      if (central) {
+        central->Release(index, blocks.data(), blocks.size());
+      } else {
+        // The allocator is destroyed, underlying_allocator_ is still alive
+        // to free the blocks.
+        for (auto *block : blocks) {
+          delete block;
+        }
+      }
+    }
+  }
+
+  SizeClassAllocation *Pop(size_t index, CentralPool *central) {
+    auto &blocks = lists_[index];
+    if (blocks.empty()) {
+      Increase(&misses_, 1);
+      central->Fetch(index, BatchNum(index), &blocks);
+      Increase(&cached_bytes_, blocks.size() * SizeOfClass(index));
+    } else {
+      Increase(&hits_, 1);
+    }
+    auto *block = blocks.back();
+    blocks.pop_back();
+    Decrease(&cached_bytes_, SizeOfClass(index));
+    return block;
+  }
+
+  void Push(SizeClassAllocation *block, CentralPool *central) {
+    size_t index = block->index();
+    auto &blocks = lists_[index];
+    blocks.emplace_back(block);
+    Increase(&cached_bytes_, SizeOfClass(index));
+    size_t batch_num = BatchNum(index);
+    if (blocks.size() > 2 * batch_num) {
+      // return the blocks freed earliest
+      central->Release(index, blocks.data(), batch_num);
+      blocks.erase(blocks.begin(), blocks.begin() + batch_num);
+      Decrease(&cached_bytes_, batch_num * SizeOfClass(index));
+    }
+  }
+
+  ThreadCacheStat Stat() const {
+    return ThreadCacheStat{thread_id_, hits_.load(std::memory_order_relaxed),
+                           misses_.load(std::memory_order_relaxed),
+                           cached_bytes_.load(std::memory_order_relaxed)};
+  }
+
+  bool IsExpired() const { return central_.expired(); }
+
+ private:
+  template <typename T>
+  static void Increase(std::atomic<T> *counter, size_t n) {
+    counter->store(counter->load(std::memory_order_relaxed) + n,
+                   std::memory_order_relaxed);
+  }
+
+  template <typename T>
+  static void Decrease(std::atomic<T> *counter, size_t n) {
+    counter->store(counter->load(std::memory_order_relaxed) - n,
+                   std::memory_order_relaxed);
+  }
+
+  std::weak_ptr<CentralPool> central_;
+  std::shared_ptr<Allocator> underlying_allocator_;
+  std::thread::id thread_id_;
+  std::vector<SizeClassAllocation *> lists_[kClassNum];
+
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<size_t> cached_bytes_{0};
+};
+
+static std::atomic<uint64_t> g_allocator_id{0};
+
+ThreadLocalAllocator::ThreadLocalAllocator(
+    const std::shared_ptr<Allocator> &underlying_allocator)
+    : id_(++g_allocator_id),
+      central_(std::make_shared<CentralPool>(underlying_allocator)) {}
+
+ThreadLocalAllocator::~ThreadLocalAllocator() {}
+
+ThreadLocalAllocator::ThreadCache *ThreadLocalAllocator::GetThreadCache() {
+  // The caches of a thread, indexed by the id of allocators.
+  struct ThreadCacheMap {
+    std::unordered_map<uint64_t, std::shared_ptr<ThreadCache>> caches;
+    uint64_t last_id{0};
+    ThreadCache *last_cache{nullptr};
+  };
+  static thread_local ThreadCacheMap cache_map;
+  if (cache_map.last_id == id_) {
+    return cache_map.last_cache;
+  }
+
+  auto iter = cache_map.caches.find(id_);
+  if (iter == cache_map.caches.end()) {
+    // drop the caches of the destroyed allocators
+    for (auto it = cache_map.caches.begin(); it != cache_map.caches.end();) {
+      if (it->second->IsExpired()) {
+        it = cache_map.caches.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    auto cache = std::make_shared<ThreadCache>(central_);
+    central_->RegisterThreadCache(cache);
+    iter = cache_map.caches.emplace(id_, std::move(cache)).first;
+  }
+  cache_map.last_id = id_;
+  cache_map.last_cache = iter->second.get();
+  return cache_map.last_cache;
+}
+
+Allocation *ThreadLocalAllocator::AllocateImpl(size_t size) {
+  size_t index = SizeClassIndex(size);
+  if (index == kLargeIndex) {
+    auto underlying = central_->AllocateUnderlying(size);
+    size_t underlying_size = underlying->size();
+    return new SizeClassAllocation(std::move(underlying), underlying_size,
+                                   kLargeIndex);
+  }
+  return GetThreadCache()->Pop(index, central_.get());
+}
+
+void ThreadLocalAllocator::FreeImpl(Allocation *allocation) {
+  auto *block = static_cast<SizeClassAllocation *>(allocation);
+  if (block->index() == kLargeIndex) {
+    delete block;
+  } else {
+    GetThreadCache()->Push(block, central_.get());
+  }
+}
+
+std::vector<ThreadCacheStat> ThreadLocalAllocator::GetThreadCacheStats() const {
+  std::vector<ThreadCacheStat> stats;
+  for (auto &cache : central_->ThreadCaches()) {
+    stats.emplace_back(cache->Stat());
+  }
+  return stats;
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
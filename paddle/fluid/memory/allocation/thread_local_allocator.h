@@ -0,0 +1,89 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+struct ThreadCacheStat {
+  std::thread::id thread_id;
+  uint64_t hits;    // allocations served by the cache of the thread
+  uint64_t misses;  // allocations served by the central pool or underlying
+  size_t cached_bytes;
+
+  double HitRate() const {
+    return hits + misses == 0 ? 0 : static_cast<double>(hits) / (hits + misses);
+  }
+};
+
+/**
+ * ThreadLocalAllocator rounds the small requests up to size classes, and
+ * keeps the freed blocks in a cache of the freeing thread, so most of the
+ * allocations take no lock. The caches exchange blocks with a central pool
+ * in batches, and the central pool takes new blocks from the underlying
+ * allocator. A central free list has its own lock, so the threads allocating
+ * different size classes do not wait for each other.
+ *
+ * There are 4 size classes between two powers of 2, which wastes at most
+ * 25% of a block. The requests larger than kMaxClassSize go to the
+ * underlying allocator directly.
+ *
+ * The blocks are kept by the central pool until the allocator is destroyed,
+ * or the underlying allocator runs out of memory.
+ */
+class ThreadLocalAllocator : public Allocator {
+ public:
+  static constexpr size_t kMinClassSize = 64;
+  static constexpr size_t kMaxClassSize = 1 << 20;
+
+  explicit ThreadLocalAllocator(
+      const std::shared_ptr<Allocator> &underlying_allocator);
+
+  ~ThreadLocalAllocator();
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+  // The caches of the live threads which used this allocator.
+  std::vector<ThreadCacheStat> GetThreadCacheStats() const;
+
+  static size_t SizeClassIndex(size_t size);
+
+  static size_t SizeOfClass(size_t index);
+
+ protected:
+  Allocation *AllocateImpl(size_t size) override;
+
+  void FreeImpl(Allocation *allocation) override;
+
+ private:
+  class ThreadCache;
+  class CentralPool;
+
+  ThreadCache *GetThreadCache();
+
+  uint64_t id_;
+  std::shared_ptr<CentralPool> central_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
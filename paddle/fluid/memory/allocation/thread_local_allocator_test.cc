@@ -0,0 +1,164 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/thread_local_allocator.h"
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/allocation/cpu_allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+TEST(ThreadLocalAllocator, SizeClass) {
+  using A = ThreadLocalAllocator;
+  EXPECT_EQ(A::SizeClassIndex(1), 0UL);
+  EXPECT_EQ(A::SizeOfClass(0), A::kMinClassSize);
+  EXPECT_EQ(A::SizeOfClass(A::SizeClassIndex(A::kMaxClassSize)),
+            A::kMaxClassSize);
+  size_t last_index = 0;
+  for (size_t size = 1; size <= A::kMaxClassSize; size += 7) {
+    size_t index = A::SizeClassIndex(size);
+    size_t class_size = A::SizeOfClass(index);
+    ASSERT_GE(class_size, size);
+    ASSERT_LE(class_size, std::max(size * 5 / 4 + 1, A::kMinClassSize));
+    ASSERT_GE(index, last_index);
+    last_index = index;
+    if (index > 0) {
+      ASSERT_LT(A::SizeOfClass(index - 1), size);
+    }
+  }
+}
+
+TEST(ThreadLocalAllocator, ReuseInThread) {
+  ThreadLocalAllocator allocator(std::make_shared<CPUAllocator>());
+  void* ptr = nullptr;
+  {
+    auto allocation = allocator.Allocate(100);
+    ASSERT_EQ(allocation->size(), ThreadLocalAllocator::SizeOfClass(
+                                      ThreadLocalAllocator::SizeClassIndex(100)));
+    ptr = allocation->ptr();
+  }
+  for (int i = 0; i < 10; ++i) {
+    auto allocation = allocator.Allocate(110);
+    ASSERT_EQ(allocation->ptr(), ptr);
+  }
+
+  // the large allocations are not cached
+  {
+    auto allocation = allocator.Allocate(ThreadLocalAllocator::kMaxClassSize + 1);
+    ASSERT_GE(allocation->size(), ThreadLocalAllocator::kMaxClassSize + 1);
+  }
+
+  auto stats = allocator.GetThreadCacheStats();
+  ASSERT_EQ(stats.size(), 1UL);
+  EXPECT_EQ(stats[0].thread_id, std::this_thread::get_id());
+  EXPECT_EQ(stats[0].misses, 1UL);
+  EXPECT_EQ(stats[0].hits, 10UL);
+  EXPECT_GT(stats[0].cached_bytes, 0UL);
+}
+
+TEST(ThreadLocalAllocator, MultiThread) {
+  auto allocator =
+      std::make_shared<ThreadLocalAllocator>(std::make_shared<CPUAllocator>());
+  const int thread_num = 4;
+  const int alloc_num = 2000;
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  int finished = 0;
+  bool exit = false;
+  // The allocations are freed by another thread than the allocating one.
+  std::vector<AllocationPtr> shared(thread_num * 16);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t] {
+      std::mt19937 engine(t);
+      std::uniform_int_distribution<size_t> dist(1, 8192);
+      std::vector<AllocationPtr> allocations;
+      for (int i = 0; i < alloc_num; ++i) {
+        size_t size = dist(engine);
+        allocations.emplace_back(allocator->Allocate(size));
+        auto* data = static_cast<uint8_t*>(allocations.back()->ptr());
+        data[0] = data[size - 1] = static_cast<uint8_t>(t);
+        if (allocations.size() > 64) {
+          allocations.erase(allocations.begin(),
+                            allocations.begin() + engine() % 64);
+        }
+      }
+      for (int i = 0; i < 16; ++i) {
+        std::lock_guard<std::mutex> guard(mtx);
+        shared[(t + 1) % thread_num * 16 + i].reset();
+        shared[t * 16 + i] = allocator->Allocate(64);
+      }
+      std::unique_lock<std::mutex> lock(mtx);
+      ++finished;
+      cv.notify_all();
+      cv.wait(lock, [&] { return exit; });
+    });
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [&] { return finished == thread_num; });
+    auto stats = allocator->GetThreadCacheStats();
+    ASSERT_EQ(stats.size(), static_cast<size_t>(thread_num));
+    for (auto& stat : stats) {
+      EXPECT_EQ(stat.hits + stat.misses,
+                static_cast<uint64_t>(alloc_num + 16));
+      EXPECT_GT(stat.HitRate(), 0.5);
+    }
+    exit = true;
+    cv.notify_all();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // the caches of the exited threads are returned to the central pool
+  EXPECT_TRUE(allocator->GetThreadCacheStats().empty());
+  shared.clear();
+}
+
+TEST(ThreadLocalAllocator, DestroyBeforeThreadExit) {
+  auto allocator =
+      std::make_shared<ThreadLocalAllocator>(std::make_shared<CPUAllocator>());
+  std::mutex mtx;
+  std::condition_variable cv;
+  int step = 0;
+  std::thread thread([&] {
+    allocator->Allocate(1024);
+    std::unique_lock<std::mutex> lock(mtx);
+    step = 1;
+    cv.notify_all();
+    // the cache is released after the allocator is destroyed
+    cv.wait(lock, [&] { return step == 2; });
+  });
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [&] { return step == 1; });
+    allocator.reset();
+    step = 2;
+    cv.notify_all();
+  }
+  thread.join();
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -31,5 +31,9 @@ AllocationPtr Alloc(const platform::Place &place, size_t size) {
   return allocation::AllocatorFacade::Instance().Alloc(place, size);
 }
 
+std::vector<ThreadCacheStat> GetThreadCacheStats(const platform::Place &place) {
+  return allocation::AllocatorFacade::Instance().GetThreadCacheStats(place);
+}
+
 }  // namespace memory
 }  // namespace paddle
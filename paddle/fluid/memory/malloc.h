@@ -15,7 +15,9 @@ limitations under the License. */
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/memory/allocation/thread_local_allocator.h"
 #include "paddle/fluid/platform/place.h"
 namespace paddle {
 
@@ -28,6 +30,7 @@ namespace memory {
 using allocation::Allocation;
 using allocation::Allocator;
 using allocation::AllocationPtr;
+using allocation::ThreadCacheStat;
 
 extern std::shared_ptr<Allocation> AllocShared(const platform::Place& place,
                                                size_t size);
@@ -36,5 +39,10 @@ extern AllocationPtr Alloc(const platform::Place& place, size_t size);
 
 extern AllocationPtr Alloc(const platform::DeviceContext& dev_ctx, size_t size);
 
+// The hit rates of the thread caches when FLAGS_allocator_strategy is
+// thread_local, one for each live thread which allocated on place.
+extern std::vector<ThreadCacheStat> GetThreadCacheStats(
+    const platform::Place& place);
+
 }  // namespace memory
 }  // namespace paddle
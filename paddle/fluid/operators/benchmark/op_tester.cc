@@ -276,20 +276,20 @@ void OpTester::SetupTensor(framework::LoDTensor *tensor,
   }
 
   if (initializer == "random") {
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int64_t i = 0; i < tensor->numel(); ++i) {
       cpu_ptr[i] = static_cast<T>(uniform_dist(rng) * (upper - lower) + lower);
     }
   } else if (initializer == "natural") {
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int64_t i = 0; i < tensor->numel(); ++i) {
       cpu_ptr[i] = static_cast<T>(lower + i);
     }
   } else if (initializer == "zeros") {
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int64_t i = 0; i < tensor->numel(); ++i) {
       cpu_ptr[i] = static_cast<T>(0);
     }
   } else if (initializer == "file") {
     std::ifstream is(filename);
-    for (size_t i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int64_t i = 0; i < tensor->numel(); ++i) {
       T value;
       is >> value;
       cpu_ptr[i] = static_cast<T>(value);
@@ -333,20 +333,22 @@ void OpTester::CreateVariables(framework::Scope *scope) {
     auto *var = scope->Var(var_name);
     auto *tensor = var->GetMutable<framework::LoDTensor>();
     const auto &data_type = var_desc->GetDataType();
+    const auto &range = item.second.range;
     if (data_type == framework::proto::VarType::INT32) {
-      SetupTensor<int>(tensor, shape, 0, 1, item.second.initializer,
+      SetupTensor<int>(tensor, shape, static_cast<int>(range[0]),
+                       static_cast<int>(range[1]), item.second.initializer,
                        item.second.filename);
     } else if (data_type == framework::proto::VarType::INT64) {
-      SetupTensor<int64_t>(tensor, shape, 0, 1, item.second.initializer,
-                           item.second.filename);
+      SetupTensor<int64_t>(tensor, shape, static_cast<int64_t>(range[0]),
+                           static_cast<int64_t>(range[1]),
+                           item.second.initializer, item.second.filename);
     } else if (data_type == framework::proto::VarType::FP32) {
-      SetupTensor<float>(tensor, shape, static_cast<float>(0.0),
-                         static_cast<float>(1.0), item.second.initializer,
+      SetupTensor<float>(tensor, shape, static_cast<float>(range[0]),
+                         static_cast<float>(range[1]), item.second.initializer,
                          item.second.filename);
     } else if (data_type == framework::proto::VarType::FP64) {
-      SetupTensor<double>(tensor, shape, static_cast<double>(0.0),
-                          static_cast<double>(1.0), item.second.initializer,
-                          item.second.filename);
+      SetupTensor<double>(tensor, shape, range[0], range[1],
+                          item.second.initializer, item.second.filename);
     } else {
       PADDLE_THROW("Unsupported dtype %d.", data_type);
     }
@@ -56,6 +56,8 @@ OpInputConfig::OpInputConfig(std::istream& is) {
         ParseDims(is);
       } else if (sep == "lod" || sep == "lod:") {
         ParseLoD(is);
+      } else if (sep == "range" || sep == "range:") {
+        ParseRange(is);
       } else if (sep == "filename") {
         is >> filename;
         EraseEndSep(&filename);
@@ -151,6 +153,25 @@ void OpInputConfig::ParseLoD(std::istream& is) {
   }
 }
 
+void OpInputConfig::ParseRange(std::istream& is) {
+  std::string range_str;
+  is >> range_str;
+  EraseEndSep(&range_str);
+
+  range.clear();
+  std::string token;
+  std::istringstream token_stream(range_str);
+  while (std::getline(token_stream, token, ',')) {
+    range.push_back(std::stod(token));
+  }
+  PADDLE_ENFORCE_EQ(range.size(), 2U,
+                    "The range of input %s should be lower,upper, but got %s",
+                    name.c_str(), range_str.c_str());
+  PADDLE_ENFORCE_LT(range[0], range[1],
+                    "The range of input %s should be lower,upper, but got %s",
+                    name.c_str(), range_str.c_str());
+}
+
 OpTesterConfig::OpTesterConfig(const std::string& filename) {
   std::ifstream fin(filename, std::ios::in | std::ios::binary);
   PADDLE_ENFORCE(static_cast<bool>(fin), "Cannot open file %s",
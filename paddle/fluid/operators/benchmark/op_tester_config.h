@@ -32,6 +32,7 @@ struct OpInputConfig {
   void ParseInitializer(std::istream& is);
   void ParseDims(std::istream& is);
   void ParseLoD(std::istream& is);
+  void ParseRange(std::istream& is);
 
   std::string name;
   std::string dtype{"fp32"};  // int32/int, int64/long, fp32/float, fp64/double
@@ -39,6 +40,8 @@ struct OpInputConfig {
   std::string filename{""};
   std::vector<int64_t> dims;
   std::vector<std::vector<size_t>> lod;
+  // [lower, upper) of the values of the random and natural initializers.
+  std::vector<double> range{0.0, 1.0};
 };
 
 struct OpTesterConfig {
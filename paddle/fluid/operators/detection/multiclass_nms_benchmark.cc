@@ -0,0 +1,201 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Measure multiclass_nms on the shapes of SSD and YOLOv3, against the NMS
+// engine it used before, which sorted the candidates with std::stable_sort
+// and erased them one by one from the front. The selected boxes of both
+// engines are checked to be the same.
+// Usage:
+//   multiclass_nms_benchmark --batch=8 --repeat=10
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/operators/detection/nms_util.h"
+#include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int32(batch, 8, "The number of images.");
+DEFINE_int32(repeat, 10, "The number of runs of each engine.");
+
+USE_NO_KERNEL_OP(multiclass_nms);
+
+namespace paddle {
+namespace operators {
+
+struct NMSShape {
+  std::string name;
+  int64_t num_boxes;
+  int64_t class_num;
+  int nms_top_k;
+  int keep_top_k;
+  float nms_threshold;
+};
+
+static bool LegacySortScorePairDescend(const std::pair<float, int>& pair1,
+                                       const std::pair<float, int>& pair2) {
+  return pair1.first > pair2.first;
+}
+
+static float LegacyJaccardOverlap(const float* box1, const float* box2) {
+  if (box2[0] > box1[2] || box2[2] < box1[0] || box2[1] > box1[3] ||
+      box2[3] < box1[1]) {
+    return 0.f;
+  }
+  const float inter_area = (std::min(box1[2], box2[2]) -
+                            std::max(box1[0], box2[0])) *
+                           (std::min(box1[3], box2[3]) -
+                            std::max(box1[1], box2[1]));
+  return inter_area / (BBoxArea<float>(box1, true) +
+                       BBoxArea<float>(box2, true) - inter_area);
+}
+
+// The NMS engine of multiclass_nms before it was rewritten.
+static void LegacyNMSFast(const float* bboxes, const float* scores,
+                          int64_t num_boxes, float score_threshold,
+                          float nms_threshold, int top_k,
+                          std::vector<int>* selected_indices) {
+  std::vector<std::pair<float, int>> sorted_indices;
+  for (int64_t i = 0; i < num_boxes; ++i) {
+    if (scores[i] > score_threshold) {
+      sorted_indices.push_back(std::make_pair(scores[i], i));
+    }
+  }
+  std::stable_sort(sorted_indices.begin(), sorted_indices.end(),
+                   LegacySortScorePairDescend);
+  if (top_k > -1 && top_k < static_cast<int>(sorted_indices.size())) {
+    sorted_indices.resize(top_k);
+  }
+
+  selected_indices->clear();
+  while (sorted_indices.size() != 0) {
+    const int idx = sorted_indices.front().second;
+    bool keep = true;
+    for (size_t k = 0; k < selected_indices->size() && keep; ++k) {
+      const int kept_idx = (*selected_indices)[k];
+      keep = LegacyJaccardOverlap(bboxes + idx * 4, bboxes + kept_idx * 4) <=
+             nms_threshold;
+    }
+    if (keep) {
+      selected_indices->push_back(idx);
+    }
+    sorted_indices.erase(sorted_indices.begin());
+  }
+}
+
+static void Run(const NMSShape& shape) {
+  const int64_t batch = FLAGS_batch;
+  const int64_t num_boxes = shape.num_boxes;
+  const int64_t class_num = shape.class_num;
+  const float score_threshold = 0.01f;
+
+  framework::Scope scope;
+  platform::CPUPlace place;
+  auto* boxes = scope.Var("boxes")->GetMutable<framework::LoDTensor>();
+  auto* scores = scope.Var("scores")->GetMutable<framework::LoDTensor>();
+  scope.Var("out")->GetMutable<framework::LoDTensor>();
+  float* boxes_data = boxes->mutable_data<float>(
+      framework::make_ddim({batch, num_boxes, 4}), place);
+  float* scores_data = scores->mutable_data<float>(
+      framework::make_ddim({batch, class_num, num_boxes}), place);
+
+  // The boxes of the priors cluster around the objects, and most of the
+  // scores are low.
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  for (int64_t i = 0; i < batch * num_boxes; ++i) {
+    float* box = boxes_data + i * 4;
+    float cx = uniform(rng), cy = uniform(rng);
+    float w = 0.02f + 0.3f * uniform(rng), h = 0.02f + 0.3f * uniform(rng);
+    box[0] = cx - w / 2;
+    box[1] = cy - h / 2;
+    box[2] = cx + w / 2;
+    box[3] = cy + h / 2;
+  }
+  for (int64_t i = 0; i < batch * class_num * num_boxes; ++i) {
+    float score = uniform(rng);
+    scores_data[i] = score * score * score * score;
+  }
+
+  std::vector<int> legacy_indices, indices;
+  platform::Timer legacy_timer, engine_timer, op_timer;
+  for (int r = 0; r < FLAGS_repeat; ++r) {
+    for (int64_t i = 0; i < batch; ++i) {
+      for (int64_t c = 1; c < class_num; ++c) {
+        const float* image_boxes = boxes_data + i * num_boxes * 4;
+        const float* class_scores =
+            scores_data + (i * class_num + c) * num_boxes;
+        legacy_timer.Resume();
+        LegacyNMSFast(image_boxes, class_scores, num_boxes, score_threshold,
+                      shape.nms_threshold, shape.nms_top_k, &legacy_indices);
+        legacy_timer.Pause();
+        engine_timer.Resume();
+        NMSFast<float>(image_boxes, 4, class_scores, 1, num_boxes, 4,
+                       score_threshold, shape.nms_threshold, 1.f,
+                       shape.nms_top_k, true, &indices);
+        engine_timer.Pause();
+        CHECK(legacy_indices == indices)
+            << "The selected boxes of image " << i << " class " << c
+            << " are different";
+      }
+    }
+  }
+
+  framework::AttributeMap attrs;
+  attrs["background_label"] = 0;
+  attrs["score_threshold"] = score_threshold;
+  attrs["nms_top_k"] = shape.nms_top_k;
+  attrs["nms_threshold"] = shape.nms_threshold;
+  attrs["nms_eta"] = 1.f;
+  attrs["keep_top_k"] = shape.keep_top_k;
+  attrs["normalized"] = true;
+  auto op = framework::OpRegistry::CreateOp(
+      "multiclass_nms", {{"BBoxes", {"boxes"}}, {"Scores", {"scores"}}},
+      {{"Out", {"out"}}}, attrs);
+  op->Run(scope, place);
+  for (int r = 0; r < FLAGS_repeat; ++r) {
+    op_timer.Resume();
+    op->Run(scope, place);
+    op_timer.Pause();
+  }
+
+  LOG(INFO) << shape.name << " [" << batch << ", " << class_num << ", "
+            << num_boxes << "]: legacy NMS "
+            << legacy_timer.ElapsedMS() / FLAGS_repeat << " ms, new NMS "
+            << engine_timer.ElapsedMS() / FLAGS_repeat
+            << " ms, multiclass_nms op "
+            << op_timer.ElapsedMS() / FLAGS_repeat << " ms";
+}
+
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  paddle::platform::DeviceContextPool::Init({paddle::platform::CPUPlace()});
+  std::vector<paddle::operators::NMSShape> shapes = {
+      {"MobileNet-SSD", 1917, 21, 400, 200, 0.45f},
+      {"SSD300", 8732, 21, 400, 200, 0.45f},
+      {"YOLOv3-608", 22743, 80, 1000, 100, 0.45f},
+  };
+  for (auto& shape : shapes) {
+    paddle::operators::Run(shape);
+  }
+  return 0;
+}
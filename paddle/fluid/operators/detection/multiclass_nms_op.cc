@@ -13,7 +13,7 @@ limitations under the License. */
 
 #include <glog/logging.h>
 #include "paddle/fluid/framework/op_registry.h"
-#include "paddle/fluid/operators/detection/poly_util.h"
+#include "paddle/fluid/operators/detection/nms_util.h"
 
 namespace paddle {
 namespace operators {
@@ -91,286 +91,107 @@ bool SortScorePairDescend(const std::pair<float, T>& pair1,
   return pair1.first > pair2.first;
 }
 
-template <class T>
-static inline void GetMaxScoreIndex(
-    const std::vector<T>& scores, const T threshold, int top_k,
-    std::vector<std::pair<T, int>>* sorted_indices) {
-  for (size_t i = 0; i < scores.size(); ++i) {
-    if (scores[i] > threshold) {
-      sorted_indices->push_back(std::make_pair(scores[i], i));
-    }
-  }
-  // Sort the score pair according to the scores in descending order
-  std::stable_sort(sorted_indices->begin(), sorted_indices->end(),
-                   SortScorePairDescend<int>);
-  // Keep top_k scores if needed.
-  if (top_k > -1 && top_k < static_cast<int>(sorted_indices->size())) {
-    sorted_indices->resize(top_k);
-  }
-}
-
-template <class T>
-static inline T BBoxArea(const T* box, const bool normalized) {
-  if (box[2] < box[0] || box[3] < box[1]) {
-    // If coordinate values are is invalid
-    // (e.g. xmax < xmin or ymax < ymin), return 0.
-    return static_cast<T>(0.);
-  } else {
-    const T w = box[2] - box[0];
-    const T h = box[3] - box[1];
-    if (normalized) {
-      return w * h;
-    } else {
-      // If coordinate values are not within range [0, 1].
-      return (w + 1) * (h + 1);
-    }
-  }
-}
-
-template <class T>
-static inline T JaccardOverlap(const T* box1, const T* box2,
-                               const bool normalized) {
-  if (box2[0] > box1[2] || box2[2] < box1[0] || box2[1] > box1[3] ||
-      box2[3] < box1[1]) {
-    return static_cast<T>(0.);
-  } else {
-    const T inter_xmin = std::max(box1[0], box2[0]);
-    const T inter_ymin = std::max(box1[1], box2[1]);
-    const T inter_xmax = std::min(box1[2], box2[2]);
-    const T inter_ymax = std::min(box1[3], box2[3]);
-    T norm = normalized ? static_cast<T>(0.) : static_cast<T>(1.);
-    T inter_w = inter_xmax - inter_xmin + norm;
-    T inter_h = inter_ymax - inter_ymin + norm;
-    const T inter_area = inter_w * inter_h;
-    const T bbox1_area = BBoxArea<T>(box1, normalized);
-    const T bbox2_area = BBoxArea<T>(box2, normalized);
-    return inter_area / (bbox1_area + bbox2_area - inter_area);
-  }
-}
-
-template <class T>
-T PolyIoU(const T* box1, const T* box2, const size_t box_size,
-          const bool normalized) {
-  T bbox1_area = PolyArea<T>(box1, box_size, normalized);
-  T bbox2_area = PolyArea<T>(box2, box_size, normalized);
-  T inter_area = PolyOverlapArea<T>(box1, box2, box_size, normalized);
-  if (bbox1_area == 0 || bbox2_area == 0 || inter_area == 0) {
-    // If coordinate values are invalid
-    // if area size <= 0,  return 0.
-    return T(0.);
-  } else {
-    return inter_area / (bbox1_area + bbox2_area - inter_area);
-  }
-}
-
-template <class T>
-void SliceOneClass(const platform::DeviceContext& ctx,
-                   const framework::Tensor& items, const int class_id,
-                   framework::Tensor* one_class_item) {
-  T* item_data = one_class_item->mutable_data<T>(ctx.GetPlace());
-  const T* items_data = items.data<T>();
-  const int64_t num_item = items.dims()[0];
-  const int class_num = items.dims()[1];
-  if (items.dims().size() == 3) {
-    int item_size = items.dims()[2];
-    for (int i = 0; i < num_item; ++i) {
-      std::memcpy(item_data + i * item_size,
-                  items_data + i * class_num * item_size + class_id * item_size,
-                  sizeof(T) * item_size);
-    }
-  } else {
-    for (int i = 0; i < num_item; ++i) {
-      item_data[i] = items_data[i * class_num + class_id];
-    }
-  }
-}
-
 template <typename T>
 class MultiClassNMSKernel : public framework::OpKernel<T> {
  public:
-  void NMSFast(const Tensor& bbox, const Tensor& scores,
-               const T score_threshold, const T nms_threshold, const T eta,
-               const int64_t top_k, std::vector<int>* selected_indices,
-               const bool normalized) const {
-    // The total boxes for each instance.
-    int64_t num_boxes = bbox.dims()[0];
-    // 4: [xmin ymin xmax ymax]
-    // 8: [x1 y1 x2 y2 x3 y3 x4 y4]
-    // 16, 24, or 32: [x1 y1 x2 y2 ...  xn yn], n = 8, 12 or 16
-    int64_t box_size = bbox.dims()[1];
-
-    std::vector<T> scores_data(num_boxes);
-    std::copy_n(scores.data<T>(), num_boxes, scores_data.begin());
-    std::vector<std::pair<T, int>> sorted_indices;
-    GetMaxScoreIndex(scores_data, score_threshold, top_k, &sorted_indices);
-
-    selected_indices->clear();
-    T adaptive_threshold = nms_threshold;
-    const T* bbox_data = bbox.data<T>();
-
-    while (sorted_indices.size() != 0) {
-      const int idx = sorted_indices.front().second;
-      bool keep = true;
-      for (size_t k = 0; k < selected_indices->size(); ++k) {
-        if (keep) {
-          const int kept_idx = (*selected_indices)[k];
-          T overlap = T(0.);
-          // 4: [xmin ymin xmax ymax]
-          if (box_size == 4) {
-            overlap =
-                JaccardOverlap<T>(bbox_data + idx * box_size,
-                                  bbox_data + kept_idx * box_size, normalized);
-          }
-          // 8: [x1 y1 x2 y2 x3 y3 x4 y4] or 16, 24, 32
-          if (box_size == 8 || box_size == 16 || box_size == 24 ||
-              box_size == 32) {
-            overlap = PolyIoU<T>(bbox_data + idx * box_size,
-                                 bbox_data + kept_idx * box_size, box_size,
-                                 normalized);
-          }
-          keep = overlap <= adaptive_threshold;
-        } else {
-          break;
-        }
-      }
-      if (keep) {
-        selected_indices->push_back(idx);
-      }
-      sorted_indices.erase(sorted_indices.begin());
-      if (keep && eta < 1 && adaptive_threshold > 0.5) {
-        adaptive_threshold *= eta;
-      }
-    }
+  // The scores and the boxes of an image. For the 3-D Scores of [N, C, M],
+  // the i-th box of class c is at bboxes[i * box_size], and its score is at
+  // scores[c * M + i]. For the LoD Scores of [M, C] and BBoxes of [M, C, 4],
+  // they are at bboxes[(i * C + c) * 4] and scores[i * C + c].
+  struct ImageSlice {
+    const T* scores;
+    const T* bboxes;
+    int64_t num_boxes;
+    int64_t class_num;
+    // the index of the first box in the batch, used by the Index output
+    int64_t offset;
+  };
+
+  const T* ClassScores(const ImageSlice& image, const int scores_size,
+                       const int c, int64_t* stride) const {
+    *stride = scores_size == 3 ? 1 : image.class_num;
+    return scores_size == 3 ? image.scores + c * image.num_boxes
+                            : image.scores + c;
   }
 
-  void MultiClassNMS(const framework::ExecutionContext& ctx,
-                     const Tensor& scores, const Tensor& bboxes,
-                     const int scores_size,
-                     std::map<int, std::vector<int>>* indices,
-                     int* num_nmsed_out) const {
-    int64_t background_label = ctx.Attr<int>("background_label");
-    int64_t nms_top_k = ctx.Attr<int>("nms_top_k");
-    int64_t keep_top_k = ctx.Attr<int>("keep_top_k");
-    bool normalized = ctx.Attr<bool>("normalized");
-    T nms_threshold = static_cast<T>(ctx.Attr<float>("nms_threshold"));
-    T nms_eta = static_cast<T>(ctx.Attr<float>("nms_eta"));
-    T score_threshold = static_cast<T>(ctx.Attr<float>("score_threshold"));
-    auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+  const T* ClassBoxes(const ImageSlice& image, const int scores_size,
+                      const int64_t box_size, const int c,
+                      int64_t* stride) const {
+    *stride = scores_size == 3 ? box_size : image.class_num * box_size;
+    return scores_size == 3 ? image.bboxes : image.bboxes + c * box_size;
+  }
 
+  // Keep the keep_top_k detections of the highest scores of an image, and
+  // return the number of the detections kept.
+  int KeepTopK(const ImageSlice& image, const int scores_size,
+               const int64_t keep_top_k,
+               std::map<int, std::vector<int>>* indices) const {
     int num_det = 0;
-
-    int64_t class_num = scores_size == 3 ? scores.dims()[0] : scores.dims()[1];
-    Tensor bbox_slice, score_slice;
-    for (int64_t c = 0; c < class_num; ++c) {
-      if (c == background_label) continue;
-      if (scores_size == 3) {
-        score_slice = scores.Slice(c, c + 1);
-        bbox_slice = bboxes;
-      } else {
-        score_slice.Resize({scores.dims()[0], 1});
-        bbox_slice.Resize({scores.dims()[0], 4});
-        SliceOneClass<T>(dev_ctx, scores, c, &score_slice);
-        SliceOneClass<T>(dev_ctx, bboxes, c, &bbox_slice);
-      }
-      NMSFast(bbox_slice, score_slice, score_threshold, nms_threshold, nms_eta,
-              nms_top_k, &((*indices)[c]), normalized);
-      if (scores_size == 2) {
-        std::stable_sort((*indices)[c].begin(), (*indices)[c].end());
-      }
-      num_det += (*indices)[c].size();
+    for (const auto& it : *indices) {
+      num_det += it.second.size();
+    }
+    if (keep_top_k <= -1 || num_det <= keep_top_k) {
+      return num_det;
     }
 
-    *num_nmsed_out = num_det;
-    const T* scores_data = scores.data<T>();
-    if (keep_top_k > -1 && num_det > keep_top_k) {
-      const T* sdata;
-      std::vector<std::pair<float, std::pair<int, int>>> score_index_pairs;
-      for (const auto& it : *indices) {
-        int label = it.first;
-        if (scores_size == 3) {
-          sdata = scores_data + label * scores.dims()[1];
-        } else {
-          score_slice.Resize({scores.dims()[0], 1});
-          SliceOneClass<T>(dev_ctx, scores, label, &score_slice);
-          sdata = score_slice.data<T>();
-        }
-        const std::vector<int>& label_indices = it.second;
-        for (size_t j = 0; j < label_indices.size(); ++j) {
-          int idx = label_indices[j];
-          score_index_pairs.push_back(
-              std::make_pair(sdata[idx], std::make_pair(label, idx)));
-        }
-      }
-      // Keep top k results per image.
-      std::stable_sort(score_index_pairs.begin(), score_index_pairs.end(),
-                       SortScorePairDescend<std::pair<int, int>>);
-      score_index_pairs.resize(keep_top_k);
-
-      // Store the new indices.
-      std::map<int, std::vector<int>> new_indices;
-      for (size_t j = 0; j < score_index_pairs.size(); ++j) {
-        int label = score_index_pairs[j].second.first;
-        int idx = score_index_pairs[j].second.second;
-        new_indices[label].push_back(idx);
+    std::vector<std::pair<float, std::pair<int, int>>> score_index_pairs;
+    score_index_pairs.reserve(num_det);
+    for (const auto& it : *indices) {
+      int label = it.first;
+      int64_t stride;
+      const T* sdata = ClassScores(image, scores_size, label, &stride);
+      const std::vector<int>& label_indices = it.second;
+      for (size_t j = 0; j < label_indices.size(); ++j) {
+        int idx = label_indices[j];
+        score_index_pairs.push_back(
+            std::make_pair(sdata[idx * stride], std::make_pair(label, idx)));
       }
-      if (scores_size == 2) {
-        for (const auto& it : new_indices) {
-          int label = it.first;
-          std::stable_sort(new_indices[label].begin(),
-                           new_indices[label].end());
-        }
+    }
+    // Keep top k results per image.
+    std::stable_sort(score_index_pairs.begin(), score_index_pairs.end(),
+                     SortScorePairDescend<std::pair<int, int>>);
+    score_index_pairs.resize(keep_top_k);
+
+    // Store the new indices.
+    std::map<int, std::vector<int>> new_indices;
+    for (size_t j = 0; j < score_index_pairs.size(); ++j) {
+      int label = score_index_pairs[j].second.first;
+      int idx = score_index_pairs[j].second.second;
+      new_indices[label].push_back(idx);
+    }
+    if (scores_size == 2) {
+      for (auto& it : new_indices) {
+        std::sort(it.second.begin(), it.second.end());
       }
-      new_indices.swap(*indices);
-      *num_nmsed_out = keep_top_k;
     }
+    new_indices.swap(*indices);
+    return keep_top_k;
   }
 
-  void MultiClassOutput(const platform::DeviceContext& ctx,
-                        const Tensor& scores, const Tensor& bboxes,
+  void MultiClassOutput(const ImageSlice& image,
                         const std::map<int, std::vector<int>>& selected_indices,
-                        const int scores_size, Tensor* outs,
-                        int* oindices = nullptr, const int offset = 0) const {
-    int64_t class_num = scores.dims()[1];
-    int64_t predict_dim = scores.dims()[1];
-    int64_t box_size = bboxes.dims()[1];
-    if (scores_size == 2) {
-      box_size = bboxes.dims()[2];
-    }
+                        const int scores_size, const int64_t box_size,
+                        T* odata, int* oindices) const {
     int64_t out_dim = box_size + 2;
-    auto* scores_data = scores.data<T>();
-    auto* bboxes_data = bboxes.data<T>();
-    auto* odata = outs->data<T>();
-    const T* sdata;
-    Tensor bbox;
-    bbox.Resize({scores.dims()[0], box_size});
     int count = 0;
     for (const auto& it : selected_indices) {
       int label = it.first;
-      const std::vector<int>& indices = it.second;
-      if (scores_size == 2) {
-        SliceOneClass<T>(ctx, bboxes, label, &bbox);
-      } else {
-        sdata = scores_data + label * predict_dim;
-      }
-      for (size_t j = 0; j < indices.size(); ++j) {
-        int idx = indices[j];
-        odata[count * out_dim] = label;  // label
-        const T* bdata;
-        if (scores_size == 3) {
-          bdata = bboxes_data + idx * box_size;
-          odata[count * out_dim + 1] = sdata[idx];  // score
-          if (oindices != nullptr) {
-            oindices[count] = offset + idx;
-          }
-        } else {
-          bdata = bbox.data<T>() + idx * box_size;
-          odata[count * out_dim + 1] = *(scores_data + idx * class_num + label);
-          if (oindices != nullptr) {
-            oindices[count] = offset + idx * class_num + label;
-          }
+      int64_t score_stride, bbox_stride;
+      const T* sdata = ClassScores(image, scores_size, label, &score_stride);
+      const T* bdata =
+          ClassBoxes(image, scores_size, box_size, label, &bbox_stride);
+      for (int idx : it.second) {
+        odata[count * out_dim] = label;                           // label
+        odata[count * out_dim + 1] = sdata[idx * score_stride];  // score
+        if (oindices != nullptr) {
+          oindices[count] =
+              scores_size == 3
+                  ? image.offset + idx
+                  : (image.offset + idx) * image.class_num + label;
         }
         // xmin, ymin, xmax, ymax or multi-points coordinates
-        std::memcpy(odata + count * out_dim + 2, bdata, box_size * sizeof(T));
+        std::memcpy(odata + count * out_dim + 2, bdata + idx * bbox_stride,
+                    box_size * sizeof(T));
         count++;
       }
     }
@@ -383,33 +204,81 @@ class MultiClassNMSKernel : public framework::OpKernel<T> {
     bool return_index = ctx.HasOutput("Index") ? true : false;
     auto index = ctx.Output<LoDTensor>("Index");
     auto score_dims = scores->dims();
-    auto score_size = score_dims.size();
-    auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    int score_size = score_dims.size();
+
+    int64_t background_label = ctx.Attr<int>("background_label");
+    int64_t nms_top_k = ctx.Attr<int>("nms_top_k");
+    int64_t keep_top_k = ctx.Attr<int>("keep_top_k");
+    bool normalized = ctx.Attr<bool>("normalized");
+    T nms_threshold = static_cast<T>(ctx.Attr<float>("nms_threshold"));
+    T nms_eta = static_cast<T>(ctx.Attr<float>("nms_eta"));
+    T score_threshold = static_cast<T>(ctx.Attr<float>("score_threshold"));
 
-    std::vector<std::map<int, std::vector<int>>> all_indices;
-    std::vector<size_t> batch_starts = {0};
-    int64_t batch_size = score_dims[0];
     int64_t box_dim = boxes->dims()[2];
     int64_t out_dim = box_dim + 2;
-    int num_nmsed_out = 0;
-    Tensor boxes_slice, scores_slice;
-    int n = score_size == 3 ? batch_size : boxes->lod().back().size() - 1;
+    int n = score_size == 3 ? score_dims[0] : boxes->lod().back().size() - 1;
+    // C is the 2nd dimension of both the 3-D and the LoD Scores
+    int64_t class_num = score_dims[1];
+
+    std::vector<ImageSlice> images(n);
     for (int i = 0; i < n; ++i) {
+      auto& image = images[i];
+      image.class_num = class_num;
       if (score_size == 3) {
-        scores_slice = scores->Slice(i, i + 1);
-        scores_slice.Resize({score_dims[1], score_dims[2]});
-        boxes_slice = boxes->Slice(i, i + 1);
-        boxes_slice.Resize({score_dims[2], box_dim});
+        image.num_boxes = score_dims[2];
+        image.offset = i * score_dims[2];
+        image.scores = scores->data<T>() + i * class_num * image.num_boxes;
+        image.bboxes = boxes->data<T>() + i * image.num_boxes * box_dim;
       } else {
-        auto boxes_lod = boxes->lod().back();
-        scores_slice = scores->Slice(boxes_lod[i], boxes_lod[i + 1]);
-        boxes_slice = boxes->Slice(boxes_lod[i], boxes_lod[i + 1]);
+        auto& boxes_lod = boxes->lod().back();
+        image.num_boxes = boxes_lod[i + 1] - boxes_lod[i];
+        image.offset = boxes_lod[i];
+        image.scores = scores->data<T>() + boxes_lod[i] * class_num;
+        image.bboxes = boxes->data<T>() + boxes_lod[i] * class_num * box_dim;
+      }
+    }
+
+    // The classes of all the images are independent, so run NMS for them in
+    // parallel.
+    std::vector<std::map<int, std::vector<int>>> all_indices(n);
+    std::vector<std::pair<int, int>> tasks;
+    std::vector<std::vector<int>*> task_indices;
+    for (int i = 0; i < n; ++i) {
+      for (int c = 0; c < class_num; ++c) {
+        if (c == background_label) continue;
+        tasks.emplace_back(i, c);
+        task_indices.push_back(&all_indices[i][c]);
+      }
+    }
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int t = 0; t < static_cast<int>(tasks.size()); ++t) {
+      auto& image = images[tasks[t].first];
+      int c = tasks[t].second;
+      int64_t score_stride, bbox_stride;
+      const T* sdata = ClassScores(image, score_size, c, &score_stride);
+      const T* bdata = ClassBoxes(image, score_size, box_dim, c, &bbox_stride);
+      auto* selected = task_indices[t];
+      NMSFast<T>(bdata, bbox_stride, sdata, score_stride, image.num_boxes,
+                 box_dim, score_threshold, nms_threshold, nms_eta, nms_top_k,
+                 normalized, selected);
+      if (score_size == 2) {
+        std::sort(selected->begin(), selected->end());
       }
-      std::map<int, std::vector<int>> indices;
-      MultiClassNMS(ctx, scores_slice, boxes_slice, score_size, &indices,
-                    &num_nmsed_out);
-      all_indices.push_back(indices);
-      batch_starts.push_back(batch_starts.back() + num_nmsed_out);
+    }
+
+    std::vector<int> num_nmsed_out(n);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int i = 0; i < n; ++i) {
+      num_nmsed_out[i] =
+          KeepTopK(images[i], score_size, keep_top_k, &all_indices[i]);
+    }
+    std::vector<size_t> batch_starts = {0};
+    for (int i = 0; i < n; ++i) {
+      batch_starts.push_back(batch_starts.back() + num_nmsed_out[i]);
     }
 
     int num_kept = batch_starts.back();
@@ -423,37 +292,20 @@ class MultiClassNMSKernel : public framework::OpKernel<T> {
         batch_starts = {0, 1};
       }
     } else {
-      outs->mutable_data<T>({num_kept, out_dim}, ctx.GetPlace());
-      int offset = 0;
+      T* odata = outs->mutable_data<T>({num_kept, out_dim}, ctx.GetPlace());
       int* oindices = nullptr;
+      if (return_index) {
+        oindices = index->mutable_data<int>({num_kept, 1}, ctx.GetPlace());
+      }
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
       for (int i = 0; i < n; ++i) {
-        if (score_size == 3) {
-          scores_slice = scores->Slice(i, i + 1);
-          boxes_slice = boxes->Slice(i, i + 1);
-          scores_slice.Resize({score_dims[1], score_dims[2]});
-          boxes_slice.Resize({score_dims[2], box_dim});
-          if (return_index) {
-            offset = i * score_dims[2];
-          }
-        } else {
-          auto boxes_lod = boxes->lod().back();
-          scores_slice = scores->Slice(boxes_lod[i], boxes_lod[i + 1]);
-          boxes_slice = boxes->Slice(boxes_lod[i], boxes_lod[i + 1]);
-          if (return_index) {
-            offset = boxes_lod[i] * score_dims[1];
-          }
-        }
         int64_t s = batch_starts[i];
-        int64_t e = batch_starts[i + 1];
-        if (e > s) {
-          Tensor out = outs->Slice(s, e);
-          if (return_index) {
-            int* output_idx =
-                index->mutable_data<int>({num_kept, 1}, ctx.GetPlace());
-            oindices = output_idx + s;
-          }
-          MultiClassOutput(dev_ctx, scores_slice, boxes_slice, all_indices[i],
-                           score_dims.size(), &out, oindices, offset);
+        if (static_cast<int64_t>(batch_starts[i + 1]) > s) {
+          MultiClassOutput(images[i], all_indices[i], score_size, box_dim,
+                           odata + s * out_dim,
+                           oindices == nullptr ? nullptr : oindices + s);
         }
       }
     }
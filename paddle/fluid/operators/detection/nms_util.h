@@ -0,0 +1,263 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "paddle/fluid/operators/detection/poly_util.h"
+
+namespace paddle {
+namespace operators {
+
+// Select the indices of the scores greater than threshold, sorted by the
+// scores in descending order, and keep the first top_k ones if top_k > -1.
+// The i-th score is scores[i * stride].
+//
+// The order is the same as std::stable_sort by the scores converted to float,
+// i.e. the equal scores keep the ascending order of the indices, so only the
+// first top_k indices are sorted.
+template <class T>
+void GetMaxScoreIndex(const T* scores, int64_t num, int64_t stride,
+                      const T threshold, int64_t top_k,
+                      std::vector<std::pair<T, int>>* sorted_indices) {
+  sorted_indices->clear();
+  for (int64_t i = 0; i < num; ++i) {
+    if (scores[i * stride] > threshold) {
+      sorted_indices->emplace_back(scores[i * stride], static_cast<int>(i));
+    }
+  }
+  auto greater = [](const std::pair<T, int>& pair1,
+                    const std::pair<T, int>& pair2) {
+    float score1 = static_cast<float>(pair1.first);
+    float score2 = static_cast<float>(pair2.first);
+    return score1 > score2 || (score1 == score2 && pair1.second < pair2.second);
+  };
+  if (top_k > -1 && top_k < static_cast<int64_t>(sorted_indices->size())) {
+    std::nth_element(sorted_indices->begin(), sorted_indices->begin() + top_k,
+                     sorted_indices->end(), greater);
+    sorted_indices->resize(top_k);
+  }
+  std::sort(sorted_indices->begin(), sorted_indices->end(), greater);
+}
+
+template <class T>
+static inline T BBoxArea(const T* box, const bool normalized) {
+  if (box[2] < box[0] || box[3] < box[1]) {
+    // If coordinate values are is invalid
+    // (e.g. xmax < xmin or ymax < ymin), return 0.
+    return static_cast<T>(0.);
+  } else {
+    const T w = box[2] - box[0];
+    const T h = box[3] - box[1];
+    if (normalized) {
+      return w * h;
+    } else {
+      // If coordinate values are not within range [0, 1].
+      return (w + 1) * (h + 1);
+    }
+  }
+}
+
+template <class T>
+T PolyIoU(const T* box1, const T* box2, const size_t box_size,
+          const bool normalized) {
+  T bbox1_area = PolyArea<T>(box1, box_size, normalized);
+  T bbox2_area = PolyArea<T>(box2, box_size, normalized);
+  T inter_area = PolyOverlapArea<T>(box1, box2, box_size, normalized);
+  if (bbox1_area == 0 || bbox2_area == 0 || inter_area == 0) {
+    // If coordinate values are invalid
+    // if area size <= 0,  return 0.
+    return T(0.);
+  } else {
+    return inter_area / (bbox1_area + bbox2_area - inter_area);
+  }
+}
+
+// The boxes of [xmin, ymin, xmax, ymax] kept by NMS, in the layout of
+// structure of arrays, so that the overlaps of a new box with them are
+// computed with SIMD.
+template <class T>
+class NMSKeptBoxes {
+ public:
+  explicit NMSKeptBoxes(size_t capacity) {
+    xmin_.reserve(capacity);
+    ymin_.reserve(capacity);
+    xmax_.reserve(capacity);
+    ymax_.reserve(capacity);
+    area_.reserve(capacity);
+  }
+
+  void Append(const T* box, T area) {
+    xmin_.push_back(box[0]);
+    ymin_.push_back(box[1]);
+    xmax_.push_back(box[2]);
+    ymax_.push_back(box[3]);
+    area_.push_back(area);
+  }
+
+  // Whether the overlap of box with any kept box is greater than threshold.
+  // The overlaps are computed in the same order of operations as the scalar
+  // Jaccard overlap, so the results are bit-identical to it.
+  bool Suppress(const T* box, T area, T threshold, bool normalized) const {
+    const T norm = normalized ? static_cast<T>(0.) : static_cast<T>(1.);
+    size_t k = 0;
+    if (SuppressSIMD(box, area, norm, threshold, &k)) {
+      return true;
+    }
+    for (; k < area_.size(); ++k) {
+      T overlap = static_cast<T>(0.);
+      if (!(xmin_[k] > box[2] || xmax_[k] < box[0] || ymin_[k] > box[3] ||
+            ymax_[k] < box[1])) {
+        const T inter_xmin = std::max(box[0], xmin_[k]);
+        const T inter_ymin = std::max(box[1], ymin_[k]);
+        const T inter_xmax = std::min(box[2], xmax_[k]);
+        const T inter_ymax = std::min(box[3], ymax_[k]);
+        T inter_w = inter_xmax - inter_xmin + norm;
+        T inter_h = inter_ymax - inter_ymin + norm;
+        const T inter_area = inter_w * inter_h;
+        overlap = inter_area / (area + area_[k] - inter_area);
+      }
+      if (!(overlap <= threshold)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  // Check the kept boxes from *k with SIMD, and advance *k to the first box
+  // left for the scalar loop.
+  bool SuppressSIMD(const T* box, T area, T norm, T threshold,
+                    size_t* k) const {
+    return false;
+  }
+
+  std::vector<T> xmin_;
+  std::vector<T> ymin_;
+  std::vector<T> xmax_;
+  std::vector<T> ymax_;
+  std::vector<T> area_;
+};
+
+#ifdef __AVX__
+template <>
+inline bool NMSKeptBoxes<float>::SuppressSIMD(const float* box, float area,
+                                              float norm, float threshold,
+                                              size_t* k) const {
+  const __m256 box_xmin = _mm256_set1_ps(box[0]);
+  const __m256 box_ymin = _mm256_set1_ps(box[1]);
+  const __m256 box_xmax = _mm256_set1_ps(box[2]);
+  const __m256 box_ymax = _mm256_set1_ps(box[3]);
+  const __m256 box_area = _mm256_set1_ps(area);
+  const __m256 norm_v = _mm256_set1_ps(norm);
+  const __m256 threshold_v = _mm256_set1_ps(threshold);
+  const __m256 zero = _mm256_setzero_ps();
+  for (; *k + 8 <= area_.size(); *k += 8) {
+    const __m256 xmin = _mm256_loadu_ps(xmin_.data() + *k);
+    const __m256 ymin = _mm256_loadu_ps(ymin_.data() + *k);
+    const __m256 xmax = _mm256_loadu_ps(xmax_.data() + *k);
+    const __m256 ymax = _mm256_loadu_ps(ymax_.data() + *k);
+    const __m256 kept_area = _mm256_loadu_ps(area_.data() + *k);
+    const __m256 disjoint = _mm256_or_ps(
+        _mm256_or_ps(_mm256_cmp_ps(xmin, box_xmax, _CMP_GT_OQ),
+                     _mm256_cmp_ps(xmax, box_xmin, _CMP_LT_OQ)),
+        _mm256_or_ps(_mm256_cmp_ps(ymin, box_ymax, _CMP_GT_OQ),
+                     _mm256_cmp_ps(ymax, box_ymin, _CMP_LT_OQ)));
+    // _mm256_max_ps(b, a) and _mm256_min_ps(b, a) return the same values as
+    // std::max(a, b) and std::min(a, b), including NaN and signed zeros.
+    const __m256 inter_xmin = _mm256_max_ps(xmin, box_xmin);
+    const __m256 inter_ymin = _mm256_max_ps(ymin, box_ymin);
+    const __m256 inter_xmax = _mm256_min_ps(xmax, box_xmax);
+    const __m256 inter_ymax = _mm256_min_ps(ymax, box_ymax);
+    const __m256 inter_w =
+        _mm256_add_ps(_mm256_sub_ps(inter_xmax, inter_xmin), norm_v);
+    const __m256 inter_h =
+        _mm256_add_ps(_mm256_sub_ps(inter_ymax, inter_ymin), norm_v);
+    const __m256 inter_area = _mm256_mul_ps(inter_w, inter_h);
+    __m256 overlap = _mm256_div_ps(
+        inter_area,
+        _mm256_sub_ps(_mm256_add_ps(box_area, kept_area), inter_area));
+    overlap = _mm256_blendv_ps(overlap, zero, disjoint);
+    if (_mm256_movemask_ps(
+            _mm256_cmp_ps(overlap, threshold_v, _CMP_NLE_UQ)) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+// Greedily select the boxes of one class in the descending order of their
+// scores, and suppress the ones overlapping with the selected boxes more than
+// the adaptive threshold. The i-th box starts at bboxes[i * bbox_stride], and
+// its score is scores[i * score_stride].
+template <class T>
+void NMSFast(const T* bboxes, int64_t bbox_stride, const T* scores,
+             int64_t score_stride, int64_t num_boxes, int64_t box_size,
+             const T score_threshold, const T nms_threshold, const T eta,
+             const int64_t top_k, const bool normalized,
+             std::vector<int>* selected_indices) {
+  std::vector<std::pair<T, int>> sorted_indices;
+  GetMaxScoreIndex(scores, num_boxes, score_stride, score_threshold, top_k,
+                   &sorted_indices);
+
+  selected_indices->clear();
+  T adaptive_threshold = nms_threshold;
+  // 4: [xmin ymin xmax ymax]
+  if (box_size == 4) {
+    NMSKeptBoxes<T> kept(sorted_indices.size());
+    for (auto& pair : sorted_indices) {
+      const T* box = bboxes + pair.second * bbox_stride;
+      T area = BBoxArea<T>(box, normalized);
+      if (!kept.Suppress(box, area, adaptive_threshold, normalized)) {
+        kept.Append(box, area);
+        selected_indices->push_back(pair.second);
+        if (eta < 1 && adaptive_threshold > 0.5) {
+          adaptive_threshold *= eta;
+        }
+      }
+    }
+    return;
+  }
+
+  // 8: [x1 y1 x2 y2 x3 y3 x4 y4] or 16, 24, 32
+  bool is_poly = box_size == 8 || box_size == 16 || box_size == 24 ||
+                 box_size == 32;
+  for (auto& pair : sorted_indices) {
+    const int idx = pair.second;
+    bool keep = true;
+    for (size_t k = 0; k < selected_indices->size() && keep; ++k) {
+      const int kept_idx = (*selected_indices)[k];
+      T overlap = is_poly ? PolyIoU<T>(bboxes + idx * bbox_stride,
+                                       bboxes + kept_idx * bbox_stride,
+                                       box_size, normalized)
+                          : T(0.);
+      keep = overlap <= adaptive_threshold;
+    }
+    if (keep) {
+      selected_indices->push_back(idx);
+      if (eta < 1 && adaptive_threshold > 0.5) {
+        adaptive_threshold *= eta;
+      }
+    }
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -27,6 +27,8 @@ limitations under the License. */
 #include "paddle/fluid/operators/distributed/distributed.h"
 #include "paddle/fluid/operators/distributed/parameter_recv.h"
 #include "paddle/fluid/operators/distributed/parameter_send.h"
+#include "paddle/fluid/operators/distributed/prefetch_row_cache.h"
+#include "paddle/fluid/string/split.h"
 
 DECLARE_int32(communicator_max_merge_var_num);
 DECLARE_int32(communicator_send_queue_size);
@@ -45,6 +47,23 @@ DEFINE_bool(communicator_merge_sparse_grad, true,
             "merge sparse gradient before sending");
 DEFINE_int32(communicator_merge_sparse_bucket, 2000,
              "number of threads for sparse var");
+DEFINE_string(communicator_grad_compress, "none",
+              "encode the merged dense gradients to none, fp16 or int8 "
+              "before sending");
+DEFINE_string(communicator_grad_compress_vars, "",
+              "the encoding of some gradients, which overrides "
+              "communicator_grad_compress, e.g. fc_0.w_0@GRAD:int8,"
+              "fc_0.b_0@GRAD:none");
+DEFINE_int32(communicator_grad_compress_block_size, 256,
+             "number of the gradients encoded with a scale");
+DEFINE_int32(communicator_grad_compress_min_numel, 1024,
+             "the slices of less gradients are sent without encoding");
+DEFINE_int64(communicator_prefetch_cache_rows, 0,
+             "number of the prefetched rows of each distributed lookup "
+             "table cached by the trainer, 0 to disable the cache");
+DEFINE_int32(communicator_prefetch_cache_staleness, 1,
+             "number of recv cycles a cached row is served before it is "
+             "prefetched again");
 
 namespace paddle {
 namespace operators {
@@ -91,6 +110,18 @@ void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
           << FLAGS_communicator_merge_sparse_grad;
   VLOG(0) << "communicator_is_sgd_optimizer: "
           << FLAGS_communicator_is_sgd_optimizer;
+  VLOG(0) << "communicator_grad_compress: " << FLAGS_communicator_grad_compress;
+  VLOG(0) << "communicator_grad_compress_vars: "
+          << FLAGS_communicator_grad_compress_vars;
+  VLOG(0) << "communicator_prefetch_cache_rows: "
+          << FLAGS_communicator_prefetch_cache_rows;
+  VLOG(0) << "communicator_prefetch_cache_staleness: "
+          << FLAGS_communicator_prefetch_cache_staleness;
+
+  if (FLAGS_communicator_prefetch_cache_rows > 0) {
+    PrefetchRowCache::Init(FLAGS_communicator_prefetch_cache_rows,
+                           FLAGS_communicator_prefetch_cache_staleness);
+  }
 
   if (send_varname_to_ctx.size() == 0) {
     VLOG(0) << "nothing need to be send, will not start send_thread";
@@ -103,6 +134,7 @@ void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
     }
     send_threadpool_.reset(
         new ::ThreadPool(FLAGS_communicator_thread_pool_size));
+    InitCompressors();
   }
 
   if (recv_varname_to_ctx.size() == 0) {
@@ -157,6 +189,32 @@ void AsyncCommunicator::InitImpl(const paddle::framework::ProgramDesc &program,
       send_varname_to_ctx, recv_varname_to_ctx, param_scope);
 }
 
+void AsyncCommunicator::InitCompressors() {
+  std::unordered_map<std::string, GradCompressType> var_types;
+  for (auto &item :
+       string::Split(FLAGS_communicator_grad_compress_vars, ',')) {
+    auto pair = string::Split(item, ':');
+    PADDLE_ENFORCE_EQ(pair.size(), 2,
+                      "communicator_grad_compress_vars should be a list of "
+                      "var_name:type, but got %s",
+                      item);
+    var_types[pair[0]] = ToGradCompressType(pair[1]);
+  }
+  auto default_type = ToGradCompressType(FLAGS_communicator_grad_compress);
+  for (auto &iter : send_varname_to_ctx_) {
+    auto it = var_types.find(iter.first);
+    auto type = it == var_types.end() ? default_type : it->second;
+    if (type == GradCompressType::kNone) {
+      continue;
+    }
+    VLOG(1) << "encode the dense gradients of " << iter.first << " to "
+            << (type == GradCompressType::kInt8 ? "int8" : "fp16");
+    compressors_[iter.first].reset(new GradientCompressor(
+        type, FLAGS_communicator_grad_compress_block_size,
+        FLAGS_communicator_grad_compress_min_numel));
+  }
+}
+
 AsyncCommunicator::~AsyncCommunicator() {
   if (FLAGS_v >= 3) {
     std::string msg("~Communicator");
@@ -214,8 +272,12 @@ void AsyncCommunicator::SendThread() {
                   << " use time " << after_merge - before_merge;
           auto send_functor = distributed::ParameterSend<float>();
           auto &ctx = send_varname_to_ctx_.at(var_name);
+          auto compressor = compressors_.find(var_name);
           if (!FLAGS_communicator_fake_rpc) {
-            send_functor(ctx, *send_scope_, true, 1);
+            send_functor(ctx, *send_scope_, true, 1,
+                         compressor == compressors_.end()
+                             ? nullptr
+                             : compressor->second.get());
           }
           auto after_send = GetCurrentUS();
           VLOG(3) << "send " << var_name << " use time "
@@ -312,6 +374,14 @@ void AsyncCommunicator::RecvAll() {
   }
   auto after_recv = GetCurrentUS();
   VLOG(1) << "run recv graph use time " << after_recv - before_send;
+
+  // The cached rows age by a step with each recv of the parameters.
+  auto *cache = PrefetchRowCache::GetInstance();
+  if (cache != nullptr) {
+    cache->Advance();
+    VLOG(1) << "prefetch cache hit rate " << cache->hit_rate() << ", saved "
+            << cache->bytes_saved() << " bytes";
+  }
 }
 
 void AsyncCommunicator::Start() {
@@ -348,6 +418,12 @@ void AsyncCommunicator::Stop() {
       recv_thread_.reset(nullptr);
     }
   }
+  auto *cache = PrefetchRowCache::GetInstance();
+  if (cache != nullptr) {
+    VLOG(0) << "prefetch cache hits " << cache->hits() << ", misses "
+            << cache->misses() << ", saved " << cache->bytes_saved()
+            << " bytes";
+  }
   VLOG(0) << "Communicator stop done";
 }
 
@@ -29,6 +29,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/variable.h"
 #include "paddle/fluid/operators/distributed/distributed.h"
+#include "paddle/fluid/operators/distributed/gradient_compressor.h"
 #include "paddle/fluid/operators/distributed/rpc_client.h"
 #include "paddle/fluid/operators/distributed/rpc_common.h"
 #include "paddle/fluid/operators/distributed_ops/send_recv_util.h"
@@ -318,9 +319,15 @@ class AsyncCommunicator : public Communicator {
       const int& trainers, const int& geo_need_push_nums) override;
 
  private:
+  // Create the compressors of the gradients to encode, by
+  // FLAGS_communicator_grad_compress and FLAGS_communicator_grad_compress_vars.
+  void InitCompressors();
+
   std::unordered_map<std::string,
                      std::shared_ptr<BlockingQueue<std::shared_ptr<Variable>>>>
       send_varname_to_queue_;
+  std::unordered_map<std::string, std::unique_ptr<GradientCompressor>>
+      compressors_;
   RpcCtxMap send_varname_to_ctx_;
   RpcCtxMap recv_varname_to_ctx_;
   std::unique_ptr<std::thread> send_thread_{nullptr};
@@ -20,8 +20,20 @@
 
 #include "paddle/fluid/operators/distributed/grpc/grpc_client.h"
 #include "paddle/fluid/operators/distributed/grpc/grpc_server.h"
+
+#ifdef __linux__
+#include "paddle/fluid/operators/distributed/shm/shm_client.h"
+#include "paddle/fluid/operators/distributed/shm/shm_server.h"
+#define RPCSERVER_T \
+  paddle::operators::distributed::ShmRPCServer< \
+      paddle::operators::distributed::AsyncGRPCServer>
+#define RPCCLIENT_T \
+  paddle::operators::distributed::ShmRPCClient< \
+      paddle::operators::distributed::GRPCClient>
+#else  // __linux__
 #define RPCSERVER_T paddle::operators::distributed::AsyncGRPCServer
 #define RPCCLIENT_T paddle::operators::distributed::GRPCClient
+#endif  // __linux__
 
 #else  // PADDLE_WITH_GRPC
 
@@ -0,0 +1,260 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/distributed/gradient_compressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// The encoded tensor is the header, a float scale of each block, and then
+// an int8 or fp16 code of each value.
+static constexpr uint32_t kEncodedGradMagic = 0x45434750;  // "PGCE"
+
+struct EncodedGradHeader {
+  uint32_t magic;
+  int32_t type;
+  int32_t block_size;
+  int32_t rank;
+  int64_t numel;
+  int64_t dims[framework::DDim::kMaxRank];
+};
+
+static int64_t NumBlocks(int64_t numel, int block_size) {
+  return (numel + block_size - 1) / block_size;
+}
+
+static size_t CodeBytes(GradCompressType type) {
+  return type == GradCompressType::kInt8 ? sizeof(int8_t)
+                                         : sizeof(platform::float16);
+}
+
+// Add the gradients x to the residuals r, and return the max of the
+// absolute values. The bits of a non-negative float are ordered as the
+// float, so the integer max vectorizes without -ffast-math.
+static float AddResidual(const float* x, float* r, int64_t n) {
+  uint32_t max_bits = 0;
+  for (int64_t i = 0; i < n; ++i) {
+    r[i] += x[i];
+    uint32_t bits;
+    std::memcpy(&bits, &r[i], sizeof(bits));
+    max_bits = std::max(max_bits, bits & 0x7fffffffu);
+  }
+  float max_abs;
+  std::memcpy(&max_abs, &max_bits, sizeof(max_abs));
+  return max_abs;
+}
+
+// Encode a block of the gradients, leave the errors of the codes in the
+// residuals, and return the scale of the block.
+static float EncodeInt8Block(const float* x, float* r, int64_t n, int8_t* q) {
+  const float scale = AddResidual(x, r, n) / 127.f;
+  const float inv = scale > 0.f ? 1.f / scale : 0.f;
+  for (int64_t i = 0; i < n; ++i) {
+    // |r[i] * inv| <= 127, rounded half away from zero.
+    const float v = r[i] * inv;
+    const int code = static_cast<int>(v + (v < 0.f ? -0.5f : 0.5f));
+    q[i] = static_cast<int8_t>(code);
+    r[i] -= code * scale;
+  }
+  return scale;
+}
+
+static float EncodeFP16Block(const float* x, float* r, int64_t n,
+                             platform::float16* h) {
+  // Scaled into [-1, 1], the small gradients do not underflow in fp16.
+  const float max_abs = AddResidual(x, r, n);
+  const float scale = max_abs > 0.f ? max_abs : 1.f;
+  const float inv = 1.f / scale;
+  for (int64_t i = 0; i < n; ++i) {
+    h[i] = platform::float16(r[i] * inv);
+    r[i] -= static_cast<float>(h[i]) * scale;
+  }
+  return scale;
+}
+
+// Not inlined, as gcc does not vectorize the kernels inlined into Encode.
+template <typename T, typename EncodeBlockFn>
+__attribute__((noinline)) static void EncodeBlocks(
+    const float* x, float* r, int64_t numel, int block_size, float* scales,
+    T* codes, EncodeBlockFn encode_block) {
+  for (int64_t begin = 0, b = 0; begin < numel; begin += block_size, ++b) {
+    const int64_t n = std::min<int64_t>(block_size, numel - begin);
+    scales[b] = encode_block(x + begin, r + begin, n, codes + begin);
+  }
+}
+
+GradCompressType ToGradCompressType(const std::string& name) {
+  if (name == "none") {
+    return GradCompressType::kNone;
+  } else if (name == "fp16") {
+    return GradCompressType::kFP16;
+  } else if (name == "int8") {
+    return GradCompressType::kInt8;
+  }
+  PADDLE_THROW("unknown gradient compression %s, should be none, fp16 or int8",
+               name);
+}
+
+int64_t GradientCompressor::EncodedBytes(GradCompressType type, int64_t numel,
+                                         int block_size) {
+  return sizeof(EncodedGradHeader) +
+         NumBlocks(numel, block_size) * sizeof(float) +
+         numel * CodeBytes(type);
+}
+
+GradientCompressor::GradientCompressor(GradCompressType type, int block_size,
+                                       int64_t min_numel)
+    : type_(type), block_size_(block_size), min_numel_(min_numel) {
+  PADDLE_ENFORCE(type != GradCompressType::kNone,
+                 "a compressor should encode the gradients");
+  PADDLE_ENFORCE_GT(block_size, 0, "block_size should be positive");
+}
+
+bool GradientCompressor::Encode(const std::string& slice_name,
+                                const framework::Tensor& src,
+                                framework::LoDTensor* out) {
+  const int64_t numel = src.numel();
+  if (numel < std::max<int64_t>(min_numel_, 1)) {
+    return false;
+  }
+  PADDLE_ENFORCE(platform::is_cpu_place(src.place()),
+                 "only the gradients on CPU can be compressed");
+  PADDLE_ENFORCE_LE(src.dims().size(), framework::DDim::kMaxRank);
+
+  std::vector<float>* residual;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    residual = &residuals_[slice_name];
+  }
+  if (static_cast<int64_t>(residual->size()) != numel) {
+    residual->assign(numel, 0.f);
+  }
+
+  const int64_t bytes = EncodedBytes(type_, numel, block_size_);
+  uint8_t* buf = out->mutable_data<uint8_t>(framework::make_ddim({bytes}),
+                                            platform::CPUPlace());
+  auto* header = reinterpret_cast<EncodedGradHeader*>(buf);
+  std::memset(header, 0, sizeof(EncodedGradHeader));
+  header->magic = kEncodedGradMagic;
+  header->type = static_cast<int32_t>(type_);
+  header->block_size = block_size_;
+  header->rank = src.dims().size();
+  header->numel = numel;
+  for (int i = 0; i < header->rank; ++i) {
+    header->dims[i] = src.dims()[i];
+  }
+  auto* scales = reinterpret_cast<float*>(buf + sizeof(EncodedGradHeader));
+  void* codes = scales + NumBlocks(numel, block_size_);
+
+  if (type_ == GradCompressType::kInt8) {
+    EncodeBlocks(src.data<float>(), residual->data(), numel, block_size_,
+                 scales, static_cast<int8_t*>(codes), EncodeInt8Block);
+  } else {
+    EncodeBlocks(src.data<float>(), residual->data(), numel, block_size_,
+                 scales, static_cast<platform::float16*>(codes),
+                 EncodeFP16Block);
+  }
+  return true;
+}
+
+std::string EncodedGradientName(const std::string& slice_name) {
+  return slice_name + kEncodedGradSuffix;
+}
+
+bool IsEncodedGradientName(const std::string& varname) {
+  const size_t n = sizeof(kEncodedGradSuffix) - 1;
+  return varname.size() > n &&
+         varname.compare(varname.size() - n, n, kEncodedGradSuffix) == 0;
+}
+
+std::string DecodedGradientName(const std::string& varname) {
+  if (!IsEncodedGradientName(varname)) {
+    return varname;
+  }
+  return varname.substr(0, varname.size() - sizeof(kEncodedGradSuffix) + 1);
+}
+
+void DecodeGradient(framework::Variable* var) {
+  auto* tensor = var->GetMutable<framework::LoDTensor>();
+  PADDLE_ENFORCE(tensor->IsInitialized() &&
+                     tensor->type() == framework::proto::VarType::UINT8,
+                 "the encoded gradient should be a uint8 tensor");
+  PADDLE_ENFORCE_GE(tensor->numel(),
+                    static_cast<int64_t>(sizeof(EncodedGradHeader)),
+                    "the encoded gradient is truncated");
+  const uint8_t* buf = tensor->data<uint8_t>();
+  const auto* header = reinterpret_cast<const EncodedGradHeader*>(buf);
+  PADDLE_ENFORCE_EQ(header->magic, kEncodedGradMagic,
+                    "the gradient is not encoded");
+  const auto type = static_cast<GradCompressType>(header->type);
+  const int64_t numel = header->numel;
+  const int block_size = header->block_size;
+  PADDLE_ENFORCE(type == GradCompressType::kFP16 ||
+                     type == GradCompressType::kInt8,
+                 "unknown gradient compression %d", header->type);
+  PADDLE_ENFORCE_GT(block_size, 0, "the block size should be positive");
+  PADDLE_ENFORCE_GT(numel, 0, "an empty gradient is never encoded");
+  PADDLE_ENFORCE(header->rank >= 0 &&
+                     header->rank <= framework::DDim::kMaxRank,
+                 "the rank %d of the encoded gradient is out of range",
+                 header->rank);
+  std::vector<int64_t> dims(header->dims, header->dims + header->rank);
+  int64_t dims_numel = 1;
+  for (int64_t d : dims) {
+    PADDLE_ENFORCE(d > 0 && dims_numel <= numel / d,
+                   "the dims of the encoded gradient are invalid");
+    dims_numel *= d;
+  }
+  PADDLE_ENFORCE_EQ(dims_numel, numel,
+                    "the numel of the encoded gradient mismatches its dims");
+  PADDLE_ENFORCE_EQ(tensor->numel(),
+                    GradientCompressor::EncodedBytes(type, numel, block_size),
+                    "the encoded gradient is truncated");
+
+  framework::LoDTensor decoded;
+  float* y = decoded.mutable_data<float>(framework::make_ddim(dims),
+                                         platform::CPUPlace());
+  const auto* scales =
+      reinterpret_cast<const float*>(buf + sizeof(EncodedGradHeader));
+  const void* codes = scales + NumBlocks(numel, block_size);
+  for (int64_t begin = 0, b = 0; begin < numel; begin += block_size, ++b) {
+    const int64_t end = std::min(begin + block_size, numel);
+    const float scale = scales[b];
+    if (type == GradCompressType::kInt8) {
+      auto* q = static_cast<const int8_t*>(codes);
+      for (int64_t i = begin; i < end; ++i) {
+        y[i] = q[i] * scale;
+      }
+    } else {
+      auto* h = static_cast<const platform::float16*>(codes);
+      for (int64_t i = begin; i < end; ++i) {
+        y[i] = static_cast<float>(h[i]) * scale;
+      }
+    }
+  }
+  decoded.set_lod(tensor->lod());
+  *tensor = decoded;
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,84 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/variable.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+enum class GradCompressType { kNone = 0, kFP16 = 1, kInt8 = 2 };
+
+// Parse "none", "fp16" or "int8".
+GradCompressType ToGradCompressType(const std::string& name);
+
+// Encode the dense gradients to fp16 or int8 codes, with a scale of each
+// block of block_size values, into a uint8 tensor which every transport
+// sends as it is. The error of the encoding of each slice is kept and added
+// to the next gradient of the slice (error feedback), so that the error does
+// not accumulate in the parameters.
+//
+// The slices of a variable are encoded one by one by its send task, so the
+// residuals are only locked against the other slices.
+class GradientCompressor {
+ public:
+  GradientCompressor(GradCompressType type, int block_size, int64_t min_numel);
+
+  GradCompressType type() const { return type_; }
+
+  // Encode src of float into out, or return false if src has less than
+  // min_numel values and should be sent as it is.
+  bool Encode(const std::string& slice_name, const framework::Tensor& src,
+              framework::LoDTensor* out);
+
+  // The bytes of numel values encoded.
+  static int64_t EncodedBytes(GradCompressType type, int64_t numel,
+                              int block_size);
+
+ private:
+  const GradCompressType type_;
+  const int block_size_;
+  const int64_t min_numel_;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::vector<float>> residuals_;
+};
+
+// An encoded slice is sent as the name of the slice with the suffix, and
+// received into the variable of the slice.
+constexpr char kEncodedGradSuffix[] = "@ENCODED";
+
+std::string EncodedGradientName(const std::string& slice_name);
+
+// Whether varname is the name an encoded slice is sent as.
+bool IsEncodedGradientName(const std::string& varname);
+
+// The variable a message of varname is received into: the slice of an
+// encoded slice, or varname itself.
+std::string DecodedGradientName(const std::string& varname);
+
+// Decode the gradient of var into a float LoDTensor on CPU in place.
+void DecodeGradient(framework::Variable* var);
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,90 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Measure the throughput of the gradient compression of the communicator,
+// and the time of sending a gradient at a given bandwidth, raw and encoded,
+// counting the encoding on the trainer and the decoding on the pserver.
+// Usage:
+//   gradient_compressor_benchmark --bandwidth_gbps=10 --repeat=20
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/operators/distributed/gradient_compressor.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_double(bandwidth_gbps, 10, "The bandwidth of the network in Gbit/s.");
+DEFINE_int32(repeat, 20, "The number of runs of each size.");
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+static void Run(GradCompressType type, const std::string& name,
+                int64_t numel) {
+  framework::LoDTensor grad;
+  float* data = grad.mutable_data<float>(framework::make_ddim({numel}),
+                                         platform::CPUPlace());
+  std::mt19937 rng(0);
+  std::normal_distribution<float> normal(0.f, 1e-3f);
+  for (int64_t i = 0; i < numel; ++i) {
+    data[i] = normal(rng);
+  }
+
+  GradientCompressor compressor(type, 256, 1);
+  platform::Timer encode_timer, decode_timer;
+  int64_t bytes = 0;
+  for (int r = 0; r < FLAGS_repeat; ++r) {
+    framework::Variable var;
+    encode_timer.Resume();
+    compressor.Encode("grad", grad, var.GetMutable<framework::LoDTensor>());
+    encode_timer.Pause();
+    bytes = var.Get<framework::LoDTensor>().numel();
+    decode_timer.Resume();
+    DecodeGradient(&var);
+    decode_timer.Pause();
+  }
+
+  const int64_t raw_bytes = numel * sizeof(float);
+  const double bytes_per_ms = FLAGS_bandwidth_gbps * 1e9 / 8 / 1e3;
+  const double encode_ms = encode_timer.ElapsedMS() / FLAGS_repeat;
+  const double decode_ms = decode_timer.ElapsedMS() / FLAGS_repeat;
+  const double raw_ms = raw_bytes / bytes_per_ms;
+  const double encoded_ms = bytes / bytes_per_ms + encode_ms + decode_ms;
+  LOG(INFO) << name << " " << raw_bytes / 1024.0 / 1024 << " MB: "
+            << static_cast<double>(raw_bytes) / bytes << "x smaller, encode "
+            << raw_bytes / encode_ms / 1e6 << " GB/s, decode "
+            << raw_bytes / decode_ms / 1e6 << " GB/s, send " << raw_ms
+            << " ms raw, " << encoded_ms << " ms encoded at "
+            << FLAGS_bandwidth_gbps << " Gbps";
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  using paddle::operators::distributed::GradCompressType;
+  for (int64_t numel : {1 << 16, 1 << 20, 1 << 24}) {
+    paddle::operators::distributed::Run(GradCompressType::kFP16, "fp16",
+                                        numel);
+    paddle::operators::distributed::Run(GradCompressType::kInt8, "int8",
+                                        numel);
+  }
+  return 0;
+}
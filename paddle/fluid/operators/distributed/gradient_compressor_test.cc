@@ -0,0 +1,185 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/operators/distributed/gradient_compressor.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+using LoDTensor = framework::LoDTensor;
+
+static void RandomGrad(LoDTensor* t, const framework::DDim& dims, int seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> normal(0.f, 1e-3f);
+  float* data = t->mutable_data<float>(dims, platform::CPUPlace());
+  for (int64_t i = 0; i < t->numel(); ++i) {
+    data[i] = normal(rng);
+  }
+}
+
+// Encode and decode src through a variable, as the trainer and the pserver.
+static void RoundTrip(GradientCompressor* compressor, const LoDTensor& src,
+                      LoDTensor* out) {
+  framework::Variable var;
+  ASSERT_TRUE(compressor->Encode("x", src, var.GetMutable<LoDTensor>()));
+  DecodeGradient(&var);
+  ASSERT_EQ(var.Get<LoDTensor>().type(), framework::proto::VarType::FP32);
+  *out = var.Get<LoDTensor>();
+}
+
+TEST(GradientCompressor, int8) {
+  const int block_size = 64;
+  GradientCompressor compressor(GradCompressType::kInt8, block_size, 1);
+  LoDTensor src, out;
+  RandomGrad(&src, framework::make_ddim({100, 33}), 0);
+  RoundTrip(&compressor, src, &out);
+
+  ASSERT_EQ(out.dims(), src.dims());
+  const float* x = src.data<float>();
+  const float* y = out.data<float>();
+  for (int64_t b = 0; b < src.numel(); b += block_size) {
+    float max_abs = 0.f;
+    for (int64_t i = b; i < std::min(b + block_size, src.numel()); ++i) {
+      max_abs = std::max(max_abs, std::fabs(x[i]));
+    }
+    for (int64_t i = b; i < std::min(b + block_size, src.numel()); ++i) {
+      EXPECT_LE(std::fabs(x[i] - y[i]), max_abs / 127.f / 2 + 1e-9f);
+    }
+  }
+  EXPECT_LT(GradientCompressor::EncodedBytes(GradCompressType::kInt8,
+                                             src.numel(), block_size),
+            src.numel() * sizeof(float) / 3);
+}
+
+TEST(GradientCompressor, fp16) {
+  GradientCompressor compressor(GradCompressType::kFP16, 256, 1);
+  LoDTensor src, out;
+  RandomGrad(&src, framework::make_ddim({4097}), 1);
+  RoundTrip(&compressor, src, &out);
+
+  ASSERT_EQ(out.dims(), src.dims());
+  const float* x = src.data<float>();
+  const float* y = out.data<float>();
+  for (int64_t i = 0; i < src.numel(); ++i) {
+    // The values are scaled by the max of the block, about 4e-3.
+    EXPECT_NEAR(x[i], y[i], 4e-3f / 1024);
+  }
+}
+
+TEST(GradientCompressor, small_and_raw) {
+  GradientCompressor compressor(GradCompressType::kInt8, 256, 1024);
+  LoDTensor src, encoded;
+  RandomGrad(&src, framework::make_ddim({10, 10}), 2);
+  EXPECT_FALSE(compressor.Encode("bias", src, &encoded));
+}
+
+TEST(GradientCompressor, encoded_name) {
+  const std::string name = EncodedGradientName("w@GRAD.block0");
+  EXPECT_TRUE(IsEncodedGradientName(name));
+  EXPECT_EQ(DecodedGradientName(name), "w@GRAD.block0");
+  EXPECT_FALSE(IsEncodedGradientName("w@GRAD.block0"));
+  EXPECT_FALSE(IsEncodedGradientName(kEncodedGradSuffix));
+  EXPECT_EQ(DecodedGradientName("w@GRAD.block0"), "w@GRAD.block0");
+}
+
+// The header of the encoded gradient from the network is checked before
+// the gradient is allocated.
+TEST(GradientCompressor, reject_corrupt_header) {
+  GradientCompressor compressor(GradCompressType::kInt8, 64, 1);
+  LoDTensor src, encoded;
+  RandomGrad(&src, framework::make_ddim({10, 20}), 3);
+  ASSERT_TRUE(compressor.Encode("x", src, &encoded));
+
+  // The offsets of block_size, rank, numel and dims in the header.
+  auto corrupt = [&](size_t offset, int64_t value, size_t size) {
+    framework::Variable var;
+    auto* t = var.GetMutable<LoDTensor>();
+    t->mutable_data<uint8_t>(encoded.dims(), platform::CPUPlace());
+    framework::TensorCopySync(encoded, platform::CPUPlace(), t);
+    std::memcpy(t->data<uint8_t>() + offset, &value, size);
+    EXPECT_THROW(DecodeGradient(&var), platform::EnforceNotMet);
+  };
+  corrupt(8, 0, sizeof(int32_t));
+  corrupt(8, -64, sizeof(int32_t));
+  corrupt(12, -1, sizeof(int32_t));
+  corrupt(12, framework::DDim::kMaxRank + 1, sizeof(int32_t));
+  corrupt(16, 201, sizeof(int64_t));
+  corrupt(24, 11, sizeof(int64_t));
+  corrupt(24, -10, sizeof(int64_t));
+  corrupt(32, int64_t(1) << 62, sizeof(int64_t));
+
+  framework::Variable raw;
+  *raw.GetMutable<LoDTensor>() = src;
+  EXPECT_THROW(DecodeGradient(&raw), platform::EnforceNotMet);
+}
+
+// With error feedback, the sum of the decoded gradients stays within one
+// quantization step of the sum of the gradients, however many are sent.
+TEST(GradientCompressor, error_feedback) {
+  GradientCompressor compressor(GradCompressType::kInt8, 128, 1);
+  const auto dims = framework::make_ddim({1000});
+  std::vector<double> sum_x(1000, 0.), sum_y(1000, 0.);
+  float max_step = 0.f;
+  for (int step = 0; step < 200; ++step) {
+    LoDTensor src, out;
+    RandomGrad(&src, dims, 100 + step);
+    RoundTrip(&compressor, src, &out);
+    const float* x = src.data<float>();
+    const float* y = out.data<float>();
+    for (int i = 0; i < 1000; ++i) {
+      sum_x[i] += x[i];
+      sum_y[i] += y[i];
+      max_step = std::max(max_step, std::fabs(x[i]) * 2 / 127.f);
+    }
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_LE(std::fabs(sum_x[i] - sum_y[i]), max_step);
+  }
+}
+
+// SGD of a quadratic with the encoded gradients reaches the same optimum.
+TEST(GradientCompressor, sgd_convergence) {
+  const int n = 2048;
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+  std::vector<float> target(n), w(n, 0.f);
+  for (auto& t : target) t = uniform(rng);
+
+  GradientCompressor compressor(GradCompressType::kInt8, 256, 1);
+  for (int step = 0; step < 300; ++step) {
+    LoDTensor grad, out;
+    float* g = grad.mutable_data<float>(framework::make_ddim({n}),
+                                        platform::CPUPlace());
+    for (int i = 0; i < n; ++i) g[i] = w[i] - target[i];
+    RoundTrip(&compressor, grad, &out);
+    const float* y = out.data<float>();
+    for (int i = 0; i < n; ++i) w[i] -= 0.05f * y[i];
+  }
+  for (int i = 0; i < n; ++i) {
+    EXPECT_NEAR(w[i], target[i], 1e-3f);
+  }
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
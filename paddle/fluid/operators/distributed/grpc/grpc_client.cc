@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include <stdlib.h>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <limits>
 
 #include "glog/logging.h"  // For VLOG
@@ -24,6 +26,11 @@ limitations under the License. */
 #include "paddle/fluid/platform/profiler.h"
 
 DECLARE_bool(rpc_disable_reuse_port);
+DEFINE_int32(rpc_send_chunk_size_mb, 0,
+             "send the dense tensors on CPU larger than this in chunks of "
+             "this size, which are sent as they are serialized and are "
+             "deserialized in parallel by the server. 0, the default, sends "
+             "them whole; measure with grpc_send_benchmark before setting it");
 
 namespace paddle {
 namespace operators {
@@ -68,6 +75,14 @@ VarHandlePtr GRPCClient::AsyncSendVar(const std::string& ep,
                                       const framework::Scope& scope,
                                       const std::string& var_name,
                                       int64_t time_out) {
+  const int64_t chunk_bytes =
+      static_cast<int64_t>(FLAGS_rpc_send_chunk_size_mb) << 20;
+  auto* send_var = scope.FindVar(var_name);
+  if (send_var != nullptr && NumSendChunks(*send_var, chunk_bytes) > 1) {
+    return AsyncSendVarInChunks(ep, ctx, scope, var_name, chunk_bytes,
+                                time_out);
+  }
+
   const platform::DeviceContext* p_ctx = &ctx;
   const std::string ep_val = ep;
   const std::string var_name_val = var_name;
@@ -122,6 +137,90 @@ VarHandlePtr GRPCClient::AsyncSendVar(const std::string& ep,
   }
 }
 
+// The sequence of a send in chunks. It starts from the time, so that the
+// sends of a restarted trainer are newer than those before.
+static int64_t NextChunkSeq() {
+  static std::atomic<int64_t> seq(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+  return seq++;
+}
+
+VarHandlePtr GRPCClient::AsyncSendVarInChunks(
+    const std::string& ep, const platform::DeviceContext& ctx,
+    const framework::Scope& scope, const std::string& var_name,
+    int64_t chunk_bytes, int64_t time_out) {
+  const platform::DeviceContext* p_ctx = &ctx;
+  const std::string var_name_val = var_name;
+  const framework::Scope* p_scope = &scope;
+  const auto ch = GetChannel(ep);
+  const std::string method = kSendRPC;
+  const int64_t chunk_num =
+      NumSendChunks(*scope.FindVar(var_name), chunk_bytes);
+  VLOG(3) << "send " << var_name << " to " << ep << " in " << chunk_num
+          << " chunks";
+
+  int retry_times_ = 0;
+
+  while (true) {
+    VarHandlePtr h(new VarHandle(ep, method, var_name_val, p_ctx, p_scope));
+    // A retry is a new send, and the server drops the chunks of the last.
+    const int64_t chunk_seq = NextChunkSeq();
+    std::vector<SendProcessor*> chunks;
+    std::vector<VarHandlePtr> chunk_handles;
+    for (int64_t i = 0; i < chunk_num; ++i) {
+      SendProcessor* s = new SendProcessor(ch);
+      chunk_handles.emplace_back(
+          new VarHandle(ep, method, var_name_val, p_ctx, p_scope));
+      s->Prepare(chunk_handles.back(), time_out);
+      s->response_call_back_ = nullptr;
+      chunks.push_back(s);
+    }
+
+    // Each chunk is sent as soon as it is serialized, so the chunks are on
+    // the wire and deserialized by the server while the next are serialized.
+    // h is finished with the last of them.
+    framework::AsyncIO([var_name_val, p_scope, p_ctx, chunk_bytes, chunk_seq,
+                        chunks, chunk_handles, method, h, this] {
+      auto* var = p_scope->FindVar(var_name_val);
+      platform::RecordRPCEvent record_event(method);
+      for (size_t i = 0; i < chunks.size(); ++i) {
+        auto* s = chunks[i];
+        ::grpc::ByteBuffer req;
+        SerializeChunkToByteBuffer(var_name_val, var, *p_ctx, chunk_bytes,
+                                   chunk_seq, i, &req, trainer_id_);
+        auto call = s->stub_g_.PrepareUnaryCall(
+            s->context_.get(), "/sendrecv.SendRecvService/SendVariable", req,
+            &cq_);
+        call->StartCall();
+        call->Finish(&s->reply_, &s->status_, reinterpret_cast<void*>(s));
+      }
+
+      bool ok = true;
+      for (auto& chunk_h : chunk_handles) {
+        ok = chunk_h->Wait() && ok;
+        h->should_retry = h->should_retry || chunk_h->should_retry;
+      }
+      h->Finish(ok);
+    });
+    req_count_ += chunk_num;
+
+    if (FLAGS_rpc_retry_times > 0 && retry_times_ < FLAGS_rpc_retry_times) {
+      h->Wait();
+      if (h->should_retry) {
+        VLOG(3) << "rpc call failed, retry times " << retry_times_;
+        retry_times_++;
+        std::random_device rd;
+        std::this_thread::sleep_for(std::chrono::milliseconds(rd() % 5));
+        continue;
+      }
+    }
+
+    return h;
+  }
+}
+
 void ProcGetResponse(const VarHandle& var_h,
                      const ::grpc::ByteBuffer& ret_msg) {
   VLOG(4) << "ProcGetResponse";
@@ -0,0 +1,136 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measure the latency of sending a large dense tensor to a parameter server
+// over loopback, whole and in chunks of rpc_send_chunk_size_mb. The tensors
+// received are checked to be the ones sent.
+// Usage:
+//   grpc_send_benchmark --repeat=10 --server_threads=4
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/operators/distributed/grpc/grpc_client.h"
+#include "paddle/fluid/operators/distributed/grpc/grpc_server.h"
+#include "paddle/fluid/operators/distributed/request_handler.h"
+#include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/timer.h"
+
+DECLARE_int32(rpc_send_chunk_size_mb);
+DEFINE_int32(repeat, 10, "The number of sends of each size.");
+DEFINE_int32(server_threads, 4, "The number of threads of the server.");
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// The tensors are received into the scope of the server.
+class RecvRequestHandler final : public RequestHandler {
+ public:
+  RecvRequestHandler() : RequestHandler(true) {}
+
+  bool Handle(const std::string& varname, framework::Scope* scope,
+              framework::Variable* var, framework::Variable** outvar,
+              const int trainer_id, const std::string& out_var_name = "",
+              const std::string& table_name = "") override {
+    return var != nullptr;
+  }
+};
+
+static double SendMS(RPCClient* client, const std::string& ep,
+                     const platform::DeviceContext& ctx,
+                     const framework::Scope& scope,
+                     const framework::Scope& server_scope) {
+  const auto& x = scope.FindVar("x")->Get<framework::LoDTensor>();
+  platform::Timer timer;
+  for (int r = 0; r < FLAGS_repeat; ++r) {
+    timer.Resume();
+    auto h = client->AsyncSendVar(ep, ctx, scope, "x");
+    PADDLE_ENFORCE(h->Wait(), "send x to %s failed", ep);
+    timer.Pause();
+
+    auto& out = server_scope.FindVar("x")->Get<framework::LoDTensor>();
+    PADDLE_ENFORCE_EQ(out.numel(), x.numel());
+    const float* x_data = x.data<float>();
+    const float* out_data = out.data<float>();
+    for (int64_t i = 0; i < x.numel(); i += 997) {
+      PADDLE_ENFORCE_EQ(out_data[i], x_data[i]);
+    }
+  }
+  return timer.ElapsedMS() / FLAGS_repeat;
+}
+
+static void Run() {
+  platform::CPUPlace place;
+  platform::CPUDeviceContext ctx(place);
+
+  framework::Scope server_scope;
+  server_scope.Var("x")->GetMutable<framework::LoDTensor>();
+  RecvRequestHandler handler;
+  handler.SetScope(&server_scope);
+  handler.SetDevCtx(&ctx);
+
+  std::unique_ptr<RPCServer> server(new GRPCServer("127.0.0.1:0", 1));
+  server->RegisterRPC(kRequestSend, &handler, FLAGS_server_threads);
+  handler.SetRPCServer(server.get());
+  std::thread server_thread(&RPCServer::StartServer, server.get());
+  server->WaitServerReady();
+  const std::string ep =
+      "127.0.0.1:" + std::to_string(server->GetSelectedPort());
+
+  std::unique_ptr<RPCClient> client(new GRPCClient());
+  client->InitImpl();
+
+  for (int64_t mb : {16, 64, 256}) {
+    framework::Scope scope;
+    auto* x = scope.Var("x")->GetMutable<framework::LoDTensor>();
+    const int64_t numel = (mb << 20) / sizeof(float);
+    float* data = x->mutable_data<float>(framework::make_ddim({numel}), place);
+    for (int64_t i = 0; i < numel; ++i) {
+      data[i] = static_cast<float>(i % 1000) / 7;
+    }
+
+    FLAGS_rpc_send_chunk_size_mb = 0;
+    const double whole_ms = SendMS(client.get(), ep, ctx, scope, server_scope);
+    for (int chunk_mb : {1, 4, 16}) {
+      if (chunk_mb >= mb) continue;
+      FLAGS_rpc_send_chunk_size_mb = chunk_mb;
+      const double chunks_ms =
+          SendMS(client.get(), ep, ctx, scope, server_scope);
+      LOG(INFO) << mb << " MB: send " << whole_ms << " ms whole, "
+                << chunks_ms << " ms in chunks of " << chunk_mb << " MB, "
+                << whole_ms / chunks_ms << "x";
+    }
+  }
+
+  client.reset();
+  server->ShutDown();
+  server_thread.join();
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  paddle::operators::distributed::Run();
+  return 0;
+}
@@ -15,6 +15,7 @@ limitations under the License. */
 #ifdef PADDLE_WITH_CUDA
 #include <nccl.h>
 #endif
+#include <algorithm>
 #include <limits>
 #include <memory>
 #include <thread>  // NOLINT
@@ -146,6 +147,61 @@ void SerializeToByteBuffer(const std::string& name, framework::Variable* var,
   msg->Swap(&tmp);
 }
 
+int64_t NumSendChunks(const framework::Variable& var, int64_t chunk_bytes) {
+  if (chunk_bytes <= 0 || !var.IsType<framework::LoDTensor>()) {
+    return 1;
+  }
+  auto& tensor = var.Get<framework::LoDTensor>();
+  if (!tensor.IsInitialized() || !platform::is_cpu_place(tensor.place())) {
+    return 1;
+  }
+  const int64_t bytes = tensor.numel() * framework::SizeOfType(tensor.type());
+  return std::max<int64_t>((bytes + chunk_bytes - 1) / chunk_bytes, 1);
+}
+
+void SerializeChunkToByteBuffer(const std::string& name,
+                                framework::Variable* var,
+                                const platform::DeviceContext& ctx,
+                                int64_t chunk_bytes, int64_t chunk_seq,
+                                int64_t chunk_id,
+                                ::grpc::ByteBuffer* msg,
+                                const int trainer_id) {
+  platform::RecordRPCEvent record_event("serial");
+  VarMsg request;
+  request.set_varname(name);
+  request.set_trainer_id(trainer_id);
+  request.set_type(::sendrecv::LOD_TENSOR);
+  // The payload holds the allocation of the whole tensor until the chunk
+  // is sent.
+  auto* payload = new TensorPayload(GetTensorPayload(var, ctx, &request));
+  const int64_t offset = chunk_id * chunk_bytes;
+  const int64_t bytes = static_cast<int64_t>(payload->memory_size());
+  PADDLE_ENFORCE_LT(offset, bytes, "the chunk %d of %s is out of range",
+                    chunk_id, name);
+  const int64_t length = std::min(chunk_bytes, bytes - offset);
+  request.set_chunk_offset(offset);
+  request.set_chunk_num((bytes + chunk_bytes - 1) / chunk_bytes);
+  request.set_chunk_seq(chunk_seq);
+
+  std::string header;
+  request.AppendToString(&header);
+  auto buffer = std::unique_ptr<char[]>(new char[1024]);
+  ProtoEncodeHelper e(buffer.get(), 1024);
+  e.WriteRawBytes(header);
+  e.WriteVarlengthBeginning(VarMsg::kSerializedFieldNumber, length);
+
+  ::grpc::Slice slices[2];  // metadata, the data of the chunk
+  slices[0] = ::grpc::Slice(e.size());
+  memcpy(const_cast<uint8_t*>(slices[0].begin()), e.data(), e.size());
+  slices[1] = ::grpc::Slice(
+      grpc_slice_new_with_user_data(
+          static_cast<uint8_t*>(payload->ptr()) + offset, length,
+          SerializeDestroyCallback, payload),
+      ::grpc::Slice::STEAL_REF);
+  ::grpc::ByteBuffer tmp(&slices[0], 2);
+  msg->Swap(&tmp);
+}
+
 void DeserializeFromByteBuffer(const ::grpc::ByteBuffer& msg,
                                const platform::DeviceContext& ctx,
                                const framework::Scope* scope,
@@ -42,6 +42,20 @@ void SerializeToByteBuffer(const std::string& name, framework::Variable* var,
                            const int trainer_id = 0,
                            const std::string& table_name = std::string());
 
+// The number of the chunks of chunk_bytes var is sent in, more than 1 only
+// for the LoDTensor on CPU larger than chunk_bytes.
+int64_t NumSendChunks(const framework::Variable& var, int64_t chunk_bytes);
+
+// Serialize the chunk_id-th chunk of the data of the LoDTensor of var, with
+// the meta of the whole tensor, for the send of chunk_seq.
+void SerializeChunkToByteBuffer(const std::string& name,
+                                framework::Variable* var,
+                                const platform::DeviceContext& ctx,
+                                int64_t chunk_bytes, int64_t chunk_seq,
+                                int64_t chunk_id,
+                                ::grpc::ByteBuffer* msg,
+                                const int trainer_id = 0);
+
 void DeserializeFromByteBuffer(const ::grpc::ByteBuffer& msg,
                                const platform::DeviceContext& ctx,
                                const framework::Scope* scope,
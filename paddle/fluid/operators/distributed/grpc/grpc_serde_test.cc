@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include <unistd.h>
+#include <chrono>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
 
@@ -29,6 +30,8 @@ limitations under the License. */
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/string/printf.h"
 
+DECLARE_int32(rpc_deadline);
+
 namespace framework = paddle::framework;
 namespace platform = paddle::platform;
 namespace operators = paddle::operators;
@@ -222,3 +225,113 @@ TEST(SelectedRows, Run) {
   RunSerdeTestSelectedRows(gpu);
 #endif
 }
+
+TEST(LodTensor, Chunks) {
+  platform::CPUPlace place;
+  platform::CPUDeviceContext ctx(place);
+
+  framework::Variable var;
+  auto* tensor = var.GetMutable<framework::LoDTensor>();
+  tensor->Resize(framework::make_ddim({1000, 300}));
+  float* data = tensor->mutable_data<float>(place);
+  for (int i = 0; i < 1000 * 300; ++i) data[i] = i;
+  tensor->set_lod({{0, 400, 1000}});
+
+  // 1200000 bytes in chunks of 256KB, the last of them shorter.
+  const int64_t chunk_bytes = 256 << 10;
+  const int64_t chunk_num =
+      operators::distributed::NumSendChunks(var, chunk_bytes);
+  ASSERT_EQ(chunk_num, 5);
+  std::vector<::grpc::ByteBuffer> msgs(chunk_num);
+  for (int64_t i = 0; i < chunk_num; ++i) {
+    operators::distributed::SerializeChunkToByteBuffer(
+        "myvar", &var, ctx, chunk_bytes, 1, i, &msgs[i], 1);
+  }
+
+  // Deserialize the chunks in parallel, in the reverse order, as the
+  // threads of the server.
+  framework::Scope scope;
+  std::vector<std::unique_ptr<operators::distributed::GRPCVariableResponse>>
+      resps;
+  std::vector<std::thread> threads;
+  for (int64_t i = chunk_num - 1; i >= 0; --i) {
+    resps.emplace_back(
+        new operators::distributed::GRPCVariableResponse(&scope, &ctx, true));
+    auto* resp = resps.back().get();
+    threads.emplace_back(
+        [resp, &msgs, i] { EXPECT_EQ(resp->Parse(msgs[i]), 0); });
+  }
+  for (auto& t : threads) t.join();
+
+  int complete = 0;
+  for (auto& resp : resps) {
+    if (resp->IsPendingChunk()) continue;
+    ++complete;
+    auto& tensor2 = resp->GetVar()->Get<framework::LoDTensor>();
+    EXPECT_EQ(tensor2.dims(), tensor->dims());
+    EXPECT_EQ(tensor2.lod(), tensor->lod());
+    const float* data2 = tensor2.data<float>();
+    for (int i = 0; i < 1000 * 300; ++i) ASSERT_EQ(data2[i], data[i]);
+  }
+  EXPECT_EQ(complete, 1);
+
+  // A small tensor is sent whole.
+  EXPECT_EQ(operators::distributed::NumSendChunks(var, 64 << 20), 1);
+  EXPECT_EQ(operators::distributed::NumSendChunks(var, 0), 1);
+}
+
+// Parse the chunks [begin, end) of the send seq of var, and count the
+// chunks failed and the tensors completed.
+static void ParseChunks(const std::string& name, framework::Variable* var,
+                        int64_t seq, int64_t begin, int64_t end,
+                        framework::Scope* scope, int* failed, int* complete) {
+  platform::CPUPlace place;
+  platform::CPUDeviceContext ctx(place);
+  *failed = *complete = 0;
+  for (int64_t i = begin; i < end; ++i) {
+    ::grpc::ByteBuffer msg;
+    operators::distributed::SerializeChunkToByteBuffer(
+        name, var, ctx, 256 << 10, seq, i, &msg, 1);
+    operators::distributed::GRPCVariableResponse resp(scope, &ctx, true);
+    if (resp.Parse(msg) != 0) {
+      ++*failed;
+    } else if (!resp.IsPendingChunk()) {
+      ++*complete;
+    }
+  }
+}
+
+TEST(LodTensor, ChunksOfFailedSends) {
+  framework::Variable var;
+  auto* tensor = var.GetMutable<framework::LoDTensor>();
+  float* data = tensor->mutable_data<float>(framework::make_ddim({1000, 300}),
+                                            platform::CPUPlace());
+  for (int i = 0; i < 1000 * 300; ++i) data[i] = i;
+  framework::Scope scope;
+  int failed, complete;
+
+  // A send fails after 3 of its 5 chunks, and is retried.
+  ParseChunks("retried", &var, 10, 0, 3, &scope, &failed, &complete);
+  EXPECT_EQ(failed, 0);
+  EXPECT_EQ(complete, 0);
+  ParseChunks("retried", &var, 11, 0, 5, &scope, &failed, &complete);
+  EXPECT_EQ(failed, 0);
+  EXPECT_EQ(complete, 1);
+  // The chunks of the failed send arriving late are dropped.
+  ParseChunks("retried", &var, 10, 3, 5, &scope, &failed, &complete);
+  EXPECT_EQ(failed, 2);
+  EXPECT_EQ(complete, 0);
+
+  // The chunks of a send left after the rpc deadline are dropped when
+  // another send starts, so that the rest never complete the tensor.
+  const int deadline = FLAGS_rpc_deadline;
+  FLAGS_rpc_deadline = 1;
+  ParseChunks("expired", &var, 20, 0, 4, &scope, &failed, &complete);
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ParseChunks("other", &var, 21, 0, 1, &scope, &failed, &complete);
+  ParseChunks("expired", &var, 20, 4, 5, &scope, &failed, &complete);
+  EXPECT_EQ(failed, 0);
+  EXPECT_EQ(complete, 0);
+  FLAGS_rpc_deadline = deadline;
+}
+
@@ -104,6 +104,11 @@ class RequestSend final : public RequestBase {
   void Process() override {
     std::string varname = GetReqName();
     VLOG(4) << "RequestSend var_name:" << varname;
+    if (request_->IsPendingChunk()) {
+      // The tensor is handled with its last chunk.
+      Finish(reply_, &responder_);
+      return;
+    }
 
     auto scope = request_->GetMutableLocalScope();
     auto invar = request_->GetVar();
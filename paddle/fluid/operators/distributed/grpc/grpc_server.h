@@ -43,7 +43,7 @@ namespace distributed {
 
 class RequestBase;
 
-class AsyncGRPCServer final : public RPCServer {
+class AsyncGRPCServer : public RPCServer {
  public:
   explicit AsyncGRPCServer(const std::string& address, int client_num)
       : RPCServer(address, client_num), ready_(0) {}
@@ -52,6 +52,9 @@ class AsyncGRPCServer final : public RPCServer {
   void WaitServerReady() override;
   void StartServer() override;
 
+ protected:
+  void ShutDownImpl() override;
+
  private:
   // HandleRequest needs to be thread-safe.
   void HandleRequest(
@@ -60,7 +63,6 @@ class AsyncGRPCServer final : public RPCServer {
 
   void TryToRegisterNewOne(const std::string& rpc_name, int req_id);
   void ShutdownQueue();
-  void ShutDownImpl() override;
 
  private:
   static const int kRequestBufSize = 100;
@@ -110,7 +110,8 @@ int GRPCVariableResponse::Parse(Source* source) {
   input.SetTotalBytesLimit(INT_MAX, INT_MAX);
 
   while (true) {
-    auto p = input.ReadTagWithCutoff(127);
+    // The tags of the fields from 16 take two bytes.
+    auto p = input.ReadTagWithCutoff(255);
     int tag = GetTagFieldNumber(p.first);
     WireType wt = GetTagWireType(p.first);
     if (!p.second) {
@@ -315,6 +316,30 @@ int GRPCVariableResponse::Parse(Source* source) {
         meta_.set_table_name(temp);
         break;
       }
+      case sendrecv::VariableMessage::kChunkOffsetFieldNumber: {
+        uint64_t v = 0;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint64(&v)) {
+          return tag;
+        }
+        meta_.set_chunk_offset(static_cast<int64_t>(v));
+        break;
+      }
+      case sendrecv::VariableMessage::kChunkNumFieldNumber: {
+        uint64_t v = 0;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint64(&v)) {
+          return tag;
+        }
+        meta_.set_chunk_num(static_cast<int64_t>(v));
+        break;
+      }
+      case sendrecv::VariableMessage::kChunkSeqFieldNumber: {
+        uint64_t v = 0;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint64(&v)) {
+          return tag;
+        }
+        meta_.set_chunk_seq(static_cast<int64_t>(v));
+        break;
+      }
       default: {
         // Unknown tag, return unknown error.
         return -1;
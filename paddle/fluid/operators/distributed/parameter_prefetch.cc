@@ -28,6 +28,7 @@
 #include "paddle/fluid/framework/tensor.h"
 
 #include "paddle/fluid/operators/distributed/distributed.h"
+#include "paddle/fluid/operators/distributed/prefetch_row_cache.h"
 #include "paddle/fluid/operators/distributed/rpc_client.h"
 #include "paddle/fluid/operators/distributed/variable_response.h"
 #include "paddle/fluid/operators/distributed_ops/send_recv_util.h"
@@ -220,8 +221,25 @@ void prefetchs(const std::vector<std::string>& id_var_names,
   }
 
   std::unordered_map<int64_t, std::vector<float>> recved_vec_map;
-  prefetch_core(ids_union, tables, height_sections, context, scope,
-                &recved_vec_map);
+  auto* cache = PrefetchRowCache::GetInstance();
+  if (cache != nullptr) {
+    // Only prefetch the rows which are not cached or are too stale.
+    std::vector<int64_t> missed_ids;
+    cache->Lookup(persistable_var_name, ids_union, &recved_vec_map,
+                  &missed_ids);
+    VLOG(3) << "prefetch " << missed_ids.size() << " of " << ids_union.size()
+            << " rows of " << persistable_var_name;
+    if (!missed_ids.empty()) {
+      std::unordered_map<int64_t, std::vector<float>> missed_vec_map;
+      prefetch_core(missed_ids, tables, height_sections, context, scope,
+                    &missed_vec_map);
+      cache->Insert(persistable_var_name, missed_vec_map);
+      recved_vec_map.insert(missed_vec_map.begin(), missed_vec_map.end());
+    }
+  } else {
+    prefetch_core(ids_union, tables, height_sections, context, scope,
+                  &recved_vec_map);
+  }
 
   auto padding_idx = distributed::kNoPadding;
 
@@ -76,7 +76,8 @@ inline EP_SPLIT_TABLE_PAIRS GetMultiFieldRpcContext(
 template <typename T>
 void ParameterSend<T>::operator()(const RpcContext &rpc_ctx,
                                   const framework::Scope &scope, bool sync,
-                                  int multi_parts) {
+                                  int multi_parts,
+                                  GradientCompressor *compressor) {
   std::unique_ptr<framework::Scope> local_scope = scope.NewTmpScope();
 
   platform::DeviceContextPool &pool = platform::DeviceContextPool::Instance();
@@ -124,9 +125,18 @@ void ParameterSend<T>::operator()(const RpcContext &rpc_ctx,
       VLOG(4) << "send var endpoint: " << endpoint;
       VLOG(4) << "need send: " << NeedSend(*local_scope.get(), send_var_name);
       if (NeedSend(*local_scope.get(), send_var_name)) {
-        VLOG(3) << "sending " << send_var_name << " to " << endpoint;
-        rets.push_back(rpc_client->AsyncSendVar(
-            endpoint, cpu_ctx, *local_scope.get(), send_var_name));
+        std::string send_name = send_var_name;
+        if (compressor != nullptr) {
+          auto &slice = local_scope->FindVar(send_var_name)->Get<LoDTensor>();
+          auto *encoded = local_scope->Var(EncodedGradientName(send_var_name))
+                              ->GetMutable<LoDTensor>();
+          if (compressor->Encode(send_var_name, slice, encoded)) {
+            send_name = EncodedGradientName(send_var_name);
+          }
+        }
+        VLOG(3) << "sending " << send_name << " to " << endpoint;
+        rets.push_back(rpc_client->AsyncSendVar(endpoint, cpu_ctx,
+                                                *local_scope.get(), send_name));
         VLOG(4) << "send var " << send_var_name << " async handle done";
       } else {
         VLOG(3) << "don't send non-initialized variable: "
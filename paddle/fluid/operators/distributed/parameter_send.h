@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/operators/distributed/gradient_compressor.h"
 #include "paddle/fluid/operators/distributed/rpc_common.h"
 
 namespace paddle {
@@ -26,8 +27,11 @@ namespace distributed {
 
 template <typename T>
 struct ParameterSend {
+  // The slices of a dense variable are encoded by compressor if it is not
+  // nullptr.
   void operator()(const RpcContext &rpc_ctx, const framework::Scope &scope,
-                  bool sync, int multi_parts);
+                  bool sync, int multi_parts,
+                  GradientCompressor *compressor = nullptr);
 };
 
 };  // namespace distributed
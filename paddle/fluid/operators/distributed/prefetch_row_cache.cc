@@ -0,0 +1,135 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/distributed/prefetch_row_cache.h"
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+std::unique_ptr<PrefetchRowCache> PrefetchRowCache::cache_(nullptr);
+
+void PrefetchRowCache::Init(int64_t capacity, int max_staleness) {
+  if (cache_ == nullptr) {
+    VLOG(0) << "cache " << capacity << " prefetched rows of each table for "
+            << max_staleness << " steps";
+    cache_.reset(new PrefetchRowCache(capacity, max_staleness));
+  }
+}
+
+PrefetchRowCache::PrefetchRowCache(int64_t capacity, int max_staleness,
+                                   int shard_num)
+    : shard_capacity_((capacity + shard_num - 1) / shard_num),
+      max_staleness_(max_staleness),
+      shard_num_(shard_num) {
+  PADDLE_ENFORCE_GT(capacity, 0, "the capacity of the cache should be > 0");
+  PADDLE_ENFORCE_GE(max_staleness, 0, "max_staleness should be >= 0");
+  PADDLE_ENFORCE_GT(shard_num, 0, "shard_num should be > 0");
+}
+
+double PrefetchRowCache::hit_rate() const {
+  const int64_t total = hits_ + misses_;
+  return total == 0 ? 0. : static_cast<double>(hits_) / total;
+}
+
+PrefetchRowCache::TableShards* PrefetchRowCache::GetTable(
+    const std::string& table) {
+  std::lock_guard<std::mutex> lock(tables_mutex_);
+  auto& shards = tables_[table];
+  if (shards == nullptr) {
+    shards.reset(new TableShards());
+    for (int i = 0; i < shard_num_; ++i) {
+      shards->emplace_back(new Shard());
+    }
+  }
+  return shards.get();
+}
+
+PrefetchRowCache::Shard* PrefetchRowCache::GetShard(TableShards* shards,
+                                                    int64_t id) const {
+  return (*shards)[static_cast<uint64_t>(id) % shard_num_].get();
+}
+
+void PrefetchRowCache::Lookup(
+    const std::string& table, const std::vector<int64_t>& ids,
+    std::unordered_map<int64_t, std::vector<float>>* rows,
+    std::vector<int64_t>* misses) {
+  auto* shards = GetTable(table);
+  // Group the ids by shard to take each lock once.
+  std::vector<std::vector<int64_t>> shard_ids(shard_num_);
+  for (auto id : ids) {
+    shard_ids[static_cast<uint64_t>(id) % shard_num_].push_back(id);
+  }
+
+  const int64_t step = step_;
+  int64_t hits = 0;
+  int64_t bytes = 0;
+  for (int i = 0; i < shard_num_; ++i) {
+    if (shard_ids[i].empty()) continue;
+    auto* shard = (*shards)[i].get();
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    for (auto id : shard_ids[i]) {
+      auto it = shard->index.find(id);
+      if (it == shard->index.end()) {
+        misses->push_back(id);
+        continue;
+      }
+      auto entry = it->second;
+      if (step - entry->step > max_staleness_) {
+        shard->lru.erase(entry);
+        shard->index.erase(it);
+        misses->push_back(id);
+        continue;
+      }
+      shard->lru.splice(shard->lru.begin(), shard->lru, entry);
+      (*rows)[id] = entry->row;
+      ++hits;
+      bytes += entry->row.size() * sizeof(float);
+    }
+  }
+  hits_ += hits;
+  misses_ += ids.size() - hits;
+  bytes_saved_ += bytes;
+}
+
+void PrefetchRowCache::Insert(
+    const std::string& table,
+    const std::unordered_map<int64_t, std::vector<float>>& rows) {
+  auto* shards = GetTable(table);
+  const int64_t step = step_;
+  for (auto& item : rows) {
+    auto* shard = GetShard(shards, item.first);
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    auto it = shard->index.find(item.first);
+    if (it != shard->index.end()) {
+      it->second->step = step;
+      it->second->row = item.second;
+      shard->lru.splice(shard->lru.begin(), shard->lru, it->second);
+      continue;
+    }
+    shard->lru.push_front(Entry{item.first, step, item.second});
+    shard->index[item.first] = shard->lru.begin();
+    if (static_cast<int64_t>(shard->index.size()) > shard_capacity_) {
+      shard->index.erase(shard->lru.back().id);
+      shard->lru.pop_back();
+    }
+  }
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,105 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// A LRU cache of the rows of the distributed lookup tables prefetched by the
+// trainer. A row is served from the cache for max_staleness steps after it
+// is prefetched, where a step is a recv cycle of the communicator, so the
+// rows updated on the pserver by the other trainers are refetched in time.
+//
+// The rows of a table are kept in shards by id, each with its own lock and
+// an equal part of the capacity.
+class PrefetchRowCache {
+ public:
+  PrefetchRowCache(int64_t capacity, int max_staleness, int shard_num = 16);
+
+  // Copy the fresh cached rows of ids into rows, and the other ids into
+  // misses.
+  void Lookup(const std::string& table, const std::vector<int64_t>& ids,
+              std::unordered_map<int64_t, std::vector<float>>* rows,
+              std::vector<int64_t>* misses);
+
+  // Cache the rows prefetched at the current step.
+  void Insert(const std::string& table,
+              const std::unordered_map<int64_t, std::vector<float>>& rows);
+
+  // Start the next step, called after each recv cycle of the communicator.
+  void Advance() { ++step_; }
+
+  int64_t step() const { return step_; }
+  int64_t hits() const { return hits_; }
+  int64_t misses() const { return misses_; }
+  // The bytes of the rows served from the cache instead of the pserver.
+  int64_t bytes_saved() const { return bytes_saved_; }
+  double hit_rate() const;
+
+ private:
+  struct Entry {
+    int64_t id;
+    int64_t step;
+    std::vector<float> row;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    // The most recently used entry first.
+    std::list<Entry> lru;
+    std::unordered_map<int64_t, std::list<Entry>::iterator> index;
+  };
+
+  using TableShards = std::vector<std::unique_ptr<Shard>>;
+
+  TableShards* GetTable(const std::string& table);
+  Shard* GetShard(TableShards* shards, int64_t id) const;
+
+  const int64_t shard_capacity_;
+  const int max_staleness_;
+  const int shard_num_;
+
+  std::mutex tables_mutex_;
+  std::unordered_map<std::string, std::unique_ptr<TableShards>> tables_;
+
+  std::atomic<int64_t> step_{0};
+  std::atomic<int64_t> hits_{0};
+  std::atomic<int64_t> misses_{0};
+  std::atomic<int64_t> bytes_saved_{0};
+
+ public:
+  // The cache of the trainer is created by the communicator, and is null
+  // when the rows are not cached.
+  static void Init(int64_t capacity, int max_staleness);
+
+  static PrefetchRowCache* GetInstance() { return cache_.get(); }
+
+ private:
+  static std::unique_ptr<PrefetchRowCache> cache_;
+};
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,136 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/operators/distributed/prefetch_row_cache.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+using RowMap = std::unordered_map<int64_t, std::vector<float>>;
+
+static RowMap MakeRows(const std::vector<int64_t>& ids, float value) {
+  RowMap rows;
+  for (auto id : ids) {
+    rows[id] = std::vector<float>(8, value + id);
+  }
+  return rows;
+}
+
+TEST(PrefetchRowCache, hit_and_miss) {
+  PrefetchRowCache cache(100, 1, 4);
+  RowMap rows;
+  std::vector<int64_t> misses;
+  cache.Lookup("emb", {1, 2, 3}, &rows, &misses);
+  EXPECT_TRUE(rows.empty());
+  EXPECT_EQ(misses.size(), 3UL);
+
+  cache.Insert("emb", MakeRows({1, 2}, 0.f));
+  rows.clear();
+  misses.clear();
+  cache.Lookup("emb", {1, 2, 3}, &rows, &misses);
+  ASSERT_EQ(rows.size(), 2UL);
+  EXPECT_EQ(rows[2][0], 2.f);
+  EXPECT_EQ(misses, std::vector<int64_t>({3}));
+
+  // The tables are cached apart.
+  rows.clear();
+  misses.clear();
+  cache.Lookup("other", {1}, &rows, &misses);
+  EXPECT_EQ(misses.size(), 1UL);
+
+  EXPECT_EQ(cache.hits(), 2);
+  EXPECT_EQ(cache.misses(), 5);
+  EXPECT_EQ(cache.bytes_saved(), 2 * 8 * sizeof(float));
+}
+
+TEST(PrefetchRowCache, staleness) {
+  PrefetchRowCache cache(100, 1, 1);
+  cache.Insert("emb", MakeRows({7}, 0.f));
+  for (int step = 0; step < 3; ++step) {
+    RowMap rows;
+    std::vector<int64_t> misses;
+    cache.Lookup("emb", {7}, &rows, &misses);
+    // Served at the step it is prefetched and the next one.
+    EXPECT_EQ(rows.size(), step <= 1 ? 1UL : 0UL) << "step " << step;
+    cache.Advance();
+  }
+
+  // A refetched row is fresh again.
+  cache.Insert("emb", MakeRows({7}, 1.f));
+  RowMap rows;
+  std::vector<int64_t> misses;
+  cache.Lookup("emb", {7}, &rows, &misses);
+  ASSERT_EQ(rows.size(), 1UL);
+  EXPECT_EQ(rows[7][0], 8.f);
+}
+
+TEST(PrefetchRowCache, lru_eviction) {
+  PrefetchRowCache cache(3, 10, 1);
+  for (int64_t id : {1, 2, 3}) {
+    cache.Insert("emb", MakeRows({id}, 0.f));
+  }
+  // Use 1, so 2 is the least recently used.
+  RowMap rows;
+  std::vector<int64_t> misses;
+  cache.Lookup("emb", {1}, &rows, &misses);
+  cache.Insert("emb", MakeRows({4}, 0.f));
+
+  rows.clear();
+  misses.clear();
+  cache.Lookup("emb", {1, 2, 3, 4}, &rows, &misses);
+  EXPECT_EQ(rows.size(), 3UL);
+  EXPECT_EQ(misses, std::vector<int64_t>({2}));
+}
+
+// With a zipf-like distribution of the ids, most of the rows of a batch are
+// served from a cache of a small part of the table.
+TEST(PrefetchRowCache, heavy_tailed_ids) {
+  const int64_t table_rows = 100000;
+  PrefetchRowCache cache(table_rows / 10, 5);
+  std::vector<double> weights(table_rows);
+  for (int64_t i = 0; i < table_rows; ++i) {
+    weights[i] = 1. / (i + 1);
+  }
+  std::discrete_distribution<int64_t> zipf(weights.begin(), weights.end());
+
+  std::vector<std::thread> trainers;
+  for (int t = 0; t < 4; ++t) {
+    trainers.emplace_back([&cache, &zipf, t] {
+      std::mt19937 rng(t);
+      auto dist = zipf;
+      for (int batch = 0; batch < 50; ++batch) {
+        std::vector<int64_t> ids(1000);
+        for (auto& id : ids) id = dist(rng);
+        RowMap rows;
+        std::vector<int64_t> misses;
+        cache.Lookup("emb", ids, &rows, &misses);
+        cache.Insert("emb", MakeRows(misses, 0.f));
+      }
+    });
+  }
+  for (auto& t : trainers) t.join();
+  EXPECT_EQ(cache.hits() + cache.misses(), 4 * 50 * 1000);
+  EXPECT_GT(cache.hit_rate(), 0.5);
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
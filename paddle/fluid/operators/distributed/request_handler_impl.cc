@@ -28,6 +28,7 @@
 #include "paddle/fluid/string/split.h"
 
 #include "paddle/fluid/operators/distributed/async_sparse_param_update_recorder.h"
+#include "paddle/fluid/operators/distributed/gradient_compressor.h"
 #include "paddle/fluid/operators/distributed/heart_beat_monitor.h"
 
 namespace paddle {
@@ -47,6 +48,16 @@ bool RequestSendHandler::Handle(const std::string& varname,
                                 const std::string& table_name) {
   VLOG(4) << "RequestSendHandler:" << varname;
 
+  // The gradient encoded by the communicator of the trainer, received into
+  // the variable of the gradient.
+  if (IsEncodedGradientName(varname)) {
+    PADDLE_ENFORCE_NOT_NULL(invar, "can not find server side var of %s",
+                            varname);
+    DecodeGradient(invar);
+    return Handle(DecodedGradientName(varname), scope, invar, outvar,
+                  trainer_id, out_var_name, table_name);
+  }
+
   // Sync
   if (varname == BATCH_BARRIER_MESSAGE) {
     VLOG(3) << "sync: recv BATCH_BARRIER_MESSAGE";
@@ -0,0 +1,259 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/shm/shm_client.h"
+
+#include <cstring>
+
+#include "glog/logging.h"
+#include "paddle/fluid/framework/threadpool.h"
+#include "paddle/fluid/platform/profiler.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// A parameter server on this host may start after the trainer.
+static constexpr int kShmProbeIntervalMs = 1000;
+
+struct ShmClient::Channel {
+  std::string ep;
+  std::unique_ptr<ShmSegment> segment;
+  int index;
+  // The requests are written by the threads of AsyncIO one by one.
+  std::mutex write_mutex;
+  std::unique_ptr<std::thread> receiver;
+
+  std::mutex pending_mutex;
+  std::unordered_map<int64_t, VarHandlePtr> pending;
+  bool closed{false};
+
+  ShmRing* request() { return segment->request(index); }
+  ShmRing* response() { return segment->response(index); }
+};
+
+ShmClient::ShmClient() : enabled_(FLAGS_rpc_shm_transport) {}
+
+ShmClient::~ShmClient() {
+  Wait();
+  std::lock_guard<std::mutex> guard(chan_mutex_);
+  for (auto& it : channels_) {
+    closed_channels_.emplace_back(std::move(it.second));
+  }
+  channels_.clear();
+  for (auto& channel : closed_channels_) {
+    // The response ring is closed first, so that the receiver exits before
+    // the parameter server frees the channel.
+    channel->response()->Close();
+    channel->receiver->join();
+    channel->request()->Close();
+  }
+}
+
+sendrecv::VariableMessage ShmClient::Meta(const std::string& varname,
+                                          const std::string& out_varname,
+                                          const std::string& table_name,
+                                          int trainer_id) {
+  sendrecv::VariableMessage meta;
+  meta.set_varname(varname);
+  meta.set_trainer_id(trainer_id);
+  if (!out_varname.empty()) {
+    meta.set_out_varname(out_varname);
+  }
+  if (!table_name.empty()) {
+    meta.set_table_name(table_name);
+  }
+  return meta;
+}
+
+std::vector<std::string> ShmClient::Endpoints() {
+  std::lock_guard<std::mutex> guard(chan_mutex_);
+  std::vector<std::string> eps;
+  for (auto& it : channels_) {
+    eps.push_back(it.first);
+  }
+  return eps;
+}
+
+ShmClient::Channel* ShmClient::GetChannel(const std::string& ep) {
+  if (!enabled_) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> guard(chan_mutex_);
+  auto it = channels_.find(ep);
+  if (it != channels_.end()) {
+    std::lock_guard<std::mutex> lock(it->second->pending_mutex);
+    if (!it->second->closed) {
+      return it->second.get();
+    }
+    closed_channels_.emplace_back(std::move(it->second));
+    channels_.erase(it);
+  }
+  if (remote_endpoints_.count(ep)) {
+    return nullptr;
+  }
+  auto now = std::chrono::steady_clock::now();
+  auto probe = probe_time_.find(ep);
+  if (probe != probe_time_.end() &&
+      now - probe->second <
+          std::chrono::milliseconds(kShmProbeIntervalMs)) {
+    return nullptr;
+  }
+  probe_time_[ep] = now;
+
+  int port = EndpointPort(ep);
+  if (port <= 0 || !IsLocalEndpoint(ep)) {
+    remote_endpoints_.insert(ep);
+    return nullptr;
+  }
+  auto segment = ShmSegment::Open(ep);
+  int index = segment ? segment->Claim() : -1;
+  if (index < 0) {
+    VLOG(3) << "no shm channel of " << ep << ", use the socket";
+    return nullptr;
+  }
+
+  std::unique_ptr<Channel> channel(new Channel());
+  channel->ep = ep;
+  channel->segment = std::move(segment);
+  channel->index = index;
+  channel->receiver.reset(
+      new std::thread(&ShmClient::Receive, this, channel.get()));
+  VLOG(1) << "send the requests to " << ep << " through shm channel "
+          << index;
+  auto* ptr = channel.get();
+  channels_[ep] = std::move(channel);
+  return ptr;
+}
+
+VarHandlePtr ShmClient::Call(const std::string& ep, int rpc,
+                             const std::string& method,
+                             const std::string& handle_name,
+                             const platform::DeviceContext* ctx,
+                             const framework::Scope* scope,
+                             const sendrecv::VariableMessage& meta,
+                             const std::string& send_var) {
+  Channel* channel = GetChannel(ep);
+  if (channel == nullptr) {
+    return nullptr;
+  }
+  VarHandlePtr h(new VarHandle(ep, method, handle_name, ctx, scope));
+
+  ShmMessageHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.rpc = rpc;
+  {
+    std::lock_guard<std::mutex> lock(sync_mutex_);
+    header.id = next_id_++;
+    req_count_++;
+  }
+  {
+    std::lock_guard<std::mutex> lock(channel->pending_mutex);
+    if (channel->closed) {
+      Complete(h, false);
+      return h;
+    }
+    channel->pending[header.id] = h;
+  }
+
+  framework::AsyncIO([channel, header, meta, send_var, ctx, scope, method] {
+    framework::Variable* var =
+        send_var.empty() ? nullptr : scope->FindVar(send_var);
+    sendrecv::VariableMessage request = meta;
+    platform::RecordRPCEvent record_event(method);
+    std::lock_guard<std::mutex> lock(channel->write_mutex);
+    if (!WriteShmMessage(channel->request(), header, &request, var, ctx)) {
+      // The receiver fails the pending requests once the server exits.
+      LOG(WARNING) << "send " << method << " to " << channel->ep
+                   << " through shm failed";
+    }
+  });
+
+  if (UNLIKELY(platform::IsProfileEnabled())) {
+    h->Wait();
+  }
+  return h;
+}
+
+void ShmClient::Receive(Channel* channel) {
+  auto* response = channel->response();
+  while (true) {
+    ShmMessageHeader header;
+    sendrecv::VariableMessage meta;
+    if (!ReadShmMeta(response, &header, &meta)) {
+      break;
+    }
+    VarHandlePtr h;
+    {
+      std::lock_guard<std::mutex> lock(channel->pending_mutex);
+      auto it = channel->pending.find(header.id);
+      if (it != channel->pending.end()) {
+        h = it->second;
+        channel->pending.erase(it);
+      }
+    }
+    if (h == nullptr) {
+      // The channel is out of sync, fail the pending requests below rather
+      // than throwing in the receiver thread.
+      LOG(ERROR) << "unknown shm response " << header.id << " from "
+                 << channel->ep;
+      break;
+    }
+    framework::Variable* var = nullptr;
+    if (header.has_var && h->scope() != nullptr) {
+      var = h->scope()->FindVar(meta.varname());
+    }
+    bool ok = ReadShmVariable(response, header, meta, h->ctx(), var);
+    Complete(h, ok && header.status == 0 && (var || !header.has_var));
+    if (!ok) {
+      break;
+    }
+  }
+
+  // The parameter server exits or is shut down, or the client is destroyed.
+  std::unordered_map<int64_t, VarHandlePtr> pending;
+  {
+    std::lock_guard<std::mutex> lock(channel->pending_mutex);
+    channel->closed = true;
+    pending.swap(channel->pending);
+  }
+  for (auto& it : pending) {
+    LOG(ERROR) << it.second->String() << " meets shm error, the server of "
+               << channel->ep << " exited";
+    Complete(it.second, false);
+  }
+}
+
+void ShmClient::Complete(const VarHandlePtr& h, bool ok) {
+  VLOG(3) << h->String() << " process";
+  h->Finish(ok);
+  {
+    std::lock_guard<std::mutex> lock(sync_mutex_);
+    req_count_--;
+    if (!ok) {
+      ok_ = false;
+    }
+  }
+  sync_cond_.notify_all();
+}
+
+bool ShmClient::Wait() {
+  std::unique_lock<std::mutex> lock(sync_mutex_);
+  sync_cond_.wait(lock, [this] { return req_count_ == 0 || !ok_; });
+  return ok_;
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
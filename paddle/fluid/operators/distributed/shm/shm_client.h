@@ -0,0 +1,274 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/operators/distributed/request_handler.h"
+#include "paddle/fluid/operators/distributed/rpc_client.h"
+#include "paddle/fluid/operators/distributed/shm/shm_segment.h"
+#include "paddle/fluid/operators/distributed/shm/shm_serde.h"
+#include "paddle/fluid/string/printf.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// The shared memory side of a trainer. It claims a channel of each parameter
+// server on the same host, and a thread of each channel reads the responses
+// into the scopes of the VarHandles.
+class ShmClient {
+ public:
+  ShmClient();
+  ~ShmClient();
+
+  // Send a request of rpc to ep through shared memory, or return nullptr if
+  // ep is not served so, e.g. on another host. An endpoint on this host
+  // without a segment, e.g. of a parameter server not started yet, is probed
+  // again after a while. The variable send_var of scope is sent with the
+  // request if it is not empty.
+  VarHandlePtr Call(const std::string& ep, int rpc, const std::string& method,
+                    const std::string& handle_name,
+                    const platform::DeviceContext* ctx,
+                    const framework::Scope* scope,
+                    const sendrecv::VariableMessage& meta,
+                    const std::string& send_var = "");
+
+  bool Wait();
+
+  // The local endpoints served through shared memory.
+  std::vector<std::string> Endpoints();
+
+  static sendrecv::VariableMessage Meta(const std::string& varname,
+                                        const std::string& out_varname = "",
+                                        const std::string& table_name = "",
+                                        int trainer_id = 0);
+
+ private:
+  struct Channel;
+
+  Channel* GetChannel(const std::string& ep);
+  void Receive(Channel* channel);
+  void Complete(const VarHandlePtr& h, bool ok);
+
+  const bool enabled_;
+
+  std::mutex chan_mutex_;
+  std::unordered_map<std::string, std::unique_ptr<Channel>> channels_;
+  // The channels of the servers exited, whose threads are joined at last.
+  std::vector<std::unique_ptr<Channel>> closed_channels_;
+  std::unordered_set<std::string> remote_endpoints_;
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+      probe_time_;
+
+  // mutex for Wait client sync
+  std::mutex sync_mutex_;
+  std::condition_variable sync_cond_;
+  int64_t req_count_{0};
+  int64_t next_id_{0};
+  bool ok_{true};
+};
+
+// A client of SocketClient, which sends the requests to the parameter
+// servers on the same host through shared memory if FLAGS_rpc_shm_transport
+// is set. The variables are copied between the tensors and the shared rings
+// directly, and the time_out of the requests is not used, since a request
+// fails once the parameter server exits.
+template <typename SocketClient>
+class ShmRPCClient : public SocketClient {
+ public:
+  ShmRPCClient() {}
+  virtual ~ShmRPCClient() {}
+
+  VarHandlePtr AsyncSendVar(const std::string& ep,
+                            const platform::DeviceContext& ctx,
+                            const framework::Scope& scope,
+                            const std::string& var_name,
+                            int64_t time_out = FLAGS_rpc_deadline) override {
+    // The other types, e.g. the ncclUniqueId, are sent by the sockets.
+    auto* var = scope.FindVar(var_name);
+    if (var != nullptr &&
+        (var->IsType<framework::LoDTensor>() ||
+         var->IsType<framework::SelectedRows>())) {
+      VarHandlePtr h =
+          shm_.Call(ep, kShmSend, kSendRPC, var_name, &ctx, &scope,
+                    ShmClient::Meta(var_name, "", "", this->trainer_id_),
+                    var_name);
+      if (h) {
+        return h;
+      }
+    }
+    return SocketClient::AsyncSendVar(ep, ctx, scope, var_name, time_out);
+  }
+
+  VarHandlePtr AsyncGetVar(const std::string& ep,
+                           const platform::DeviceContext& ctx,
+                           const framework::Scope& scope,
+                           const std::string& var_name,
+                           const std::string& out_varname,
+                           const std::string& table_name = "",
+                           int64_t time_out = FLAGS_rpc_deadline) override {
+    VarHandlePtr h =
+        shm_.Call(ep, kShmGet, kGetRPC, out_varname, &ctx, &scope,
+                  ShmClient::Meta(var_name, out_varname, table_name,
+                                  this->trainer_id_));
+    return h ? h
+             : SocketClient::AsyncGetVar(ep, ctx, scope, var_name,
+                                         out_varname, table_name, time_out);
+  }
+
+  VarHandlePtr AsyncGetVarNoBarrier(
+      const std::string& ep, const platform::DeviceContext& ctx,
+      const framework::Scope& scope, const std::string& var_name,
+      const std::string& out_varname,
+      int64_t time_out = FLAGS_rpc_deadline) override {
+    std::string var_name_no_barrier =
+        string::Sprintf("%s%s", var_name, WITHOUT_BARRIER_MESSAGE);
+    VarHandlePtr h = shm_.Call(
+        ep, kShmGetNoBarrier, kGetNoBarrierRPC, out_varname, &ctx, &scope,
+        ShmClient::Meta(var_name_no_barrier, out_varname, "",
+                        this->trainer_id_));
+    return h ? h
+             : SocketClient::AsyncGetVarNoBarrier(ep, ctx, scope, var_name,
+                                                  out_varname, time_out);
+  }
+
+  VarHandlePtr AsyncGetMonomerVariable(
+      const std::string& ep, const platform::DeviceContext& ctx,
+      const framework::Scope& scope, const std::string& var_name,
+      int64_t time_out = FLAGS_rpc_deadline) override {
+    VarHandlePtr h = shm_.Call(
+        ep, kShmGetMonomerVariable, kGetMonomerRPC, var_name, &ctx, &scope,
+        ShmClient::Meta(var_name, var_name, "", this->trainer_id_));
+    return h ? h
+             : SocketClient::AsyncGetMonomerVariable(ep, ctx, scope, var_name,
+                                                     time_out);
+  }
+
+  VarHandlePtr AsyncPrefetchVar(
+      const std::string& ep, const platform::DeviceContext& ctx,
+      const framework::Scope& scope, const std::string& in_var_name,
+      const std::string& out_var_name, const std::string& table_name = "",
+      int64_t time_out = FLAGS_rpc_deadline) override {
+    VarHandlePtr h =
+        shm_.Call(ep, kShmPrefetch, kPrefetchRPC, out_var_name, &ctx, &scope,
+                  ShmClient::Meta(in_var_name, out_var_name, table_name),
+                  in_var_name);
+    return h ? h
+             : SocketClient::AsyncPrefetchVar(ep, ctx, scope, in_var_name,
+                                              out_var_name, table_name,
+                                              time_out);
+  }
+
+  VarHandlePtr AsyncSendBatchBarrier(
+      const std::string& ep, int64_t time_out = FLAGS_rpc_deadline) override {
+    VarHandlePtr h =
+        shm_.Call(ep, kShmSend, kBatchBarrierRPC, BATCH_BARRIER_MESSAGE,
+                  nullptr, nullptr, ShmClient::Meta(BATCH_BARRIER_MESSAGE));
+    return h ? h : SocketClient::AsyncSendBatchBarrier(ep, time_out);
+  }
+
+  VarHandlePtr AsyncSendFetchBarrier(
+      const std::string& ep, int64_t time_out = FLAGS_rpc_deadline) override {
+    VarHandlePtr h =
+        shm_.Call(ep, kShmGet, kFetchBarrierRPC, FETCH_BARRIER_MESSAGE,
+                  nullptr, nullptr, ShmClient::Meta(FETCH_BARRIER_MESSAGE));
+    return h ? h : SocketClient::AsyncSendFetchBarrier(ep, time_out);
+  }
+
+  VarHandlePtr AsyncGetMonomerBarrier(
+      const std::string& ep, const std::string& var_name,
+      int64_t time_out = FLAGS_rpc_deadline) override {
+    VarHandlePtr h =
+        shm_.Call(ep, kShmGetMonomerBarrier, kSendMonomerFetchBarrierRPC,
+                  var_name, nullptr, nullptr, ShmClient::Meta(var_name));
+    return h ? h
+             : SocketClient::AsyncGetMonomerBarrier(ep, var_name, time_out);
+  }
+
+  VarHandlePtr AsyncCheckpointNotify(
+      const std::string& ep, const std::string& dir,
+      int64_t time_out = FLAGS_rpc_deadline) override {
+    VarHandlePtr h =
+        shm_.Call(ep, kShmCheckpoint, kCheckPointNotifyRPC,
+                  CHECKPOINT_SAVE_MESSAGE, nullptr, nullptr,
+                  ShmClient::Meta(CHECKPOINT_SAVE_MESSAGE, dir));
+    return h ? h : SocketClient::AsyncCheckpointNotify(ep, dir, time_out);
+  }
+
+  VarHandlePtr AsyncDistributeNotify(
+      const std::string& ep, const std::string& type,
+      int64_t time_out = FLAGS_rpc_deadline) override {
+    VarHandlePtr h =
+        shm_.Call(ep, kShmNotify, kRequestNotify, LEARNING_RATE_DECAY_MESSAGE,
+                  nullptr, nullptr, ShmClient::Meta(type));
+    return h ? h : SocketClient::AsyncDistributeNotify(ep, type, time_out);
+  }
+
+  // The socket clients send the complete message to their channels through
+  // this method, so an endpoint reached by both transports, e.g. before its
+  // segment is created, still gets it once.
+  VarHandlePtr AsyncSendComplete(
+      const std::string& ep, int64_t time_out = FLAGS_rpc_deadline) override {
+    {
+      std::lock_guard<std::mutex> guard(completed_mutex_);
+      if (!completed_.insert(ep).second) {
+        VarHandlePtr h(new VarHandle(ep, kSendCompleteRPC, COMPLETE_MESSAGE,
+                                     nullptr, nullptr));
+        h->Finish(true);
+        return h;
+      }
+    }
+    VarHandlePtr h = shm_.Call(
+        ep, kShmSend, kSendCompleteRPC, COMPLETE_MESSAGE, nullptr, nullptr,
+        ShmClient::Meta(COMPLETE_MESSAGE, "", "", this->trainer_id_));
+    return h ? h : SocketClient::AsyncSendComplete(ep, time_out);
+  }
+
+  void SendComplete() override {
+    for (auto& ep : shm_.Endpoints()) {
+      AsyncSendComplete(ep);
+    }
+    SocketClient::SendComplete();
+    PADDLE_ENFORCE(shm_.Wait(), "internal shm rpc error");
+  }
+
+  bool Wait() override {
+    bool ok = shm_.Wait();
+    return SocketClient::Wait() && ok;
+  }
+
+ private:
+  ShmClient shm_;
+
+  std::mutex completed_mutex_;
+  std::set<std::string> completed_;
+};
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,140 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measure the round trips of send and get between a trainer and a parameter
+// server on the same host, through the shared memory transport and through
+// the socket of the RPC client it falls back to. The variables got back are
+// checked to be the ones sent.
+// Usage:
+//   shm_rpc_benchmark --repeat=100
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/operators/distributed/distributed.h"
+#include "paddle/fluid/operators/distributed/request_handler.h"
+#include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int32(repeat, 100, "The number of round trips of each size.");
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// Receive the variables into the scope, and return them to get.
+class EchoRequestHandler final : public RequestHandler {
+ public:
+  EchoRequestHandler() : RequestHandler(true) {}
+
+  bool Handle(const std::string& varname, framework::Scope* scope,
+              framework::Variable* var, framework::Variable** outvar,
+              const int trainer_id, const std::string& out_var_name = "",
+              const std::string& table_name = "") override {
+    if (outvar != nullptr) {
+      *outvar = scope_->FindVar(varname);
+    }
+    return true;
+  }
+};
+
+static double RoundTripMS(RPCClient* client, const std::string& ep,
+                          const platform::DeviceContext& ctx,
+                          framework::Scope* scope) {
+  const auto& x = scope->FindVar("x")->Get<framework::LoDTensor>();
+  platform::Timer timer;
+  for (int r = 0; r < FLAGS_repeat; ++r) {
+    timer.Resume();
+    client->AsyncSendVar(ep, ctx, *scope, "x");
+    PADDLE_ENFORCE(client->Wait(), "send x to %s failed", ep);
+    client->AsyncGetVar(ep, ctx, *scope, "x", "x_out");
+    PADDLE_ENFORCE(client->Wait(), "get x from %s failed", ep);
+    timer.Pause();
+
+    auto& out = scope->FindVar("x_out")->Get<framework::LoDTensor>();
+    PADDLE_ENFORCE_EQ(out.numel(), x.numel());
+    const float* x_data = x.data<float>();
+    const float* out_data = out.data<float>();
+    for (int64_t i = 0; i < x.numel(); i += 97) {
+      PADDLE_ENFORCE_EQ(out_data[i], x_data[i]);
+    }
+  }
+  return timer.ElapsedMS() / FLAGS_repeat;
+}
+
+static void Run() {
+  platform::CPUPlace place;
+  platform::CPUDeviceContext ctx(place);
+  const std::vector<int64_t> sizes = {1 << 8, 1 << 14, 1 << 18, 1 << 22};
+
+  framework::Scope server_scope;
+  server_scope.Var("x")->GetMutable<framework::LoDTensor>();
+  EchoRequestHandler handler;
+  handler.SetScope(&server_scope);
+  handler.SetDevCtx(&ctx);
+
+  FLAGS_rpc_shm_transport = true;
+  std::unique_ptr<RPCServer> server(new RPCSERVER_T("127.0.0.1:0", 1));
+  server->RegisterRPC(kRequestSend, &handler);
+  server->RegisterRPC(kRequestGet, &handler);
+  handler.SetRPCServer(server.get());
+  std::thread server_thread(&RPCServer::StartServer, server.get());
+  server->WaitServerReady();
+  const std::string ep =
+      "127.0.0.1:" + std::to_string(server->GetSelectedPort());
+
+  // The transport of a client is chosen when it is created.
+  std::unique_ptr<RPCClient> shm_client(new RPCCLIENT_T());
+  shm_client->InitImpl();
+  FLAGS_rpc_shm_transport = false;
+  std::unique_ptr<RPCClient> socket_client(new RPCCLIENT_T());
+  socket_client->InitImpl();
+
+  for (int64_t numel : sizes) {
+    framework::Scope scope;
+    auto* x = scope.Var("x")->GetMutable<framework::LoDTensor>();
+    float* data = x->mutable_data<float>(framework::make_ddim({numel}), place);
+    for (int64_t i = 0; i < numel; ++i) {
+      data[i] = static_cast<float>(i % 1000) / 7;
+    }
+    scope.Var("x_out")->GetMutable<framework::LoDTensor>();
+
+    double socket_ms = RoundTripMS(socket_client.get(), ep, ctx, &scope);
+    double shm_ms = RoundTripMS(shm_client.get(), ep, ctx, &scope);
+    LOG(INFO) << numel * sizeof(float) / 1024.0 << " KB: send and get "
+              << socket_ms << " ms through the socket, " << shm_ms
+              << " ms through shm, " << socket_ms / shm_ms << "x";
+  }
+
+  shm_client.reset();
+  socket_client.reset();
+  server->ShutDown();
+  server_thread.join();
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  paddle::operators::distributed::Run();
+  return 0;
+}
@@ -0,0 +1,522 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/shm/shm_segment.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ifaddrs.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+
+DEFINE_bool(rpc_shm_transport, false,
+            "Send the variables between the trainers and the parameter "
+            "servers on the same host through shared memory instead of "
+            "the sockets. Both sides need it.");
+DEFINE_int32(rpc_shm_ring_size_mb, 8,
+             "The size in MB of a ring buffer of the shared memory transport. "
+             "A trainer uses two rings of each parameter server.");
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+static constexpr uint64_t kShmMagic = 0x70616464726963ULL;
+static constexpr size_t kShmAlignment = 64;
+static constexpr long kShmWaitNanoSeconds = 100 * 1000 * 1000;  // NOLINT
+
+struct ShmRingHeader {
+  pthread_mutex_t mutex;
+  pthread_cond_t readable;
+  pthread_cond_t writable;
+  uint64_t read_pos;
+  uint64_t write_pos;
+  int32_t writer;
+  int32_t reader;
+  int32_t closed;
+};
+
+struct ShmSegmentHeader {
+  uint64_t magic;
+  int32_t pid;
+  int32_t num_channels;
+  uint64_t ring_capacity;
+  pthread_mutex_t mutex;
+  // The pid of the trainer of each channel, or 0 if it is free.
+  int32_t owners[1];
+};
+
+static size_t Align(size_t size) {
+  return (size + kShmAlignment - 1) / kShmAlignment * kShmAlignment;
+}
+
+static size_t SegmentHeaderBytes(int num_channels) {
+  return Align(sizeof(ShmSegmentHeader) + num_channels * sizeof(int32_t));
+}
+
+// The pid 0 is a side not attached yet, which is waited for.
+static bool ProcessAlive(int pid) {
+  return pid == 0 || kill(pid, 0) == 0 || errno == EPERM;
+}
+
+// The locks are robust, so that a process exits with a lock held does not
+// block the other side.
+static void InitMutex(pthread_mutex_t* mutex) {
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+  pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+  PADDLE_ENFORCE_EQ(pthread_mutex_init(mutex, &attr), 0);
+  pthread_mutexattr_destroy(&attr);
+}
+
+static void InitCond(pthread_cond_t* cond) {
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  PADDLE_ENFORCE_EQ(pthread_cond_init(cond, &attr), 0);
+  pthread_condattr_destroy(&attr);
+}
+
+static void Lock(pthread_mutex_t* mutex) {
+  int ret = pthread_mutex_lock(mutex);
+  if (ret == EOWNERDEAD) {
+    pthread_mutex_consistent(mutex);
+  } else {
+    PADDLE_ENFORCE_EQ(ret, 0, "lock the shared memory ring failed");
+  }
+}
+
+static void Unlock(pthread_mutex_t* mutex) { pthread_mutex_unlock(mutex); }
+
+// Return false if the wait times out.
+static bool TimedWait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  deadline.tv_nsec += kShmWaitNanoSeconds;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec += 1;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  int ret = pthread_cond_timedwait(cond, mutex, &deadline);
+  if (ret == EOWNERDEAD) {
+    pthread_mutex_consistent(mutex);
+  }
+  return ret != ETIMEDOUT;
+}
+
+ShmRing::ShmRing(void* base, size_t capacity)
+    : header_(static_cast<ShmRingHeader*>(base)),
+      data_(static_cast<char*>(base) + Align(sizeof(ShmRingHeader))),
+      capacity_(capacity) {}
+
+size_t ShmRing::Bytes(size_t capacity) {
+  return Align(sizeof(ShmRingHeader)) + Align(capacity);
+}
+
+void ShmRing::Init(void* base, size_t capacity) {
+  auto* header = static_cast<ShmRingHeader*>(base);
+  std::memset(header, 0, sizeof(ShmRingHeader));
+  InitMutex(&header->mutex);
+  InitCond(&header->readable);
+  InitCond(&header->writable);
+}
+
+size_t ShmRing::WaitReadable() {
+  Lock(&header_->mutex);
+  while (!header_->closed && header_->write_pos == header_->read_pos) {
+    if (!TimedWait(&header_->readable, &header_->mutex) &&
+        !ProcessAlive(header_->writer)) {
+      LOG(WARNING) << "the writer " << header_->writer
+                   << " of the shared memory ring exited";
+      header_->closed = 1;
+    }
+  }
+  size_t size =
+      header_->closed ? 0 : static_cast<size_t>(header_->write_pos -
+                                                header_->read_pos);
+  Unlock(&header_->mutex);
+  return size;
+}
+
+size_t ShmRing::WaitWritable() {
+  Lock(&header_->mutex);
+  while (!header_->closed &&
+         header_->write_pos - header_->read_pos == capacity_) {
+    if (!TimedWait(&header_->writable, &header_->mutex) &&
+        !ProcessAlive(header_->reader)) {
+      LOG(WARNING) << "the reader " << header_->reader
+                   << " of the shared memory ring exited";
+      header_->closed = 1;
+    }
+  }
+  size_t size = header_->closed
+                    ? 0
+                    : capacity_ - static_cast<size_t>(header_->write_pos -
+                                                      header_->read_pos);
+  Unlock(&header_->mutex);
+  return size;
+}
+
+// The positions are only moved by their own side, so the bytes between them
+// are copied without the lock.
+bool ShmRing::Write(const void* data, size_t size) {
+  const char* src = static_cast<const char*>(data);
+  while (size > 0) {
+    size_t free = WaitWritable();
+    if (free == 0) {
+      return false;
+    }
+    size_t offset = header_->write_pos % capacity_;
+    size_t n = std::min(std::min(size, free), capacity_ - offset);
+    std::memcpy(data_ + offset, src, n);
+    Lock(&header_->mutex);
+    header_->write_pos += n;
+    pthread_cond_signal(&header_->readable);
+    Unlock(&header_->mutex);
+    src += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool ShmRing::Read(void* data, size_t size) {
+  char* dst = static_cast<char*>(data);
+  while (size > 0) {
+    size_t used = WaitReadable();
+    if (used == 0) {
+      return false;
+    }
+    size_t offset = header_->read_pos % capacity_;
+    size_t n = std::min(std::min(size, used), capacity_ - offset);
+    if (dst != nullptr) {
+      std::memcpy(dst, data_ + offset, n);
+      dst += n;
+    }
+    Lock(&header_->mutex);
+    header_->read_pos += n;
+    pthread_cond_signal(&header_->writable);
+    Unlock(&header_->mutex);
+    size -= n;
+  }
+  return true;
+}
+
+bool ShmRing::Skip(size_t size) { return Read(nullptr, size); }
+
+void ShmRing::Close() {
+  Lock(&header_->mutex);
+  header_->closed = 1;
+  pthread_cond_broadcast(&header_->readable);
+  pthread_cond_broadcast(&header_->writable);
+  Unlock(&header_->mutex);
+}
+
+void ShmRing::Reset() {
+  Lock(&header_->mutex);
+  header_->read_pos = 0;
+  header_->write_pos = 0;
+  header_->writer = 0;
+  header_->reader = 0;
+  header_->closed = 0;
+  Unlock(&header_->mutex);
+}
+
+bool ShmRing::closed() const { return header_->closed != 0; }
+
+void ShmRing::set_writer(int pid) {
+  Lock(&header_->mutex);
+  header_->writer = pid;
+  Unlock(&header_->mutex);
+}
+
+void ShmRing::set_reader(int pid) {
+  Lock(&header_->mutex);
+  header_->reader = pid;
+  Unlock(&header_->mutex);
+}
+
+ShmSegment::ShmSegment(const std::string& name, void* base, size_t bytes,
+                       bool owner)
+    : name_(name),
+      base_(base),
+      bytes_(bytes),
+      owner_(owner),
+      header_(static_cast<ShmSegmentHeader*>(base)) {
+  const size_t ring_bytes = ShmRing::Bytes(header_->ring_capacity);
+  char* channel = static_cast<char*>(base) +
+                  SegmentHeaderBytes(header_->num_channels);
+  for (int i = 0; i < header_->num_channels; ++i) {
+    requests_.emplace_back(channel, header_->ring_capacity);
+    responses_.emplace_back(channel + ring_bytes, header_->ring_capacity);
+    channel += 2 * ring_bytes;
+  }
+}
+
+ShmSegment::~ShmSegment() {
+  munmap(base_, bytes_);
+  if (owner_) {
+    shm_unlink(name_.c_str());
+  }
+}
+
+// The pid of the parameter server of the segment, or 0 if there is no
+// segment of the name.
+static int SegmentServerPid(const std::string& name) {
+  int fd = shm_open(name.c_str(), O_RDONLY, 0600);
+  if (fd < 0) {
+    return 0;
+  }
+  struct stat st;
+  void* base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 &&
+      static_cast<size_t>(st.st_size) >= sizeof(ShmSegmentHeader)) {
+    base = mmap(nullptr, sizeof(ShmSegmentHeader), PROT_READ, MAP_SHARED, fd,
+                0);
+  }
+  close(fd);
+  if (base == MAP_FAILED) {
+    return 0;
+  }
+  int pid = static_cast<ShmSegmentHeader*>(base)->pid;
+  munmap(base, sizeof(ShmSegmentHeader));
+  return pid;
+}
+
+std::unique_ptr<ShmSegment> ShmSegment::Create(const std::string& endpoint,
+                                               int num_channels,
+                                               size_t ring_capacity) {
+  const std::string name = ShmSegmentName(endpoint);
+  const size_t bytes = SegmentHeaderBytes(num_channels) +
+                       2 * num_channels * ShmRing::Bytes(ring_capacity);
+  // The endpoint is bound by this process, so a segment of it is left by a
+  // parameter server exited before, unless its process is still running.
+  int pid = SegmentServerPid(name);
+  PADDLE_ENFORCE(pid == 0 || pid == getpid() || !ProcessAlive(pid),
+                 "the shared memory %s is used by the running process %d",
+                 name, pid);
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  PADDLE_ENFORCE_GE(fd, 0, "create the shared memory %s failed: %s", name,
+                    strerror(errno));
+  int ret = ftruncate(fd, bytes);
+  void* base = ret == 0 ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                               MAP_SHARED, fd, 0)
+                        : MAP_FAILED;
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    PADDLE_THROW("map the shared memory %s of %d bytes failed: %s", name,
+                 bytes, strerror(errno));
+  }
+
+  auto* header = static_cast<ShmSegmentHeader*>(base);
+  header->pid = getpid();
+  header->num_channels = num_channels;
+  header->ring_capacity = ring_capacity;
+  InitMutex(&header->mutex);
+  const size_t ring_bytes = ShmRing::Bytes(ring_capacity);
+  char* channel = static_cast<char*>(base) + SegmentHeaderBytes(num_channels);
+  for (int i = 0; i < num_channels; ++i) {
+    header->owners[i] = 0;
+    ShmRing::Init(channel, ring_capacity);
+    ShmRing::Init(channel + ring_bytes, ring_capacity);
+    channel += 2 * ring_bytes;
+  }
+
+  std::unique_ptr<ShmSegment> segment(new ShmSegment(name, base, bytes, true));
+  for (int i = 0; i < num_channels; ++i) {
+    segment->request(i)->set_reader(header->pid);
+    segment->response(i)->set_writer(header->pid);
+  }
+  // The trainers only open the segment after the magic is written.
+  __atomic_store_n(&header->magic, kShmMagic, __ATOMIC_RELEASE);
+  VLOG(3) << "created the shared memory " << name << " of " << num_channels
+          << " channels";
+  return segment;
+}
+
+std::unique_ptr<ShmSegment> ShmSegment::Open(const std::string& endpoint) {
+  const std::string name = ShmSegmentName(endpoint);
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0) {
+    return nullptr;
+  }
+  // Only a segment created by a parameter server of the same user is used,
+  // which no other user can read or write.
+  struct stat st;
+  void* base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_uid == geteuid() &&
+      (st.st_mode & 0777) == 0600 &&
+      static_cast<size_t>(st.st_size) >= sizeof(ShmSegmentHeader)) {
+    base = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                0);
+  }
+  close(fd);
+  if (base == MAP_FAILED) {
+    return nullptr;
+  }
+  auto* header = static_cast<ShmSegmentHeader*>(base);
+  const size_t bytes = static_cast<size_t>(st.st_size);
+  bool valid =
+      __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == kShmMagic &&
+      header->num_channels > 0 &&
+      bytes == SegmentHeaderBytes(header->num_channels) +
+                   2 * header->num_channels *
+                       ShmRing::Bytes(header->ring_capacity) &&
+      header->pid != 0 && ProcessAlive(header->pid);
+  if (!valid) {
+    munmap(base, bytes);
+    return nullptr;
+  }
+  return std::unique_ptr<ShmSegment>(new ShmSegment(name, base, bytes, false));
+}
+
+int ShmSegment::num_channels() const { return header_->num_channels; }
+
+int ShmSegment::Claim() {
+  const int pid = getpid();
+  int channel = -1;
+  Lock(&header_->mutex);
+  for (int i = 0; i < header_->num_channels; ++i) {
+    if (header_->owners[i] == 0) {
+      header_->owners[i] = pid;
+      requests_[i].set_writer(pid);
+      responses_[i].set_reader(pid);
+      channel = i;
+      break;
+    }
+  }
+  Unlock(&header_->mutex);
+  return channel;
+}
+
+void ShmSegment::Release(int channel) {
+  Lock(&header_->mutex);
+  requests_[channel].Reset();
+  responses_[channel].Reset();
+  requests_[channel].set_reader(header_->pid);
+  responses_[channel].set_writer(header_->pid);
+  header_->owners[channel] = 0;
+  Unlock(&header_->mutex);
+}
+
+void ShmSegment::Close() {
+  __atomic_store_n(&header_->magic, 0, __ATOMIC_RELEASE);
+  for (int i = 0; i < header_->num_channels; ++i) {
+    requests_[i].Close();
+    responses_[i].Close();
+  }
+}
+
+std::string ShmSegmentName(const std::string& endpoint) {
+  std::string name = "/paddle_rpc.";
+  for (char c : endpoint) {
+    name += std::isalnum(static_cast<unsigned char>(c)) || c == '.' ? c : '_';
+  }
+  return name + "." + std::to_string(geteuid());
+}
+
+int EndpointPort(const std::string& ep) {
+  size_t pos = ep.rfind(':');
+  if (pos == std::string::npos || pos + 1 == ep.size() ||
+      ep.find_first_not_of("0123456789", pos + 1) != std::string::npos) {
+    return -1;
+  }
+  return std::stoi(ep.substr(pos + 1));
+}
+
+static bool SameAddress(const struct sockaddr* a, const struct sockaddr* b) {
+  if (a->sa_family != b->sa_family) {
+    return false;
+  }
+  if (a->sa_family == AF_INET) {
+    return reinterpret_cast<const sockaddr_in*>(a)->sin_addr.s_addr ==
+           reinterpret_cast<const sockaddr_in*>(b)->sin_addr.s_addr;
+  }
+  if (a->sa_family == AF_INET6) {
+    return std::memcmp(&reinterpret_cast<const sockaddr_in6*>(a)->sin6_addr,
+                       &reinterpret_cast<const sockaddr_in6*>(b)->sin6_addr,
+                       sizeof(struct in6_addr)) == 0;
+  }
+  return false;
+}
+
+static bool IsLoopback(const struct sockaddr* addr) {
+  if (addr->sa_family == AF_INET) {
+    auto* in = reinterpret_cast<const sockaddr_in*>(addr);
+    auto ip = ntohl(in->sin_addr.s_addr);
+    return (ip >> 24) == 127;
+  }
+  if (addr->sa_family == AF_INET6) {
+    return IN6_IS_ADDR_LOOPBACK(
+        &reinterpret_cast<const sockaddr_in6*>(addr)->sin6_addr);
+  }
+  return false;
+}
+
+bool IsLocalEndpoint(const std::string& ep) {
+  size_t pos = ep.rfind(':');
+  if (pos == std::string::npos) {
+    return false;
+  }
+  std::string host = ep.substr(0, pos);
+  if (host.size() > 2 && host.front() == '[' && host.back() == ']') {
+    host = host.substr(1, host.size() - 2);
+  }
+
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  struct addrinfo* addrs = nullptr;
+  if (getaddrinfo(host.c_str(), nullptr, &hints, &addrs) != 0) {
+    return false;
+  }
+  struct ifaddrs* ifaddrs = nullptr;
+  if (getifaddrs(&ifaddrs) != 0) {
+    ifaddrs = nullptr;
+  }
+
+  bool local = false;
+  for (auto* addr = addrs; addr != nullptr && !local; addr = addr->ai_next) {
+    local = IsLoopback(addr->ai_addr);
+    for (auto* ifa = ifaddrs; ifa != nullptr && !local; ifa = ifa->ifa_next) {
+      local = ifa->ifa_addr != nullptr &&
+              SameAddress(addr->ai_addr, ifa->ifa_addr);
+    }
+  }
+  if (ifaddrs != nullptr) {
+    freeifaddrs(ifaddrs);
+  }
+  freeaddrinfo(addrs);
+  return local;
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
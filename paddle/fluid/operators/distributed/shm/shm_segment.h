@@ -0,0 +1,132 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+
+DECLARE_bool(rpc_shm_transport);
+DECLARE_int32(rpc_shm_ring_size_mb);
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+struct ShmRingHeader;
+struct ShmSegmentHeader;
+
+// A byte stream from one writer process to one reader process, in a ring
+// buffer of a shared memory segment. The bytes are copied outside of the
+// lock, so a message larger than the ring streams through it while the
+// reader copies the front of it out.
+//
+// A wait of a side checks the process on the other side every 100ms, and
+// closes the ring if it has exited, so that a crashed trainer or parameter
+// server never blocks the other side forever.
+class ShmRing {
+ public:
+  ShmRing(void* base, size_t capacity);
+
+  // The bytes of a ring of capacity in the segment.
+  static size_t Bytes(size_t capacity);
+  // Initialize the ring at base, with the process-shared lock.
+  static void Init(void* base, size_t capacity);
+
+  // Return false if the ring is closed.
+  bool Write(const void* data, size_t size);
+  bool Read(void* data, size_t size);
+  bool Skip(size_t size);
+
+  // Wake up and fail all the waits on the ring.
+  void Close();
+  // Empty the ring and clear the processes of both sides.
+  void Reset();
+  bool closed() const;
+
+  void set_writer(int pid);
+  void set_reader(int pid);
+
+ private:
+  // Wait until there are bytes to read, or space to write, and return the
+  // number of them, or 0 if the ring is closed.
+  size_t WaitReadable();
+  size_t WaitWritable();
+
+  ShmRingHeader* header_;
+  char* data_;
+  size_t capacity_;
+};
+
+// A shared memory segment of a parameter server, named by the endpoint it
+// listens on and its user. It has num_channels pairs of rings, and a trainer
+// on the same host claims a pair to send its requests and receive the
+// responses.
+class ShmSegment {
+ public:
+  ~ShmSegment();
+
+  // Called by the parameter server. The segment is removed from the system
+  // when it is destroyed.
+  static std::unique_ptr<ShmSegment> Create(const std::string& endpoint,
+                                            int num_channels,
+                                            size_t ring_capacity);
+  // Called by a trainer. Return nullptr if there is no running parameter
+  // server of the endpoint on this host run by the same user.
+  static std::unique_ptr<ShmSegment> Open(const std::string& endpoint);
+
+  int num_channels() const;
+
+  ShmRing* request(int channel) { return &requests_[channel]; }
+  ShmRing* response(int channel) { return &responses_[channel]; }
+
+  // Claim a free channel for this process, or return -1.
+  int Claim();
+  // Free the channel of an exited or closed trainer. Called by the parameter
+  // server when the request ring is closed.
+  void Release(int channel);
+
+  // Close the rings of all channels, and stop the trainers from opening the
+  // segment.
+  void Close();
+
+ private:
+  ShmSegment(const std::string& name, void* base, size_t bytes, bool owner);
+
+  std::string name_;
+  void* base_;
+  size_t bytes_;
+  bool owner_;
+  ShmSegmentHeader* header_;
+  std::vector<ShmRing> requests_;
+  std::vector<ShmRing> responses_;
+};
+
+// The name of the segment of the endpoint "ip:port" and the effective user.
+std::string ShmSegmentName(const std::string& endpoint);
+
+// Whether the host of an endpoint is an address of this host.
+bool IsLocalEndpoint(const std::string& ep);
+
+// The port of an endpoint "ip:port", or -1 if it can not be parsed.
+int EndpointPort(const std::string& ep);
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
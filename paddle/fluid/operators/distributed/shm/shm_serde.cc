@@ -0,0 +1,165 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/shm/shm_serde.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/operators/distributed/request_handler.h"
+#include "paddle/fluid/operators/distributed/sendrecvop_utils.h"
+#include "paddle/fluid/platform/profiler.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+const char* ShmRPCName(int rpc) {
+  static const char* names[kShmRPCNum] = {
+      kRequestSend,     kRequestGet,        kRequestGetNoBarrier,
+      kRequestGetMonomerVariable,           kRequestGetMonomerBarrier,
+      kRequestPrefetch, kRequestCheckpoint, kRequestNotify};
+  PADDLE_ENFORCE(rpc >= 0 && rpc < kShmRPCNum, "invalid shm rpc %d", rpc);
+  return names[rpc];
+}
+
+bool WriteShmMessage(ShmRing* ring, ShmMessageHeader header,
+                     sendrecv::VariableMessage* meta, framework::Variable* var,
+                     const platform::DeviceContext* ctx) {
+  platform::RecordRPCEvent record_event("serial");
+  std::unique_ptr<TensorPayload> payload;
+  const int64_t* rows = nullptr;
+  header.has_var = var != nullptr;
+  header.rows_bytes = 0;
+  header.tensor_bytes = 0;
+  if (var != nullptr && var->IsType<framework::LoDTensor>()) {
+    meta->set_type(sendrecv::LOD_TENSOR);
+    payload.reset(new TensorPayload(GetTensorPayload(var, *ctx, meta)));
+  } else if (var != nullptr && var->IsType<framework::SelectedRows>()) {
+    meta->set_type(sendrecv::SELECTED_ROWS);
+    payload.reset(new TensorPayload(GetSelectedRowsPayload(var, *ctx, meta)));
+    auto& slr = var->Get<framework::SelectedRows>();
+    header.rows_bytes = slr.rows().size() * sizeof(int64_t);
+    rows = header.rows_bytes > 0 ? slr.rows().data() : nullptr;
+  } else if (var != nullptr) {
+    PADDLE_THROW("the shm transport does not support type: %s",
+                 typeid(var->Type()).name());
+  }
+  if (payload) {
+    header.tensor_bytes = payload->memory_size();
+  }
+
+  std::string meta_bytes;
+  meta->SerializeToString(&meta_bytes);
+  header.meta_bytes = static_cast<int32_t>(meta_bytes.size());
+  return ring->Write(&header, sizeof(header)) &&
+         ring->Write(meta_bytes.data(), meta_bytes.size()) &&
+         ring->Write(rows, header.rows_bytes) &&
+         (header.tensor_bytes == 0 ||
+          ring->Write(payload->ptr(), header.tensor_bytes));
+}
+
+bool ReadShmMeta(ShmRing* ring, ShmMessageHeader* header,
+                 sendrecv::VariableMessage* meta) {
+  if (!ring->Read(header, sizeof(*header))) {
+    return false;
+  }
+  std::string meta_bytes(header->meta_bytes, '\0');
+  if (!ring->Read(&meta_bytes[0], meta_bytes.size())) {
+    return false;
+  }
+  PADDLE_ENFORCE(meta->ParseFromString(meta_bytes),
+                 "parse the meta of the shm message %d failed", header->id);
+  return true;
+}
+
+static bool ReadRaw(ShmRing* ring, const platform::DeviceContext* ctx,
+                    const platform::Place& place, void* dest, int64_t size) {
+  if (platform::is_gpu_place(place)) {
+#ifdef PADDLE_WITH_CUDA
+    std::unique_ptr<char[]> staging(new char[size]);
+    if (!ring->Read(staging.get(), size)) {
+      return false;
+    }
+    auto* gpu_dev_ctx = static_cast<const platform::CUDADeviceContext*>(ctx);
+    memory::Copy(boost::get<platform::CUDAPlace>(place), dest,
+                 platform::CPUPlace(), staging.get(), size,
+                 gpu_dev_ctx->stream());
+    ctx->Wait();
+    return true;
+#else
+    PADDLE_THROW("Unexpected branch");
+#endif
+  }
+  return ring->Read(dest, size);
+}
+
+bool ReadShmVariable(ShmRing* ring, const ShmMessageHeader& header,
+                     const sendrecv::VariableMessage& meta,
+                     const platform::DeviceContext* ctx,
+                     framework::Variable* var) {
+  if (!header.has_var) {
+    return true;
+  }
+  if (var == nullptr) {
+    LOG(ERROR) << "recved var should not on current server: "
+               << meta.varname();
+    return ring->Skip(header.rows_bytes + header.tensor_bytes);
+  }
+
+  std::vector<int64_t> dims(meta.dims().begin(), meta.dims().end());
+  auto type = ToVarType(meta.data_type());
+  framework::Tensor* tensor = nullptr;
+  if (meta.type() == sendrecv::LOD_TENSOR) {
+    auto* lod_tensor = var->GetMutable<framework::LoDTensor>();
+    framework::LoD lod;
+    for (int i = 0; i < meta.lod_level(); ++i) {
+      framework::Vector<size_t> v;
+      for (int j = 0; j < meta.lod(i).lod_data_size(); ++j) {
+        v.push_back(meta.lod(i).lod_data(j));
+      }
+      lod.push_back(v);
+    }
+    lod_tensor->set_lod(lod);
+    tensor = lod_tensor;
+  } else if (meta.type() == sendrecv::SELECTED_ROWS) {
+    auto* slr = var->GetMutable<framework::SelectedRows>();
+    slr->set_height(meta.slr_height());
+    auto* rows = slr->mutable_rows();
+    rows->resize(header.rows_bytes / sizeof(int64_t));
+    // The rows are always on CPU, and copied to GPU lazily.
+    if (header.rows_bytes > 0 &&
+        !ring->Read(rows->data(), header.rows_bytes)) {
+      return false;
+    }
+    tensor = slr->mutable_value();
+  } else {
+    PADDLE_THROW("the shm transport does not support type: %d", meta.type());
+  }
+
+  tensor->Resize(framework::make_ddim(dims));
+  void* data = tensor->mutable_data(ctx->GetPlace(), type);
+  PADDLE_ENFORCE_EQ(
+      static_cast<int64_t>(tensor->numel() * framework::SizeOfType(type)),
+      header.tensor_bytes, "the bytes of var %s mismatch its shape",
+      meta.varname());
+  return ReadRaw(ring, ctx, tensor->place(), data, header.tensor_bytes);
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,82 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/variable.h"
+#include "paddle/fluid/operators/distributed/distributed_pb.h"
+#include "paddle/fluid/operators/distributed/shm/shm_segment.h"
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// A message on a ring is the header, the VariableMessage of the names and
+// the shape without the data, the rows of a SelectedRows, and then the bytes
+// of the tensor. The rows and the tensor are copied between the ring and
+// the memory of the variable directly, without a protobuf message or a
+// buffer of the socket in between.
+struct ShmMessageHeader {
+  int64_t id;
+  // The index of the rpc in ShmRPCNames.
+  int32_t rpc;
+  // 0 if the request is handled, or 1 if it fails or is not supported.
+  int32_t status;
+  // Whether a variable follows the meta.
+  int32_t has_var;
+  int32_t meta_bytes;
+  int64_t rows_bytes;
+  int64_t tensor_bytes;
+};
+
+enum ShmRPC {
+  kShmSend = 0,
+  kShmGet,
+  kShmGetNoBarrier,
+  kShmGetMonomerVariable,
+  kShmGetMonomerBarrier,
+  kShmPrefetch,
+  kShmCheckpoint,
+  kShmNotify,
+  kShmRPCNum,
+};
+
+// The names of the rpcs registered to the RPCServer.
+const char* ShmRPCName(int rpc);
+
+// Write a message to the ring. var and ctx may be nullptr for a message
+// without a variable, and var is a LoDTensor or a SelectedRows otherwise.
+// Return false if the ring is closed.
+bool WriteShmMessage(ShmRing* ring, ShmMessageHeader header,
+                     sendrecv::VariableMessage* meta, framework::Variable* var,
+                     const platform::DeviceContext* ctx);
+
+// Read the header and the meta of the next message.
+bool ReadShmMeta(ShmRing* ring, ShmMessageHeader* header,
+                 sendrecv::VariableMessage* meta);
+
+// Read the variable of the message into var, on the place of ctx. The
+// variable is skipped if var is nullptr, and then ctx may be nullptr.
+bool ReadShmVariable(ShmRing* ring, const ShmMessageHeader& header,
+                     const sendrecv::VariableMessage& meta,
+                     const platform::DeviceContext* ctx,
+                     framework::Variable* var);
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
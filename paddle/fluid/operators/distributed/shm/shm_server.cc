@@ -0,0 +1,242 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/shm/shm_server.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <string>
+
+#include "glog/logging.h"
+#include "paddle/fluid/operators/distributed/gradient_compressor.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// The trainers of a parameter server claim a channel each, and a few more
+// channels are left for the other clients, e.g. the collective clients.
+static constexpr int kSpareShmChannels = 2;
+
+ShmServer::~ShmServer() {
+  ShutDown();
+  // The handlers in the pools have returned after the RPCServer is shut down.
+  pools_.clear();
+}
+
+void ShmServer::Start(
+    const std::string& endpoint, int client_num,
+    const std::unordered_map<std::string, RequestHandler*>& handlers,
+    const std::unordered_map<std::string, int>& thread_num) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (shut_down_) {
+    return;
+  }
+  const int num_channels = std::max(client_num, 1) + kSpareShmChannels;
+  segment_ = ShmSegment::Create(
+      endpoint, num_channels,
+      static_cast<size_t>(FLAGS_rpc_shm_ring_size_mb) << 20);
+  handlers_ = handlers;
+  for (auto& t : handlers_) {
+    auto it = thread_num.find(t.first);
+    int threads = it == thread_num.end() ? 1 : std::max(it->second, 1);
+    pools_[t.first].reset(new ::ThreadPool(threads));
+  }
+  response_mutex_.reset(new std::mutex[num_channels]);
+  pending_.assign(num_channels, 0);
+  for (int i = 0; i < num_channels; ++i) {
+    threads_.emplace_back(new std::thread(&ShmServer::Serve, this, i));
+  }
+  ready_ = true;
+  lock.unlock();
+  cond_.notify_all();
+  LOG(INFO) << "Server serves the trainers on this host through "
+            << ShmSegmentName(endpoint) << " of " << num_channels
+            << " channels";
+}
+
+void ShmServer::WaitReady() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this] { return ready_ || shut_down_; });
+}
+
+void ShmServer::ShutDown() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (shut_down_) {
+      return;
+    }
+    shut_down_ = true;
+    if (segment_) {
+      segment_->Close();
+    }
+  }
+  cond_.notify_all();
+  for (auto& t : threads_) {
+    t->join();
+  }
+  threads_.clear();
+  VLOG(4) << "ShmServer shutdown!";
+}
+
+void ShmServer::Serve(int channel) {
+  auto* request = segment_->request(channel);
+  while (true) {
+    ShmMessageHeader header;
+    sendrecv::VariableMessage meta;
+    bool ok = ReadShmMeta(request, &header, &meta);
+    if (ok) {
+      auto it = handlers_.find(ShmRPCName(header.rpc));
+      RequestHandler* handler = it == handlers_.end() ? nullptr : it->second;
+      // The variable of a request is read into the scope of the handler,
+      // or a local scope, the same as the socket servers.
+      std::shared_ptr<framework::Scope> local_scope;
+      framework::Variable* invar = nullptr;
+      if (handler != nullptr && header.has_var) {
+        const std::string name = DecodedGradientName(meta.varname());
+        if (header.rpc == kShmPrefetch ||
+            (header.rpc == kShmSend && !handler->sync_mode())) {
+          local_scope.reset(handler->scope()->NewTmpScope().release());
+          invar = local_scope->Var(name);
+        } else {
+          invar = handler->scope()->FindVar(name);
+        }
+      }
+      ok = ReadShmVariable(request, header, meta,
+                           handler ? handler->dev_ctx() : nullptr, invar);
+      if (ok && handler == nullptr) {
+        LOG(ERROR) << "rpc " << ShmRPCName(header.rpc)
+                   << " is not registered to the server";
+        header.status = 1;
+        Respond(channel, header, "", nullptr, nullptr);
+      } else if (ok) {
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          ++pending_[channel];
+        }
+        pools_[ShmRPCName(header.rpc)]->enqueue(
+            [this, channel, header, meta, local_scope, invar, handler] {
+              Process(channel, header, meta, local_scope, invar, handler);
+              {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --pending_[channel];
+              }
+              cond_.notify_all();
+            });
+      }
+    }
+    if (ok) {
+      continue;
+    }
+    // The trainer of the channel exits, or the server is shut down.
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this, channel] {
+      return pending_[channel] == 0 || shut_down_;
+    });
+    if (shut_down_) {
+      break;
+    }
+    segment_->Release(channel);
+    VLOG(3) << "released the shm channel " << channel;
+  }
+}
+
+void ShmServer::Process(int channel, const ShmMessageHeader& header,
+                        const sendrecv::VariableMessage& meta,
+                        std::shared_ptr<framework::Scope> local_scope,
+                        framework::Variable* invar, RequestHandler* handler) {
+  const std::string& varname = meta.varname();
+  const std::string& out_varname = meta.out_varname();
+  const int trainer_id = static_cast<int>(meta.trainer_id());
+  VLOG(4) << "shm " << ShmRPCName(header.rpc) << " var_name:" << varname
+          << ", out_var_name:" << out_varname << ", channel:" << channel;
+
+  framework::Variable* outvar = nullptr;
+  const platform::DeviceContext* ctx = handler->dev_ctx();
+  std::unique_ptr<framework::Scope> tmp_scope;
+  ShmMessageHeader response = header;
+  response.status = 0;
+  try {
+    switch (header.rpc) {
+      case kShmSend:
+        handler->Handle(varname, local_scope.get(), invar, &outvar,
+                        trainer_id);
+        outvar = nullptr;
+        break;
+      case kShmGet:
+        tmp_scope = handler->scope()->NewTmpScope();
+        handler->Handle(varname, tmp_scope.get(), nullptr, &outvar,
+                        trainer_id, out_varname, meta.table_name());
+        break;
+      case kShmGetNoBarrier:
+        handler->Handle(varname, handler->scope(), nullptr, &outvar,
+                        trainer_id, out_varname);
+        break;
+      case kShmGetMonomerVariable: {
+        rpc_server_->WaitVarCond(varname);
+        MonomerHandle h = rpc_server_->GetMonomer(varname);
+        handler->Handle(varname, h.scope_, h.scope_->FindVar(varname), &outvar,
+                        trainer_id);
+        ctx = h.dev_ctx_;
+        break;
+      }
+      case kShmGetMonomerBarrier:
+        rpc_server_->WaitVarCond(varname);
+        rpc_server_->GetMonomer(varname);
+        handler->Handle(varname, nullptr, nullptr, &outvar, trainer_id);
+        outvar = nullptr;
+        break;
+      case kShmPrefetch:
+        // out var must be created in local scope!
+        outvar = local_scope->Var(out_varname);
+        handler->Handle(varname, local_scope.get(), invar, &outvar, trainer_id,
+                        out_varname, meta.table_name());
+        break;
+      case kShmCheckpoint:
+        handler->Handle(varname, nullptr, nullptr, nullptr, trainer_id,
+                        out_varname);
+        break;
+      case kShmNotify:
+        handler->Handle(varname, nullptr, nullptr, nullptr, trainer_id);
+        break;
+      default:
+        PADDLE_THROW("not supported shm rpc %d", header.rpc);
+    }
+  } catch (std::exception& e) {
+    LOG(ERROR) << "shm " << ShmRPCName(header.rpc) << " of " << varname
+               << " failed: " << e.what();
+    response.status = 1;
+    outvar = nullptr;
+  }
+
+  const std::string& name =
+      header.rpc == kShmGetMonomerVariable ? varname : out_varname;
+  Respond(channel, response, name, outvar, ctx);
+}
+
+void ShmServer::Respond(int channel, ShmMessageHeader header,
+                        const std::string& varname, framework::Variable* var,
+                        const platform::DeviceContext* ctx) {
+  sendrecv::VariableMessage meta;
+  meta.set_varname(varname);
+  std::lock_guard<std::mutex> lock(response_mutex_[channel]);
+  if (!WriteShmMessage(segment_->response(channel), header, &meta, var, ctx)) {
+    VLOG(3) << "the trainer of shm channel " << channel << " exited";
+  }
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
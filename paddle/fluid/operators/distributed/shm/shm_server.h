@@ -0,0 +1,141 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <ThreadPool.h>
+
+#include <condition_variable>  // NOLINT
+#include <exception>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/operators/distributed/request_handler.h"
+#include "paddle/fluid/operators/distributed/rpc_server.h"
+#include "paddle/fluid/operators/distributed/shm/shm_segment.h"
+#include "paddle/fluid/operators/distributed/shm/shm_serde.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// The shared memory side of a parameter server. A thread of each channel
+// reads the variables of the requests into the scopes, as the socket servers
+// do, and the handlers run on a thread pool of each rpc, of the threads
+// registered to the RPCServer.
+class ShmServer {
+ public:
+  explicit ShmServer(RPCServer* rpc_server) : rpc_server_(rpc_server) {}
+  ~ShmServer();
+
+  // Create the segment of the endpoint and serve the channels. It is called
+  // after the socket server is ready, when the port is selected.
+  void Start(const std::string& endpoint, int client_num,
+             const std::unordered_map<std::string, RequestHandler*>& handlers,
+             const std::unordered_map<std::string, int>& thread_num);
+  // Wait until the channels are served, or the server fails to start or is
+  // shut down.
+  void WaitReady();
+  void ShutDown();
+
+ private:
+  void Serve(int channel);
+  void Process(int channel, const ShmMessageHeader& header,
+               const sendrecv::VariableMessage& meta,
+               std::shared_ptr<framework::Scope> local_scope,
+               framework::Variable* invar, RequestHandler* handler);
+  void Respond(int channel, ShmMessageHeader header,
+               const std::string& varname, framework::Variable* var,
+               const platform::DeviceContext* ctx);
+
+  RPCServer* rpc_server_;
+  std::unique_ptr<ShmSegment> segment_;
+  std::unordered_map<std::string, RequestHandler*> handlers_;
+  std::unordered_map<std::string, std::unique_ptr<::ThreadPool>> pools_;
+  std::vector<std::unique_ptr<std::thread>> threads_;
+  std::unique_ptr<std::mutex[]> response_mutex_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  // The requests of each channel in the thread pools.
+  std::vector<int> pending_;
+  bool ready_{false};
+  bool shut_down_{false};
+};
+
+// A socket server of SocketServer, which also serves the trainers on the
+// same host through shared memory if FLAGS_rpc_shm_transport is set. Both
+// transports share the barriers and the handlers of the RPCServer.
+template <typename SocketServer>
+class ShmRPCServer : public SocketServer {
+ public:
+  explicit ShmRPCServer(const std::string& address, int client_num)
+      : SocketServer(address, client_num), shm_(this) {}
+
+  virtual ~ShmRPCServer() {}
+
+  void StartServer() override {
+    if (!FLAGS_rpc_shm_transport) {
+      SocketServer::StartServer();
+      return;
+    }
+    // The segment is named by the endpoint, whose port is only known after
+    // the socket server starts. A trainer finds it by the same endpoint, so
+    // the trainers of a server bound to a wildcard address use the socket.
+    std::thread shm_thread([this] {
+      SocketServer::WaitServerReady();
+      const std::string& address = this->bind_address_;
+      try {
+        shm_.Start(address.substr(0, address.rfind(':') + 1) +
+                       std::to_string(this->GetSelectedPort()),
+                   this->client_num_, this->rpc_call_map_,
+                   this->rpc_thread_num_);
+      } catch (std::exception& e) {
+        // The trainers find no segment and use the socket.
+        LOG(ERROR) << "Server cannot serve the trainers through shared "
+                      "memory, serve them through the socket only: "
+                   << e.what();
+        shm_.ShutDown();
+      }
+    });
+    SocketServer::StartServer();
+    shm_thread.join();
+  }
+
+  void WaitServerReady() override {
+    SocketServer::WaitServerReady();
+    if (FLAGS_rpc_shm_transport) {
+      shm_.WaitReady();
+    }
+  }
+
+ protected:
+  void ShutDownImpl() override {
+    shm_.ShutDown();
+    SocketServer::ShutDownImpl();
+  }
+
+ private:
+  ShmServer shm_;
+};
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,262 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <condition_variable>  // NOLINT
+#include <mutex>                // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/operators/distributed/shm/shm_segment.h"
+#include "paddle/fluid/operators/distributed/shm/shm_serde.h"
+#include "paddle/fluid/operators/distributed/shm/shm_server.h"
+#include "paddle/fluid/platform/device_context.h"
+
+namespace framework = paddle::framework;
+namespace platform = paddle::platform;
+namespace distributed = paddle::operators::distributed;
+
+// A port no server listens on, so that the tests of several processes do not
+// share a segment.
+static std::string TestEndpoint() {
+  return "127.0.0.1:" + std::to_string(60000 + getpid() % 5000);
+}
+
+TEST(ShmSegment, open_and_claim) {
+  const std::string ep = TestEndpoint();
+  EXPECT_EQ(distributed::ShmSegment::Open(ep), nullptr);
+
+  auto server = distributed::ShmSegment::Create(ep, 2, 4096);
+  ASSERT_NE(server, nullptr);
+  EXPECT_EQ(server->num_channels(), 2);
+
+  auto client = distributed::ShmSegment::Open(ep);
+  ASSERT_NE(client, nullptr);
+  EXPECT_EQ(client->Claim(), 0);
+  EXPECT_EQ(client->Claim(), 1);
+  EXPECT_EQ(client->Claim(), -1);
+  server->Release(0);
+  EXPECT_EQ(client->Claim(), 0);
+
+  server->Close();
+  EXPECT_EQ(distributed::ShmSegment::Open(ep), nullptr);
+  EXPECT_FALSE(client->request(0)->Write("x", 1));
+}
+
+TEST(ShmSegment, open_only_private_segment) {
+  const std::string ep = TestEndpoint();
+  auto server = distributed::ShmSegment::Create(ep, 1, 4096);
+  ASSERT_NE(distributed::ShmSegment::Open(ep), nullptr);
+  // another user could write to the segment
+  int fd = shm_open(distributed::ShmSegmentName(ep).c_str(), O_RDWR, 0600);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(fchmod(fd, 0666), 0);
+  close(fd);
+  EXPECT_EQ(distributed::ShmSegment::Open(ep), nullptr);
+}
+
+TEST(ShmSegment, keep_segment_of_running_server) {
+  const std::string ep = TestEndpoint();
+  int ready[2];
+  ASSERT_EQ(pipe(ready), 0);
+  pid_t child = fork();
+  if (child == 0) {
+    auto server = distributed::ShmSegment::Create(ep, 1, 4096);
+    char c = 0;
+    PADDLE_ENFORCE_EQ(write(ready[1], &c, 1), 1);
+    pause();
+    _exit(0);
+  }
+  char c;
+  ASSERT_EQ(read(ready[0], &c, 1), 1);
+  EXPECT_THROW(distributed::ShmSegment::Create(ep, 1, 4096),
+               paddle::platform::EnforceNotMet);
+  EXPECT_NE(distributed::ShmSegment::Open(ep), nullptr);
+
+  // the segment left by the killed server is replaced
+  kill(child, SIGKILL);
+  waitpid(child, nullptr, 0);
+  EXPECT_NE(distributed::ShmSegment::Create(ep, 1, 4096), nullptr);
+  close(ready[0]);
+  close(ready[1]);
+}
+
+// A socket server which is ready once started, on the port of the test.
+class FakeSocketServer : public distributed::RPCServer {
+ public:
+  FakeSocketServer(const std::string& address, int client_num)
+      : distributed::RPCServer(address, client_num) {}
+
+  void StartServer() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      selected_port_ = std::stoi(bind_address_.substr(
+          bind_address_.rfind(':') + 1));
+      ready_ = true;
+    }
+    cond_.notify_all();
+  }
+
+  void WaitServerReady() override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return ready_; });
+  }
+
+ protected:
+  void ShutDownImpl() override {}
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool ready_{false};
+};
+
+TEST(ShmRPCServer, serve_socket_only_if_segment_fails) {
+  const std::string ep = TestEndpoint();
+  int ready[2];
+  ASSERT_EQ(pipe(ready), 0);
+  pid_t child = fork();
+  if (child == 0) {
+    auto server = distributed::ShmSegment::Create(ep, 1, 4096);
+    char c = 0;
+    PADDLE_ENFORCE_EQ(write(ready[1], &c, 1), 1);
+    pause();
+    _exit(0);
+  }
+  char c;
+  ASSERT_EQ(read(ready[0], &c, 1), 1);
+
+  // The segment of the endpoint is held by the running process, so the
+  // server falls back to the socket instead of terminating.
+  FLAGS_rpc_shm_transport = true;
+  distributed::ShmRPCServer<FakeSocketServer> server(ep, 1);
+  std::thread start([&server] { server.StartServer(); });
+  server.WaitServerReady();
+  start.join();
+  server.ShutDown();
+  FLAGS_rpc_shm_transport = false;
+
+  kill(child, SIGKILL);
+  waitpid(child, nullptr, 0);
+  close(ready[0]);
+  close(ready[1]);
+}
+
+TEST(ShmRing, stream_larger_than_ring) {
+  const std::string ep = TestEndpoint();
+  auto server = distributed::ShmSegment::Create(ep, 1, 4096);
+  auto client = distributed::ShmSegment::Open(ep);
+  ASSERT_EQ(client->Claim(), 0);
+
+  std::vector<int> data(1 << 18);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<int>(i * 7);
+  }
+  std::thread writer([&] {
+    auto* ring = client->request(0);
+    EXPECT_TRUE(ring->Write(data.data(), data.size() * sizeof(int)));
+    EXPECT_TRUE(ring->Write(data.data(), 100 * sizeof(int)));
+  });
+
+  std::vector<int> out(data.size());
+  auto* ring = server->request(0);
+  EXPECT_TRUE(ring->Read(out.data(), out.size() * sizeof(int)));
+  EXPECT_EQ(out, data);
+  EXPECT_TRUE(ring->Skip(100 * sizeof(int)));
+  writer.join();
+
+  ring->Close();
+  EXPECT_TRUE(ring->closed());
+  EXPECT_FALSE(ring->Read(out.data(), sizeof(int)));
+}
+
+TEST(ShmSerde, lod_tensor_and_selected_rows) {
+  const std::string ep = TestEndpoint();
+  auto server = distributed::ShmSegment::Create(ep, 1, 4096);
+  auto client = distributed::ShmSegment::Open(ep);
+  ASSERT_EQ(client->Claim(), 0);
+
+  platform::CPUPlace place;
+  platform::CPUDeviceContext ctx(place);
+  framework::Scope scope;
+
+  auto* tensor = scope.Var("tensor")->GetMutable<framework::LoDTensor>();
+  float* t = tensor->mutable_data<float>(framework::make_ddim({600, 8}), place);
+  for (int i = 0; i < 600 * 8; ++i) t[i] = static_cast<float>(i) / 3;
+  tensor->set_lod({{0, 200, 600}});
+
+  auto* slr = scope.Var("rows")->GetMutable<framework::SelectedRows>();
+  slr->set_height(1000);
+  auto* value = slr->mutable_value();
+  float* v = value->mutable_data<float>(framework::make_ddim({300, 4}), place);
+  for (int i = 0; i < 300 * 4; ++i) v[i] = static_cast<float>(i);
+  for (int i = 0; i < 300; ++i) slr->mutable_rows()->push_back(i * 3);
+
+  // As the gradients encoded by the communicator.
+  auto* bytes = scope.Var("bytes")->GetMutable<framework::LoDTensor>();
+  uint8_t* b = bytes->mutable_data<uint8_t>(framework::make_ddim({999}), place);
+  for (int i = 0; i < 999; ++i) b[i] = static_cast<uint8_t>(i);
+
+  std::thread writer([&] {
+    auto* ring = client->request(0);
+    for (auto& name : {"tensor", "rows", "bytes"}) {
+      distributed::ShmMessageHeader header;
+      memset(&header, 0, sizeof(header));
+      header.id = name[0];
+      sendrecv::VariableMessage meta;
+      meta.set_varname(name);
+      EXPECT_TRUE(distributed::WriteShmMessage(ring, header, &meta,
+                                               scope.FindVar(name), &ctx));
+    }
+  });
+
+  framework::Scope out_scope;
+  auto* ring = server->request(0);
+  for (int i = 0; i < 3; ++i) {
+    distributed::ShmMessageHeader header;
+    sendrecv::VariableMessage meta;
+    ASSERT_TRUE(distributed::ReadShmMeta(ring, &header, &meta));
+    EXPECT_EQ(header.id, meta.varname()[0]);
+    EXPECT_TRUE(header.has_var);
+    ASSERT_TRUE(distributed::ReadShmVariable(ring, header, meta, &ctx,
+                                             out_scope.Var(meta.varname())));
+  }
+  writer.join();
+
+  auto& out_tensor = out_scope.FindVar("tensor")->Get<framework::LoDTensor>();
+  EXPECT_EQ(out_tensor.dims(), tensor->dims());
+  EXPECT_EQ(out_tensor.lod(), tensor->lod());
+  const float* ot = out_tensor.data<float>();
+  for (int i = 0; i < 600 * 8; ++i) EXPECT_EQ(ot[i], t[i]);
+
+  auto& out_slr = out_scope.FindVar("rows")->Get<framework::SelectedRows>();
+  EXPECT_EQ(out_slr.height(), 1000);
+  EXPECT_EQ(out_slr.value().dims(), value->dims());
+  for (int i = 0; i < 300; ++i) EXPECT_EQ(out_slr.rows()[i], i * 3);
+  const float* ov = out_slr.value().data<float>();
+  for (int i = 0; i < 300 * 4; ++i) EXPECT_EQ(ov[i], v[i]);
+
+  auto& out_bytes = out_scope.FindVar("bytes")->Get<framework::LoDTensor>();
+  ASSERT_EQ(out_bytes.type(), framework::proto::VarType::UINT8);
+  for (int i = 0; i < 999; ++i) EXPECT_EQ(out_bytes.data<uint8_t>()[i], b[i]);
+}
@@ -13,8 +13,16 @@
 // limitations under the License.
 
 #include "paddle/fluid/operators/distributed/variable_response.h"
+#include <chrono>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "paddle/fluid/operators/distributed/sendrecvop_utils.h"
+#include "paddle/fluid/string/printf.h"
+
+DECLARE_int32(rpc_deadline);
 
 DEFINE_string(rpc_server_profile_path, "./profile_ps",
               "the profile log file path");
@@ -91,6 +99,115 @@ bool VariableResponse::ReadRaw(::google::protobuf::io::CodedInputStream* input,
   return true;
 }
 
+// The tensors received in chunks, by the trainer and the name. The first
+// chunk of a send allocates the tensor, the threads of the server copy the
+// chunks into it in parallel, and the last chunk takes it. The chunks of a
+// failed send are dropped when a newer send of the tensor starts, or after
+// the rpc deadline, and the chunks of the sends older than the last
+// received are rejected.
+class ChunkedTensors {
+ public:
+  static ChunkedTensors& Instance() {
+    static ChunkedTensors instance;
+    return instance;
+  }
+
+  // The tensor of the send seq to copy a chunk into. It shares the memory
+  // with the tensor received, or is not initialized if the send has been
+  // received or a newer send has started.
+  framework::Tensor Get(const std::string& key, int64_t seq, int64_t chunk_num,
+                        const framework::DDim& dims,
+                        framework::proto::VarType::Type type,
+                        const platform::Place& place) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto now = Clock::now();
+    auto& entry = tensors_[key];
+    if (entry != nullptr &&
+        (entry->seq > seq || (entry->seq == seq && entry->received))) {
+      return framework::Tensor();
+    }
+    if (entry == nullptr || entry->seq < seq) {
+      EvictExpired(now);
+      entry.reset(new Entry());
+      entry->seq = seq;
+      entry->chunk_num = chunk_num;
+      entry->tensor.Resize(dims);
+      entry->tensor.mutable_data(place, type);
+    }
+    PADDLE_ENFORCE(entry->chunk_num == chunk_num &&
+                       entry->tensor.dims() == dims &&
+                       entry->tensor.type() == type,
+                   "the chunks of the send %d of %s mismatch", seq, key);
+    entry->updated = now;
+    return entry->tensor;
+  }
+
+  // Mark the chunk at offset of the send seq received, and move the tensor
+  // into out and set *done when all of the chunks are. Return false if the
+  // send has been dropped or received.
+  bool Finish(const std::string& key, int64_t seq, int64_t offset,
+              framework::Tensor* out, bool* done) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tensors_.find(key);
+    if (it == tensors_.end() || it->second->seq != seq ||
+        it->second->received) {
+      return false;
+    }
+    auto& entry = *it->second;
+    entry.offsets.insert(offset);
+    *done = static_cast<int64_t>(entry.offsets.size()) >= entry.chunk_num;
+    if (*done) {
+      // Only the sequence is kept, to reject the late chunks of the send.
+      *out = entry.tensor;
+      entry.tensor = framework::Tensor();
+      entry.offsets.clear();
+      entry.received = true;
+    }
+    return true;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    int64_t seq;
+    int64_t chunk_num;
+    bool received = false;
+    framework::Tensor tensor;
+    // A retried chunk is received again, so the chunks are counted by offset.
+    std::unordered_set<int64_t> offsets;
+    Clock::time_point updated;
+  };
+
+  void EvictExpired(Clock::time_point now) {
+    const auto deadline = std::chrono::milliseconds(FLAGS_rpc_deadline);
+    for (auto it = tensors_.begin(); it != tensors_.end();) {
+      if (it->second != nullptr && now - it->second->updated > deadline) {
+        VLOG(3) << "drop the chunks of the send " << it->second->seq << " of "
+                << it->first;
+        it = tensors_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::unique_ptr<Entry>> tensors_;
+};
+
+static framework::LoD GetLoD(const sendrecv::VariableMessage& meta) {
+  framework::LoD lod;
+  for (int i = 0; i < meta.lod_level(); ++i) {
+    framework::Vector<size_t> v;
+    for (int j = 0; j < meta.lod(i).lod_data_size(); ++j) {
+      v.push_back(meta.lod(i).lod_data(j));
+    }
+    lod.push_back(v);
+  }
+  return lod;
+}
+
 bool VariableResponse::CopyLodTensorData(
     ::google::protobuf::io::CodedInputStream* input,
     const platform::DeviceContext& ctx, const framework::DDim& dims,
@@ -103,15 +220,7 @@ bool VariableResponse::CopyLodTensorData(
   }
   auto* tensor = GetVar()->GetMutable<framework::LoDTensor>();
   tensor->Resize(dims);
-  framework::LoD lod;
-  for (int i = 0; i < meta_.lod_level(); ++i) {
-    framework::Vector<size_t> v;
-    for (int j = 0; j < meta_.lod(i).lod_data_size(); ++j) {
-      v.push_back(meta_.lod(i).lod_data(j));
-    }
-    lod.push_back(v);
-  }
-  tensor->set_lod(lod);
+  tensor->set_lod(GetLoD(meta_));
 
   void* tensor_data =
       tensor->mutable_data(ctx.GetPlace(), ToVarType(meta_.data_type()));
@@ -123,6 +232,61 @@ bool VariableResponse::CopyLodTensorData(
   return ReadRaw(input, ctx, tensor->place(), tensor_data, length);
 }
 
+bool VariableResponse::CopyLodTensorChunk(
+    ::google::protobuf::io::CodedInputStream* input,
+    const platform::DeviceContext& ctx, const framework::DDim& dims,
+    int length) {
+  auto server_var = GetVar();
+  if (!server_var) {
+    LOG(ERROR) << "recved var should not on current server: "
+               << meta_.varname();
+    return false;
+  }
+  PADDLE_ENFORCE_GE(meta_.chunk_offset(), 0,
+                    "the chunk of %s has a negative offset", meta_.varname());
+  PADDLE_ENFORCE_GT(meta_.chunk_num(), 0,
+                    "the chunk of %s has no chunk number", meta_.varname());
+  auto& chunked = ChunkedTensors::Instance();
+  const std::string key =
+      string::Sprintf("%d@%s", meta_.trainer_id(), meta_.varname());
+  framework::Tensor tensor =
+      chunked.Get(key, meta_.chunk_seq(), meta_.chunk_num(), dims,
+                  ToVarType(meta_.data_type()), ctx.GetPlace());
+  if (!tensor.IsInitialized()) {
+    LOG(WARNING) << "drop the chunk of the send " << meta_.chunk_seq()
+                 << " of " << key << ", a newer send has started";
+    return false;
+  }
+  const int64_t bytes = static_cast<int64_t>(tensor.memory_size());
+  PADDLE_ENFORCE(meta_.chunk_offset() <= bytes &&
+                     length <= bytes - meta_.chunk_offset(),
+                 "the chunk of %s at %d is out of range", meta_.varname(),
+                 meta_.chunk_offset());
+  VLOG(6) << "recv the chunk of " << meta_.varname() << " at "
+          << meta_.chunk_offset() << ", " << length << " bytes";
+  void* dest =
+      static_cast<uint8_t*>(tensor.data<void>()) + meta_.chunk_offset();
+  if (!ReadRaw(input, ctx, tensor.place(), dest, length)) {
+    return false;
+  }
+
+  framework::Tensor received;
+  bool done = false;
+  if (!chunked.Finish(key, meta_.chunk_seq(), meta_.chunk_offset(), &received,
+                      &done)) {
+    LOG(WARNING) << "the send " << meta_.chunk_seq() << " of " << key
+                 << " has been dropped";
+    return false;
+  }
+  pending_chunk_ = !done;
+  if (done) {
+    auto* out = server_var->GetMutable<framework::LoDTensor>();
+    out->ShareDataWith(received);
+    out->set_lod(GetLoD(meta_));
+  }
+  return true;
+}
+
 inline framework::DDim GetDims(
     const ::google::protobuf::RepeatedField<::google::protobuf::int64>& dims) {
   std::vector<int> vecdims;
@@ -203,6 +367,9 @@ bool VariableResponse::ProcSerializedField(
   framework::DDim dims = GetDims(meta_.dims());
   if (meta_.type() == sendrecv::LOD_TENSOR) {
     PADDLE_ENFORCE(meta_.lod_size() >= 0, "lod info should be got first!");
+    if (meta_.chunk_num() != 0 || meta_.chunk_offset() != 0) {
+      return CopyLodTensorChunk(input, *dev_ctx_, dims, num_bytes);
+    }
     if (!CopyLodTensorData(input, *dev_ctx_, dims, num_bytes)) {
       return false;
     }
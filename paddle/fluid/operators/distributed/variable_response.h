@@ -26,6 +26,7 @@
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/operators/distributed/distributed_pb.h"
+#include "paddle/fluid/operators/distributed/gradient_compressor.h"
 
 DECLARE_string(rpc_server_profile_path);
 
@@ -90,14 +91,20 @@ class VariableResponse {
 
   // should call parse first.
   framework::Variable* GetVar() {
+    // An encoded gradient is received into the variable of the gradient.
+    const std::string name = DecodedGradientName(meta_.varname());
     if (create_scope_) {
-      return local_scope_->Var(meta_.varname());
+      return local_scope_->Var(name);
     }
-    return scope_->FindVar(meta_.varname());
+    return scope_->FindVar(name);
   }
 
   int GetTrainerId() { return static_cast<int>(meta_.trainer_id()); }
 
+  // Whether the request is a chunk of a tensor whose other chunks are still
+  // to come, so that there is nothing to handle yet.
+  bool IsPendingChunk() const { return pending_chunk_; }
+
  protected:
   bool ReadRaw(::google::protobuf::io::CodedInputStream* input,
                const platform::DeviceContext& dev_ctx, platform::Place place,
@@ -114,6 +121,10 @@ class VariableResponse {
                          const platform::DeviceContext& ctx,
                          const framework::DDim& dims, int length);
 
+  bool CopyLodTensorChunk(::google::protobuf::io::CodedInputStream* input,
+                          const platform::DeviceContext& ctx,
+                          const framework::DDim& dims, int length);
+
   bool ProcSerializedField(int tag,
                            ::google::protobuf::io::CodedInputStream* input,
                            int64_t num_bytes);
@@ -123,6 +134,7 @@ class VariableResponse {
   const platform::DeviceContext* dev_ctx_;
   bool create_scope_ = false;
   framework::Scope* local_scope_ = nullptr;
+  bool pending_chunk_ = false;
 
   sendrecv::VariableMessage meta_;
 };
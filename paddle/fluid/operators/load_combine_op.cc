@@ -71,6 +71,11 @@ in the SaveCombine operator. Hence, the LoadCombine operator is tightly coupled
 with the SaveCombine operator, and can only deserialize one or more LoDTensors
 that were saved using the SaveCombine operator.
 
+If the file is saved by SaveCombine with mmap_layout, the file is mapped into
+the memory, and the LoDTensors in CPU use the mapped memory without copying.
+The pages of the file are shared by the processes loading it, until they are
+written.
+
 )DOC");
   }
 };
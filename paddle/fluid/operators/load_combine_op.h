@@ -20,6 +20,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/data_type_transform.h"
+#include "paddle/fluid/framework/mmap_param_file.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/platform/device_context.h"
 
@@ -38,7 +39,11 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
     PADDLE_ENFORCE_GT(
         static_cast<int>(out_var_names.size()), 0,
         "The number of output variables should be greater than 0.");
-    if (!model_from_memory) {
+    if (!model_from_memory &&
+        framework::MmapParamFile::IsMmapParamFile(filename)) {
+      LoadParamsFromMmapFile(ctx, place, filename, load_as_fp16,
+                             out_var_names);
+    } else if (!model_from_memory) {
       std::ifstream fin(filename, std::ios::binary);
       PADDLE_ENFORCE(static_cast<bool>(fin),
                      "OP(LoadCombine) fail to open file %s, please check "
@@ -78,25 +83,8 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
       // Get data from fin to tensor
       DeserializeFromStream(*buffer, tensor, dev_ctx);
 
-      auto in_dtype = tensor->type();
-      auto out_dtype =
-          load_as_fp16 ? framework::proto::VarType::FP16 : in_dtype;
-
-      if (in_dtype != out_dtype) {
-        // convert to float16 tensor
-        auto in_kernel_type = framework::OpKernelType(in_dtype, place);
-        auto out_kernel_type = framework::OpKernelType(out_dtype, place);
-        framework::LoDTensor fp16_tensor;
-        // copy LoD info to the new tensor
-        fp16_tensor.set_lod(tensor->lod());
-        framework::TransDataType(in_kernel_type, out_kernel_type, *tensor,
-                                 &fp16_tensor);
-
-        // reset output tensor
-        out_vars[i]->Clear();
-        tensor = out_vars[i]->GetMutable<framework::LoDTensor>();
-        tensor->set_lod(fp16_tensor.lod());
-        tensor->ShareDataWith(fp16_tensor);
+      if (load_as_fp16) {
+        ConvertToFP16(place, out_vars[i]);
       }
     }
     buffer->peek();
@@ -104,6 +92,63 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
                    "You are not allowed to load partial data via "
                    "load_combine_op, use load_op instead.");
   }
+
+  // The tensors in CPU use the mapped file directly, without copying.
+  void LoadParamsFromMmapFile(
+      const framework::ExecutionContext &context, const platform::Place &place,
+      const std::string &filename, bool load_as_fp16,
+      const std::vector<std::string> &out_var_names) const {
+    auto file = framework::MmapParamFile::Open(filename);
+    PADDLE_ENFORCE_EQ(file->size(), out_var_names.size(),
+                      "The file %s has %d tensors, but %d are loaded. You are "
+                      "not allowed to load partial data via load_combine_op, "
+                      "use load_op instead.",
+                      filename, file->size(), out_var_names.size());
+    auto out_vars = context.MultiOutputVar("Out");
+
+    for (size_t i = 0; i < out_var_names.size(); i++) {
+      PADDLE_ENFORCE(out_vars[i] != nullptr,
+                     "Output variable %s cannot be found", out_var_names[i]);
+
+      auto *tensor = out_vars[i]->GetMutable<framework::LoDTensor>();
+      if (platform::is_cpu_place(place)) {
+        file->ShareDataTo(i, tensor);
+      } else {
+        framework::LoDTensor mapped;
+        file->ShareDataTo(i, &mapped);
+        framework::TensorCopySync(mapped, place, tensor);
+        tensor->set_lod(mapped.lod());
+      }
+
+      if (load_as_fp16) {
+        ConvertToFP16(place, out_vars[i]);
+      }
+    }
+  }
+
+  void ConvertToFP16(const platform::Place &place,
+                     framework::Variable *var) const {
+    auto *tensor = var->GetMutable<framework::LoDTensor>();
+    auto in_dtype = tensor->type();
+    auto out_dtype = framework::proto::VarType::FP16;
+
+    if (in_dtype != out_dtype) {
+      // convert to float16 tensor
+      auto in_kernel_type = framework::OpKernelType(in_dtype, place);
+      auto out_kernel_type = framework::OpKernelType(out_dtype, place);
+      framework::LoDTensor fp16_tensor;
+      // copy LoD info to the new tensor
+      fp16_tensor.set_lod(tensor->lod());
+      framework::TransDataType(in_kernel_type, out_kernel_type, *tensor,
+                               &fp16_tensor);
+
+      // reset output tensor
+      var->Clear();
+      tensor = var->GetMutable<framework::LoDTensor>();
+      tensor->set_lod(fp16_tensor.lod());
+      tensor->ShareDataWith(fp16_tensor);
+    }
+  }
 };
 
 }  // namespace operators
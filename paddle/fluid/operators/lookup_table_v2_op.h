@@ -21,12 +21,14 @@ limitations under the License. */
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/selected_rows.h"
-#include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/embedding_gather.h"
 
 #ifdef PADDLE_WITH_DISTRIBUTE
 #include "paddle/fluid/operators/distributed/parameter_prefetch.h"
 #endif
 
+DECLARE_bool(lookup_table_dedup_ids);
+
 namespace paddle {
 namespace operators {
 
@@ -73,6 +75,8 @@ class LookupTableV2Kernel : public framework::OpKernel<T> {
       int64_t padding_idx = context.Attr<int64_t>("padding_idx");
       int64_t *ids = const_cast<int64_t *>(ids_t->data<int64_t>());
       int64_t ids_numel = ids_t->numel();
+      auto &dev_ctx =
+          context.template device_context<platform::CPUDeviceContext>();
 
       if (table_var->IsType<LoDTensor>()) {
         auto *table_t = context.Input<LoDTensor>("W");
@@ -84,23 +88,27 @@ class LookupTableV2Kernel : public framework::OpKernel<T> {
 
         for (int64_t i = 0; i < ids_numel; ++i) {
           if (padding_idx != kNoPadding && ids[i] == padding_idx) {
-            memset(output + i * row_width, 0, row_width * sizeof(T));
-          } else {
-            PADDLE_ENFORCE_LT(
-                ids[i], row_number,
-                "Variable value (input) of OP(fluid.layers.embedding) "
-                "expected >= 0 and < %ld, but got %ld. Please check input "
-                "value.",
-                row_number, ids[i]);
-            PADDLE_ENFORCE_GE(
-                ids[i], 0,
-                "Variable value (input) of OP(fluid.layers.embedding) "
-                "expected >= 0 and < %ld, but got %ld. Please check input "
-                "value.",
-                row_number, ids[i]);
-            memcpy(output + i * row_width, table + ids[i] * row_width,
-                   row_width * sizeof(T));
+            continue;
           }
+          PADDLE_ENFORCE_LT(
+              ids[i], row_number,
+              "Variable value (input) of OP(fluid.layers.embedding) "
+              "expected >= 0 and < %ld, but got %ld. Please check input "
+              "value.",
+              row_number, ids[i]);
+          PADDLE_ENFORCE_GE(
+              ids[i], 0,
+              "Variable value (input) of OP(fluid.layers.embedding) "
+              "expected >= 0 and < %ld, but got %ld. Please check input "
+              "value.",
+              row_number, ids[i]);
+        }
+        if (FLAGS_lookup_table_dedup_ids) {
+          math::DedupGatherRows<T>(dev_ctx, table, row_width, ids, ids_numel,
+                                   padding_idx, output);
+        } else {
+          math::GatherRows<T>(dev_ctx, table, row_width, ids, ids_numel,
+                              padding_idx, output);
         }
       } else if (table_var->IsType<SelectedRows>()) {
         const auto &table_t = table_var->Get<SelectedRows>();
@@ -108,23 +116,29 @@ class LookupTableV2Kernel : public framework::OpKernel<T> {
         const auto *table = table_t.value().data<T>();
         auto *output = output_t->mutable_data<T>(context.GetPlace());
 
-        auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
+        // The padding ids are looked up as the row -1 of zeros.
+        std::vector<int64_t> index(ids_numel);
         for (int64_t i = 0; i < ids_numel; ++i) {
           if (padding_idx != kNoPadding && ids[i] == padding_idx) {
-            memset(output + i * row_width, 0, row_width * sizeof(T));
-          } else {
-            PADDLE_ENFORCE_GE(
-                ids[i], 0,
-                "Variable value (input) of OP(fluid.layers.embedding) "
-                "expected >= 0. But received %ld",
-                ids[i]);
-            auto id_index = table_t.Index(ids[i]);
-            PADDLE_ENFORCE_GE(
-                id_index, 0, "the input key should be exists. But received %d.",
-                id_index);
-            blas.VCOPY(row_width, table + id_index * row_width,
-                       output + i * row_width);
+            index[i] = -1;
+            continue;
           }
+          PADDLE_ENFORCE_GE(
+              ids[i], 0,
+              "Variable value (input) of OP(fluid.layers.embedding) "
+              "expected >= 0. But received %ld",
+              ids[i]);
+          index[i] = table_t.Index(ids[i]);
+          PADDLE_ENFORCE_GE(
+              index[i], 0, "the input key should be exists. But received %d.",
+              index[i]);
+        }
+        if (FLAGS_lookup_table_dedup_ids) {
+          math::DedupGatherRows<T>(dev_ctx, table, row_width, index.data(),
+                                   ids_numel, -1, output);
+        } else {
+          math::GatherRows<T>(dev_ctx, table, row_width, index.data(),
+                              ids_numel, -1, output);
         }
       }
     }
@@ -152,7 +166,40 @@ class LookupTableV2GradKernel : public framework::OpKernel<T> {
     bool is_sparse = context.Attr<bool>("is_sparse");
     // Since paddings are not trainable and fixed in forward, the gradient of
     // paddings makes no sense and we don't deal with it in backward.
-    if (is_sparse) {
+    auto &dev_ctx =
+        context.template device_context<platform::CPUDeviceContext>();
+    if (is_sparse && FLAGS_lookup_table_dedup_ids) {
+      auto *ids = context.Input<LoDTensor>("Ids");
+      auto *d_output = context.Input<LoDTensor>(framework::GradVarName("Out"));
+      auto *d_table = context.Output<SelectedRows>(framework::GradVarName("W"));
+
+      auto *ids_data = ids->data<int64_t>();
+      int64_t ids_num = ids->numel();
+
+      // The rows of the same id are merged into one row.
+      std::vector<int64_t> new_rows, index;
+      math::DedupIndex(ids_data, ids_num, &new_rows, &index);
+      d_table->set_rows(new_rows);
+      d_table->set_height(table_dim[0]);
+
+      auto d_output_dims = d_output->dims();
+      auto d_output_dims_2d =
+          framework::flatten_to_2d(d_output_dims, d_output_dims.size() - 1);
+      PADDLE_ENFORCE_EQ(d_output_dims_2d,
+                        framework::make_ddim({ids_num, table_dim[1]}),
+                        "ShapeError: The shape of output@Grad should be "
+                        "[%d, %d]. But received output@Grad's shape = [%s].",
+                        ids_num, table_dim[1], d_output_dims_2d);
+
+      auto *d_table_value = d_table->mutable_value();
+      d_table_value->Resize(
+          {static_cast<int64_t>(new_rows.size()), table_dim[1]});
+      auto *d_table_data = d_table_value->mutable_data<T>(context.GetPlace());
+      memset(d_table_data, 0, d_table_value->numel() * sizeof(T));
+      math::ScatterAddRows<T>(dev_ctx, d_output->data<T>(), table_dim[1],
+                              index.data(), ids_num, kNoPadding,
+                              new_rows.size(), d_table_data);
+    } else if (is_sparse) {
       auto *ids = context.Input<LoDTensor>("Ids");
       auto *d_output = context.Input<LoDTensor>(framework::GradVarName("Out"));
       auto *d_table = context.Output<SelectedRows>(framework::GradVarName("W"));
@@ -205,22 +252,21 @@ class LookupTableV2GradKernel : public framework::OpKernel<T> {
         if (padding_idx != kNoPadding && ids_data[i] == padding_idx) {
           // the gradient of padding_idx should be 0, already done by memset, so
           // do nothing.
-        } else {
-          PADDLE_ENFORCE_LT(
-              ids_data[i], N,
-              "Variable value (input) of OP(fluid.layers.embedding) "
-              "expected >= 0 and < %ld, but got %ld. Please check input value.",
-              N, ids_data[i]);
-          PADDLE_ENFORCE_GE(
-              ids_data[i], 0,
-              "Variable value (input) of OP(fluid.layers.embedding) "
-              "expected >= 0 and < %ld, but got %ld. Please check input value.",
-              N, ids_data[i]);
-          for (int j = 0; j < D; ++j) {
-            d_table_data[ids_data[i] * D + j] += d_output_data[i * D + j];
-          }
+          continue;
         }
+        PADDLE_ENFORCE_LT(
+            ids_data[i], N,
+            "Variable value (input) of OP(fluid.layers.embedding) "
+            "expected >= 0 and < %ld, but got %ld. Please check input value.",
+            N, ids_data[i]);
+        PADDLE_ENFORCE_GE(
+            ids_data[i], 0,
+            "Variable value (input) of OP(fluid.layers.embedding) "
+            "expected >= 0 and < %ld, but got %ld. Please check input value.",
+            N, ids_data[i]);
       }
+      math::ScatterAddRows<T>(dev_ctx, d_output_data, D, ids_data,
+                              ids->numel(), padding_idx, N, d_table_data);
     }
   }
 };
@@ -0,0 +1,157 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/embedding_gather.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "paddle/fluid/operators/jit/kernels.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// The rows of the indices kPrefetchDistance ahead are prefetched, which is
+// about the number of rows copied during a miss of the memory.
+static constexpr int64_t kPrefetchDistance = 8;
+static constexpr size_t kCacheLineSize = 64;
+
+static inline void PrefetchRow(const void* row, size_t bytes) {
+#if defined(__GNUC__) || defined(__clang__)
+  const char* ptr = static_cast<const char*>(row);
+  for (size_t offset = 0; offset < bytes; offset += kCacheLineSize) {
+    __builtin_prefetch(ptr + offset, /*rw=*/0, /*locality=*/1);
+  }
+#endif
+}
+
+template <typename T>
+void GatherRows(const platform::CPUDeviceContext& context, const T* table,
+                int64_t width, const int64_t* index, int64_t num,
+                int64_t padding_idx, T* out) {
+  const std::vector<T> zeros(width, static_cast<T>(0));
+  const size_t row_bytes = width * sizeof(T);
+  auto row = [&](int64_t i) {
+    return index[i] == padding_idx ? zeros.data() : table + index[i] * width;
+  };
+  // A row costs a miss of the memory besides the copy.
+  const double cost = 200.0 + static_cast<double>(row_bytes) / 16;
+  context.ParallelFor(num, cost, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < std::min(begin + kPrefetchDistance, end);
+         ++i) {
+      PrefetchRow(row(i), row_bytes);
+    }
+    for (int64_t i = begin; i < end; ++i) {
+      if (i + kPrefetchDistance < end) {
+        PrefetchRow(row(i + kPrefetchDistance), row_bytes);
+      }
+      std::memcpy(out + i * width, row(i), row_bytes);
+    }
+  });
+}
+
+void DedupIndex(const int64_t* index, int64_t num,
+                std::vector<int64_t>* unique, std::vector<int64_t>* inverse) {
+  // An open addressing hash table of the positions in unique, with linear
+  // probing and Fibonacci hashing, which is several times faster than
+  // std::unordered_map for the ids of a batch.
+  int shift = 64 - 4;
+  while ((static_cast<int64_t>(1) << (64 - shift)) < 2 * num) {
+    --shift;
+  }
+  const size_t mask = (static_cast<size_t>(1) << (64 - shift)) - 1;
+  std::vector<std::pair<int64_t, int64_t>> slots(mask + 1, {0, -1});
+  unique->clear();
+  inverse->resize(num);
+  for (int64_t i = 0; i < num; ++i) {
+    const int64_t id = index[i];
+    size_t slot =
+        (static_cast<uint64_t>(id) * 0x9E3779B97F4A7C15ULL) >> shift;
+    while (slots[slot].second >= 0 && slots[slot].first != id) {
+      slot = (slot + 1) & mask;
+    }
+    if (slots[slot].second < 0) {
+      slots[slot] = {id, static_cast<int64_t>(unique->size())};
+      unique->push_back(id);
+    }
+    (*inverse)[i] = slots[slot].second;
+  }
+}
+
+template <typename T>
+void DedupGatherRows(const platform::CPUDeviceContext& context, const T* table,
+                     int64_t width, const int64_t* index, int64_t num,
+                     int64_t padding_idx, T* out) {
+  std::vector<int64_t> unique, inverse;
+  DedupIndex(index, num, &unique, &inverse);
+  std::vector<T> rows(unique.size() * width);
+  GatherRows<T>(context, table, width, unique.data(), unique.size(),
+                padding_idx, rows.data());
+  // The positions in unique are never negative, so -1 pads nothing.
+  GatherRows<T>(context, rows.data(), width, inverse.data(), num, -1, out);
+}
+
+template <typename T>
+void ScatterAddRows(const platform::CPUDeviceContext& context, const T* rows,
+                    int64_t width, const int64_t* index, int64_t num,
+                    int64_t padding_idx, int64_t height, T* out) {
+  auto add = jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache()
+                 .At(static_cast<int>(width));
+  const size_t row_bytes = width * sizeof(T);
+  // Every part scans all the indices, and adds the rows in its range of out.
+  const int64_t parts =
+      std::max<int64_t>(std::min<int64_t>(context.intra_op_threads(), height),
+                        1);
+  const double cost = static_cast<double>(num) * (20.0 + width);
+  context.ParallelFor(parts, cost, [&](int64_t begin, int64_t end) {
+    for (int64_t part = begin; part < end; ++part) {
+      const int64_t lower = height * part / parts;
+      const int64_t upper = height * (part + 1) / parts;
+      for (int64_t i = 0; i < num; ++i) {
+        const int64_t next = index[std::min(i + kPrefetchDistance, num - 1)];
+        if (next >= lower && next < upper && next != padding_idx) {
+          PrefetchRow(out + next * width, row_bytes);
+        }
+        const int64_t id = index[i];
+        if (id >= lower && id < upper && id != padding_idx) {
+          T* dst = out + id * width;
+          add(dst, rows + i * width, dst, static_cast<int>(width));
+        }
+      }
+    }
+  });
+}
+
+template void GatherRows<float>(const platform::CPUDeviceContext&,
+                                const float*, int64_t, const int64_t*,
+                                int64_t, int64_t, float*);
+template void GatherRows<double>(const platform::CPUDeviceContext&,
+                                 const double*, int64_t, const int64_t*,
+                                 int64_t, int64_t, double*);
+template void DedupGatherRows<float>(const platform::CPUDeviceContext&,
+                                     const float*, int64_t, const int64_t*,
+                                     int64_t, int64_t, float*);
+template void DedupGatherRows<double>(const platform::CPUDeviceContext&,
+                                      const double*, int64_t, const int64_t*,
+                                      int64_t, int64_t, double*);
+template void ScatterAddRows<float>(const platform::CPUDeviceContext&,
+                                    const float*, int64_t, const int64_t*,
+                                    int64_t, int64_t, int64_t, float*);
+template void ScatterAddRows<double>(const platform::CPUDeviceContext&,
+                                     const double*, int64_t, const int64_t*,
+                                     int64_t, int64_t, int64_t, double*);
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,65 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <vector>
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+/*
+ * The CPU engine of lookup_table, which gathers the rows of an embedding
+ * table of [height, width] by the indices, and scatters the gradients back.
+ *
+ * The indices are split over the intra-op threads of the context, and the
+ * rows of the next indices are prefetched while a row is copied, since the
+ * rows of a large table are rarely in the cache. The indices equal to
+ * padding_idx read a row of zeros instead of branching on every element.
+ * The indices are checked by the callers.
+ */
+
+// out[i] = table[index[i]] for i in [0, num), and out is of [num, width].
+template <typename T>
+void GatherRows(const platform::CPUDeviceContext& context, const T* table,
+                int64_t width, const int64_t* index, int64_t num,
+                int64_t padding_idx, T* out);
+
+// Unique the indices in the order of their first occurrences, so that
+// index[i] == (*unique)[(*inverse)[i]].
+void DedupIndex(const int64_t* index, int64_t num,
+                std::vector<int64_t>* unique, std::vector<int64_t>* inverse);
+
+// The same as GatherRows, but every distinct index is read from the table
+// once into a compact buffer, which is then copied to out. It is faster when
+// the indices repeat a lot, e.g. the hot ids of the recommendation models.
+template <typename T>
+void DedupGatherRows(const platform::CPUDeviceContext& context, const T* table,
+                     int64_t width, const int64_t* index, int64_t num,
+                     int64_t padding_idx, T* out);
+
+// out[index[i]] += rows[i] for i in [0, num) except the indices equal to
+// padding_idx, and out is of [height, width]. The rows of out are split over
+// the threads, so the rows of an index are added by one thread in the order
+// of i, the same as a serial loop.
+template <typename T>
+void ScatterAddRows(const platform::CPUDeviceContext& context, const T* rows,
+                    int64_t width, const int64_t* index, int64_t num,
+                    int64_t padding_idx, int64_t height, T* out);
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,121 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/embedding_gather.h"
+#include <random>
+#include <vector>
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+DECLARE_int32(intra_op_threads);
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+static const int64_t kHeight = 1000;
+static const int64_t kWidth = 37;
+static const int64_t kNum = 20000;
+static const int64_t kPaddingIdx = 3;
+
+static std::vector<int64_t> RandomIndex(int64_t num, int64_t height) {
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int64_t> dist(0, height - 1);
+  std::vector<int64_t> index(num);
+  for (auto& i : index) {
+    i = dist(rng);
+  }
+  return index;
+}
+
+static std::vector<float> RandomRows(int64_t num, int64_t width) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  std::vector<float> rows(num * width);
+  for (auto& v : rows) {
+    v = dist(rng);
+  }
+  return rows;
+}
+
+static void ExpectGathered(const std::vector<float>& table,
+                           const std::vector<int64_t>& index,
+                           const std::vector<float>& out) {
+  for (size_t i = 0; i < index.size(); ++i) {
+    for (int64_t j = 0; j < kWidth; ++j) {
+      float expected =
+          index[i] == kPaddingIdx ? 0.f : table[index[i] * kWidth + j];
+      ASSERT_EQ(out[i * kWidth + j], expected);
+    }
+  }
+}
+
+class EmbeddingGatherTest : public ::testing::TestWithParam<int> {
+ protected:
+  // The pool is created at the first use, with the threads of the flag.
+  static void SetUpTestCase() { FLAGS_intra_op_threads = 4; }
+
+  void SetUp() override { platform::SetIntraOpThreads(GetParam()); }
+  void TearDown() override { platform::SetIntraOpThreads(0); }
+
+  platform::CPUDeviceContext ctx_;
+};
+
+TEST_P(EmbeddingGatherTest, GatherRows) {
+  auto table = RandomRows(kHeight, kWidth);
+  auto index = RandomIndex(kNum, kHeight);
+  std::vector<float> out(kNum * kWidth, -1.f);
+  GatherRows<float>(ctx_, table.data(), kWidth, index.data(), kNum,
+                    kPaddingIdx, out.data());
+  ExpectGathered(table, index, out);
+
+  std::fill(out.begin(), out.end(), -1.f);
+  DedupGatherRows<float>(ctx_, table.data(), kWidth, index.data(), kNum,
+                         kPaddingIdx, out.data());
+  ExpectGathered(table, index, out);
+}
+
+TEST_P(EmbeddingGatherTest, ScatterAddRows) {
+  auto rows = RandomRows(kNum, kWidth);
+  auto index = RandomIndex(kNum, kHeight);
+  std::vector<float> expected(kHeight * kWidth, 0.f);
+  for (int64_t i = 0; i < kNum; ++i) {
+    if (index[i] == kPaddingIdx) {
+      continue;
+    }
+    for (int64_t j = 0; j < kWidth; ++j) {
+      expected[index[i] * kWidth + j] += rows[i * kWidth + j];
+    }
+  }
+  std::vector<float> out(kHeight * kWidth, 0.f);
+  ScatterAddRows<float>(ctx_, rows.data(), kWidth, index.data(), kNum,
+                        kPaddingIdx, kHeight, out.data());
+  // The rows of an index are added in the same order as the serial loop.
+  EXPECT_EQ(out, expected);
+}
+
+INSTANTIATE_TEST_CASE_P(IntraOpThreads, EmbeddingGatherTest,
+                        ::testing::Values(1, 4));
+
+TEST(EmbeddingGather, DedupIndex) {
+  std::vector<int64_t> index = {5, 2, 5, 7, 2, 2, 0};
+  std::vector<int64_t> unique, inverse;
+  DedupIndex(index.data(), index.size(), &unique, &inverse);
+  EXPECT_EQ(unique, std::vector<int64_t>({5, 2, 7, 0}));
+  EXPECT_EQ(inverse, std::vector<int64_t>({0, 1, 0, 2, 1, 1, 3}));
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -65,6 +65,14 @@ to a file on disk.
                   "type and then saved. Otherwise, the tensor will be "
                   "directly saved without data type conversion.")
         .SetDefault(false);
+    AddAttr<bool>("mmap_layout",
+                  "(boolean, default false)"
+                  "If true, the tensors are saved in the layout which can be "
+                  "mapped into the memory by load_combine, so that the "
+                  "processes loading the file share the memory of the "
+                  "tensors. Otherwise, the tensors are serialized one by "
+                  "one.")
+        .SetDefault(false);
     AddAttr<std::string>(
         "file_path",
         "(string)"
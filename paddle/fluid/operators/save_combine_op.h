@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include <stdint.h>
 #include <fstream>
+#include <memory>
 #include <numeric>
 #include <sstream>
 #include <string>
@@ -24,6 +25,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/data_type_transform.h"
 #include "paddle/fluid/framework/framework.pb.h"
 #include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/mmap_param_file.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/port.h"
@@ -38,6 +40,7 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     auto filename = ctx.Attr<std::string>("file_path");
     auto overwrite = ctx.Attr<bool>("overwrite");
     auto save_as_fp16 = ctx.Attr<bool>("save_as_fp16");
+    auto mmap_layout = ctx.Attr<bool>("mmap_layout");
 
     bool is_present = FileExists(filename);
     if (is_present && !overwrite) {
@@ -46,9 +49,15 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     }
 
     MkDirRecursively(DirName(filename).c_str());
-    std::ofstream fout(filename, std::ios::binary);
-    PADDLE_ENFORCE(static_cast<bool>(fout), "Cannot open %s to write",
-                   filename);
+    std::unique_ptr<framework::MmapParamFileWriter> writer;
+    std::ofstream fout;
+    if (mmap_layout) {
+      writer.reset(new framework::MmapParamFileWriter(filename));
+    } else {
+      fout.open(filename, std::ios::binary);
+      PADDLE_ENFORCE(static_cast<bool>(fout), "Cannot open %s to write",
+                     filename);
+    }
 
     auto &inp_var_names = ctx.Inputs("X");
     auto &inp_vars = ctx.MultiInputVar("X");
@@ -82,12 +91,22 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
         // copy LoD info to the new tensor
         out.set_lod(tensor.lod());
         framework::TransDataType(in_kernel_type, out_kernel_type, tensor, &out);
-        framework::SerializeToStream(fout, out, dev_ctx);
+        if (writer) {
+          writer->Append(inp_var_names[i], out);
+        } else {
+          framework::SerializeToStream(fout, out, dev_ctx);
+        }
+      } else if (writer) {
+        writer->Append(inp_var_names[i], tensor);
       } else {
         framework::SerializeToStream(fout, tensor, dev_ctx);
       }
     }
-    fout.close();
+    if (writer) {
+      writer->Close();
+    } else {
+      fout.close();
+    }
   }
 };
 
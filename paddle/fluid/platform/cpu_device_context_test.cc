@@ -0,0 +1,118 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/device_context.h"
+
+DECLARE_int32(intra_op_threads);
+
+namespace paddle {
+namespace platform {
+
+// The pool is created at the first use, with the threads of the flag.
+static void InitIntraOpThreadPool() { FLAGS_intra_op_threads = 4; }
+
+#ifdef EIGEN_USE_THREADS
+TEST(CPUDeviceContext, IntraOpThreads) {
+  InitIntraOpThreadPool();
+  CPUDeviceContext ctx;
+  EXPECT_EQ(GetIntraOpThreads(), 0);
+  EXPECT_EQ(ctx.intra_op_threads(), 4);
+  {
+    ScopedIntraOpThreads guard(2);
+    EXPECT_EQ(ctx.intra_op_threads(), 2);
+    EXPECT_EQ(ctx.eigen_device()->numThreads(), 2);
+    {
+      ScopedIntraOpThreads inner(1);
+      EXPECT_EQ(ctx.intra_op_threads(), 1);
+    }
+    EXPECT_EQ(ctx.intra_op_threads(), 2);
+  }
+  EXPECT_EQ(GetIntraOpThreads(), 0);
+
+  // the budget is larger than the pool
+  ScopedIntraOpThreads guard(16);
+  EXPECT_EQ(ctx.intra_op_threads(), 4);
+
+  // the budget is set for every thread
+  std::thread thread([&ctx] {
+    EXPECT_EQ(GetIntraOpThreads(), 0);
+    SetIntraOpThreads(3);
+    EXPECT_EQ(ctx.intra_op_threads(), 3);
+  });
+  thread.join();
+  EXPECT_EQ(GetIntraOpThreads(), 16);
+}
+#endif
+
+TEST(CPUDeviceContext, ParallelFor) {
+  InitIntraOpThreadPool();
+  CPUDeviceContext ctx;
+  for (int num_threads : {1, 4}) {
+    ScopedIntraOpThreads guard(num_threads);
+    for (int64_t n : {0, 1, 7, 100000}) {
+      std::vector<std::atomic<int>> visited(n);
+      for (auto& v : visited) {
+        v = 0;
+      }
+      ctx.ParallelFor(n, 100, [&](int64_t begin, int64_t end) {
+        ASSERT_LE(0, begin);
+        ASSERT_LE(begin, end);
+        ASSERT_LE(end, n);
+        for (int64_t i = begin; i < end; ++i) {
+          ++visited[i];
+        }
+        // the nested loops in the pool threads do not deadlock
+        std::atomic<int64_t> nested{0};
+        ctx.ParallelFor(10, 100000, [&nested](int64_t begin, int64_t end) {
+          nested += end - begin;
+        });
+        ASSERT_EQ(nested, 10);
+      });
+      for (int64_t i = 0; i < n; ++i) {
+        ASSERT_EQ(visited[i], 1) << "n = " << n << ", i = " << i;
+      }
+    }
+  }
+}
+
+TEST(CPUDeviceContext, EigenExpression) {
+  InitIntraOpThreadPool();
+  CPUDeviceContext ctx;
+  ScopedIntraOpThreads guard(4);
+  const int n = 1 << 16;
+  std::vector<double> x(n), y(n), out(n);
+  for (int i = 0; i < n; ++i) {
+    x[i] = i;
+    y[i] = 2 * i;
+  }
+  Eigen::TensorMap<Eigen::Tensor<double, 1>> x_t(x.data(), n);
+  Eigen::TensorMap<Eigen::Tensor<double, 1>> y_t(y.data(), n);
+  Eigen::TensorMap<Eigen::Tensor<double, 1>> out_t(out.data(), n);
+  out_t.device(*ctx.eigen_device()) = x_t + y_t;
+  for (int i = 0; i < n; ++i) {
+    ASSERT_EQ(out[i], 3.0 * i);
+  }
+
+  Eigen::Tensor<double, 0> sum;
+  sum.device(*ctx.eigen_device()) = x_t.sum();
+  EXPECT_DOUBLE_EQ(sum(), 0.5 * n * (n - 1));
+}
+
+}  // namespace platform
+}  // namespace paddle
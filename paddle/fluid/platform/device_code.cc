@@ -13,12 +13,172 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/platform/device_code.h"
+#ifndef _WIN32
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
 #include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include "gflags/gflags.h"
 #include "paddle/fluid/platform/enforce.h"
 
+DEFINE_string(cpu_device_code_compiler, "c++",
+              "The C++ compiler to compile the code of CPUDeviceCode, e.g. "
+              "the kernels generated by fusion_group.");
+DEFINE_string(cpu_device_code_cache_dir, "",
+              "The directory to cache the shared libraries compiled by "
+              "CPUDeviceCode, which must be owned by the user and not "
+              "writable by the others. The default is "
+              "$HOME/.cache/paddle_cpu_device_code, or "
+              "/tmp/paddle_cpu_device_code.<uid> without $HOME.");
+
 namespace paddle {
 namespace platform {
 
+#ifndef _WIN32
+static const char kCPUCompileOptions[] =
+    "-std=c++11 -O3 -march=native -fPIC -shared";
+
+static void MkDirRecursively(const std::string& dir) {
+  struct stat st;
+  if (stat(dir.c_str(), &st) == 0) {
+    PADDLE_ENFORCE(S_ISDIR(st.st_mode), "%s is not a directory", dir);
+    return;
+  }
+  auto pos = dir.find_last_of('/');
+  if (pos != std::string::npos && pos > 0) {
+    MkDirRecursively(dir.substr(0, pos));
+  }
+  PADDLE_ENFORCE(mkdir(dir.c_str(), 0700) == 0 || errno == EEXIST,
+                 "Cannot create the directory %s", dir);
+}
+
+static std::string CPUDeviceCodeCacheDir() {
+  if (!FLAGS_cpu_device_code_cache_dir.empty()) {
+    return FLAGS_cpu_device_code_cache_dir;
+  }
+  const char* home = std::getenv("HOME");
+  if (home != nullptr && home[0] != '\0') {
+    return std::string(home) + "/.cache/paddle_cpu_device_code";
+  }
+  return "/tmp/paddle_cpu_device_code." + std::to_string(geteuid());
+}
+
+// A library is only loaded from a directory or a file which is not a
+// symbolic link, is owned by the user, and can not be written by the others,
+// so that no other user can make the process load their code.
+static void CheckOwnedByUser(const std::string& path, bool is_dir) {
+  struct stat st;
+  PADDLE_ENFORCE_EQ(lstat(path.c_str(), &st), 0, "Cannot stat %s", path);
+  PADDLE_ENFORCE(is_dir ? S_ISDIR(st.st_mode) : S_ISREG(st.st_mode),
+                 "%s is not a %s", path, is_dir ? "directory" : "file");
+  PADDLE_ENFORCE(st.st_uid == geteuid() &&
+                     (st.st_mode & (S_IWGRP | S_IWOTH)) == 0,
+                 "%s must be owned by the user and not writable by the "
+                 "group or the others",
+                 path);
+}
+
+// The code is compiled with -march=native, so the libraries compiled on
+// another CPU, e.g. in a directory shared by the machines, are not loaded.
+static std::string CPUIdentifier() {
+  std::ifstream fin("/proc/cpuinfo");
+  std::string line, id;
+  while (std::getline(fin, line)) {
+    if (line.compare(0, 10, "model name") == 0 ||
+        line.compare(0, 5, "flags") == 0) {
+      id += line + "\n";
+    } else if (line.empty() && !id.empty()) {
+      break;
+    }
+  }
+  return id;
+}
+
+CPUDeviceCode::CPUDeviceCode(const Place& place, const std::string& name,
+                             const std::string& kernel) {
+  if (!is_cpu_place(place)) {
+    PADDLE_THROW("CPUDeviceCode can only launch on CPU place.");
+  }
+
+  place_ = place;
+  name_ = name;
+  kernel_ = kernel;
+}
+
+CPUDeviceCode::~CPUDeviceCode() {
+  if (library_ != nullptr) {
+    dlclose(library_);
+  }
+}
+
+void CPUDeviceCode::Compile() {
+  std::string compile_command =
+      FLAGS_cpu_device_code_compiler + " " + kCPUCompileOptions;
+  static const std::string cpu_id = CPUIdentifier();
+  std::string key = std::to_string(std::hash<std::string>()(
+      compile_command + "\n" + cpu_id + "\n" + kernel_));
+  const std::string cache_dir = CPUDeviceCodeCacheDir();
+  MkDirRecursively(cache_dir);
+  CheckOwnedByUser(cache_dir, true);
+  std::string library_path = cache_dir + "/" + name_ + "_" + key + ".so";
+
+  struct stat st;
+  if (lstat(library_path.c_str(), &st) != 0) {
+    // Compile into a temporary file and rename it, so that the processes
+    // compiling the same code never load a partial library.
+    std::string tmp_path = library_path + ".tmp" + std::to_string(getpid());
+    std::string source_path = tmp_path + ".cc";
+    std::string log_path = tmp_path + ".log";
+    {
+      std::ofstream fout(source_path);
+      fout << kernel_;
+      PADDLE_ENFORCE(static_cast<bool>(fout), "Failed to write %s",
+                     source_path);
+    }
+    std::string command = compile_command + " -o '" + tmp_path + "' '" +
+                          source_path + "' > '" + log_path + "' 2>&1";
+    int ret = std::system(command.c_str());
+    std::ifstream fin(log_path);
+    std::string log((std::istreambuf_iterator<char>(fin)),
+                    std::istreambuf_iterator<char>());
+    std::remove(source_path.c_str());
+    std::remove(log_path.c_str());
+    if (ret != 0) {
+      std::remove(tmp_path.c_str());
+      PADDLE_THROW("JIT compiling of CPU code %s failed by `%s`:\n%s", name_,
+                   command, log);
+    }
+    PADDLE_ENFORCE_EQ(chmod(tmp_path.c_str(), 0700), 0,
+                      "Failed to change the mode of %s", tmp_path);
+    PADDLE_ENFORCE_EQ(std::rename(tmp_path.c_str(), library_path.c_str()), 0,
+                      "Failed to rename the library to %s", library_path);
+    VLOG(3) << "Compile " << name_ << " into " << library_path;
+  }
+
+  CheckOwnedByUser(library_path, false);
+  library_ = dlopen(library_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  PADDLE_ENFORCE_NOT_NULL(library_, "Fail to load %s: %s", library_path,
+                          dlerror());
+  function_ =
+      reinterpret_cast<void (*)(void**)>(dlsym(library_, name_.c_str()));
+  PADDLE_ENFORCE_NOT_NULL(function_, "Fail to get function of %s in %s",
+                          name_, library_path);
+}
+
+void CPUDeviceCode::Launch(const size_t n, std::vector<void*>* args) const {
+  PADDLE_ENFORCE_NOT_NULL(function_, "%s is not compiled.", name_);
+  function_(args->data());
+}
+#endif
+
 #ifdef PADDLE_WITH_CUDA
 inline bool is_error(nvrtcResult stat) { return stat != NVRTC_SUCCESS; }
 
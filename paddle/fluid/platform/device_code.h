@@ -37,6 +37,27 @@ class DeviceCode {
   std::string kernel_;
 };
 
+#ifndef _WIN32
+// Compile the code for the host into a shared library by the C++ compiler and
+// load it. The libraries are cached on the disk by the hash of the code, the
+// compiler options and the CPU, so the code is compiled once on the machine.
+//
+// The kernel is launched like a CUDA kernel: the function named `name` takes
+// the pointers to the arguments as `void** args`.
+class CPUDeviceCode : public DeviceCode {
+ public:
+  explicit CPUDeviceCode(const Place& place, const std::string& name,
+                         const std::string& kernel);
+  ~CPUDeviceCode();
+  void Compile() override;
+  void Launch(const size_t n, std::vector<void*>* args) const override;
+
+ private:
+  void* library_{nullptr};
+  void (*function_)(void**){nullptr};
+};
+#endif
+
 #ifdef PADDLE_WITH_CUDA
 class CUDADeviceCode : public DeviceCode {
  public:
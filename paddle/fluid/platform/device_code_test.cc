@@ -13,10 +13,16 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/platform/device_code.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/platform/init.h"
 
+DECLARE_string(cpu_device_code_cache_dir);
+
 constexpr auto saxpy_code = R"(
 extern "C" __global__
 void saxpy_kernel(float a, float *x, float* y, float* z, size_t n) {
@@ -27,6 +33,77 @@ void saxpy_kernel(float a, float *x, float* y, float* z, size_t n) {
 }
 )";
 
+constexpr auto cpu_saxpy_code = R"(
+#include <cstddef>
+
+extern "C" void saxpy_kernel(void** args) {
+  float a = *static_cast<float*>(args[0]);
+  float* x = *static_cast<float**>(args[1]);
+  float* y = *static_cast<float**>(args[2]);
+  float* z = *static_cast<float**>(args[3]);
+  size_t n = *static_cast<size_t*>(args[4]);
+  for (size_t i = 0; i < n; ++i) {
+    z[i] = a * x[i] + y[i];
+  }
+}
+)";
+
+TEST(device_code, cpu) {
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceCode code(place, "saxpy_kernel", cpu_saxpy_code);
+
+  paddle::framework::Tensor x;
+  paddle::framework::Tensor y;
+  paddle::framework::Tensor z;
+
+  float scale = 2;
+  auto dims = paddle::framework::make_ddim(
+      {static_cast<int64_t>(256), static_cast<int64_t>(1024)});
+  float* x_data = x.mutable_data<float>(dims, place);
+  float* y_data = y.mutable_data<float>(dims, place);
+  float* z_data = z.mutable_data<float>(dims, place);
+
+  size_t n = x.numel();
+  for (size_t i = 0; i < n; ++i) {
+    x_data[i] = static_cast<float>(i);
+    y_data[i] = static_cast<float>(0.5);
+  }
+
+  code.Compile();
+
+  std::vector<void*> args = {&scale, &x_data, &y_data, &z_data, &n};
+  code.Launch(n, &args);
+
+  for (size_t i = 0; i < n; i++) {
+    PADDLE_ENFORCE_EQ(z_data[i], static_cast<float>(i) * scale + 0.5);
+  }
+
+  // The second one loads the cached library.
+  paddle::platform::CPUDeviceCode cached(place, "saxpy_kernel",
+                                         cpu_saxpy_code);
+  cached.Compile();
+  scale = 3;
+  cached.Launch(n, &args);
+  PADDLE_ENFORCE_EQ(z_data[10], 30.5f);
+
+  paddle::platform::CPUDeviceCode wrong(place, "saxpy_kernel",
+                                        "not a C++ code");
+  EXPECT_THROW(wrong.Compile(), paddle::platform::EnforceNotMet);
+}
+
+TEST(device_code, cpu_cache_dir_writable_by_others) {
+  std::string dir = "device_code_test_cache." + std::to_string(getpid());
+  ASSERT_EQ(mkdir(dir.c_str(), 0700), 0);
+  ASSERT_EQ(chmod(dir.c_str(), 0777), 0);
+  std::string old_dir = FLAGS_cpu_device_code_cache_dir;
+  FLAGS_cpu_device_code_cache_dir = dir;
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceCode code(place, "saxpy_kernel", cpu_saxpy_code);
+  EXPECT_THROW(code.Compile(), paddle::platform::EnforceNotMet);
+  FLAGS_cpu_device_code_cache_dir = old_dir;
+  rmdir(dir.c_str());
+}
+
 #ifdef PADDLE_WITH_CUDA
 TEST(device_code, cuda) {
   paddle::framework::InitDevices(false, {0});
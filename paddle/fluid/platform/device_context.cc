@@ -10,6 +10,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 #include "paddle/fluid/platform/device_context.h"
+#include <algorithm>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -22,8 +23,11 @@ limitations under the License. */
 #include "paddle/fluid/platform/cuda_device_guard.h"
 #endif
 
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 
+DECLARE_int32(intra_op_threads);
+
 namespace paddle {
 namespace memory {
 
@@ -117,6 +121,77 @@ DeviceContextPool::DeviceContextPool(
   }
 }
 
+#ifdef EIGEN_USE_THREADS
+// Run the tasks in the calling thread.
+class InlineThreadPool : public Eigen::ThreadPoolInterface {
+ public:
+  void Schedule(std::function<void()> fn) override { fn(); }
+  int NumThreads() const override { return 1; }
+  int CurrentThreadId() const override { return -1; }
+};
+
+// The intra-op thread pool shared by the CPUDeviceContexts, and the Eigen
+// devices on it, devices_[i] uses i + 1 threads.
+class IntraOpThreadPool {
+ public:
+  static IntraOpThreadPool& Instance() {
+    static IntraOpThreadPool pool(std::max(FLAGS_intra_op_threads, 1));
+    return pool;
+  }
+
+  Eigen::ThreadPoolDevice* Device(int num_threads) {
+    // the nested parallelism in the pool threads may deadlock
+    if (pool_ && pool_->CurrentThreadId() != -1) {
+      num_threads = 1;
+    }
+    if (num_threads <= 0 || num_threads > static_cast<int>(devices_.size())) {
+      num_threads = static_cast<int>(devices_.size());
+    }
+    return devices_[num_threads - 1].get();
+  }
+
+ private:
+  explicit IntraOpThreadPool(int num_threads) {
+    devices_.emplace_back(new Eigen::ThreadPoolDevice(&inline_pool_, 1));
+    if (num_threads > 1) {
+      VLOG(1) << "Create the intra-op thread pool of " << num_threads
+              << " threads";
+      pool_.reset(new Eigen::ThreadPool(num_threads));
+      for (int i = 2; i <= num_threads; ++i) {
+        devices_.emplace_back(new Eigen::ThreadPoolDevice(pool_.get(), i));
+      }
+    }
+  }
+
+  InlineThreadPool inline_pool_;
+  std::unique_ptr<Eigen::ThreadPool> pool_;
+  std::vector<std::unique_ptr<Eigen::ThreadPoolDevice>> devices_;
+};
+#endif
+
+static thread_local int g_intra_op_threads = 0;
+
+void SetIntraOpThreads(int num_threads) {
+  PADDLE_ENFORCE_GE(num_threads, 0,
+                    "The number of intra-op threads should not be negative");
+  g_intra_op_threads = num_threads;
+}
+
+int GetIntraOpThreads() { return g_intra_op_threads; }
+
+#ifdef EIGEN_USE_THREADS
+CPUDeviceContext::CPUDeviceContext() {}
+
+CPUDeviceContext::CPUDeviceContext(CPUPlace place) : place_(place) {}
+
+Eigen::ThreadPoolDevice* CPUDeviceContext::eigen_device() const {
+  return IntraOpThreadPool::Instance().Device(g_intra_op_threads);
+}
+
+int CPUDeviceContext::intra_op_threads() const {
+  return eigen_device()->numThreads();
+}
+#else
 CPUDeviceContext::CPUDeviceContext() {
   eigen_device_.reset(new Eigen::DefaultDevice());
 }
@@ -129,6 +204,32 @@ Eigen::DefaultDevice* CPUDeviceContext::eigen_device() const {
   return eigen_device_.get();
 }
 
+int CPUDeviceContext::intra_op_threads() const { return 1; }
+#endif
+
+void CPUDeviceContext::ParallelFor(
+    int64_t n, double cost_per_unit,
+    const std::function<void(int64_t, int64_t)>& fn) const {
+  if (n <= 0) {
+    return;
+  }
+#ifdef EIGEN_USE_THREADS
+  auto* device = eigen_device();
+  if (device->numThreads() == 1) {
+    fn(0, n);
+    return;
+  }
+  device->parallelFor(static_cast<Eigen::Index>(n),
+                      Eigen::TensorOpCost(0, 0, cost_per_unit),
+                      [&fn](Eigen::Index begin, Eigen::Index end) {
+                        fn(static_cast<int64_t>(begin),
+                           static_cast<int64_t>(end));
+                      });
+#else
+  fn(0, n);
+#endif
+}
+
 Place CPUDeviceContext::GetPlace() const { return place_; }
 
 #ifdef PADDLE_WITH_CUDA
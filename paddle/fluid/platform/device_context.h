@@ -10,6 +10,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 #pragma once
 
+#include <functional>
 #include <future>  // NOLINT
 #include <memory>
 #include <mutex>  // NOLINT
@@ -52,18 +53,62 @@ class DeviceContext {
   virtual void Wait() const {}
 };
 
+/*
+ * The CPU kernels run by a thread use at most GetIntraOpThreads() threads,
+ * which is the budget of the executor or the predictor run by the thread.
+ * The threads are taken from a pool of FLAGS_intra_op_threads threads shared
+ * by all the CPUDeviceContexts. 0 means all the threads of the pool.
+ *
+ * The pool is only built with WITH_EIGEN_THREADPOOL, which defines
+ * EIGEN_USE_THREADS. Otherwise the CPU kernels always run in the calling
+ * thread by Eigen::DefaultDevice.
+ */
+void SetIntraOpThreads(int num_threads);
+int GetIntraOpThreads();
+
+// Set the intra-op threads of the calling thread in the scope.
+class ScopedIntraOpThreads {
+ public:
+  explicit ScopedIntraOpThreads(int num_threads)
+      : prev_num_threads_(GetIntraOpThreads()) {
+    SetIntraOpThreads(num_threads);
+  }
+  ~ScopedIntraOpThreads() { SetIntraOpThreads(prev_num_threads_); }
+
+ private:
+  int prev_num_threads_;
+};
+
 class CPUDeviceContext : public DeviceContext {
  public:
   CPUDeviceContext();
   explicit CPUDeviceContext(CPUPlace place);
 
+#ifdef EIGEN_USE_THREADS
+  // The Eigen device using the intra-op threads of the calling thread. It
+  // runs the expressions in the calling thread if the budget is 1, or it is
+  // called by a thread of the pool.
+  Eigen::ThreadPoolDevice* eigen_device() const;
+#else
   Eigen::DefaultDevice* eigen_device() const;
+#endif
+
+  // The number of threads used by eigen_device() and ParallelFor.
+  int intra_op_threads() const;
+
+  // Call fn(begin, end) for the ranges covering [0, n) in parallel by the
+  // intra-op threads. cost_per_unit is the estimated cycles of a unit, the
+  // cheap loops are run in the calling thread.
+  void ParallelFor(int64_t n, double cost_per_unit,
+                   const std::function<void(int64_t, int64_t)>& fn) const;
 
   Place GetPlace() const override;
 
  private:
   CPUPlace place_;
+#ifndef EIGEN_USE_THREADS
   std::unique_ptr<Eigen::DefaultDevice> eigen_device_;
+#endif
 };
 
 template <typename Place>
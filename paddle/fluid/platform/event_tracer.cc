@@ -0,0 +1,442 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/event_tracer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/string/printf.h"
+
+DEFINE_bool(enable_event_tracer, false,
+            "Enable the event tracer, which records the latency histograms "
+            "and the timelines of the events, e.g. the ops, with little "
+            "overhead.");
+DEFINE_int32(event_tracer_buffer_size, 32768,
+             "The number of the latest events kept by every thread for the "
+             "Chrome trace of the event tracer.");
+
+namespace paddle {
+namespace platform {
+
+static constexpr int kMaxTracedNames = 4096;
+
+// The latencies in ns are counted by log-linear buckets: 8 buckets in every
+// [2^e, 2^(e+1)), whose error is within 1/16. The latencies longer than
+// 2^40 ns are counted by the last bucket.
+static constexpr int kSubBucketBits = 3;
+static constexpr uint64_t kSubBucketNum = 1 << kSubBucketBits;
+static constexpr int kMaxBit = 40;
+static constexpr size_t kBucketNum =
+    (kMaxBit - kSubBucketBits + 1) * kSubBucketNum;
+
+static inline int HighestBit(uint64_t n) {
+  int bit = 0;
+  while (n >>= 1) {
+    ++bit;
+  }
+  return bit;
+}
+
+static size_t BucketIndex(uint64_t ns) {
+  if (ns < kSubBucketNum) {
+    return ns;
+  }
+  int e = HighestBit(ns);
+  if (e >= kMaxBit) {
+    return kBucketNum - 1;
+  }
+  return (e - kSubBucketBits + 1) * kSubBucketNum +
+         ((ns >> (e - kSubBucketBits)) & (kSubBucketNum - 1));
+}
+
+// The middle of the latencies counted by the bucket
+static double BucketValue(size_t index) {
+  if (index < kSubBucketNum) {
+    return index;
+  }
+  int e = index / kSubBucketNum + kSubBucketBits - 1;
+  uint64_t sub = index % kSubBucketNum;
+  uint64_t width = static_cast<uint64_t>(1) << (e - kSubBucketBits);
+  return static_cast<double>((kSubBucketNum + sub) * width) + width / 2.0;
+}
+
+// A histogram is only written by its thread, the relaxed atomics make it
+// readable by the other threads. ResetEventTracer may lose the counts
+// written at the same time.
+struct LatencyHistogram {
+  LatencyHistogram() { Reset(); }
+
+  void Add(uint64_t ns) {
+    Increase(&buckets[BucketIndex(ns)], 1);
+    Increase(&calls, 1);
+    Increase(&total_ns, ns);
+    if (ns > max_ns.load(std::memory_order_relaxed)) {
+      max_ns.store(ns, std::memory_order_relaxed);
+    }
+  }
+
+  void Reset() {
+    for (auto &bucket : buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    calls.store(0, std::memory_order_relaxed);
+    total_ns.store(0, std::memory_order_relaxed);
+    max_ns.store(0, std::memory_order_relaxed);
+  }
+
+  static void Increase(std::atomic<uint64_t> *counter, uint64_t n) {
+    counter->store(counter->load(std::memory_order_relaxed) + n,
+                   std::memory_order_relaxed);
+  }
+
+  std::atomic<uint64_t> buckets[kBucketNum];
+  std::atomic<uint64_t> calls;
+  std::atomic<uint64_t> total_ns;
+  std::atomic<uint64_t> max_ns;
+};
+
+struct TraceRecord {
+  std::atomic<int> event_id;
+  std::atomic<uint64_t> start_ns;
+  std::atomic<uint64_t> end_ns;
+};
+
+// The ring buffer and the histograms of a thread. The i-th event is written
+// to records[i % capacity], and head is increased after it is written, so
+// a reader knows which records may be overwritten while it reads.
+struct ThreadTrace {
+  ThreadTrace(int tid, size_t capacity)
+      : tid(tid), capacity(capacity), records(new TraceRecord[capacity]) {
+    for (auto &histogram : histograms) {
+      histogram.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~ThreadTrace() {
+    for (auto &histogram : histograms) {
+      delete histogram.load(std::memory_order_relaxed);
+    }
+  }
+
+  int tid;
+  size_t capacity;
+  std::unique_ptr<TraceRecord[]> records;
+  std::atomic<uint64_t> head{0};
+  std::atomic<LatencyHistogram *> histograms[kMaxTracedNames];
+};
+
+struct EventTracer {
+  std::mutex mtx;
+  std::unordered_map<std::string, int> name_ids;
+  std::deque<std::string> names;
+  std::vector<std::shared_ptr<ThreadTrace>> threads;
+  // The traces of the exited threads, which are still read by the stats and
+  // the Chrome trace. A new thread reuses one of them, so there are no more
+  // traces than the threads alive at the same time, and ResetEventTracer
+  // releases them.
+  std::vector<ThreadTrace *> free_threads;
+  int next_tid = 0;
+  // the events started before are dropped
+  std::atomic<uint64_t> begin_ns{0};
+};
+
+// It is never destroyed, since the threads may record events at exit.
+static EventTracer &GetEventTracer() {
+  static auto *tracer = new EventTracer;
+  return *tracer;
+}
+
+static void ReleaseThreadTrace(EventTracer *tracer, ThreadTrace *trace) {
+  auto &threads = tracer->threads;
+  threads.erase(std::find_if(threads.begin(), threads.end(),
+                             [trace](const std::shared_ptr<ThreadTrace> &t) {
+                               return t.get() == trace;
+                             }));
+}
+
+static thread_local ThreadTrace *g_thread_trace = nullptr;
+// set when the thread exits, the events recorded after are ignored
+static thread_local bool g_thread_exited = false;
+
+// Owned by every thread recording events, gives its trace to the free list
+// of the tracer when the thread exits.
+struct ThreadTraceOwner {
+  ~ThreadTraceOwner() {
+    g_thread_exited = true;
+    if (g_thread_trace != nullptr) {
+      auto &tracer = GetEventTracer();
+      std::lock_guard<std::mutex> guard(tracer.mtx);
+      tracer.free_threads.push_back(g_thread_trace);
+      g_thread_trace = nullptr;
+    }
+  }
+};
+
+static ThreadTrace *GetThreadTrace() {
+  if (g_thread_trace == nullptr && !g_thread_exited) {
+    static thread_local ThreadTraceOwner owner;
+    auto &tracer = GetEventTracer();
+    size_t capacity = std::max(FLAGS_event_tracer_buffer_size, 1);
+    std::lock_guard<std::mutex> guard(tracer.mtx);
+    while (!tracer.free_threads.empty()) {
+      auto *trace = tracer.free_threads.back();
+      tracer.free_threads.pop_back();
+      if (trace->capacity == capacity) {
+        g_thread_trace = trace;
+        return g_thread_trace;
+      }
+      ReleaseThreadTrace(&tracer, trace);
+    }
+    tracer.threads.emplace_back(
+        std::make_shared<ThreadTrace>(tracer.next_tid++, capacity));
+    g_thread_trace = tracer.threads.back().get();
+  }
+  return g_thread_trace;
+}
+
+bool IsEventTracerEnabled() { return FLAGS_enable_event_tracer; }
+
+void EnableEventTracer() { FLAGS_enable_event_tracer = true; }
+
+void DisableEventTracer() { FLAGS_enable_event_tracer = false; }
+
+void ResetEventTracer() {
+  auto &tracer = GetEventTracer();
+  std::lock_guard<std::mutex> guard(tracer.mtx);
+  tracer.begin_ns.store(TracerNowNs());
+  for (auto *trace : tracer.free_threads) {
+    ReleaseThreadTrace(&tracer, trace);
+  }
+  tracer.free_threads.clear();
+  for (auto &thread : tracer.threads) {
+    for (auto &histogram : thread->histograms) {
+      auto *h = histogram.load(std::memory_order_acquire);
+      if (h != nullptr) {
+        h->Reset();
+      }
+    }
+  }
+}
+
+uint64_t TracerNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int TracedEventId(const std::string &name) {
+  static thread_local std::unordered_map<std::string, int> name_ids;
+  auto iter = name_ids.find(name);
+  if (iter != name_ids.end()) {
+    return iter->second;
+  }
+
+  auto &tracer = GetEventTracer();
+  int id = -1;
+  {
+    std::lock_guard<std::mutex> guard(tracer.mtx);
+    auto it = tracer.name_ids.find(name);
+    if (it != tracer.name_ids.end()) {
+      id = it->second;
+    } else if (tracer.names.size() < static_cast<size_t>(kMaxTracedNames)) {
+      id = static_cast<int>(tracer.names.size());
+      tracer.names.emplace_back(name);
+      tracer.name_ids.emplace(name, id);
+    } else {
+      LOG_FIRST_N(WARNING, 1) << "The event tracer records at most "
+                              << kMaxTracedNames << " names, " << name
+                              << " is ignored";
+    }
+  }
+  name_ids.emplace(name, id);
+  return id;
+}
+
+void TraceEvent(int event_id, uint64_t start_ns, uint64_t end_ns) {
+  if (event_id < 0) {
+    return;
+  }
+  auto *thread = GetThreadTrace();
+  if (thread == nullptr) {
+    return;
+  }
+  auto &histogram = thread->histograms[event_id];
+  auto *h = histogram.load(std::memory_order_relaxed);
+  if (h == nullptr) {
+    h = new LatencyHistogram;
+    histogram.store(h, std::memory_order_release);
+  }
+  h->Add(end_ns > start_ns ? end_ns - start_ns : 0);
+
+  uint64_t head = thread->head.load(std::memory_order_relaxed);
+  auto &record = thread->records[head % thread->capacity];
+  record.event_id.store(event_id, std::memory_order_relaxed);
+  record.start_ns.store(start_ns, std::memory_order_relaxed);
+  record.end_ns.store(end_ns, std::memory_order_relaxed);
+  thread->head.store(head + 1, std::memory_order_release);
+}
+
+static double Percentile(const std::vector<uint64_t> &buckets, uint64_t calls,
+                         double q) {
+  uint64_t target = std::max<uint64_t>(
+      static_cast<uint64_t>(std::ceil(q * calls)), static_cast<uint64_t>(1));
+  uint64_t count = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    count += buckets[i];
+    if (count >= target) {
+      return BucketValue(i);
+    }
+  }
+  return BucketValue(buckets.size() - 1);
+}
+
+std::vector<EventLatencyStat> GetEventLatencyStats() {
+  auto &tracer = GetEventTracer();
+  std::lock_guard<std::mutex> guard(tracer.mtx);
+  std::vector<EventLatencyStat> stats;
+  std::vector<uint64_t> buckets(kBucketNum);
+  for (size_t id = 0; id < tracer.names.size(); ++id) {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    uint64_t calls = 0, total_ns = 0, max_ns = 0;
+    for (auto &thread : tracer.threads) {
+      auto *h = thread->histograms[id].load(std::memory_order_acquire);
+      if (h == nullptr) {
+        continue;
+      }
+      for (size_t i = 0; i < kBucketNum; ++i) {
+        buckets[i] += h->buckets[i].load(std::memory_order_relaxed);
+      }
+      calls += h->calls.load(std::memory_order_relaxed);
+      total_ns += h->total_ns.load(std::memory_order_relaxed);
+      max_ns = std::max(max_ns, h->max_ns.load(std::memory_order_relaxed));
+    }
+    if (calls == 0) {
+      continue;
+    }
+    EventLatencyStat stat;
+    stat.name = tracer.names[id];
+    stat.calls = calls;
+    stat.total_ms = total_ns / 1e6;
+    stat.ave_us = total_ns / 1e3 / calls;
+    stat.max_us = max_ns / 1e3;
+    stat.p50_us = std::min(Percentile(buckets, calls, 0.5) / 1e3, stat.max_us);
+    stat.p99_us = std::min(Percentile(buckets, calls, 0.99) / 1e3, stat.max_us);
+    stats.emplace_back(std::move(stat));
+  }
+  std::sort(stats.begin(), stats.end(),
+            [](const EventLatencyStat &a, const EventLatencyStat &b) {
+              return a.total_ms > b.total_ms;
+            });
+  return stats;
+}
+
+static std::string JsonEscape(const std::string &str) {
+  std::string escaped;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      escaped += buf;
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+void WriteChromeTrace(std::ostream *os) {
+  auto &tracer = GetEventTracer();
+  std::vector<std::shared_ptr<ThreadTrace>> threads;
+  std::vector<std::string> names;
+  {
+    std::lock_guard<std::mutex> guard(tracer.mtx);
+    threads = tracer.threads;
+    names.assign(tracer.names.begin(), tracer.names.end());
+  }
+  uint64_t begin_ns = tracer.begin_ns.load();
+
+  *os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  for (auto &thread : threads) {
+    *os << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\","
+        << "\"pid\":0,\"tid\":" << thread->tid
+        << ",\"args\":{\"name\":\"thread " << thread->tid << "\"}}";
+    first = false;
+
+    uint64_t head = thread->head.load(std::memory_order_acquire);
+    uint64_t begin = head > thread->capacity ? head - thread->capacity : 0;
+    struct Record {
+      int event_id;
+      uint64_t start_ns;
+      uint64_t end_ns;
+    };
+    std::vector<Record> records;
+    records.reserve(head - begin);
+    for (uint64_t i = begin; i < head; ++i) {
+      auto &record = thread->records[i % thread->capacity];
+      records.push_back(
+          Record{record.event_id.load(std::memory_order_relaxed),
+                 record.start_ns.load(std::memory_order_relaxed),
+                 record.end_ns.load(std::memory_order_relaxed)});
+    }
+    // The records may be overwritten by the events after head while they
+    // are read, drop them.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t new_head = thread->head.load(std::memory_order_relaxed);
+    size_t skip = 0;
+    if (new_head >= thread->capacity && new_head - thread->capacity >= begin) {
+      skip = std::min<uint64_t>(new_head - thread->capacity - begin + 1,
+                                records.size());
+    }
+
+    for (size_t i = skip; i < records.size(); ++i) {
+      auto &record = records[i];
+      if (record.start_ns < begin_ns || record.event_id < 0 ||
+          static_cast<size_t>(record.event_id) >= names.size()) {
+        continue;
+      }
+      *os << ",\n{\"name\":\"" << JsonEscape(names[record.event_id])
+          << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread->tid
+          << ",\"ts\":" << string::Sprintf("%.3f", record.start_ns / 1e3)
+          << ",\"dur\":"
+          << string::Sprintf("%.3f",
+                             (record.end_ns - record.start_ns) / 1e3)
+          << "}";
+    }
+  }
+  *os << "\n]}\n";
+}
+
+void DumpChromeTrace(const std::string &path) {
+  std::ofstream ofs(path);
+  PADDLE_ENFORCE(ofs.is_open(), "Cannot open %s to write the Chrome trace",
+                 path);
+  WriteChromeTrace(&ofs);
+  VLOG(1) << "The Chrome trace of the event tracer is written to " << path;
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -0,0 +1,77 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace platform {
+
+/*
+ * The event tracer is a lightweight alternative of the profiler, which is
+ * cheap enough to stay on in a running job. Every thread records its events
+ * into its own ring buffer and latency histograms without any lock, and the
+ * records can be read at any time, without disabling the tracer:
+ *
+ *  - GetEventLatencyStats returns the calls and the percentiles of the
+ *    latency of every event name, e.g. of every op type.
+ *  - DumpChromeTrace writes the latest events of every thread as a Chrome
+ *    trace JSON, which can be opened by chrome://tracing.
+ *
+ * The tracer is enabled by FLAGS_enable_event_tracer or EnableEventTracer,
+ * and the events are recorded by RecordEvent.
+ */
+
+bool IsEventTracerEnabled();
+
+void EnableEventTracer();
+
+void DisableEventTracer();
+
+// Clear the histograms, drop the events recorded before, and release the
+// ring buffers of the exited threads.
+void ResetEventTracer();
+
+// The id of the event name, -1 if the number of names exceeds the limit.
+int TracedEventId(const std::string& name);
+
+// Record an event of [start_ns, end_ns) of the calling thread, the time is
+// from TracerNowNs.
+void TraceEvent(int event_id, uint64_t start_ns, uint64_t end_ns);
+
+uint64_t TracerNowNs();
+
+struct EventLatencyStat {
+  std::string name;
+  uint64_t calls;
+  double total_ms;
+  double ave_us;
+  double p50_us;
+  double p99_us;
+  double max_us;
+};
+
+// Sorted by the total time in descending order.
+std::vector<EventLatencyStat> GetEventLatencyStats();
+
+void WriteChromeTrace(std::ostream* os);
+
+void DumpChromeTrace(const std::string& path);
+
+}  // namespace platform
+}  // namespace paddle
@@ -0,0 +1,169 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/event_tracer.h"
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+DECLARE_int32(event_tracer_buffer_size);
+
+namespace paddle {
+namespace platform {
+
+static const EventLatencyStat* FindStat(
+    const std::vector<EventLatencyStat>& stats, const std::string& name) {
+  for (auto& stat : stats) {
+    if (stat.name == name) {
+      return &stat;
+    }
+  }
+  return nullptr;
+}
+
+static size_t CountSubstr(const std::string& str, const std::string& sub) {
+  size_t count = 0;
+  for (size_t pos = str.find(sub); pos != std::string::npos;
+       pos = str.find(sub, pos + sub.size())) {
+    ++count;
+  }
+  return count;
+}
+
+TEST(EventTracer, LatencyStats) {
+  ResetEventTracer();
+  int fast = TracedEventId("fast_op");
+  int slow = TracedEventId("slow_op");
+  EXPECT_EQ(TracedEventId("fast_op"), fast);
+  EXPECT_NE(fast, slow);
+
+  // fast_op takes 1us to 100us, slow_op takes 1ms except one 10ms call.
+  uint64_t now = TracerNowNs();
+  for (int i = 1; i <= 100; ++i) {
+    TraceEvent(fast, now, now + i * 1000);
+  }
+  for (int i = 0; i < 99; ++i) {
+    TraceEvent(slow, now, now + 1000000);
+  }
+  TraceEvent(slow, now, now + 10000000);
+
+  auto stats = GetEventLatencyStats();
+  auto* fast_stat = FindStat(stats, "fast_op");
+  auto* slow_stat = FindStat(stats, "slow_op");
+  ASSERT_NE(fast_stat, nullptr);
+  ASSERT_NE(slow_stat, nullptr);
+  // sorted by the total time
+  EXPECT_EQ(stats[0].name, "slow_op");
+
+  EXPECT_EQ(fast_stat->calls, 100UL);
+  EXPECT_NEAR(fast_stat->ave_us, 50.5, 1e-6);
+  EXPECT_NEAR(fast_stat->p50_us, 50, 50 / 16.0);
+  EXPECT_NEAR(fast_stat->p99_us, 99, 99 / 16.0);
+  EXPECT_NEAR(fast_stat->max_us, 100, 1e-6);
+
+  EXPECT_EQ(slow_stat->calls, 100UL);
+  EXPECT_NEAR(slow_stat->p50_us, 1000, 1000 / 16.0);
+  EXPECT_NEAR(slow_stat->p99_us, 1000, 1000 / 16.0);
+  EXPECT_NEAR(slow_stat->max_us, 10000, 1e-6);
+
+  ResetEventTracer();
+  EXPECT_EQ(FindStat(GetEventLatencyStats(), "fast_op"), nullptr);
+}
+
+TEST(EventTracer, ChromeTrace) {
+  ResetEventTracer();
+  int id = TracedEventId("op\"quoted\"");
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 3; ++t) {
+    threads.emplace_back([id] {
+      for (int i = 0; i < 10; ++i) {
+        uint64_t start = TracerNowNs();
+        TraceEvent(id, start, start + 100);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::ostringstream os;
+  WriteChromeTrace(&os);
+  std::string trace = os.str();
+  EXPECT_EQ(trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0UL);
+  EXPECT_EQ(CountSubstr(trace, "\"name\":\"op\\\"quoted\\\"\""), 30UL);
+  EXPECT_EQ(CountSubstr(trace, "\"dur\":0.100"), 30UL);
+  EXPECT_EQ(trace.substr(trace.size() - 3), "]}\n");
+}
+
+TEST(EventTracer, RingBufferKeepsLatestEvents) {
+  ResetEventTracer();
+  FLAGS_event_tracer_buffer_size = 16;
+  int old_id = TracedEventId("old_event");
+  int new_id = TracedEventId("new_event");
+  // a new thread takes the new buffer size
+  std::thread thread([old_id, new_id] {
+    uint64_t start = TracerNowNs();
+    for (int i = 0; i < 100; ++i) {
+      TraceEvent(old_id, start, start + 1);
+    }
+    for (int i = 0; i < 16; ++i) {
+      TraceEvent(new_id, start, start + 1);
+    }
+  });
+  thread.join();
+
+  std::ostringstream os;
+  WriteChromeTrace(&os);
+  EXPECT_EQ(CountSubstr(os.str(), "\"name\":\"old_event\""), 0UL);
+  // the oldest record is dropped, since it may be overwritten while it is
+  // read
+  EXPECT_EQ(CountSubstr(os.str(), "\"name\":\"new_event\""), 15UL);
+  // the histograms count all events
+  auto stats = GetEventLatencyStats();
+  auto* stat = FindStat(stats, "old_event");
+  ASSERT_NE(stat, nullptr);
+  EXPECT_EQ(stat->calls, 100UL);
+}
+
+TEST(EventTracer, ExitedThreadsReuseBuffers) {
+  FLAGS_event_tracer_buffer_size = 64;
+  ResetEventTracer();
+  int id = TracedEventId("short_thread_event");
+  std::ostringstream before;
+  WriteChromeTrace(&before);
+  for (int t = 0; t < 20; ++t) {
+    std::thread thread([id] {
+      uint64_t start = TracerNowNs();
+      TraceEvent(id, start, start + 1);
+    });
+    thread.join();
+  }
+
+  std::ostringstream os;
+  WriteChromeTrace(&os);
+  // the threads run one by one share a ring buffer, and keep their events
+  EXPECT_EQ(CountSubstr(os.str(), "\"name\":\"short_thread_event\""), 20UL);
+  EXPECT_EQ(CountSubstr(os.str(), "\"name\":\"thread_name\""),
+            CountSubstr(before.str(), "\"name\":\"thread_name\"") + 1);
+  auto stats = GetEventLatencyStats();
+  auto* stat = FindStat(stats, "short_thread_event");
+  ASSERT_NE(stat, nullptr);
+  EXPECT_EQ(stat->calls, 20UL);
+}
+
+}  // namespace platform
+}  // namespace paddle
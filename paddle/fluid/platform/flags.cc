@@ -33,6 +33,39 @@
 DEFINE_int32(paddle_num_threads, 1,
              "Number of threads for each paddle instance.");
 
+/**
+ * Operator related FLAG
+ * Name: FLAGS_intra_op_threads
+ * Since Version: 1.6.0
+ * Value Range: int32, default=1
+ * Example: FLAGS_intra_op_threads=8, the Eigen based CPU kernels, e.g. the
+ * elementwise, activation and reduce kernels, run by 8 threads.
+ * Note: The threads are shared by all the executors and predictors in the
+ * process, the budget of an executor or a predictor can be smaller, see
+ * platform::SetIntraOpThreads. It only works when Paddle is built with
+ * WITH_EIGEN_THREADPOOL=ON.
+ */
+DEFINE_int32(intra_op_threads, 1,
+             "The number of threads in the pool shared by the CPU kernels to "
+             "run an op in parallel. 1 means running the ops in the thread "
+             "of the executor.");
+
+/**
+ * Operator related FLAG
+ * Name: FLAGS_lookup_table_dedup_ids
+ * Since Version: 1.6.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_lookup_table_dedup_ids=true, the CPU kernels of
+ * lookup_table read the row of every distinct id from the table once, and
+ * merge the rows of the same id in the sparse gradient.
+ * Note: It saves the reads of a large table and the rows of the sparse
+ * gradient when the ids of a batch repeat a lot, at the cost of hashing the
+ * ids, so it is slower when most of the ids are distinct.
+ */
+DEFINE_bool(lookup_table_dedup_ids, false,
+            "Whether the CPU kernels of lookup_table gather the distinct ids "
+            "only once and merge the sparse gradients of the same id.");
+
 /**
  * Operator related FLAG
  * Name: FLAGS_check_nan_inf
@@ -303,7 +336,8 @@ DEFINE_double(memory_fraction_of_eager_deletion, 1.0,
  * Allocator related FLAG
  * Name: FLAGS_allocator_strategy
  * Since Version: 1.2
- * Value Range: string, {naive_best_fit, auto_growth}, default=naive_best_fit
+ * Value Range: string, {naive_best_fit, auto_growth, thread_local},
+ *              default=naive_best_fit
  * Example:
  * Note: For selecting allocator policy of PaddlePaddle.
  */
@@ -311,7 +345,9 @@ DEFINE_string(allocator_strategy, "naive_best_fit",
               "The allocation strategy. naive_best_fit means the original best "
               "fit allocator of Fluid. "
               "auto_growth means the experimental auto-growth allocator. "
-              "Enum in [naive_best_fit, auto_growth].");
+              "thread_local means the CPU allocator with thread local caches "
+              "of size classes. "
+              "Enum in [naive_best_fit, auto_growth, thread_local].");
 
 /**
  * Memory related FLAG
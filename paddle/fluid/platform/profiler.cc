@@ -29,6 +29,7 @@ limitations under the License. */
 #include "glog/logging.h"
 #include "paddle/fluid/framework/block_desc.h"
 #include "paddle/fluid/platform/device_tracer.h"
+#include "paddle/fluid/platform/event_tracer.h"
 #include "paddle/fluid/platform/port.h"
 #include "paddle/fluid/string/printf.h"
 
@@ -138,6 +139,10 @@ void PopEvent(const std::string &name) {
 
 RecordEvent::RecordEvent(const std::string &name)
     : is_enabled_(false), start_ns_(PosixInNsec()) {
+  if (IsEventTracerEnabled()) {
+    trace_id_ = TracedEventId(name);
+    trace_start_ns_ = TracerNowNs();
+  }
   if (g_state == ProfilerState::kDisabled) return;
   // lock is not needed, the code below is thread-safe
 
@@ -149,6 +154,9 @@ RecordEvent::RecordEvent(const std::string &name)
 }
 
 RecordEvent::~RecordEvent() {
+  if (trace_id_ >= 0) {
+    TraceEvent(trace_id_, trace_start_ns_, TracerNowNs());
+  }
   if (g_state == ProfilerState::kDisabled || !is_enabled_) return;
   // lock is not needed, the code below is thread-safe
   DeviceTracer *tracer = GetDeviceTracer();
@@ -85,6 +85,9 @@ struct RecordEvent {
 
   bool is_enabled_;
   uint64_t start_ns_;
+  // The id of the event in the event tracer, -1 if it is not traced.
+  int trace_id_{-1};
+  uint64_t trace_start_ns_{0};
   // Event name
   std::string name_;
   // Need to distinguish name by op type, block_id, program_id and perhaps
@@ -23,6 +23,7 @@ limitations under the License. */
 #include "pybind11/pybind11.h"
 
 #include "paddle/fluid/operators/distributed/communicator.h"
+#include "paddle/fluid/operators/distributed/prefetch_row_cache.h"
 
 namespace py = pybind11;
 
@@ -30,6 +31,7 @@ using paddle::framework::ProgramDesc;
 using paddle::operators::distributed::Communicator;
 using paddle::operators::distributed::AsyncCommunicator;
 using paddle::operators::distributed::GeoSgdCommunicator;
+using paddle::operators::distributed::PrefetchRowCache;
 using paddle::framework::Scope;
 
 namespace paddle {
@@ -56,7 +58,19 @@ void BindCommunicator(py::module* m) {
       }))
       .def("stop", &Communicator::Stop)
       .def("start", &Communicator::Start)
-      .def("is_running", &Communicator::IsRunning);
+      .def("is_running", &Communicator::IsRunning)
+      .def("prefetch_cache_stats", [](const Communicator& self) {
+        // hits, misses, hit_rate and bytes_saved of the prefetch cache.
+        std::map<std::string, double> stats;
+        auto* cache = PrefetchRowCache::GetInstance();
+        if (cache != nullptr) {
+          stats["hits"] = cache->hits();
+          stats["misses"] = cache->misses();
+          stats["hit_rate"] = cache->hit_rate();
+          stats["bytes_saved"] = cache->bytes_saved();
+        }
+        return stats;
+      });
 }
 
 }  // namespace pybind
@@ -239,6 +239,8 @@ void BindDataset(py::module *m) {
            py::call_guard<py::gil_scoped_release>())
       .def("set_queue_num", &framework::Dataset::SetChannelNum,
            py::call_guard<py::gil_scoped_release>())
+      .def("set_channel_shard_num", &framework::Dataset::SetChannelShardNum,
+           py::call_guard<py::gil_scoped_release>())
       .def("set_parse_ins_id", &framework::Dataset::SetParseInsId,
            py::call_guard<py::gil_scoped_release>())
       .def("set_parse_content", &framework::Dataset::SetParseContent,
@@ -25,6 +25,7 @@ limitations under the License. */
 #include <utility>
 #include <vector>
 #include "paddle/fluid/imperative/backward_strategy.h"
+#include "paddle/fluid/imperative/jit/program_replayer.h"
 #include "paddle/fluid/imperative/layer.h"
 #include "paddle/fluid/imperative/nccl_context.h"
 #include "paddle/fluid/imperative/profiler.h"
@@ -210,6 +211,12 @@ void BindImperative(py::module *m_ptr) {
                     backward_strategy = fluid.dygraph.BackwardStrategy()
                     backward_strategy.sort_sum_gradient = True
                     loss2.backward(backward_strategy)
+
+        **num_threads**:
+
+        The number of threads to run the independent grad ops concurrently, which only works when all the grad ops are on CPU. The grad ops are run one by one if it is 1. The gradients summed by several threads are deterministic only if sort_sum_gradient is True.
+
+        By Default: 1
       )DOC");
   backward_strategy.def(py::init())
       .def_property("sort_sum_gradient",
@@ -219,6 +226,16 @@ void BindImperative(py::module *m_ptr) {
                     [](imperative::detail::BackwardStrategy &self,
                        bool sorted_sum_gradient) {
                       self.sorted_sum_gradient_ = sorted_sum_gradient;
+                    })
+      .def_property("num_threads",
+                    [](const imperative::detail::BackwardStrategy &self) {
+                      return self.num_threads_;
+                    },
+                    [](imperative::detail::BackwardStrategy &self,
+                       size_t num_threads) {
+                      PADDLE_ENFORCE_GT(num_threads, 0,
+                                        "num_threads must be positive");
+                      self.num_threads_ = num_threads;
                     });
 
   m.def("start_imperative_gperf_profiler",
@@ -327,8 +344,44 @@ void BindImperative(py::module *m_ptr) {
       .def("set_fetch_vars", &imperative::jit::ProgramDescTracer::SetFetchVars)
       .def("create_program_desc",
            &imperative::jit::ProgramDescTracer::CreateProgramDesc)
+      .def("get_persistable_vars",
+           &imperative::jit::ProgramDescTracer::GetPersistableVars)
       .def("reset", &imperative::jit::ProgramDescTracer::Reset);
 
+  using VarBaseList = std::vector<std::shared_ptr<imperative::VarBase>>;
+  py::class_<imperative::jit::ProgramReplayer>(m, "ProgramReplayer", "")
+      .def("__init__",
+           [](imperative::jit::ProgramReplayer &self,
+              const framework::ProgramDesc &program,
+              const VarBaseList &feed_vars,
+              const std::vector<std::string> &feed_names,
+              const std::vector<std::string> &fetch_names,
+              const VarBaseList &persistable_vars,
+              const std::vector<std::string> &passes,
+              const platform::CUDAPlace &place) {
+             new (&self) imperative::jit::ProgramReplayer(
+                 program, feed_vars, feed_names, fetch_names,
+                 persistable_vars, passes, place);
+           })
+      .def("__init__",
+           [](imperative::jit::ProgramReplayer &self,
+              const framework::ProgramDesc &program,
+              const VarBaseList &feed_vars,
+              const std::vector<std::string> &feed_names,
+              const std::vector<std::string> &fetch_names,
+              const VarBaseList &persistable_vars,
+              const std::vector<std::string> &passes,
+              const platform::CPUPlace &place) {
+             new (&self) imperative::jit::ProgramReplayer(
+                 program, feed_vars, feed_names, fetch_names,
+                 persistable_vars, passes, place);
+           })
+      .def("is_matched", &imperative::jit::ProgramReplayer::IsMatched)
+      .def("run", &imperative::jit::ProgramReplayer::Run,
+           py::call_guard<py::gil_scoped_release>())
+      .def("program", &imperative::jit::ProgramReplayer::Program,
+           py::return_value_policy::reference_internal);
+
   py::class_<imperative::Tracer>(m, "Tracer", "")
       .def("__init__",
            [](imperative::Tracer &self) { new (&self) imperative::Tracer(); })
@@ -337,9 +337,17 @@ void BindAnalysisConfig(py::module *m) {
            py::arg("x") = true)
       .def("ir_optim", &AnalysisConfig::ir_optim)
       .def("enable_memory_optim", &AnalysisConfig::EnableMemoryOptim)
+      .def("enable_static_memory_plan",
+           &AnalysisConfig::EnableStaticMemoryPlan, py::arg("x") = true)
+      .def("static_memory_plan_enabled",
+           &AnalysisConfig::static_memory_plan_enabled)
       .def("enable_profile", &AnalysisConfig::EnableProfile)
       .def("disable_glog_info", &AnalysisConfig::DisableGlogInfo)
       .def("set_optim_cache_dir", &AnalysisConfig::SetOptimCacheDir)
+      .def("enable_optim_program_cache",
+           &AnalysisConfig::EnableOptimProgramCache, py::arg("x") = true)
+      .def("optim_program_cache_enabled",
+           &AnalysisConfig::optim_program_cache_enabled)
       .def("switch_use_feed_fetch_ops", &AnalysisConfig::SwitchUseFeedFetchOps,
            py::arg("x") = true)
       .def("use_feed_fetch_ops_enabled",
@@ -370,6 +378,8 @@ void BindAnalysisConfig(py::module *m) {
            &AnalysisConfig::SetCpuMathLibraryNumThreads)
       .def("cpu_math_library_num_threads",
            &AnalysisConfig::cpu_math_library_num_threads)
+      .def("set_intra_op_threads", &AnalysisConfig::SetIntraOpThreads)
+      .def("intra_op_threads", &AnalysisConfig::intra_op_threads)
       .def("to_native_config", &AnalysisConfig::ToNativeConfig)
       .def("enable_quantizer", &AnalysisConfig::EnableMkldnnQuantizer)
 #ifdef PADDLE_WITH_MKLDNN
@@ -51,10 +51,12 @@ limitations under the License. */
 #include "paddle/fluid/operators/reader/lod_tensor_blocking_queue.h"
 #include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/dynload/dynamic_loader.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/init.h"
 #include "paddle/fluid/platform/place.h"
+#include "paddle/fluid/platform/event_tracer.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/pybind/box_helper_py.h"
 #include "paddle/fluid/pybind/const_value.h"
@@ -307,6 +309,8 @@ PYBIND11_MODULE(core_noavx, m) {
   BindException(&m);
 
   m.def("set_num_threads", &platform::SetNumThreads);
+  m.def("set_intra_op_threads", &platform::SetIntraOpThreads);
+  m.def("get_intra_op_threads", &platform::GetIntraOpThreads);
 
   m.def("from_dlpack", [](py::capsule *dltensor) {
     DLManagedTensor *dmt = reinterpret_cast<DLManagedTensor *>(
@@ -1538,6 +1542,22 @@ All parameter, weight, gradient are variables in Paddle.
   m.def("disable_profiler", platform::DisableProfiler);
   m.def("is_profiler_enabled", platform::IsProfileEnabled);
   m.def("reset_profiler", platform::ResetProfiler);
+
+  py::class_<platform::EventLatencyStat>(m, "EventLatencyStat")
+      .def_readonly("name", &platform::EventLatencyStat::name)
+      .def_readonly("calls", &platform::EventLatencyStat::calls)
+      .def_readonly("total_ms", &platform::EventLatencyStat::total_ms)
+      .def_readonly("ave_us", &platform::EventLatencyStat::ave_us)
+      .def_readonly("p50_us", &platform::EventLatencyStat::p50_us)
+      .def_readonly("p99_us", &platform::EventLatencyStat::p99_us)
+      .def_readonly("max_us", &platform::EventLatencyStat::max_us);
+
+  m.def("enable_event_tracer", platform::EnableEventTracer);
+  m.def("disable_event_tracer", platform::DisableEventTracer);
+  m.def("is_event_tracer_enabled", platform::IsEventTracerEnabled);
+  m.def("reset_event_tracer", platform::ResetEventTracer);
+  m.def("get_event_latency_stats", platform::GetEventLatencyStats);
+  m.def("dump_chrome_trace", platform::DumpChromeTrace);
   m.def("get_pass", [](const std::string &pass_type) {
     auto pass = framework::ir::PassRegistry::Instance().Get(pass_type);
     return std::shared_ptr<framework::ir::Pass>(std::move(pass));
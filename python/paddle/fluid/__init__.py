@@ -168,7 +168,11 @@ def __bootstrap__():
         'print_sub_graph_dir', 'pe_profile_fname', 'inner_op_parallelism',
         'enable_parallel_graph', 'fuse_parameter_groups_size',
         'multiple_of_cupti_buffer_size', 'fuse_parameter_memory_size',
-        'tracer_profile_fname', 'dygraph_debug'
+        'tracer_profile_fname', 'dygraph_debug',
+        'enable_multi_slot_buffer_parser', 'enable_work_stealing_threadpool',
+        'enable_executor_var_slots', 'enable_op_runtime_cache',
+        'enable_event_tracer', 'event_tracer_buffer_size', 'intra_op_threads',
+        'lookup_table_dedup_ids'
     ]
     if 'Darwin' not in sysstr:
         read_env_flags.append('use_pinned_memory')
@@ -193,6 +197,13 @@ def __bootstrap__():
         read_env_flags.append('rpc_prefetch_thread_num')
         read_env_flags.append('rpc_disable_reuse_port')
         read_env_flags.append('rpc_retry_bind_port')
+        if not core.is_compiled_with_brpc():
+            read_env_flags.append('rpc_send_chunk_size_mb')
+        # the shm transport wraps the grpc transport on linux only
+        if not core.is_compiled_with_brpc() and \
+                sys.platform.startswith('linux'):
+            read_env_flags.append('rpc_shm_transport')
+            read_env_flags.append('rpc_shm_ring_size_mb')
 
         read_env_flags.append('worker_update_interval_secs')
 
@@ -207,6 +218,12 @@ def __bootstrap__():
         read_env_flags.append('communicator_send_wait_times')
         read_env_flags.append('communicator_merge_sparse_grad')
         read_env_flags.append('communicator_is_sgd_optimizer')
+        read_env_flags.append('communicator_grad_compress')
+        read_env_flags.append('communicator_grad_compress_vars')
+        read_env_flags.append('communicator_grad_compress_block_size')
+        read_env_flags.append('communicator_grad_compress_min_numel')
+        read_env_flags.append('communicator_prefetch_cache_rows')
+        read_env_flags.append('communicator_prefetch_cache_staleness')
         if core.is_compiled_with_brpc():
             read_env_flags.append('max_body_size')
             #set brpc max body size
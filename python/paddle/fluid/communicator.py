@@ -120,3 +120,24 @@ class Communicator(object):
                 comm.is_running()
         """
         self.communicator_.is_running()
+
+    def prefetch_cache_stats(self):
+        """
+        Get the counters of the cache of the prefetched rows of the
+        distributed lookup tables, which is enabled by
+        FLAGS_communicator_prefetch_cache_rows.
+
+        Returns:
+            dict: hits, misses, hit_rate and bytes_saved, empty if the
+            rows are not cached.
+
+        Examples:
+            .. code-block:: python
+
+                import paddle.fluid as fluid
+
+                prog = fluid.Program()
+                comm = fluid.communicator.Communicator(prog)
+                comm.prefetch_cache_stats()
+        """
+        return self.communicator_.prefetch_cache_stats()
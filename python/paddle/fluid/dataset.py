@@ -294,6 +294,7 @@ class InMemoryDataset(DatasetBase):
         self.parse_content = False
         self.merge_by_lineid = False
         self.fleet_send_sleep_seconds = None
+        self.channel_shard_num = 0
 
     def _prepare_to_run(self):
         """
@@ -306,6 +307,7 @@ class InMemoryDataset(DatasetBase):
         if self.queue_num is None:
             self.queue_num = self.thread_num
         self.dataset.set_queue_num(self.queue_num)
+        self.dataset.set_channel_shard_num(self.channel_shard_num)
         self.dataset.set_parse_ins_id(self.parse_ins_id)
         self.dataset.set_parse_content(self.parse_content)
         self.dataset.set_data_feed_desc(self.desc())
@@ -340,6 +342,27 @@ class InMemoryDataset(DatasetBase):
         self.is_user_set_queue_num = True
         self.queue_num = queue_num
 
+    def set_channel_shard_num(self, channel_shard_num):
+        """
+        Set the shard num of the dataset channels. A sharded channel gives
+        every thread its own lock, which helps when many threads read and
+        write the same channel, e.g. thread_num is much larger than
+        queue_num. It does not keep the order of instances across threads.
+
+        Args:
+            channel_shard_num(int): shard num, 0 or 1 means not sharded,
+                                    default is 0
+
+        Examples:
+            .. code-block:: python
+
+              import paddle.fluid as fluid
+              dataset = fluid.DatasetFactory().create_dataset("InMemoryDataset")
+              dataset.set_channel_shard_num(8)
+
+        """
+        self.channel_shard_num = channel_shard_num
+
     def set_parse_ins_id(self, parse_ins_id):
         """
         Set id Dataset need to parse insid
@@ -374,6 +397,28 @@ class InMemoryDataset(DatasetBase):
         """
         self.parse_content = parse_content
 
+    def set_data_format(self, data_format):
+        """
+        Set the format of the files in filelist, "text" for MultiSlot text
+        files and "columnar" for the columnar record files converted by
+        columnar_record_converter, which are loaded without parsing.
+
+        Args:
+            data_format(str): "text" or "columnar", default is "text"
+
+        Examples:
+            .. code-block:: python
+
+              import paddle.fluid as fluid
+              dataset = fluid.DatasetFactory().create_dataset("InMemoryDataset")
+              dataset.set_data_format("columnar")
+
+        """
+        if data_format not in ("text", "columnar"):
+            raise ValueError("data_format must be text or columnar, got %s" %
+                             data_format)
+        self.proto_desc.data_format = data_format
+
     def set_fleet_send_batch_size(self, fleet_send_batch_size=1024):
         """
         Set fleet send batch size, default is 1024
@@ -657,6 +702,26 @@ class InMemoryDataset(DatasetBase):
         return local_data_size[0]
 
 
+class ArenaInMemoryDataset(InMemoryDataset):
+    """
+    ArenaInMemoryDataset, it is the same as InMemoryDataset except that the
+    instances parsed from one buffer share one block of memory, instead of
+    allocating memory for every instance. It saves a lot of memory when there
+    are many instances, but does not support merge_by_lineid and
+    slots_shuffle.
+    This class should be created by DatasetFactory
+
+    Example:
+        dataset = paddle.fluid.DatasetFactory().create_dataset("ArenaInMemoryDataset")
+    """
+
+    def __init__(self):
+        """ Init. """
+        super(ArenaInMemoryDataset, self).__init__()
+        self.proto_desc.name = "MultiSlotArenaInMemoryDataFeed"
+        self.dataset = core.Dataset("MultiSlotArenaDataset")
+
+
 class QueueDataset(DatasetBase):
     """
     QueueDataset, it will process data streamly.
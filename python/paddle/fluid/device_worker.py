@@ -175,6 +175,8 @@ class DownpourSGD(DeviceWorker):
         if opt_info["stat_var_names"]:
             for i in opt_info["stat_var_names"]:
                 downpour.stat_var_names.extend([i])
+        downpour.pipeline_pull_sparse = opt_info.get("pipeline_pull_sparse",
+                                                     False)
 
         for i in worker.get_desc().dense_table:
             if i.table_id in dense_table_set:
@@ -12,11 +12,15 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
-__all__ = ['trace']
+__all__ = ['trace', 'ReplayedLayer']
+
+import collections
+import logging
 
 from .base import program_desc_tracing_guard
 from .layers import Layer
-from paddle.fluid.framework import Program, Block, Variable, _dygraph_tracer, dygraph_only, _dygraph_guard
+from paddle.fluid.framework import Program, Block, Variable, _dygraph_tracer, dygraph_only, _dygraph_guard, _current_expected_place, default_main_program
+from paddle.fluid import core, unique_name
 
 
 def create_program_from_desc(program_desc):
@@ -134,3 +138,252 @@ def trace(layer, inputs, feed_names=None, fetch_names=None):
         program = create_program_from_desc(program_desc)
 
     return original_outputs, program
+
+
+_DEFAULT_REPLAY_PASSES = ['fc_fuse_pass', 'fuse_elewise_add_act_pass']
+
+
+def _input_signature(inputs):
+    """
+    The hashable signature of the inputs, which includes the shapes, data types
+    and LoDs of the Variables, and the values of the other arguments. Return
+    None if any argument is not hashable.
+    """
+    if isinstance(inputs, Variable):
+        tensor = inputs._ivar.value().get_tensor()
+        lod = tuple(tuple(level) for level in tensor.lod())
+        return (Variable, tuple(inputs.shape), inputs.dtype, lod)
+
+    if isinstance(inputs, (list, tuple)):
+        signature = [type(inputs)]
+        for item in inputs:
+            item_signature = _input_signature(item)
+            if item_signature is None:
+                return None
+            signature.append(item_signature)
+        return tuple(signature)
+
+    try:
+        hash(inputs)
+    except TypeError:
+        return None
+    return (type(inputs), inputs)
+
+
+def _flatten_outputs(outputs, var_list):
+    """
+    Append the Variables in outputs into var_list, and return the structure
+    of outputs for _pack_outputs.
+    """
+    if isinstance(outputs, Variable):
+        var_list.append(outputs)
+        return None
+
+    if isinstance(outputs, (list, tuple)):
+        return (type(outputs),
+                [_flatten_outputs(item, var_list) for item in outputs])
+
+    raise TypeError("The outputs of the replayed layer should be Variables, "
+                    "but got %s" % type(outputs))
+
+
+def _pack_outputs(structure, var_iter):
+    if structure is None:
+        return next(var_iter)
+
+    outputs_type, items = structure
+    return outputs_type([_pack_outputs(item, var_iter) for item in items])
+
+
+def _op_types(program_desc):
+    block = program_desc.block(0)
+    return [block.op(i).type() for i in range(block.op_size())]
+
+
+class _ReplayEntry(object):
+    def __init__(self, replayer, structure, num_outputs, op_types):
+        self.replayer = replayer
+        self.structure = structure
+        self.num_outputs = num_outputs
+        self.op_types = op_types
+        self.run_count = 0
+
+    def run(self, var_list):
+        block = default_main_program().current_block()
+        outputs = [
+            Variable(
+                block,
+                type=core.VarDesc.VarType.LOD_TENSOR,
+                name=unique_name.generate('replayed_tmp'),
+                stop_gradient=True) for _ in range(self.num_outputs)
+        ]
+        self.replayer.run(var_list, [var._ivar for var in outputs])
+        return _pack_outputs(self.structure, iter(outputs))
+
+
+class ReplayedLayer(object):
+    """
+    Run a dygraph :code:`Layer` by replaying the :code:`Program` traced from
+    it, instead of tracing its operators one by one in every call.
+
+    The first call with the inputs of a new signature, i.e. the shapes, data
+    types and LoDs of the input Variables and the values of the other
+    arguments, runs the layer in dygraph mode and traces it into a
+    :code:`Program`, which is optimized by :code:`passes` and prepared for the
+    static graph executor. The later calls with the same signature run the
+    prepared :code:`Program` with the current parameters of the layer.
+
+    Since the replayed operators are not recorded for backward, the layer is
+    only replayed when no gradient is required, i.e. under
+    :code:`fluid.dygraph.no_grad` or after :code:`layer.eval()` . Otherwise
+    the layer runs in dygraph mode as usual. The layer also runs in dygraph
+    mode if it cannot be traced, e.g. it returns its inputs directly.
+
+    The traced :code:`Program` is only valid if the operators run by the
+    layer depend on nothing but the signature of the inputs. To catch a
+    layer whose control flow depends on the values of the inputs, the layer
+    is traced again every :code:`check_interval` calls of a signature, which
+    stops replaying the signature once the traced operators change. A
+    change between two checks is not detected, and with
+    :code:`check_interval=0` it is never detected: the first traced
+    :code:`Program` keeps being replayed.
+
+    Parameters:
+        layer(Layer): the layer to be replayed.
+        passes(list(str), optional): the IR passes to optimize the traced
+                :code:`Program` . The passes should not modify the
+                parameters, since they share the memory with the layer.
+                Default None, which means the fc and the elementwise_add
+                activation fusion passes.
+        max_cache_size(int, optional): the max number of the signatures
+                cached. The least recently used one is dropped. Default 8.
+        check_interval(int, optional): trace the layer again every
+                :code:`check_interval` calls to check whether the traced
+                operators change. 0 means never check, so the changes of
+                the control flow go undetected. Default 100.
+
+    Examples:
+
+        .. code-block:: python
+
+            import paddle.fluid as fluid
+            from paddle.fluid.dygraph import FC, to_variable
+            from paddle.fluid.dygraph.jit import ReplayedLayer
+            import numpy as np
+
+            with fluid.dygraph.guard():
+                fc = FC("fc", 10)
+                fc.eval()
+                replayed = ReplayedLayer(fc)
+                for _ in range(10):
+                    in_np = np.random.random([2, 3]).astype('float32')
+                    out = replayed(to_variable(in_np))
+
+    """
+
+    def __init__(self, layer, passes=None, max_cache_size=8,
+                 check_interval=100):
+        assert isinstance(layer, Layer)
+        assert max_cache_size > 0, "max_cache_size should be positive"
+        assert check_interval >= 0, "check_interval should not be negative"
+        self._layer = layer
+        self._passes = list(_DEFAULT_REPLAY_PASSES
+                            if passes is None else passes)
+        self._max_cache_size = max_cache_size
+        self._check_interval = check_interval
+        # signature -> _ReplayEntry, or None if the signature is not replayable
+        self._cache = collections.OrderedDict()
+
+    @dygraph_only
+    def __call__(self, *inputs):
+        if _dygraph_tracer()._train_mode:
+            return self._layer(*inputs)
+
+        signature = _input_signature(inputs)
+        if signature is None:
+            return self._layer(*inputs)
+
+        if signature not in self._cache:
+            return self._trace(signature, inputs)
+
+        entry = self._cache.pop(signature)
+        self._cache[signature] = entry
+        if entry is None:
+            return self._layer(*inputs)
+
+        entry.run_count += 1
+        if self._check_interval > 0 and \
+                entry.run_count % self._check_interval == 0:
+            return self._check(signature, entry, inputs)
+
+        var_list = extract_vars(inputs)
+        if not entry.replayer.is_matched(var_list):
+            # e.g. the inputs are on another place
+            return self._layer(*inputs)
+        return entry.run(var_list)
+
+    def _trace_program(self, inputs):
+        """
+        Run the layer and trace it. Return the outputs, and the traced
+        program with its feed and fetch vars, or None if it cannot be traced.
+        """
+        tracer = _dygraph_tracer()._get_program_desc_tracer()
+        var_list = extract_vars(inputs)
+        feed_names = ['feed_%d' % i for i in range(len(var_list))]
+        tracer.set_feed_vars(var_list, feed_names)
+        try:
+            with program_desc_tracing_guard(True):
+                outputs = self._layer(*inputs)
+            try:
+                out_vars = []
+                structure = _flatten_outputs(outputs, out_vars)
+                fetch_names = ['fetch_%d' % i for i in range(len(out_vars))]
+                tracer.set_fetch_vars([var._ivar for var in out_vars],
+                                      fetch_names)
+                tracer.set_name_prefix('t_')
+                program_desc = tracer.create_program_desc()
+                persistable_vars = tracer.get_persistable_vars()
+            except (TypeError, core.EnforceNotMet) as e:
+                logging.warning("Cannot trace %s: %s",
+                                self._layer.full_name(), e)
+                return outputs, None
+        finally:
+            tracer.reset()
+        return outputs, (program_desc, structure, var_list, feed_names,
+                         fetch_names, persistable_vars)
+
+    def _trace(self, signature, inputs):
+        num_parameters = len(self._layer.parameters())
+        outputs, traced = self._trace_program(inputs)
+        if len(self._layer.parameters()) != num_parameters:
+            # The parameters are created in the call, and their initializers
+            # are traced, so trace the next call again.
+            return outputs
+
+        entry = None
+        if traced is not None:
+            program_desc, structure, var_list, feed_names, fetch_names, \
+                persistable_vars = traced
+            try:
+                replayer = core.ProgramReplayer(
+                    program_desc, var_list, feed_names, fetch_names,
+                    persistable_vars, self._passes, _current_expected_place())
+                entry = _ReplayEntry(replayer, structure, len(fetch_names),
+                                     _op_types(program_desc))
+            except core.EnforceNotMet as e:
+                logging.warning("Cannot replay %s: %s",
+                                self._layer.full_name(), e)
+
+        if len(self._cache) >= self._max_cache_size:
+            self._cache.popitem(last=False)
+        self._cache[signature] = entry
+        return outputs
+
+    def _check(self, signature, entry, inputs):
+        outputs, traced = self._trace_program(inputs)
+        if traced is None or _op_types(traced[0]) != entry.op_types:
+            logging.warning(
+                "The operators of %s change between calls, stop replaying "
+                "it for the inputs", self._layer.full_name())
+            self._cache[signature] = None
+        return outputs
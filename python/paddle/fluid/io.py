@@ -151,7 +151,8 @@ def save_vars(executor,
               main_program=None,
               vars=None,
               predicate=None,
-              filename=None):
+              filename=None,
+              mmap_layout=False):
     """
     This API saves specific variables in the `Program` to files.
 
@@ -179,6 +180,12 @@ def save_vars(executor,
         filename(str, optional): If you prefer to save all variables in a single file,
                                  use `filename` to specify it. Otherwise, let `filename` be None. 
                                  Default: None
+        mmap_layout(bool, optional): If True, the single file `filename` is saved in
+                                     the layout which is mapped into the memory when
+                                     it is loaded, so that the processes loading it share
+                                     the memory of the variables. It only works with
+                                     `filename`.
+                                     Default: False
 
     Returns:
         None
@@ -227,7 +234,8 @@ def save_vars(executor,
             main_program=main_program,
             dirname=save_dirname,
             vars=list(filter(predicate, main_program.list_vars())),
-            filename=filename)
+            filename=filename,
+            mmap_layout=mmap_layout)
     else:
         # give warning when there is no var in model
         if len(list(vars)) == 0:
@@ -265,7 +273,10 @@ def save_vars(executor,
                 type='save_combine',
                 inputs={'X': save_var_list},
                 outputs={},
-                attrs={'file_path': os.path.join(save_dirname, filename)})
+                attrs={
+                    'file_path': os.path.join(save_dirname, filename),
+                    'mmap_layout': mmap_layout
+                })
 
         executor.run(save_program)
 
@@ -520,7 +531,11 @@ def _save_distributed_persistables(executor, dirname, main_program):
                 main_program._endpoints)
 
 
-def save_persistables(executor, dirname, main_program=None, filename=None):
+def save_persistables(executor,
+                      dirname,
+                      main_program=None,
+                      filename=None,
+                      mmap_layout=False):
     """
     This operator saves all persistable variables from :code:`main_program` to 
     the folder :code:`dirname` or file :code:`filename`. You can refer to 
@@ -547,6 +562,11 @@ def save_persistables(executor, dirname, main_program=None, filename=None):
         filename(str, optional): The file to save all variables. If you prefer to
                                  save variables in different files, set it to None.
                                  Default: None.
+        mmap_layout(bool, optional): If True, the file :code:`filename` is saved in the
+                                     layout which is mapped into the memory when it is
+                                     loaded, so that the processes loading it share the
+                                     memory of the variables.
+                                     Default: False.
 
     Returns:
         None
@@ -582,7 +602,8 @@ def save_persistables(executor, dirname, main_program=None, filename=None):
             main_program=main_program,
             vars=None,
             predicate=is_persistable,
-            filename=filename)
+            filename=filename,
+            mmap_layout=mmap_layout)
 
 
 def load_vars(executor,
@@ -1016,7 +1037,8 @@ def save_inference_model(dirname,
                          model_filename=None,
                          params_filename=None,
                          export_for_deployment=True,
-                         program_only=False):
+                         program_only=False,
+                         mmap_layout=False):
     """
     Prune the given `main_program` to build a new program especially for inference,
     and then save it and all related parameters to given `dirname` .
@@ -1057,6 +1079,11 @@ def save_inference_model(dirname,
         program_only(bool, optional): If True, It will save inference program only, and do not 
                                       save params of Program.
                                       Default: False.
+        mmap_layout(bool, optional): If True, the file `params_filename` is saved in the
+                                     layout which is mapped into the memory when it is
+                                     loaded, so that the predictors and processes loading
+                                     the model share the memory of the parameters.
+                                     Default: False.
 
     Returns:
         The fetch variables' name list
@@ -1208,7 +1235,12 @@ def save_inference_model(dirname,
     if params_filename is not None:
         params_filename = os.path.basename(params_filename)
 
-    save_persistables(executor, save_dirname, main_program, params_filename)
+    save_persistables(
+        executor,
+        save_dirname,
+        main_program,
+        params_filename,
+        mmap_layout=mmap_layout)
     return target_var_name_list
 
 
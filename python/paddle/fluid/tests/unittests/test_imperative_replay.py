@@ -0,0 +1,144 @@
+# Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import unittest
+import numpy as np
+import paddle.fluid as fluid
+from paddle.fluid.dygraph import FC, to_variable
+from paddle.fluid.dygraph.jit import ReplayedLayer
+
+
+class MLP(fluid.dygraph.Layer):
+    def __init__(self, name_scope):
+        super(MLP, self).__init__(name_scope)
+        self._fc1 = FC(self.full_name(), 8, act='relu')
+        self._fc2 = FC(self.full_name(), 4)
+
+    def forward(self, x, scale=1.0):
+        hidden = self._fc1(x)
+        return self._fc2(hidden), fluid.layers.scale(hidden, scale=scale)
+
+
+class BranchedLayer(fluid.dygraph.Layer):
+    def __init__(self, name_scope):
+        super(BranchedLayer, self).__init__(name_scope)
+        self._fc = FC(self.full_name(), 4)
+
+    def forward(self, x):
+        out = self._fc(x)
+        # the control flow depends on the value of the input
+        if np.sum(x.numpy()) > 0:
+            out = fluid.layers.relu(out)
+        return out
+
+
+class TestImperativeReplay(unittest.TestCase):
+    def setUp(self):
+        self.place = fluid.CPUPlace()
+
+    def test_replay(self):
+        with fluid.dygraph.guard(self.place):
+            mlp = MLP('mlp')
+            replayed = ReplayedLayer(mlp)
+            with fluid.dygraph.no_grad():
+                for _ in range(4):
+                    x = to_variable(
+                        np.random.random([3, 5]).astype('float32'))
+                    out, hidden = replayed(x, 2.0)
+                    expected_out, expected_hidden = mlp(x, 2.0)
+                    self.assertTrue(
+                        np.allclose(out.numpy(), expected_out.numpy()))
+                    self.assertTrue(
+                        np.allclose(hidden.numpy(), expected_hidden.numpy()))
+                    self.assertTrue(out.stop_gradient)
+                self.assertEqual(len(replayed._cache), 1)
+                self.assertIsNotNone(list(replayed._cache.values())[0])
+
+                # a new shape or a new argument is traced again
+                x = to_variable(np.random.random([6, 5]).astype('float32'))
+                out, _ = replayed(x, 2.0)
+                self.assertEqual(out.shape, [6, 4])
+                out, hidden = replayed(x, 3.0)
+                _, expected_hidden = mlp(x, 3.0)
+                self.assertTrue(
+                    np.allclose(hidden.numpy(), expected_hidden.numpy()))
+                self.assertEqual(len(replayed._cache), 3)
+
+                # the replayed program uses the current parameters
+                weight = mlp._fc2.weight
+                weight.set_value(np.ones(weight.shape).astype('float32'))
+                out, _ = replayed(x, 3.0)
+                expected_out, _ = mlp(x, 3.0)
+                self.assertTrue(np.allclose(out.numpy(), expected_out.numpy()))
+
+    def test_cache_size(self):
+        with fluid.dygraph.guard(self.place):
+            replayed = ReplayedLayer(MLP('mlp'), max_cache_size=2)
+            with fluid.dygraph.no_grad():
+                for batch_size in range(1, 5):
+                    x = to_variable(
+                        np.random.random([batch_size, 5]).astype('float32'))
+                    replayed(x)
+            self.assertEqual(len(replayed._cache), 2)
+
+    def test_train_mode(self):
+        with fluid.dygraph.guard(self.place):
+            mlp = MLP('mlp')
+            replayed = ReplayedLayer(mlp)
+            x = to_variable(np.random.random([3, 5]).astype('float32'))
+            out, _ = replayed(x)
+            fluid.layers.reduce_mean(out).backward()
+            self.assertEqual(len(replayed._cache), 0)
+            self.assertIsNotNone(mlp._fc2.weight.gradient())
+
+            mlp.eval()
+            replayed(x)
+            self.assertEqual(len(replayed._cache), 1)
+            mlp.train()
+
+    def test_check_interval(self):
+        with fluid.dygraph.guard(self.place):
+            layer = BranchedLayer('branched')
+            replayed = ReplayedLayer(layer, check_interval=1)
+            positive = to_variable(np.ones([2, 3]).astype('float32'))
+            negative = to_variable(-np.ones([2, 3]).astype('float32'))
+            with fluid.dygraph.no_grad():
+                replayed(positive)
+                out = replayed(positive)
+                self.assertIsNotNone(list(replayed._cache.values())[0])
+                # the operators change, so the layer is not replayed any more
+                out = replayed(negative)
+                self.assertIsNone(list(replayed._cache.values())[0])
+                self.assertTrue(
+                    np.allclose(out.numpy(), layer(negative).numpy()))
+
+    def test_default_check_interval(self):
+        with fluid.dygraph.guard(self.place):
+            layer = BranchedLayer('branched')
+            replayed = ReplayedLayer(layer)
+            positive = to_variable(np.ones([2, 3]).astype('float32'))
+            negative = to_variable(-np.ones([2, 3]).astype('float32'))
+            with fluid.dygraph.no_grad():
+                for _ in range(100):
+                    replayed(positive)
+                self.assertIsNotNone(list(replayed._cache.values())[0])
+                # the 100th replayed call is traced again
+                replayed(negative)
+                self.assertIsNone(list(replayed._cache.values())[0])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -91,6 +91,44 @@ class TestBook(unittest.TestCase):
         self.assertEqual(expected, actual)
 
 
+class TestMmapLayout(unittest.TestCase):
+    def test_save_and_load_mmap_layout(self):
+        MODEL_DIR = "./tmp/inference_model_mmap"
+        PARAMS_FILENAME = "__params__"
+
+        init_program = Program()
+        program = Program()
+        with program_guard(program, init_program):
+            x = layers.data(name='x', shape=[2], dtype='float32')
+            y_predict = layers.fc(input=x, size=3, act=None)
+
+        place = core.CPUPlace()
+        exe = executor.Executor(place)
+        exe.run(init_program, feed={}, fetch_list=[])
+
+        tensor_x = np.array([[1, 1], [1, 2], [3, 4], [5, 2]]).astype("float32")
+        expected = exe.run(program,
+                           feed={'x': tensor_x},
+                           fetch_list=[y_predict])[0]
+        save_inference_model(
+            MODEL_DIR, ["x"], [y_predict],
+            exe,
+            program,
+            params_filename=PARAMS_FILENAME,
+            mmap_layout=True)
+        with open(MODEL_DIR + "/" + PARAMS_FILENAME, "rb") as f:
+            self.assertEqual(f.read(8), b"PDMMAPPM")
+
+        six.moves.reload_module(executor)  # reload to build a new scope
+        exe = executor.Executor(place)
+        [infer_prog, feed_var_names, fetch_vars] = load_inference_model(
+            MODEL_DIR, exe, params_filename=PARAMS_FILENAME)
+        actual = exe.run(infer_prog,
+                         feed={feed_var_names[0]: tensor_x},
+                         fetch_list=fetch_vars)[0]
+        self.assertTrue(np.array_equal(expected, actual))
+
+
 class TestSaveInferenceModel(unittest.TestCase):
     def test_save_inference_model(self):
         MODEL_DIR = "./tmp/inference_model2"
@@ -241,10 +241,13 @@ class TestMulticlassNMSOp(OpTest):
         self.score_threshold = 0.01
 
     def setUp(self):
+        self.N = 7
+        self.C = 21
+        self.sparse_boxes = False
         self.set_argument()
-        N = 7
+        N = self.N
         M = 1200
-        C = 21
+        C = self.C
         BOX_SIZE = 4
         background = 0
         nms_threshold = 0.3
@@ -266,6 +269,13 @@ class TestMulticlassNMSOp(OpTest):
         boxes = np.random.random((N, M, BOX_SIZE)).astype('float32')
         boxes[:, :, 0:2] = boxes[:, :, 0:2] * 0.5
         boxes[:, :, 2:4] = boxes[:, :, 2:4] * 0.5 + 0.5
+        if self.sparse_boxes:
+            # Small boxes scattered in the image keep many boxes of a class,
+            # and the rounded scores have ties.
+            scores = np.round(scores, 3)
+            boxes[:, :, 0:2] = np.random.random((N, M, 2)) * 0.95
+            boxes[:, :, 2:4] = boxes[:, :, 0:2] + np.random.uniform(
+                0.01, 0.05, (N, M, 2))
 
         det_outs, lod = batched_multiclass_nms(boxes, scores, background,
                                                score_threshold, nms_threshold,
@@ -299,6 +309,14 @@ class TestMulticlassNMSOpNoOutput(TestMulticlassNMSOp):
         self.score_threshold = 2.0
 
 
+class TestMulticlassNMSOpSparseBoxes(TestMulticlassNMSOp):
+    def set_argument(self):
+        self.score_threshold = 0.01
+        self.N = 2
+        self.C = 4
+        self.sparse_boxes = True
+
+
 class TestMulticlassNMSLoDInput(OpTest):
     def set_argument(self):
         self.score_threshold = 0.01